@@ -59,6 +59,21 @@ APT_DECLARE(apt_task_vtable_t*) apt_consumer_task_vtable_get(const apt_consumer_
  */
 APT_DECLARE(void*) apt_consumer_task_object_get(const apt_consumer_task_t *task);
 
+/**
+ * Get the number of messages pending in the queue of consumer task.
+ * @param task the consumer task to get the queue size of
+ */
+APT_DECLARE(apr_size_t) apt_consumer_task_queue_size_get(const apt_consumer_task_t *task);
+
+/**
+ * Signal message to consumer task without blocking.
+ * @param task the consumer task to signal message to
+ * @param msg the message to signal
+ * @return FALSE if the queue is full, the message is not released then and may be signaled later
+ * @remark The task can signal a message to itself this way, without waiting on its own queue.
+ */
+APT_DECLARE(apt_bool_t) apt_consumer_task_msg_trysignal(apt_consumer_task_t *task, apt_task_msg_t *msg);
+
 /**
  * Create timer.
  * @param task the consumer task to create timer for
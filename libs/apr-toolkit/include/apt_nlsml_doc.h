@@ -47,6 +47,24 @@ typedef struct nlsml_input_t nlsml_input_t;
  */
 APT_DECLARE(nlsml_result_t*) nlsml_result_parse(const char *data, apr_size_t length, apr_pool_t *pool);
 
+/**
+ * Parse NLSML result in a single pass without building an XML tree
+ * @param data the data to parse
+ * @param length the length of the data
+ * @param pool the memory pool to use
+ * @return the parsed NLSML result.
+ * @remark The content of the instance and input elements is available via
+ * nlsml_instance_content_generate() and nlsml_input_content_generate(), while
+ * nlsml_instance_elem_get() and nlsml_input_elem_get() return NULL. Use
+ * nlsml_result_parse() if XML elements are needed (e.g. to suppress SWI elements).
+ * @remark Plain text content is decoded the same way by either parser. Structured
+ * content (e.g. SISR <instance><city>Boston</city></instance>) is kept as written
+ * in the document, references and CDATA sections included, while the content
+ * generated from the XML tree has references resolved and the elements of a
+ * namespace prefixed by ns0:, ns1:, etc.
+ */
+APT_DECLARE(nlsml_result_t*) nlsml_result_fast_parse(const char *data, apr_size_t length, apr_pool_t *pool);
+
 /**
  * Trace parsed NLSML result (for debug purposes only)
  * @param result the parsed result to output
@@ -161,6 +179,7 @@ APT_DECLARE(apt_bool_t) nlsml_instance_swi_suppress(nlsml_instance_t *instance);
  * Generate a plain text content of the instance element
  * @param instance the parsed instance to generate content of
  * @param pool the memory pool to use
+ * @remark Structured content differs depending on the parser, see nlsml_result_fast_parse().
  */
 APT_DECLARE(const char*) nlsml_instance_content_generate(const nlsml_instance_t *instance, apr_pool_t *pool);
 
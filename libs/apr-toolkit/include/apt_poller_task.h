@@ -34,6 +34,9 @@ typedef struct apt_poller_task_t apt_poller_task_t;
 /** Function prototype to handle signalled descripors */
 typedef apt_bool_t (*apt_poll_signal_f)(void *obj, const apr_pollfd_t *descriptor);
 
+/** Function prototype to handle completion of the task messages signalled within a poll cycle */
+typedef void (*apt_poll_msg_batch_f)(void *obj);
+
 
 /**
  * Create poller task.
@@ -95,6 +98,15 @@ APT_DECLARE(apt_task_vtable_t*) apt_poller_task_vtable_get(const apt_poller_task
  */
 APT_DECLARE(void*) apt_poller_task_object_get(const apt_poller_task_t *task);
 
+/**
+ * Set the handler invoked once all the pending task messages are processed.
+ * @param task the poller task to set the handler for
+ * @param handler the handler to set (NULL to unset)
+ * @remark Work deferred while processing a batch of messages (e.g. sending)
+ *         can be carried out in the handler at once.
+ */
+APT_DECLARE(void) apt_poller_task_msg_batch_handler_set(apt_poller_task_t *task, apt_poll_msg_batch_f handler);
+
 /**
  * Add descriptor to pollset.
  * @param task the task which holds the pollset
@@ -38,6 +38,12 @@ APT_BEGIN_EXTERN_C
 /** Opaque pollset declaration */
 typedef struct apt_pollset_t apt_pollset_t;
 
+/**
+ * Register descriptors in edge-triggered mode, if supported by the underlying method (epoll).
+ * The caller is then responsible to read/write a signalled descriptor till EAGAIN.
+ */
+#define APT_POLLSET_FLAG_EDGE_TRIGGERED 0x1
+
 /**
  * Create interruptable pollset on top of APR pollset.
  * @param size the maximum number of descriptors pollset can hold
@@ -45,6 +51,15 @@ typedef struct apt_pollset_t apt_pollset_t;
  */
 APT_DECLARE(apt_pollset_t*) apt_pollset_create(apr_uint32_t size, apr_pool_t *pool);
 
+/**
+ * Create interruptable pollset with the specified flags.
+ * @param size the maximum number of descriptors pollset can hold
+ * @param flags the pollset flags (APT_POLLSET_FLAG_XXX)
+ * @param pool the pool to allocate memory from
+ * @remark On Linux the pollset is based on epoll and eventfd directly, otherwise on APR pollset.
+ */
+APT_DECLARE(apt_pollset_t*) apt_pollset_create_ex(apr_uint32_t size, apr_uint32_t flags, apr_pool_t *pool);
+
 /**
  * Destroy pollset.
  * @param pollset the pollset to destroy
@@ -84,6 +99,12 @@ APT_DECLARE(apr_status_t) apt_pollset_poll(
  */
 APT_DECLARE(apt_bool_t) apt_pollset_wakeup(apt_pollset_t *pollset);
 
+/**
+ * Get the name of the method the pollset is based on.
+ * @param pollset the pollset to use
+ */
+APT_DECLARE(const char*) apt_pollset_method_name_get(const apt_pollset_t *pollset);
+
 /**
  * Match against builtin wake up descriptor in a pollset.
  * @param pollset the pollset to use
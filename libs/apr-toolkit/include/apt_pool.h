@@ -31,17 +31,104 @@
 
 APT_BEGIN_EXTERN_C
 
+/** Allocator types of root pools */
+typedef enum {
+	APT_POOL_ALLOCATOR_OWN,      /**< own allocator guarded by a mutex (default) */
+	APT_POOL_ALLOCATOR_UNLOCKED, /**< own allocator without a mutex, for pools accessed from a single thread only */
+	APT_POOL_ALLOCATOR_SHARED,   /**< global allocator of APR shared across the pools */
+
+	APT_POOL_ALLOCATOR_COUNT     /**< number of allocator types */
+} apt_pool_allocator_e;
+
 /**
- * Create APR pool
+ * Create APR pool using the default allocator type
+ * @see apt_pool_allocator_default_set()
  */
 APT_DECLARE(apr_pool_t*) apt_pool_create(void);
 
+/**
+ * Create APR pool using the specified allocator type
+ * @param type the allocator type
+ * @param max_free the max amount of free memory retained by the own allocator (0 - unlimited)
+ * @remark The pools created with APT_POOL_ALLOCATOR_UNLOCKED, as well as their subpools,
+ *         must not be accessed from different threads concurrently.
+ * @remark The pool must not be cleared, clear a subpool of it instead. APR runs the cleanups
+ *         of the pool on apr_pool_clear() as well, which destroy the mutex of the own allocator
+ *         and take the pool off the active counter.
+ */
+APT_DECLARE(apr_pool_t*) apt_pool_create_ex(apt_pool_allocator_e type, apr_size_t max_free);
+
+/**
+ * Set the default allocator type used by apt_pool_create()
+ * @param type the allocator type (APT_POOL_ALLOCATOR_UNLOCKED is not allowed)
+ * @param max_free the max amount of free memory retained by allocators (0 - unlimited)
+ * @remark Should be called at startup, affects the pools created afterwards.
+ */
+APT_DECLARE(apt_bool_t) apt_pool_allocator_default_set(apt_pool_allocator_e type, apr_size_t max_free);
+
+/**
+ * Find allocator type by name ("own", "unlocked", "shared")
+ * @return the allocator type or APT_POOL_ALLOCATOR_COUNT, if not found
+ */
+APT_DECLARE(apt_pool_allocator_e) apt_pool_allocator_type_find(const char *name);
+
+/**
+ * Get allocator type name
+ */
+APT_DECLARE(const char*) apt_pool_allocator_type_name_get(apt_pool_allocator_e type);
+
+/**
+ * Get the counters of root pools created with the specified allocator type
+ * @param type the allocator type
+ * @param created the total number of pools created
+ * @param active the number of pools not destroyed (nor cleared) yet
+ */
+APT_DECLARE(void) apt_pool_stats_get(apt_pool_allocator_e type, apr_size_t *created, apr_size_t *active);
+
 /**
  * Create APR subpool pool
  * @param parent the parent pool
  */
 APT_DECLARE(apr_pool_t*) apt_subpool_create(apr_pool_t *parent);
 
+
+/** Opaque pool recycler declaration */
+typedef struct apt_pool_recycler_t apt_pool_recycler_t;
+
+/**
+ * Create pool recycler (freelist of cleared pools).
+ * @param max_count the max number of cleared pools to keep for reuse
+ * @param pool the pool the lifetime of the recycler is bound to
+ * @remark Recycled pools are subpools of the recycler's own pool (with own allocator),
+ * the recycler can be accessed from different threads. All the pools acquired from
+ * the recycler are destroyed along with the specified pool.
+ */
+APT_DECLARE(apt_pool_recycler_t*) apt_pool_recycler_create(apr_size_t max_count, apr_pool_t *pool);
+
+/**
+ * Create pool recycler (freelist of cleared pools).
+ * @param max_count the max number of cleared pools to keep for reuse
+ * @param own_allocator whether to create each pool with own allocator
+ * @param pool the pool the lifetime of the recycler is bound to
+ * @remark If own_allocator is set, the pools used by different threads don't contend for
+ * the mutex of a single allocator. Then only the pools kept for reuse are destroyed along with
+ * the specified pool, the acquired ones must be released to the recycler beforehand.
+ */
+APT_DECLARE(apt_pool_recycler_t*) apt_pool_recycler_create_ex(apr_size_t max_count, apt_bool_t own_allocator, apr_pool_t *pool);
+
+/**
+ * Acquire pool from the recycler (reuse cleared pool or create a new one).
+ * @param recycler the recycler to acquire pool from
+ */
+APT_DECLARE(apr_pool_t*) apt_pool_recycler_acquire(apt_pool_recycler_t *recycler);
+
+/**
+ * Release pool back to the recycler.
+ * @param recycler the recycler to release pool to
+ * @param pool the pool to clear and keep for reuse (destroyed if the recycler is full)
+ */
+APT_DECLARE(void) apt_pool_recycler_release(apt_pool_recycler_t *recycler, apr_pool_t *pool);
+
 APT_END_EXTERN_C
 
 #endif /* APT_POOL_H */
@@ -54,6 +54,9 @@ APT_DECLARE(apt_message_parser_t*) apt_message_parser_create(void *obj, const ap
 /** Parse message by raising corresponding event handlers */
 APT_DECLARE(apt_message_status_e) apt_message_parser_run(apt_message_parser_t *parser, apt_text_stream_t *stream, void **message);
 
+/** Reset parser to start with a new message (the message being parsed is discarded) */
+APT_DECLARE(void) apt_message_parser_reset(apt_message_parser_t *parser);
+
 /** Get external object associated with parser */
 APT_DECLARE(void*) apt_message_parser_object_get(apt_message_parser_t *parser);
 
@@ -95,11 +98,14 @@ struct apt_message_context_t {
 	apt_header_section_t *header;
 	/** Body or content of the message */
 	apt_str_t            *body;
+	/** Pool to allocate header fields and body of the message from */
+	apr_pool_t           *pool;
 };
 
 /** Vtable of text message parser */
 struct apt_message_parser_vtable_t {
-	/** Start new message parsing by associating corresponding context and reading its start-line if applicable */
+	/** Start new message parsing by associating corresponding context and reading its start-line if applicable,
+	    the context pool is set to the parser pool and may be overridden by the handler */
 	apt_bool_t (*on_start)(apt_message_parser_t *parser, apt_message_context_t *context, apt_text_stream_t *stream, apr_pool_t *pool);
 	/** Header section handler is invoked when entire header section has been read and parsed into header fields */
 	apt_bool_t (*on_header_complete)(apt_message_parser_t *parser, apt_message_context_t *context);
@@ -100,7 +100,7 @@ APT_DECLARE(apt_bool_t) apt_boolean_value_parse(const apt_str_t *str, apt_bool_t
 /** Generate apr_size_t value from pool (buffer is allocated from pool) */
 APT_DECLARE(apt_bool_t) apt_boolean_value_generate(apt_bool_t value, apt_str_t *str, apr_pool_t *pool);
 
-/** Parse apr_size_t value */
+/** Parse apr_size_t value (the string does not have to be NUL-terminated) */
 APT_DECLARE(apr_size_t) apt_size_value_parse(const apt_str_t *str);
 /** Generate apr_size_t value from pool (buffer is allocated from pool) */
 APT_DECLARE(apt_bool_t) apt_size_value_generate(apr_size_t value, apt_str_t *str, apr_pool_t *pool);
@@ -108,7 +108,7 @@ APT_DECLARE(apt_bool_t) apt_size_value_generate(apr_size_t value, apt_str_t *str
 /** Insert apr_size_t value */
 APT_DECLARE(apt_bool_t) apt_text_size_value_insert(apt_text_stream_t *stream, apr_size_t value);
 
-/** Parse float value */
+/** Parse float value (the string does not have to be NUL-terminated) */
 APT_DECLARE(float) apt_float_value_parse(const apt_str_t *str);
 /** Generate float value (buffer is allocated from pool) */
 APT_DECLARE(apt_bool_t) apt_float_value_generate(float value, apt_str_t *str, apr_pool_t *pool);
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef APT_TEXT_TEMPLATE_H
+#define APT_TEXT_TEMPLATE_H
+
+/**
+ * @file apt_text_template.h
+ * @brief Precompiled Text Template
+ *
+ * The text is split into literal segments and slots once, then rendered
+ * by copying the segments and substituting the values of the slots,
+ * without parsing any format at generation time.
+ */
+
+#include "apt_text_stream.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Opaque text template declaration */
+typedef struct apt_text_template_t apt_text_template_t;
+
+/**
+ * Compile text template.
+ * @param text the text containing slots in the form of ${name}
+ * @param slot_names the names of the slots, values are passed in the same order
+ * @param slot_count the number of slot names
+ * @param pool the pool to allocate memory from
+ * @return the compiled template, or NULL if the text refers to an unknown slot
+ */
+APT_DECLARE(apt_text_template_t*) apt_text_template_compile(
+									const char *text,
+									const char * const *slot_names,
+									apr_size_t slot_count,
+									apr_pool_t *pool);
+
+/**
+ * Render text template into text stream.
+ * @param tmpl the template to render
+ * @param values the values of the slots (slot_count values in the order of slot names)
+ * @param stream the text stream to render into
+ * @return FALSE if there is not enough room in the stream
+ */
+APT_DECLARE(apt_bool_t) apt_text_template_render(
+									const apt_text_template_t *tmpl,
+									const apt_str_t *values,
+									apt_text_stream_t *stream);
+
+/**
+ * Render text template into text stream, the stream is marked as full (is_eos),
+ * if there is not enough room in it. Nothing is rendered into a full stream, so
+ * that a sequence of insertions can be checked once, when the text is complete.
+ * @param tmpl the template to render
+ * @param values the values of the slots
+ * @param stream the text stream to render into
+ */
+APT_DECLARE(void) apt_text_template_stream_render(
+									const apt_text_template_t *tmpl,
+									const apt_str_t *values,
+									apt_text_stream_t *stream);
+
+/**
+ * Insert text into text stream, the stream is marked as full (is_eos),
+ * if there is not enough room in it.
+ * @param stream the text stream to insert into
+ * @param text the text to insert
+ * @param length the length of the text
+ */
+APT_DECLARE(void) apt_text_template_text_insert(apt_text_stream_t *stream, const char *text, apr_size_t length);
+
+/** Insert string literal into text stream, the stream is marked as full, if there is not enough room in it */
+#define APT_TEXT_TEMPLATE_LITERAL_INSERT(stream,literal) apt_text_template_text_insert(stream,literal,sizeof(literal)-1)
+
+/**
+ * Insert numeric value into text stream, the stream is marked as full (is_eos),
+ * if there is not enough room in it.
+ * @param stream the text stream to insert into
+ * @param value the value to insert
+ */
+APT_DECLARE(void) apt_text_template_number_insert(apt_text_stream_t *stream, apr_size_t value);
+
+/**
+ * Format numeric value of a slot.
+ * @param value the value of the slot to set
+ * @param buffer the buffer to format the number in (referenced by the value)
+ * @param size the size of the buffer
+ * @param number the number to format
+ */
+APT_DECLARE(void) apt_text_template_number_set(apt_str_t *value, char *buffer, apr_size_t size, apr_size_t number);
+
+APT_END_EXTERN_C
+
+#endif /* APT_TEXT_TEMPLATE_H */
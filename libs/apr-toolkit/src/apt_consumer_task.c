@@ -77,6 +77,11 @@ APT_DECLARE(void*) apt_consumer_task_object_get(const apt_consumer_task_t *task)
 	return task->obj;
 }
 
+APT_DECLARE(apt_bool_t) apt_consumer_task_msg_trysignal(apt_consumer_task_t *task, apt_task_msg_t *msg)
+{
+	return (apr_queue_trypush(task->msg_queue,msg) == APR_SUCCESS) ? TRUE : FALSE;
+}
+
 APT_DECLARE(apt_timer_t*) apt_consumer_task_timer_create(
 									apt_consumer_task_t *task, 
 									apt_timer_proc_f proc, 
@@ -90,6 +95,11 @@ APT_DECLARE(apt_timer_t*) apt_consumer_task_timer_create(
 #endif
 }
 
+APT_DECLARE(apr_size_t) apt_consumer_task_queue_size_get(const apt_consumer_task_t *task)
+{
+	return apr_queue_size(task->msg_queue);
+}
+
 static apt_bool_t apt_consumer_task_msg_signal(apt_task_t *task, apt_task_msg_t *msg)
 {
 	apt_consumer_task_t *consumer_task = apt_task_object_get(task);
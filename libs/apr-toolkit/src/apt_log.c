@@ -415,7 +415,8 @@ static apt_bool_t apt_log_file_open_internal(const char *dir_path, const char *p
 	file_data->ctime = 0;
 	file_data->cur_size = 0;
 	file_data->mutex = NULL;
-	file_data->pool = apt_pool_create();
+	/* the pool is accessed under the mutex only */
+	file_data->pool = apt_pool_create_ex(APT_POOL_ALLOCATOR_UNLOCKED,0);
 	file_data->rotation_count = 0;
 	file_data->settings = *settings;
 
@@ -1078,6 +1079,8 @@ static void apt_log_files_populate(apt_log_file_data_t *file_data)
 
 static apt_bool_t apt_log_file_rotate(apt_log_file_data_t *file_data)
 {
+	apr_pool_t *pool;
+
 	/* close current log file */
 	fclose(file_data->file);
 
@@ -1095,8 +1098,12 @@ static apt_bool_t apt_log_file_rotate(apt_log_file_data_t *file_data)
 	if (file_data->rotation_count == file_data->settings.pool_reuse_count) {
 		file_data->rotation_count = 0;
 
-		/* clear pool to release memory used for allocation of temporary data */
-		apr_pool_clear(file_data->pool);
+		/* recreate pool to release memory used for allocation of temporary data */
+		pool = apt_pool_create_ex(APT_POOL_ALLOCATOR_UNLOCKED,0);
+		if (pool) {
+			apr_pool_destroy(file_data->pool);
+			file_data->pool = pool;
+		}
 	}
 
 	return apt_log_file_create(file_data);
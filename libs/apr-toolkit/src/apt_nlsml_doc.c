@@ -19,8 +19,10 @@
 #pragma warning(disable: 4127)
 #endif
 #include <apr_ring.h>
+#include <apr_strings.h>
 
 #include "apt_nlsml_doc.h"
+#include "apt_string.h"
 #include "apt_log.h"
 
 /** NLSML result */
@@ -45,6 +47,8 @@ struct nlsml_instance_t
 
 	/** Instance element */
 	apr_xml_elem *elem;
+	/** Content of the element (single-pass parsing only) */
+	const char   *content;
 };
 
 /** NLSML input */
@@ -52,6 +56,8 @@ struct nlsml_input_t
 {
 	/** Input element */
 	apr_xml_elem *elem;
+	/** Content of the element (single-pass parsing only) */
+	const char *content;
 	/** Input mode attribute [default: "speech"] */
 	const char *mode;
 	/** Confidence attribute [default: 1.0] */
@@ -141,6 +147,29 @@ static float nlsml_confidence_parse(const char *str)
 	return confidence;
 }
 
+/** Create empty NLSML result */
+static nlsml_result_t* nlsml_result_create(apr_pool_t *pool)
+{
+	nlsml_result_t *result = apr_palloc(pool, sizeof(*result));
+	APR_RING_INIT(&result->interpretations, nlsml_interpretation_t, link);
+	APR_RING_INIT(&result->enrollment_results, nlsml_enrollment_result_t, link);
+	APR_RING_INIT(&result->verification_results, nlsml_verification_result_t, link);
+	result->grammar = NULL;
+	return result;
+}
+
+/** Create empty NLSML interpretation */
+static nlsml_interpretation_t* nlsml_interpretation_create(apr_pool_t *pool)
+{
+	nlsml_interpretation_t *interpretation = apr_palloc(pool, sizeof(*interpretation));
+	APR_RING_ELEM_INIT(interpretation,link);
+	interpretation->grammar = NULL;
+	interpretation->confidence = 1.0;
+	interpretation->input = NULL;
+	APR_RING_INIT(&interpretation->instances, nlsml_instance_t, link);
+	return interpretation;
+}
+
 /** Parse <instance> element */
 static nlsml_instance_t* nlsml_instance_parse(apr_xml_elem *elem, apr_pool_t *pool)
 {
@@ -148,6 +177,7 @@ static nlsml_instance_t* nlsml_instance_parse(apr_xml_elem *elem, apr_pool_t *po
 	nlsml_instance_t *instance = apr_palloc(pool, sizeof(*instance));
 	APR_RING_ELEM_INIT(instance,link);
 	instance->elem = elem;
+	instance->content = NULL;
 
 	return instance;
 }
@@ -159,6 +189,7 @@ static nlsml_input_t* nlsml_input_parse(apr_xml_elem *elem, apr_pool_t *pool)
 	/* Initialize input */
 	nlsml_input_t *input = apr_palloc(pool, sizeof(*input));
 	input->elem = elem;
+	input->content = NULL;
 	input->mode = "speech";
 	input->confidence = 1.0;
 	input->timestamp_start = NULL;
@@ -195,12 +226,7 @@ static nlsml_interpretation_t* nlsml_interpretation_parse(apr_xml_elem *elem, ap
 	nlsml_input_t *input;
 
 	/* Initialize interpretation */
-	nlsml_interpretation_t *interpretation = apr_palloc(pool, sizeof(*interpretation));
-	APR_RING_ELEM_INIT(interpretation,link);
-	interpretation->grammar = NULL;
-	interpretation->confidence = 1.0;
-	interpretation->input = NULL;
-	APR_RING_INIT(&interpretation->instances, nlsml_instance_t, link);
+	nlsml_interpretation_t *interpretation = nlsml_interpretation_create(pool);
 
 	/* Find optional grammar and confidence attributes */
 	for(xml_attr = elem->attr; xml_attr; xml_attr = xml_attr->next) {
@@ -270,11 +296,7 @@ APT_DECLARE(nlsml_result_t*) nlsml_result_parse(const char *data, apr_size_t len
 	root = doc->root;
 
 	/* Initialize result */
-	result = apr_palloc(pool, sizeof(*result));
-	APR_RING_INIT(&result->interpretations, nlsml_interpretation_t, link);
-	APR_RING_INIT(&result->enrollment_results, nlsml_enrollment_result_t, link);
-	APR_RING_INIT(&result->verification_results, nlsml_verification_result_t, link);
-	result->grammar = NULL;
+	result = nlsml_result_create(pool);
 
 	/* Find optional grammar attribute */
 	for(xml_attr = root->attr; xml_attr; xml_attr = xml_attr->next) {
@@ -321,6 +343,563 @@ APT_DECLARE(nlsml_result_t*) nlsml_result_parse(const char *data, apr_size_t len
 	return result;
 }
 
+/** Tag types reported by the single-pass scanner */
+typedef enum {
+	NLSML_TAG_START,   /**< start tag <name ...> */
+	NLSML_TAG_EMPTY,   /**< empty-element tag <name .../> */
+	NLSML_TAG_END,     /**< end tag </name> */
+	NLSML_TAG_NONE,    /**< no more tags */
+	NLSML_TAG_INVALID  /**< malformed markup */
+} nlsml_tag_type_e;
+
+/** Tag reported by the single-pass scanner */
+typedef struct nlsml_tag_t nlsml_tag_t;
+struct nlsml_tag_t {
+	/** Tag type */
+	nlsml_tag_type_e type;
+	/** Local name of the element (namespace prefix stripped) */
+	apt_str_t        name;
+	/** Raw attributes */
+	const char      *attrs;
+	const char      *attrs_end;
+	/** Position of the opening '<' */
+	const char      *begin;
+	/** Position following the closing '>' */
+	const char      *end;
+};
+
+/** Single-pass scanner */
+typedef struct nlsml_scanner_t nlsml_scanner_t;
+struct nlsml_scanner_t {
+	/** Current position */
+	const char *pos;
+	/** End of data */
+	const char *end;
+};
+
+#define NLSML_NAME_IS(name,literal) \
+	((name)->length == sizeof(literal) - 1 && strncasecmp((name)->buf,literal,sizeof(literal) - 1) == 0)
+
+#define NLSML_DATA_IS(pos,end,literal) \
+	((apr_size_t)((end) - (pos)) >= sizeof(literal) - 1 && memcmp(pos,literal,sizeof(literal) - 1) == 0)
+
+static APR_INLINE apt_bool_t nlsml_is_space(char ch)
+{
+	return (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') ? TRUE : FALSE;
+}
+
+/** Find pattern in data, return position following the pattern */
+static const char* nlsml_pattern_skip(const char *pos, const char *end, const char *pattern, apr_size_t length)
+{
+	for(; pos + length <= end; pos++) {
+		if(*pos == *pattern && memcmp(pos,pattern,length) == 0)
+			return pos + length;
+	}
+	return NULL;
+}
+
+/** Strip namespace prefix */
+static void nlsml_name_localize(apt_str_t *name)
+{
+	apr_size_t i = name->length;
+	while(i) {
+		if(name->buf[--i] == ':') {
+			name->buf += i + 1;
+			name->length -= i + 1;
+			break;
+		}
+	}
+}
+
+/** Scan next tag skipping character data, comments, CDATA sections, PIs and declarations */
+static nlsml_tag_type_e nlsml_tag_scan(nlsml_scanner_t *scanner, nlsml_tag_t *tag)
+{
+	const char *pos = scanner->pos;
+	const char *end = scanner->end;
+	char quote = 0;
+
+	for(;;) {
+		pos = pos < end ? memchr(pos,'<',end - pos) : NULL;
+		if(!pos) {
+			scanner->pos = end;
+			return tag->type = NLSML_TAG_NONE;
+		}
+
+		tag->begin = pos++;
+		if(NLSML_DATA_IS(pos,end,"?")) {
+			pos = nlsml_pattern_skip(pos,end,"?>",2);
+		}
+		else if(NLSML_DATA_IS(pos,end,"!--")) {
+			pos = nlsml_pattern_skip(pos,end,"-->",3);
+		}
+		else if(NLSML_DATA_IS(pos,end,"![CDATA[")) {
+			pos = nlsml_pattern_skip(pos,end,"]]>",3);
+		}
+		else if(NLSML_DATA_IS(pos,end,"!")) {
+			pos = nlsml_pattern_skip(pos,end,">",1);
+		}
+		else {
+			break;
+		}
+
+		if(!pos) {
+			scanner->pos = end;
+			return tag->type = NLSML_TAG_INVALID;
+		}
+	}
+
+	tag->type = NLSML_TAG_START;
+	if(pos < end && *pos == '/') {
+		tag->type = NLSML_TAG_END;
+		pos++;
+	}
+
+	tag->name.buf = (char*)pos;
+	while(pos < end && nlsml_is_space(*pos) == FALSE && *pos != '>' && *pos != '/')
+		pos++;
+	tag->name.length = pos - tag->name.buf;
+	nlsml_name_localize(&tag->name);
+
+	/* find the closing '>', which may also appear in quoted attribute values */
+	tag->attrs = pos;
+	for(; pos < end; pos++) {
+		if(quote) {
+			if(*pos == quote)
+				quote = 0;
+		}
+		else if(*pos == '"' || *pos == '\'') {
+			quote = *pos;
+		}
+		else if(*pos == '>') {
+			break;
+		}
+	}
+
+	if(pos >= end || !tag->name.length) {
+		scanner->pos = end;
+		return tag->type = NLSML_TAG_INVALID;
+	}
+
+	tag->attrs_end = pos;
+	if(tag->type == NLSML_TAG_START && pos > tag->attrs && *(pos - 1) == '/') {
+		tag->type = NLSML_TAG_EMPTY;
+		tag->attrs_end--;
+	}
+	tag->end = pos + 1;
+	scanner->pos = tag->end;
+	return tag->type;
+}
+
+/** Scan next attribute of the tag skipping namespace declarations */
+static apt_bool_t nlsml_attr_scan(const char **cur, const char *end, apt_str_t *name, apt_str_t *value)
+{
+	const char *pos = *cur;
+	char quote;
+
+	do {
+		while(pos < end && nlsml_is_space(*pos) == TRUE)
+			pos++;
+		if(pos >= end)
+			return FALSE;
+
+		name->buf = (char*)pos;
+		while(pos < end && *pos != '=' && nlsml_is_space(*pos) == FALSE)
+			pos++;
+		name->length = pos - name->buf;
+
+		while(pos < end && nlsml_is_space(*pos) == TRUE)
+			pos++;
+		if(pos >= end || *pos != '=')
+			return FALSE;
+		pos++;
+		while(pos < end && nlsml_is_space(*pos) == TRUE)
+			pos++;
+		if(pos >= end || (*pos != '"' && *pos != '\''))
+			return FALSE;
+
+		quote = *pos++;
+		value->buf = (char*)pos;
+		while(pos < end && *pos != quote)
+			pos++;
+		if(pos >= end)
+			return FALSE;
+		value->length = pos - value->buf;
+		pos++;
+	}
+	while(NLSML_NAME_IS(name,"xmlns") || (name->length > 6 && strncmp(name->buf,"xmlns:",6) == 0));
+
+	*cur = pos;
+	nlsml_name_localize(name);
+	return TRUE;
+}
+
+/** Encode Unicode code point in UTF-8 */
+static char* nlsml_utf8_encode(char *out, apr_uint32_t code)
+{
+	if(code < 0x80) {
+		*out++ = (char)code;
+	}
+	else if(code < 0x800) {
+		*out++ = (char)(0xC0 | (code >> 6));
+		*out++ = (char)(0x80 | (code & 0x3F));
+	}
+	else if(code < 0x10000) {
+		*out++ = (char)(0xE0 | (code >> 12));
+		*out++ = (char)(0x80 | ((code >> 6) & 0x3F));
+		*out++ = (char)(0x80 | (code & 0x3F));
+	}
+	else {
+		*out++ = (char)(0xF0 | (code >> 18));
+		*out++ = (char)(0x80 | ((code >> 12) & 0x3F));
+		*out++ = (char)(0x80 | ((code >> 6) & 0x3F));
+		*out++ = (char)(0x80 | (code & 0x3F));
+	}
+	return out;
+}
+
+/** Decode reference (the part between '&' and ';') */
+static char* nlsml_reference_decode(char *out, const char *ref, apr_size_t length)
+{
+	if(length == 2 && memcmp(ref,"lt",2) == 0) {
+		*out++ = '<';
+	}
+	else if(length == 2 && memcmp(ref,"gt",2) == 0) {
+		*out++ = '>';
+	}
+	else if(length == 3 && memcmp(ref,"amp",3) == 0) {
+		*out++ = '&';
+	}
+	else if(length == 4 && memcmp(ref,"quot",4) == 0) {
+		*out++ = '"';
+	}
+	else if(length == 4 && memcmp(ref,"apos",4) == 0) {
+		*out++ = '\'';
+	}
+	else if(length > 1 && length < 10 && *ref == '#') {
+		char digits[10];
+		unsigned long code;
+		memcpy(digits,ref + 1,length - 1);
+		digits[length - 1] = '\0';
+		if(*digits == 'x' || *digits == 'X') {
+			code = strtoul(digits + 1,NULL,16);
+		}
+		else {
+			code = strtoul(digits,NULL,10);
+		}
+		if(code && code <= 0x10FFFF) {
+			out = nlsml_utf8_encode(out,(apr_uint32_t)code);
+		}
+	}
+	else {
+		/* keep unknown reference as is */
+		*out++ = '&';
+		memcpy(out,ref,length);
+		out += length;
+		*out++ = ';';
+	}
+	return out;
+}
+
+/** Decode character data resolving references and CDATA sections, return NULL if data contains elements */
+static char* nlsml_text_decode(const char *pos, const char *end, apr_pool_t *pool)
+{
+	/* decoded text is never longer than the source one */
+	char *text = apr_palloc(pool,end - pos + 1);
+	char *out = text;
+	const char *next;
+
+	while(pos < end) {
+		if(*pos == '&' && (next = memchr(pos,';',end - pos)) != NULL) {
+			out = nlsml_reference_decode(out,pos + 1,next - pos - 1);
+			pos = next + 1;
+		}
+		else if(*pos == '<') {
+			if(NLSML_DATA_IS(pos,end,"<![CDATA[")) {
+				pos += 9;
+				next = nlsml_pattern_skip(pos,end,"]]>",3);
+				if(!next)
+					return NULL;
+				memcpy(out,pos,next - 3 - pos);
+				out += next - 3 - pos;
+				pos = next;
+			}
+			else if(NLSML_DATA_IS(pos,end,"<!--")) {
+				pos = nlsml_pattern_skip(pos + 4,end,"-->",3);
+				if(!pos)
+					return NULL;
+			}
+			else {
+				return NULL;
+			}
+		}
+		else {
+			*out++ = *pos++;
+		}
+	}
+	*out = '\0';
+	return text;
+}
+
+/** Copy attribute value */
+static const char* nlsml_attr_value_copy(const apt_str_t *value, apr_pool_t *pool)
+{
+	const char *text = nlsml_text_decode(value->buf,value->buf + value->length,pool);
+	if(!text)
+		text = apr_pstrmemdup(pool,value->buf,value->length);
+	return text;
+}
+
+/** Skip the content of the element the start tag of which has been scanned */
+static apt_bool_t nlsml_element_skip(nlsml_scanner_t *scanner, const char **content_end)
+{
+	nlsml_tag_t tag;
+	apr_size_t depth = 1;
+	do {
+		switch(nlsml_tag_scan(scanner,&tag)) {
+			case NLSML_TAG_START:
+				depth++;
+				break;
+			case NLSML_TAG_END:
+				depth--;
+				break;
+			case NLSML_TAG_EMPTY:
+				break;
+			default:
+				return FALSE;
+		}
+	}
+	while(depth);
+
+	if(content_end)
+		*content_end = tag.begin;
+	return TRUE;
+}
+
+/** Get the content of the element the start tag of which has been scanned */
+static const char* nlsml_element_content_scan(nlsml_scanner_t *scanner, const nlsml_tag_t *tag, apr_pool_t *pool)
+{
+	const char *begin = tag->end;
+	const char *end;
+	const char *text;
+	if(tag->type == NLSML_TAG_EMPTY)
+		return "";
+
+	if(nlsml_element_skip(scanner,&end) == FALSE)
+		return NULL;
+
+	text = nlsml_text_decode(begin,end,pool);
+	if(!text) {
+		/* structured content is kept as is */
+		text = apr_pstrmemdup(pool,begin,end - begin);
+	}
+	return text;
+}
+
+/** Scan <instance> element */
+static nlsml_instance_t* nlsml_instance_scan(nlsml_scanner_t *scanner, const nlsml_tag_t *tag, apr_pool_t *pool)
+{
+	/* Initialize instance */
+	nlsml_instance_t *instance = apr_palloc(pool, sizeof(*instance));
+	APR_RING_ELEM_INIT(instance,link);
+	instance->elem = NULL;
+	instance->content = nlsml_element_content_scan(scanner,tag,pool);
+	if(!instance->content)
+		return NULL;
+
+	return instance;
+}
+
+/** Scan <input> element */
+static nlsml_input_t* nlsml_input_scan(nlsml_scanner_t *scanner, const nlsml_tag_t *tag, apr_pool_t *pool)
+{
+	apt_str_t name;
+	apt_str_t value;
+	const char *pos = tag->attrs;
+	/* Initialize input */
+	nlsml_input_t *input = apr_palloc(pool, sizeof(*input));
+	input->elem = NULL;
+	input->mode = "speech";
+	input->confidence = 1.0;
+	input->timestamp_start = NULL;
+	input->timestamp_end = NULL;
+
+	/* Find input attributes */
+	while(nlsml_attr_scan(&pos,tag->attrs_end,&name,&value) == TRUE) {
+		if(NLSML_NAME_IS(&name,"mode")) {
+			input->mode = nlsml_attr_value_copy(&value,pool);
+		}
+		else if(NLSML_NAME_IS(&name,"confidence")) {
+			/* the value is terminated by the quote */
+			input->confidence = nlsml_confidence_parse(value.buf);
+		}
+		else if(NLSML_NAME_IS(&name,"timestamp-start")) {
+			input->timestamp_start = nlsml_attr_value_copy(&value,pool);
+		}
+		else if(NLSML_NAME_IS(&name,"timestamp-end")) {
+			input->timestamp_end = nlsml_attr_value_copy(&value,pool);
+		}
+		else {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown attribute '%.*s' for <input>", (int)name.length, name.buf);
+		}
+	}
+
+	input->content = nlsml_element_content_scan(scanner,tag,pool);
+	if(!input->content)
+		return NULL;
+
+	return input;
+}
+
+/** Scan <interpretation> element */
+static nlsml_interpretation_t* nlsml_interpretation_scan(nlsml_scanner_t *scanner, const nlsml_tag_t *tag, apr_pool_t *pool)
+{
+	nlsml_tag_t child_tag;
+	apt_str_t name;
+	apt_str_t value;
+	const char *pos = tag->attrs;
+	nlsml_instance_t *instance;
+
+	/* Initialize interpretation */
+	nlsml_interpretation_t *interpretation = nlsml_interpretation_create(pool);
+
+	/* Find optional grammar and confidence attributes */
+	while(nlsml_attr_scan(&pos,tag->attrs_end,&name,&value) == TRUE) {
+		if(NLSML_NAME_IS(&name,"grammar")) {
+			interpretation->grammar = nlsml_attr_value_copy(&value,pool);
+		}
+		else if(NLSML_NAME_IS(&name,"confidence")) {
+			interpretation->confidence = nlsml_confidence_parse(value.buf);
+		}
+		else {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown attribute '%.*s' for <interpretation>", (int)name.length, name.buf);
+		}
+	}
+
+	if(tag->type == NLSML_TAG_EMPTY)
+		return interpretation;
+
+	/* Find input and instance elements */
+	for(;;) {
+		switch(nlsml_tag_scan(scanner,&child_tag)) {
+			case NLSML_TAG_START:
+			case NLSML_TAG_EMPTY:
+				if(NLSML_NAME_IS(&child_tag.name,"input")) {
+					interpretation->input = nlsml_input_scan(scanner,&child_tag,pool);
+					if(!interpretation->input)
+						return NULL;
+				}
+				else if(NLSML_NAME_IS(&child_tag.name,"instance")) {
+					instance = nlsml_instance_scan(scanner,&child_tag,pool);
+					if(!instance)
+						return NULL;
+					APR_RING_INSERT_TAIL(&interpretation->instances, instance, nlsml_instance_t, link);
+				}
+				else {
+					apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown child element <%.*s> for <interpretation>",
+						(int)child_tag.name.length, child_tag.name.buf);
+					if(child_tag.type == NLSML_TAG_START && nlsml_element_skip(scanner,NULL) == FALSE)
+						return NULL;
+				}
+				break;
+			case NLSML_TAG_END:
+				return interpretation;
+			default:
+				return NULL;
+		}
+	}
+}
+
+/** Parse NLSML result in a single pass without building an XML tree */
+APT_DECLARE(nlsml_result_t*) nlsml_result_fast_parse(const char *data, apr_size_t length, apr_pool_t *pool)
+{
+	nlsml_result_t *result;
+	nlsml_scanner_t scanner;
+	nlsml_tag_t root_tag;
+	nlsml_tag_t child_tag;
+	nlsml_interpretation_t *interpretation;
+	apt_str_t name;
+	apt_str_t value;
+	const char *pos;
+	apt_bool_t status = TRUE;
+
+	if(!data || !length) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No NLSML data available");
+		return NULL;
+	}
+
+	scanner.pos = data;
+	scanner.end = data + length;
+
+	/* Find root element */
+	nlsml_tag_scan(&scanner,&root_tag);
+	if(root_tag.type != NLSML_TAG_START && root_tag.type != NLSML_TAG_EMPTY) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to parse NLSML document");
+		return NULL;
+	}
+	if(root_tag.name.length != 6 || strncmp(root_tag.name.buf,"result",6) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected NLSML root element <%.*s>",(int)root_tag.name.length,root_tag.name.buf);
+		return NULL;
+	}
+
+	/* Initialize result */
+	result = nlsml_result_create(pool);
+
+	/* Find optional grammar attribute */
+	pos = root_tag.attrs;
+	while(nlsml_attr_scan(&pos,root_tag.attrs_end,&name,&value) == TRUE) {
+		if(NLSML_NAME_IS(&name,"grammar")) {
+			result->grammar = nlsml_attr_value_copy(&value,pool);
+		}
+		else {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown attribute '%.*s' for <result>", (int)name.length, name.buf);
+		}
+	}
+
+	/* Find interpretation, enrollment-result, or verification-result elements */
+	while(root_tag.type == NLSML_TAG_START && status == TRUE) {
+		nlsml_tag_scan(&scanner,&child_tag);
+		if(child_tag.type == NLSML_TAG_END) {
+			break;
+		}
+		if(child_tag.type != NLSML_TAG_START && child_tag.type != NLSML_TAG_EMPTY) {
+			status = FALSE;
+			break;
+		}
+
+		if(NLSML_NAME_IS(&child_tag.name,"interpretation")) {
+			interpretation = nlsml_interpretation_scan(&scanner,&child_tag,pool);
+			if(interpretation) {
+				APR_RING_INSERT_TAIL(&result->interpretations, interpretation, nlsml_interpretation_t, link);
+			}
+			else {
+				status = FALSE;
+			}
+			continue;
+		}
+
+		if(!NLSML_NAME_IS(&child_tag.name,"enrollment-result") && !NLSML_NAME_IS(&child_tag.name,"verification-result")) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown child element <%.*s> for <result>",
+				(int)child_tag.name.length, child_tag.name.buf);
+		}
+		/* enrollment and verification results are to be done, as in the tree-based parser */
+		if(child_tag.type == NLSML_TAG_START) {
+			status = nlsml_element_skip(&scanner,NULL);
+		}
+	}
+
+	if(status == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to parse NLSML document");
+		return NULL;
+	}
+
+	if(APR_RING_EMPTY(&result->interpretations, nlsml_interpretation_t, link)) {
+		/* at least one of <interpretation>, <enrollment-result>, <verification-result> MUST be specified */
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid NLSML document: at least one child element MUST be specified for <result>");
+	}
+
+	return result;
+}
+
 /** Trace NLSML result (for debug purposes only) */
 APT_DECLARE(void) nlsml_result_trace(const nlsml_result_t *result, apr_pool_t *pool)
 {
@@ -522,6 +1101,9 @@ APT_DECLARE(const char*) nlsml_instance_content_generate(const nlsml_instance_t
 		apr_size_t size;
 		apr_xml_to_text(pool, instance->elem, APR_XML_X2T_INNER, NULL, NULL, &buf, &size);
 	}
+	else {
+		buf = instance->content;
+	}
 	return buf;
 }
 
@@ -539,6 +1121,9 @@ APT_DECLARE(const char*) nlsml_input_content_generate(const nlsml_input_t *input
 		apr_size_t size;
 		apr_xml_to_text(pool, input->elem, APR_XML_X2T_INNER, NULL, NULL, &buf, &size);
 	}
+	else {
+		buf = input->content;
+	}
 	return buf;
 }
 
@@ -20,6 +20,8 @@
 #include "apt_cyclic_queue.h"
 #include "apt_log.h"
 
+/** Max number of task messages popped from the queue at once */
+#define APT_POLLER_TASK_MSG_BATCH_SIZE 32
 
 /** Poller task */
 struct apt_poller_task_t {
@@ -28,6 +30,7 @@ struct apt_poller_task_t {
 	
 	void               *obj;
 	apt_poll_signal_f   signal_handler;
+	apt_poll_msg_batch_f msg_batch_handler;
 
 	apr_thread_mutex_t *guard;
 	apt_cyclic_queue_t *msg_queue;
@@ -65,6 +68,7 @@ APT_DECLARE(apt_poller_task_t*) apt_poller_task_create(
 	task->obj = obj;
 	task->pollset = NULL;
 	task->signal_handler = signal_handler;
+	task->msg_batch_handler = NULL;
 
 	task->pollset = apt_pollset_create((apr_uint32_t)max_pollset_size,pool);
 	if(!task->pollset) {
@@ -183,6 +187,12 @@ APT_DECLARE(apt_bool_t) apt_poller_task_descriptor_remove(const apt_poller_task_
 	return FALSE;
 }
 
+/** Set the handler invoked once all the pending task messages are processed */
+APT_DECLARE(void) apt_poller_task_msg_batch_handler_set(apt_poller_task_t *task, apt_poll_msg_batch_f handler)
+{
+	task->msg_batch_handler = handler;
+}
+
 /** Create timer */
 APT_DECLARE(apt_timer_t*) apt_poller_task_timer_create(
 									apt_poller_task_t *task, 
@@ -195,21 +205,30 @@ APT_DECLARE(apt_timer_t*) apt_poller_task_timer_create(
 
 static apt_bool_t apt_poller_task_wakeup_process(apt_poller_task_t *task)
 {
-	apt_bool_t running = TRUE;
-	apt_task_msg_t *msg;
+	apt_task_msg_t *batch[APT_POLLER_TASK_MSG_BATCH_SIZE];
+	apr_size_t count;
+	apr_size_t i;
 
 	do {
+		/* pop a batch of messages at once to lock the queue as few times as possible */
 		apr_thread_mutex_lock(task->guard);
-		msg = apt_cyclic_queue_pop(task->msg_queue);
-		apr_thread_mutex_unlock(task->guard);
-		if(msg) {
-			apt_task_msg_process(task->base,msg);
+		for(count = 0; count < APT_POLLER_TASK_MSG_BATCH_SIZE; count++) {
+			batch[count] = apt_cyclic_queue_pop(task->msg_queue);
+			if(!batch[count]) {
+				break;
+			}
 		}
-		else {
-			running = FALSE;
+		apr_thread_mutex_unlock(task->guard);
+
+		for(i = 0; i < count; i++) {
+			apt_task_msg_process(task->base,batch[i]);
 		}
 	}
-	while(running == TRUE);
+	while(count == APT_POLLER_TASK_MSG_BATCH_SIZE);
+
+	if(task->msg_batch_handler) {
+		task->msg_batch_handler(task->obj);
+	}
 	return TRUE;
 }
 
@@ -18,6 +18,329 @@
 #include "apt_pollset.h"
 #include "apt_log.h"
 
+#if defined(__linux__) && !defined(APT_POLLSET_NO_EPOLL)
+/** Use epoll directly with eventfd wakeups (Linux) */
+#define APT_POLLSET_EPOLL
+#endif
+
+#ifdef APT_POLLSET_EPOLL
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <apr_portable.h>
+#include <apr_hash.h>
+#endif
+
+#ifdef APT_POLLSET_EPOLL
+
+/** Registered descriptor */
+typedef struct apt_pollset_elem_t apt_pollset_elem_t;
+struct apt_pollset_elem_t {
+	/** Copy of the registered descriptor */
+	apr_pollfd_t        pfd;
+	/** OS file descriptor (key in the table of registered descriptors) */
+	int                 fd;
+	/** Next element in the free list */
+	apt_pollset_elem_t *next;
+};
+
+struct apt_pollset_t {
+	/** Epoll file descriptor */
+	int                 epoll_fd;
+	/** Eventfd descriptor used for wakeup */
+	int                 event_fd;
+	/** Builtin wakeup poll descriptor */
+	apr_pollfd_t        wakeup_pfd;
+	/** Pollset flags */
+	apr_uint32_t        flags;
+
+	/** Max number of events retrieved at once */
+	apr_uint32_t        size;
+	/** Events retrieved from epoll_wait */
+	struct epoll_event *events;
+	/** Signalled descriptors returned to the caller */
+	apr_pollfd_t       *result_set;
+
+	/** Table of registered descriptors (apt_pollset_elem_t*) by OS file descriptor */
+	apr_hash_t         *elem_table;
+	/** Free list of elements */
+	apt_pollset_elem_t *free_elems;
+
+	/** Pool to allocate memory from */
+	apr_pool_t         *pool;
+};
+
+/** Get OS file descriptor from APR poll descriptor */
+static apt_bool_t apt_pollset_os_fd_get(const apr_pollfd_t *descriptor, int *fd)
+{
+	if(descriptor->desc_type == APR_POLL_SOCKET) {
+		apr_os_sock_t os_sock;
+		if(apr_os_sock_get(&os_sock,descriptor->desc.s) != APR_SUCCESS) {
+			return FALSE;
+		}
+		*fd = os_sock;
+		return TRUE;
+	}
+	if(descriptor->desc_type == APR_POLL_FILE) {
+		apr_os_file_t os_file;
+		if(apr_os_file_get(&os_file,descriptor->desc.f) != APR_SUCCESS) {
+			return FALSE;
+		}
+		*fd = os_file;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+static APR_INLINE apr_uint32_t apt_epoll_events_get(apr_int16_t reqevents)
+{
+	apr_uint32_t events = 0;
+	if(reqevents & APR_POLLIN)
+		events |= EPOLLIN;
+	if(reqevents & APR_POLLPRI)
+		events |= EPOLLPRI;
+	if(reqevents & APR_POLLOUT)
+		events |= EPOLLOUT;
+	return events;
+}
+
+static APR_INLINE apr_int16_t apt_apr_events_get(apr_uint32_t events)
+{
+	apr_int16_t rtnevents = 0;
+	if(events & EPOLLIN)
+		rtnevents |= APR_POLLIN;
+	if(events & EPOLLPRI)
+		rtnevents |= APR_POLLPRI;
+	if(events & EPOLLOUT)
+		rtnevents |= APR_POLLOUT;
+	if(events & EPOLLERR)
+		rtnevents |= APR_POLLERR;
+	if(events & EPOLLHUP)
+		rtnevents |= APR_POLLHUP;
+	return rtnevents;
+}
+
+/** Close descriptors of the pollset on pool cleanup */
+static apr_status_t apt_pollset_cleanup(void *obj)
+{
+	apt_pollset_t *pollset = obj;
+	if(pollset->event_fd != -1) {
+		close(pollset->event_fd);
+		pollset->event_fd = -1;
+	}
+	if(pollset->epoll_fd != -1) {
+		close(pollset->epoll_fd);
+		pollset->epoll_fd = -1;
+	}
+	return APR_SUCCESS;
+}
+
+/** Create interruptable pollset on top of epoll */
+APT_DECLARE(apt_pollset_t*) apt_pollset_create_ex(apr_uint32_t size, apr_uint32_t flags, apr_pool_t *pool)
+{
+	struct epoll_event event;
+	apt_pollset_t *pollset = apr_palloc(pool,sizeof(apt_pollset_t));
+	pollset->pool = pool;
+	pollset->flags = flags;
+	/* +1 is builtin wakeup descriptor */
+	pollset->size = size + 1;
+	pollset->events = apr_palloc(pool,sizeof(struct epoll_event) * pollset->size);
+	pollset->result_set = apr_palloc(pool,sizeof(apr_pollfd_t) * pollset->size);
+	pollset->elem_table = apr_hash_make(pool);
+	pollset->free_elems = NULL;
+	memset(&pollset->wakeup_pfd,0,sizeof(pollset->wakeup_pfd));
+	pollset->wakeup_pfd.desc_type = APR_NO_DESC;
+	pollset->wakeup_pfd.reqevents = APR_POLLIN;
+	pollset->wakeup_pfd.client_data = pollset;
+
+	pollset->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if(pollset->epoll_fd == -1) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Epoll Descriptor [%d]",errno);
+		return NULL;
+	}
+
+	/* create wakeup descriptor */
+	pollset->event_fd = eventfd(0,EFD_NONBLOCK | EFD_CLOEXEC);
+	if(pollset->event_fd == -1) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Wakeup Eventfd [%d]",errno);
+		close(pollset->epoll_fd);
+		return NULL;
+	}
+
+	/* add wakeup descriptor to pollset, NULL data identifies it */
+	memset(&event,0,sizeof(event));
+	event.events = EPOLLIN;
+	if(flags & APT_POLLSET_FLAG_EDGE_TRIGGERED) {
+		event.events |= EPOLLET;
+	}
+	event.data.ptr = NULL;
+	if(epoll_ctl(pollset->epoll_fd,EPOLL_CTL_ADD,pollset->event_fd,&event) != 0) {
+		close(pollset->event_fd);
+		close(pollset->epoll_fd);
+		return NULL;
+	}
+
+	apr_pool_cleanup_register(pool,pollset,apt_pollset_cleanup,apr_pool_cleanup_null);
+	return pollset;
+}
+
+/** Destroy pollset */
+APT_DECLARE(apt_bool_t) apt_pollset_destroy(apt_pollset_t *pollset)
+{
+	apr_pool_cleanup_run(pollset->pool,pollset,apt_pollset_cleanup);
+	return TRUE;
+}
+
+/** Add pollset descriptor to a pollset */
+APT_DECLARE(apt_bool_t) apt_pollset_add(apt_pollset_t *pollset, const apr_pollfd_t *descriptor)
+{
+	struct epoll_event event;
+	apt_pollset_elem_t *elem;
+	apt_bool_t registered = FALSE;
+	int fd;
+	if(apt_pollset_os_fd_get(descriptor,&fd) == FALSE) {
+		return FALSE;
+	}
+
+	elem = apr_hash_get(pollset->elem_table,&fd,sizeof(fd));
+	if(elem) {
+		/* the descriptor is either added twice, which is rejected by epoll, or has been closed
+		without removal and the number reused, in which case the element is reused as well */
+		registered = TRUE;
+	}
+	else {
+		elem = pollset->free_elems;
+		if(elem) {
+			pollset->free_elems = elem->next;
+		}
+		else {
+			elem = apr_palloc(pollset->pool,sizeof(apt_pollset_elem_t));
+		}
+	}
+
+	memset(&event,0,sizeof(event));
+	event.events = apt_epoll_events_get(descriptor->reqevents);
+	if(pollset->flags & APT_POLLSET_FLAG_EDGE_TRIGGERED) {
+		event.events |= EPOLLET;
+	}
+	event.data.ptr = elem;
+	if(epoll_ctl(pollset->epoll_fd,EPOLL_CTL_ADD,fd,&event) != 0) {
+		if(registered == TRUE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Descriptor Already Added to Pollset [%d]",fd);
+		}
+		else {
+			elem->next = pollset->free_elems;
+			pollset->free_elems = elem;
+		}
+		return FALSE;
+	}
+
+	elem->pfd = *descriptor;
+	elem->fd = fd;
+	elem->next = NULL;
+	if(registered == FALSE) {
+		apr_hash_set(pollset->elem_table,&elem->fd,sizeof(elem->fd),elem);
+	}
+	return TRUE;
+}
+
+/** Remove pollset descriptor from a pollset */
+APT_DECLARE(apt_bool_t) apt_pollset_remove(apt_pollset_t *pollset, const apr_pollfd_t *descriptor)
+{
+	struct epoll_event event;
+	apt_pollset_elem_t *elem;
+	int fd;
+	if(apt_pollset_os_fd_get(descriptor,&fd) == FALSE) {
+		return FALSE;
+	}
+
+	elem = apr_hash_get(pollset->elem_table,&fd,sizeof(fd));
+	if(!elem) {
+		return FALSE;
+	}
+	apr_hash_set(pollset->elem_table,&fd,sizeof(fd),NULL);
+
+	/* events signalled before are already copied to the result set, the element can be reused right away */
+	elem->next = pollset->free_elems;
+	pollset->free_elems = elem;
+
+	/* non-NULL event is required by kernels before 2.6.9 */
+	memset(&event,0,sizeof(event));
+	return (epoll_ctl(pollset->epoll_fd,EPOLL_CTL_DEL,fd,&event) == 0) ? TRUE : FALSE;
+}
+
+/** Block for activity on the descriptor(s) in a pollset */
+APT_DECLARE(apr_status_t) apt_pollset_poll(
+								apt_pollset_t *pollset,
+								apr_interval_time_t timeout,
+								apr_int32_t *num,
+								const apr_pollfd_t **descriptors)
+{
+	int i;
+	int count;
+	apt_pollset_elem_t *elem;
+	apr_pollfd_t *result;
+
+	*num = 0;
+	/* round the timeout up to milliseconds, so that the poll doesn't return before the timeout elapses */
+	count = epoll_wait(pollset->epoll_fd,pollset->events,(int)pollset->size,
+				timeout < 0 ? -1 : (int)((timeout + 999) / 1000));
+	if(count < 0) {
+		return apr_get_netos_error();
+	}
+	if(count == 0) {
+		return APR_TIMEUP;
+	}
+
+	/* copy the whole batch out, descriptors may be removed while the results are being processed */
+	for(i = 0; i < count; i++) {
+		elem = pollset->events[i].data.ptr;
+		result = &pollset->result_set[i];
+		*result = elem ? elem->pfd : pollset->wakeup_pfd;
+		result->rtnevents = apt_apr_events_get(pollset->events[i].events);
+	}
+
+	*num = count;
+	if(descriptors) {
+		*descriptors = pollset->result_set;
+	}
+	return APR_SUCCESS;
+}
+
+/** Interrupt the blocked poll call */
+APT_DECLARE(apt_bool_t) apt_pollset_wakeup(apt_pollset_t *pollset)
+{
+	apr_uint64_t value = 1;
+	if(write(pollset->event_fd,&value,sizeof(value)) != sizeof(value)) {
+		/* EAGAIN means the counter is about to overflow, the poller is signalled anyway */
+		return (errno == EAGAIN) ? TRUE : FALSE;
+	}
+	return TRUE;
+}
+
+/** Get the name of the method the pollset is based on */
+APT_DECLARE(const char*) apt_pollset_method_name_get(const apt_pollset_t *pollset)
+{
+	return (pollset->flags & APT_POLLSET_FLAG_EDGE_TRIGGERED) ? "epoll-et" : "epoll";
+}
+
+/** Match against builtin wake up descriptor in a pollset */
+APT_DECLARE(apt_bool_t) apt_pollset_is_wakeup(apt_pollset_t *pollset, const apr_pollfd_t *descriptor)
+{
+	if(descriptor->desc_type == APR_NO_DESC && descriptor->client_data == pollset) {
+		apr_uint64_t value;
+		/* reading resets the counter, no matter how many times the poller has been signalled */
+		if(read(pollset->event_fd,&value,sizeof(value)) < 0) {
+			/* nothing to read out */
+		}
+		return TRUE;
+	}
+	return FALSE;
+}
+
+#else /* APT_POLLSET_EPOLL */
+
 struct apt_pollset_t {
 	/** APR pollset */
 	apr_pollset_t *base;
@@ -39,9 +362,12 @@ static apt_bool_t apt_wakeup_pipe_create(apt_pollset_t *pollset);
 static apt_bool_t apt_wakeup_pipe_destroy(apt_pollset_t *pollset);
 
 /** Create interruptable pollset on top of APR pollset */
-APT_DECLARE(apt_pollset_t*) apt_pollset_create(apr_uint32_t size, apr_pool_t *pool)
+APT_DECLARE(apt_pollset_t*) apt_pollset_create_ex(apr_uint32_t size, apr_uint32_t flags, apr_pool_t *pool)
 {
 	apt_pollset_t *pollset = apr_palloc(pool,sizeof(apt_pollset_t));
+	if(flags & APT_POLLSET_FLAG_EDGE_TRIGGERED) {
+		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Edge-Triggered Mode Not Supported by Pollset, Fall Back to Level-Triggered");
+	}
 	pollset->pool = pool;
 	memset(&pollset->wakeup_pfd,0,sizeof(pollset->wakeup_pfd));
 	
@@ -118,6 +444,12 @@ APT_DECLARE(apt_bool_t) apt_pollset_wakeup(apt_pollset_t *pollset)
 	return status;
 }
 
+/** Get the name of the method the pollset is based on */
+APT_DECLARE(const char*) apt_pollset_method_name_get(const apt_pollset_t *pollset)
+{
+	return "apr";
+}
+
 /** Match against builtin wake up descriptor in a pollset */
 APT_DECLARE(apt_bool_t) apt_pollset_is_wakeup(apt_pollset_t *pollset, const apr_pollfd_t *descriptor)
 {
@@ -321,3 +653,11 @@ static apt_bool_t apt_wakeup_pipe_destroy(apt_pollset_t *pollset)
 }
 
 #endif
+
+#endif /* APT_POLLSET_EPOLL */
+
+/** Create interruptable pollset */
+APT_DECLARE(apt_pollset_t*) apt_pollset_create(apr_uint32_t size, apr_pool_t *pool)
+{
+	return apt_pollset_create_ex(size,0,pool);
+}
@@ -14,10 +14,27 @@
  * limitations under the License.
  */
 
+#include <string.h>
+#include <apr_thread_mutex.h>
+#include <apr_atomic.h>
 #include "apt_pool.h"
 #include "apt_log.h"
 
-#define OWN_ALLOCATOR_PER_POOL
+/** Allocator type used by apt_pool_create() */
+static apt_pool_allocator_e default_allocator_type = APT_POOL_ALLOCATOR_OWN;
+/** Max free memory retained by allocators (0 - unlimited) */
+static apr_size_t default_max_free = 0;
+
+/** Number of pools created per allocator type */
+static apr_uint32_t created_counters[APT_POOL_ALLOCATOR_COUNT];
+/** Number of pools currently in use per allocator type */
+static apr_uint32_t active_counters[APT_POOL_ALLOCATOR_COUNT];
+
+static const char *allocator_type_names[APT_POOL_ALLOCATOR_COUNT] = {
+	"own",
+	"unlocked",
+	"shared"
+};
 
 static int apt_abort_fn(int retcode)
 {
@@ -25,31 +42,238 @@ static int apt_abort_fn(int retcode)
 	return 0;
 }
 
+static apr_status_t apt_pool_counter_cleanup(void *data)
+{
+	apr_atomic_dec32(data);
+	return APR_SUCCESS;
+}
+
 APT_DECLARE(apr_pool_t*) apt_pool_create()
 {
-	apr_pool_t *pool = NULL;
+	return apt_pool_create_ex(default_allocator_type,default_max_free);
+}
 
-#ifdef OWN_ALLOCATOR_PER_POOL
+APT_DECLARE(apr_pool_t*) apt_pool_create_ex(apt_pool_allocator_e type, apr_size_t max_free)
+{
+	apr_pool_t *pool = NULL;
 	apr_allocator_t *allocator = NULL;
 	apr_thread_mutex_t *mutex = NULL;
 
-	if(apr_allocator_create(&allocator) == APR_SUCCESS) {
-		if(apr_pool_create_ex(&pool,NULL,apt_abort_fn,allocator) == APR_SUCCESS) {
+	switch(type) {
+		case APT_POOL_ALLOCATOR_OWN:
+		case APT_POOL_ALLOCATOR_UNLOCKED:
+			if(apr_allocator_create(&allocator) != APR_SUCCESS) {
+				return NULL;
+			}
+			if(apr_pool_create_ex(&pool,NULL,apt_abort_fn,allocator) != APR_SUCCESS) {
+				apr_allocator_destroy(allocator);
+				return NULL;
+			}
 			apr_allocator_owner_set(allocator,pool);
-			apr_thread_mutex_create(&mutex,APR_THREAD_MUTEX_NESTED,pool);
-			apr_allocator_mutex_set(allocator,mutex);
-			apr_pool_mutex_set(pool,mutex); 
-		}
+			if(type == APT_POOL_ALLOCATOR_OWN) {
+				apr_thread_mutex_create(&mutex,APR_THREAD_MUTEX_NESTED,pool);
+				apr_allocator_mutex_set(allocator,mutex);
+				apr_pool_mutex_set(pool,mutex);
+			}
+			if(max_free) {
+				apr_allocator_max_free_set(allocator,max_free);
+			}
+			break;
+		case APT_POOL_ALLOCATOR_SHARED:
+			/* the global allocator of APR is guarded by its own mutex */
+			if(apr_pool_create_ex(&pool,NULL,apt_abort_fn,NULL) != APR_SUCCESS) {
+				return NULL;
+			}
+			break;
+		default:
+			return NULL;
 	}
-#else
-	apr_pool_create(&pool,NULL);
-#endif
+
+	apr_atomic_inc32(&created_counters[type]);
+	apr_atomic_inc32(&active_counters[type]);
+	/* APR has no destroy-only hook, (pre-)cleanups run on apr_pool_clear() too,
+	thus root pools are never cleared, recycled pools are subpools for the same reason */
+	apr_pool_cleanup_register(pool,&active_counters[type],apt_pool_counter_cleanup,apr_pool_cleanup_null);
 	return pool;
 }
 
+APT_DECLARE(apt_bool_t) apt_pool_allocator_default_set(apt_pool_allocator_e type, apr_size_t max_free)
+{
+	apr_pool_t *pool;
+	if(type == APT_POOL_ALLOCATOR_UNLOCKED || type >= APT_POOL_ALLOCATOR_COUNT) {
+		/* pools created by default may be accessed from different threads */
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Default Pool Allocator [%d]",type);
+		return FALSE;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Default Pool Allocator [%s] max-free [%"APR_SIZE_T_FMT"]",
+		allocator_type_names[type],max_free);
+	default_allocator_type = type;
+	default_max_free = max_free;
+	if(type == APT_POOL_ALLOCATOR_SHARED && max_free) {
+		/* the limit of the global allocator is set once for all the pools sharing it */
+		if(apr_pool_create(&pool,NULL) == APR_SUCCESS) {
+			apr_allocator_max_free_set(apr_pool_allocator_get(pool),max_free);
+			apr_pool_destroy(pool);
+		}
+	}
+	return TRUE;
+}
+
+APT_DECLARE(apt_pool_allocator_e) apt_pool_allocator_type_find(const char *name)
+{
+	int i;
+	for(i = 0; i < APT_POOL_ALLOCATOR_COUNT; i++) {
+		if(strcasecmp(allocator_type_names[i],name) == 0) {
+			return i;
+		}
+	}
+	return APT_POOL_ALLOCATOR_COUNT;
+}
+
+APT_DECLARE(const char*) apt_pool_allocator_type_name_get(apt_pool_allocator_e type)
+{
+	if(type >= APT_POOL_ALLOCATOR_COUNT) {
+		return "unknown";
+	}
+	return allocator_type_names[type];
+}
+
+APT_DECLARE(void) apt_pool_stats_get(apt_pool_allocator_e type, apr_size_t *created, apr_size_t *active)
+{
+	if(type >= APT_POOL_ALLOCATOR_COUNT) {
+		return;
+	}
+	if(created) {
+		*created = apr_atomic_read32(&created_counters[type]);
+	}
+	if(active) {
+		*active = apr_atomic_read32(&active_counters[type]);
+	}
+}
+
 APT_DECLARE(apr_pool_t*) apt_subpool_create(apr_pool_t *parent)
 {
 	apr_pool_t *pool = NULL;
 	apr_pool_create(&pool,parent);
 	return pool;
 }
+
+
+/** Pool recycler */
+struct apt_pool_recycler_t {
+	/** Parent pool recycled pools are created from */
+	apr_pool_t         *pool;
+	/** Mutex to protect the freelist */
+	apr_thread_mutex_t *guard;
+	/** Freelist of cleared pools */
+	apr_pool_t        **free_pools;
+	/** Number of pools in the freelist */
+	apr_size_t          free_count;
+	/** Max number of pools in the freelist */
+	apr_size_t          max_count;
+	/** Create each pool with own allocator rather than as a subpool of the recycler's pool */
+	apt_bool_t          own_allocator;
+};
+
+/** Destroy a pool created by the recycler */
+static APR_INLINE void apt_pool_recycler_pool_destroy(apt_pool_recycler_t *recycler, apr_pool_t *pool)
+{
+	if(recycler->own_allocator == TRUE) {
+		/* the pool is a subpool of a root pool, which owns the allocator */
+		pool = apr_pool_parent_get(pool);
+	}
+	apr_pool_destroy(pool);
+}
+
+static apr_status_t apt_pool_recycler_cleanup(void *data)
+{
+	apt_pool_recycler_t *recycler = data;
+	if(recycler->own_allocator == TRUE) {
+		while(recycler->free_count) {
+			apt_pool_recycler_pool_destroy(recycler,recycler->free_pools[--recycler->free_count]);
+		}
+	}
+	apr_pool_destroy(recycler->pool);
+	return APR_SUCCESS;
+}
+
+APT_DECLARE(apt_pool_recycler_t*) apt_pool_recycler_create(apr_size_t max_count, apr_pool_t *pool)
+{
+	return apt_pool_recycler_create_ex(max_count,FALSE,pool);
+}
+
+APT_DECLARE(apt_pool_recycler_t*) apt_pool_recycler_create_ex(apr_size_t max_count, apt_bool_t own_allocator, apr_pool_t *pool)
+{
+	apt_pool_recycler_t *recycler = apr_palloc(pool,sizeof(apt_pool_recycler_t));
+	recycler->pool = apt_pool_create();
+	if(!recycler->pool) {
+		return NULL;
+	}
+
+	recycler->guard = NULL;
+	recycler->free_count = 0;
+	recycler->max_count = max_count;
+	recycler->own_allocator = own_allocator;
+	recycler->free_pools = NULL;
+	if(max_count) {
+		recycler->free_pools = apr_palloc(recycler->pool,sizeof(apr_pool_t*) * max_count);
+	}
+	if(apr_thread_mutex_create(&recycler->guard,APR_THREAD_MUTEX_DEFAULT,recycler->pool) != APR_SUCCESS) {
+		apr_pool_destroy(recycler->pool);
+		return NULL;
+	}
+
+	apr_pool_cleanup_register(pool,recycler,apt_pool_recycler_cleanup,apr_pool_cleanup_null);
+	return recycler;
+}
+
+APT_DECLARE(apr_pool_t*) apt_pool_recycler_acquire(apt_pool_recycler_t *recycler)
+{
+	apr_pool_t *pool = NULL;
+	apr_thread_mutex_lock(recycler->guard);
+	if(recycler->free_count) {
+		pool = recycler->free_pools[--recycler->free_count];
+	}
+	apr_thread_mutex_unlock(recycler->guard);
+
+	if(!pool) {
+		if(recycler->own_allocator == TRUE) {
+			/* the pools don't contend for a single allocator, the root pool owning the allocator
+			is not handed out, since clearing it would destroy the mutex of the allocator */
+			apr_pool_t *root = apt_pool_create();
+			if(root) {
+				pool = apt_subpool_create(root);
+				if(!pool) {
+					apr_pool_destroy(root);
+				}
+			}
+		}
+		else {
+			/* parent pool has own allocator with mutex set, subpools can be created from any thread */
+			pool = apt_subpool_create(recycler->pool);
+		}
+	}
+	return pool;
+}
+
+APT_DECLARE(void) apt_pool_recycler_release(apt_pool_recycler_t *recycler, apr_pool_t *pool)
+{
+	if(!pool) {
+		return;
+	}
+
+	/* clear the pool outside of the lock, the first memory block is retained by the pool */
+	apr_pool_clear(pool);
+
+	apr_thread_mutex_lock(recycler->guard);
+	if(recycler->free_count < recycler->max_count) {
+		recycler->free_pools[recycler->free_count++] = pool;
+		pool = NULL;
+	}
+	apr_thread_mutex_unlock(recycler->guard);
+
+	if(pool) {
+		apt_pool_recycler_pool_destroy(recycler,pool);
+	}
+}
@@ -48,23 +48,28 @@ struct apt_message_generator_t {
 	apt_bool_t                            verbose;
 };
 
-/** Parse individual header field (name-value pair) */
-APT_DECLARE(apt_header_field_t*) apt_header_field_parse(apt_text_stream_t *stream, apr_pool_t *pool)
+/** Read name-value pair of the header field along with the folding lines (if any) */
+static apt_bool_t apt_header_pair_read(apt_text_stream_t *stream, apt_pair_t *pair, apr_array_header_t **folded_lines, apr_size_t *folding_length, apr_pool_t *pool)
 {
-	apr_size_t folding_length = 0;
-	apr_array_header_t *folded_lines = NULL;
-	apt_header_field_t *header_field;
 	apt_str_t temp_line;
 	apt_str_t *line;
-	apt_pair_t pair;
+	char *start = stream->pos;
+	*folded_lines = NULL;
+	*folding_length = 0;
 	/* read name-value pair */
-	if(apt_text_header_read(stream,&pair) == FALSE) {
-		return NULL;
+	if(apt_text_header_read(stream,pair) == FALSE) {
+		return FALSE;
 	}
 
-	if (apt_string_is_empty(&pair.name) == FALSE) {
+	if (apt_string_is_empty(&pair->name) == FALSE) {
 		/* check folding lines (value spanning multiple lines) */
-		while (stream->pos < stream->end) {
+		for(;;) {
+			if (stream->pos >= stream->end) {
+				/* the next line may fold the value, read the field again once it is received */
+				stream->pos = start;
+				stream->is_eos = TRUE;
+				return FALSE;
+			}
 			if (apt_text_is_wsp(*stream->pos) == FALSE) {
 				break;
 			}
@@ -74,36 +79,36 @@ APT_DECLARE(apt_header_field_t*) apt_header_field_parse(apt_text_stream_t *strea
 			/* skip further white spaces (if any) */
 			apt_text_white_spaces_skip(stream);
 
-			if (!folded_lines) {
-				folded_lines = apr_array_make(pool, 1, sizeof(apt_str_t));
+			if (apt_text_line_read(stream, &temp_line) == FALSE) {
+				/* the folding line is incomplete */
+				stream->pos = start;
+				return FALSE;
 			}
-			if (apt_text_line_read(stream, &temp_line) == TRUE) {
-				line = apr_array_push(folded_lines);
-				*line = temp_line;
-				folding_length += line->length;
+			if (!*folded_lines) {
+				*folded_lines = apr_array_make(pool, 1, sizeof(apt_str_t));
 			}
+			line = apr_array_push(*folded_lines);
+			*line = temp_line;
+			*folding_length += line->length;
 		}
 	}
+	return TRUE;
+}
 
-	header_field = apt_header_field_alloc(pool);
-	/* copy parsed name of the header field */
-	header_field->name.length = pair.name.length;
-	header_field->name.buf = apr_palloc(pool, pair.name.length + 1);
-	if(pair.name.length) {
-		memcpy(header_field->name.buf, pair.name.buf, pair.name.length);
-	}
-	header_field->name.buf[header_field->name.length] = '\0';
-
+/** Copy value of the header field */
+static void apt_header_value_copy(apt_header_field_t *header_field, const apt_str_t *value, const apr_array_header_t *folded_lines, apr_size_t folding_length, apr_pool_t *pool)
+{
 	/* copy parsed value of the header field */
-	header_field->value.length = pair.value.length + folding_length;
+	header_field->value.length = value->length + folding_length;
 	header_field->value.buf = apr_palloc(pool, header_field->value.length + 1);
-	if(pair.value.length) {
-		memcpy(header_field->value.buf, pair.value.buf, pair.value.length);
+	if(value->length) {
+		memcpy(header_field->value.buf, value->buf, value->length);
 	}
 
 	if(folding_length) {
 		int i;
-		char *pos = header_field->value.buf + pair.value.length;
+		const apt_str_t *line;
+		char *pos = header_field->value.buf + value->length;
 		/* copy parsed folding lines */
 		for(i=0; i<folded_lines->nelts; i++) {
 			line = &APR_ARRAY_IDX(folded_lines,i,apt_str_t);
@@ -113,10 +118,146 @@ APT_DECLARE(apt_header_field_t*) apt_header_field_parse(apt_text_stream_t *strea
 		}
 	}
 	header_field->value.buf[header_field->value.length] = '\0';
+}
+
+/** Parse individual header field (name-value pair) */
+APT_DECLARE(apt_header_field_t*) apt_header_field_parse(apt_text_stream_t *stream, apr_pool_t *pool)
+{
+	apr_size_t folding_length;
+	apr_array_header_t *folded_lines;
+	apt_header_field_t *header_field;
+	apt_pair_t pair;
+	/* read name-value pair */
+	if(apt_header_pair_read(stream,&pair,&folded_lines,&folding_length,pool) == FALSE) {
+		return NULL;
+	}
+
+	header_field = apt_header_field_alloc(pool);
+	/* copy parsed name of the header field */
+	header_field->name.length = pair.name.length;
+	header_field->name.buf = apr_palloc(pool, pair.name.length + 1);
+	if(pair.name.length) {
+		memcpy(header_field->name.buf, pair.name.buf, pair.name.length);
+	}
+	header_field->name.buf[header_field->name.length] = '\0';
+
+	/* copy parsed value of the header field */
+	apt_header_value_copy(header_field,&pair.value,folded_lines,folding_length,pool);
+	return header_field;
+}
+
+/**
+ * Parse individual header field referencing the name and the value in the stream.
+ * The name and the value are terminated in place, therefore, the stream must be
+ * a private copy living as long as the header field does.
+ */
+static apt_header_field_t* apt_header_field_in_place_parse(apt_text_stream_t *stream, apr_pool_t *pool)
+{
+	apr_size_t folding_length;
+	apr_array_header_t *folded_lines;
+	apt_header_field_t *header_field;
+	apt_pair_t pair;
+	/* read name-value pair */
+	if(apt_header_pair_read(stream,&pair,&folded_lines,&folding_length,pool) == FALSE) {
+		return NULL;
+	}
+
+	header_field = apt_header_field_alloc(pool);
+	if(!pair.name.length) {
+		/* empty header */
+		apt_string_set(&header_field->name,"");
+		apt_string_set(&header_field->value,"");
+		return header_field;
+	}
+
+	/* the name is followed by the separator ':' */
+	header_field->name = pair.name;
+	header_field->name.buf[header_field->name.length] = '\0';
 
+	if(folding_length) {
+		apt_header_value_copy(header_field,&pair.value,folded_lines,folding_length,pool);
+	}
+	else if(pair.value.length) {
+		/* the value is followed by the end of line */
+		header_field->value = pair.value;
+		header_field->value.buf[header_field->value.length] = '\0';
+	}
+	else {
+		/* reference the terminated separator */
+		header_field->value.buf = header_field->name.buf + header_field->name.length;
+		header_field->value.length = 0;
+	}
 	return header_field;
 }
 
+/** Find the end of complete header section (the position following the empty line) */
+static const char* apt_header_section_end_find(const apt_text_stream_t *stream)
+{
+	const char *pos = stream->pos;
+	const char *line = pos;
+	while(pos < stream->end) {
+		if(*pos == APT_TOKEN_CR || *pos == APT_TOKEN_LF) {
+			apt_bool_t empty = (pos == line) ? TRUE : FALSE;
+			if(*pos == APT_TOKEN_CR) {
+				if(pos + 1 >= stream->end) {
+					/* <LF> might follow in the next segment */
+					return NULL;
+				}
+				if(*(pos + 1) == APT_TOKEN_LF) {
+					pos++;
+				}
+			}
+			pos++;
+			if(empty == TRUE) {
+				return pos;
+			}
+			line = pos;
+			continue;
+		}
+		pos++;
+	}
+	return NULL;
+}
+
+/**
+ * Parse complete header section from a single private copy of it, the header fields
+ * reference instead of copying the names and the values of their own.
+ */
+static apt_bool_t apt_header_section_in_place_parse(apt_header_section_t *header, apt_text_stream_t *stream, const char *section_end, apr_pool_t *pool)
+{
+	apt_header_field_t *header_field;
+	apt_text_stream_t section;
+	apt_bool_t result = FALSE;
+	apr_size_t length = section_end - stream->pos;
+
+	section.text.buf = apr_palloc(pool,length);
+	section.text.length = length;
+	memcpy(section.text.buf,stream->pos,length);
+	apt_text_stream_reset(&section);
+
+	do {
+		header_field = apt_header_field_in_place_parse(&section,pool);
+		if(header_field) {
+			if(apt_string_is_empty(&header_field->name) == FALSE) {
+				/* normal header */
+				apt_header_section_field_add(header,header_field);
+			}
+			else {
+				/* empty header => exit */
+				result = TRUE;
+				break;
+			}
+		}
+		else {
+			/* malformed header => skip to the next one */
+		}
+	}
+	while(apt_text_is_eos(&section) == FALSE);
+
+	stream->pos += section.pos - section.text.buf;
+	return result;
+}
+
 /** Generate individual header field (name-value pair) */
 APT_DECLARE(apt_bool_t) apt_header_field_generate(const apt_header_field_t *header_field, apt_text_stream_t *stream)
 {
@@ -183,7 +324,7 @@ static apt_bool_t apt_message_body_read(apt_message_parser_t *parser, apt_text_s
 		stream->pos += required_length;
 		if(parser->verbose == TRUE) {
 			apr_size_t length = required_length;
-			const char *masked_data = apt_log_data_mask(stream->pos,&length,parser->pool);
+			const char *masked_data = apt_log_data_mask(stream->pos,&length,parser->context.pool);
 			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Parsed Message Body [%"APR_SIZE_T_FMT" bytes]\n%.*s",
 					required_length, length, masked_data);
 		}
@@ -234,6 +375,7 @@ APT_DECLARE(apt_message_parser_t*) apt_message_parser_create(void *obj, const ap
 	parser->context.message = NULL;
 	parser->context.body = NULL;
 	parser->context.header = NULL;
+	parser->context.pool = pool;
 	parser->content_length = 0;
 	parser->stage = APT_MESSAGE_STAGE_START_LINE;
 	parser->skip_lf = FALSE;
@@ -241,6 +383,18 @@ APT_DECLARE(apt_message_parser_t*) apt_message_parser_create(void *obj, const ap
 	return parser;
 }
 
+/** Reset parser to start with a new message */
+APT_DECLARE(void) apt_message_parser_reset(apt_message_parser_t *parser)
+{
+	parser->context.message = NULL;
+	parser->context.body = NULL;
+	parser->context.header = NULL;
+	parser->context.pool = parser->pool;
+	parser->content_length = 0;
+	parser->stage = APT_MESSAGE_STAGE_START_LINE;
+	parser->skip_lf = FALSE;
+}
+
 static APR_INLINE void apt_crlf_segmentation_test(apt_message_parser_t *parser, apt_text_stream_t *stream)
 {
 	/* in the worst case message segmentation may occur between <CR> and <LF> */
@@ -267,6 +421,7 @@ APT_DECLARE(apt_message_status_e) apt_message_parser_run(apt_message_parser_t *p
 	do {
 		pos = stream->pos;
 		if(parser->stage == APT_MESSAGE_STAGE_START_LINE) {
+			parser->context.pool = parser->pool;
 			if(parser->vtable->on_start(parser,&parser->context,stream,parser->pool) == FALSE) {
 				if(apt_text_is_eos(stream) == FALSE) {
 					status = APT_MESSAGE_STATUS_INVALID;
@@ -280,8 +435,15 @@ APT_DECLARE(apt_message_status_e) apt_message_parser_run(apt_message_parser_t *p
 		}
 
 		if(parser->stage == APT_MESSAGE_STAGE_HEADER) {
-			/* read header section */
-			apt_bool_t res = apt_header_section_parse(parser->context.header,stream,parser->pool);
+			/* read header section, at once if it is received completely */
+			apt_bool_t res;
+			const char *section_end = apt_header_section_end_find(stream);
+			if(section_end) {
+				res = apt_header_section_in_place_parse(parser->context.header,stream,section_end,parser->context.pool);
+			}
+			else {
+				res = apt_header_section_parse(parser->context.header,stream,parser->context.pool);
+			}
 			if(parser->verbose == TRUE) {
 				apr_size_t length = stream->pos - pos;
 				apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Parsed Message Header [%"APR_SIZE_T_FMT" bytes]\n%.*s",
@@ -304,7 +466,7 @@ APT_DECLARE(apt_message_status_e) apt_message_parser_run(apt_message_parser_t *p
 			if(parser->context.body && parser->context.body->length) {
 				apt_str_t *body = parser->context.body;
 				parser->content_length = body->length;
-				body->buf = apr_palloc(parser->pool,parser->content_length+1);
+				body->buf = apr_palloc(parser->context.pool,parser->content_length+1);
 				body->buf[parser->content_length] = '\0';
 				body->length = 0;
 				parser->stage = APT_MESSAGE_STAGE_BODY;
@@ -363,6 +525,7 @@ APT_DECLARE(apt_message_generator_t*) apt_message_generator_create(void *obj, co
 	generator->context.message = NULL;
 	generator->context.header = NULL;
 	generator->context.body = NULL;
+	generator->context.pool = pool;
 	generator->content_length = 0;
 	generator->stage = APT_MESSAGE_STAGE_START_LINE;
 	generator->verbose = FALSE;
@@ -356,11 +356,11 @@ APT_DECLARE(apt_bool_t) apt_boolean_value_parse(const apt_str_t *str, apt_bool_t
 	if(!str->buf) {
 		return FALSE;
 	}
-	if(strncasecmp(str->buf,TOKEN_TRUE,TOKEN_TRUE_LENGTH) == 0) {
+	if(str->length >= TOKEN_TRUE_LENGTH && strncasecmp(str->buf,TOKEN_TRUE,TOKEN_TRUE_LENGTH) == 0) {
 		*value = TRUE;
 		return TRUE;
 	}
-	if(strncasecmp(str->buf,TOKEN_FALSE,TOKEN_FALSE_LENGTH) == 0) {
+	if(str->length >= TOKEN_FALSE_LENGTH && strncasecmp(str->buf,TOKEN_FALSE,TOKEN_FALSE_LENGTH) == 0) {
 		*value = FALSE;
 		return TRUE;
 	}
@@ -387,7 +387,24 @@ APT_DECLARE(apt_bool_t) apt_boolean_value_generate(apt_bool_t value, apt_str_t *
 /** Parse apr_size_t value */
 APT_DECLARE(apr_size_t) apt_size_value_parse(const apt_str_t *str)
 {
-	return str->buf ? atol(str->buf) : 0;
+	/* the value is parsed within its length and does not have to be NUL-terminated */
+	apr_size_t value = 0;
+	apt_bool_t negative = FALSE;
+	const char *pos = str->buf;
+	const char *end = str->buf + str->length;
+	if(!pos) {
+		return 0;
+	}
+
+	while(pos < end && apt_text_is_wsp(*pos) == TRUE) pos++;
+	if(pos < end && (*pos == '+' || *pos == '-')) {
+		negative = (*pos == '-') ? TRUE : FALSE;
+		pos++;
+	}
+	for(; pos < end && *pos >= '0' && *pos <= '9'; pos++) {
+		value = value * 10 + (*pos - '0');
+	}
+	return negative == TRUE ? (apr_size_t)(0 - value) : value;
 }
 
 /** Generate apr_size_t value (buffer is allocated from pool) */
@@ -401,10 +418,21 @@ APT_DECLARE(apt_bool_t) apt_size_value_generate(apr_size_t value, apt_str_t *str
 /** Insert apr_size_t value */
 APT_DECLARE(apt_bool_t) apt_text_size_value_insert(apt_text_stream_t *stream, apr_size_t value)
 {
-	int length = apr_snprintf(stream->pos, stream->end - stream->pos, "%"APR_SIZE_T_FMT, value);
-	if(length <= 0) {
+	/* digits are generated backwards, no format is parsed */
+	char digits[24];
+	char *pos = digits + sizeof(digits);
+	apr_size_t length;
+	do {
+		*--pos = (char)('0' + value % 10);
+		value /= 10;
+	}
+	while(value);
+
+	length = digits + sizeof(digits) - pos;
+	if(stream->pos + length >= stream->end) {
 		return FALSE;
 	}
+	memcpy(stream->pos,pos,length);
 	stream->pos += length;
 	return TRUE;
 }
@@ -413,7 +441,18 @@ APT_DECLARE(apt_bool_t) apt_text_size_value_insert(apt_text_stream_t *stream, ap
 /** Parse float value */
 APT_DECLARE(float) apt_float_value_parse(const apt_str_t *str)
 {
-	return str->buf ? (float)atof(str->buf) : 0;
+	/* the value does not have to be NUL-terminated, copy it to the stack */
+	char buf[32];
+	apr_size_t length = str->length;
+	if(!str->buf) {
+		return 0;
+	}
+	if(length >= sizeof(buf)) {
+		length = sizeof(buf) - 1;
+	}
+	memcpy(buf,str->buf,length);
+	buf[length] = '\0';
+	return (float)atof(buf);
 }
 
 /** Generate float value (buffer is allocated from pool) */
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <apr_tables.h>
+#include "apt_text_template.h"
+#include "apt_log.h"
+
+/** Segment of the template */
+typedef struct apt_text_segment_t apt_text_segment_t;
+struct apt_text_segment_t {
+	/** Literal text (if slot is negative) */
+	apt_str_t text;
+	/** Index of the slot to substitute */
+	int       slot;
+};
+
+/** Precompiled text template */
+struct apt_text_template_t {
+	/** Array of segments */
+	apt_text_segment_t *segments;
+	/** Number of segments */
+	apr_size_t          count;
+};
+
+/** Find slot by name */
+static int apt_text_slot_find(const char *name, apr_size_t length, const char * const *slot_names, apr_size_t slot_count)
+{
+	apr_size_t i;
+	for(i=0; i<slot_count; i++) {
+		if(strncmp(slot_names[i],name,length) == 0 && slot_names[i][length] == '\0') {
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+/** Compile text template */
+APT_DECLARE(apt_text_template_t*) apt_text_template_compile(
+									const char *text,
+									const char * const *slot_names,
+									apr_size_t slot_count,
+									apr_pool_t *pool)
+{
+	apt_text_template_t *tmpl;
+	apt_text_segment_t *segment;
+	apr_array_header_t *segments;
+	const char *literal = text;
+	const char *pos = text;
+	const char *end;
+	int slot;
+
+	if(!text) {
+		return NULL;
+	}
+
+	segments = apr_array_make(pool,5,sizeof(apt_text_segment_t));
+	while((pos = strstr(pos,"${")) != NULL) {
+		end = strchr(pos+2,'}');
+		if(!end) {
+			/* not a slot, the rest of the text is literal */
+			break;
+		}
+
+		slot = apt_text_slot_find(pos+2,end-pos-2,slot_names,slot_count);
+		if(slot < 0) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Template Slot [%.*s]",(int)(end-pos-2),pos+2);
+			return NULL;
+		}
+
+		if(pos > literal) {
+			segment = apr_array_push(segments);
+			apt_string_assign_n(&segment->text,literal,pos-literal,pool);
+			segment->slot = -1;
+		}
+		segment = apr_array_push(segments);
+		apt_string_reset(&segment->text);
+		segment->slot = slot;
+
+		pos = literal = end + 1;
+	}
+
+	if(*literal != '\0') {
+		segment = apr_array_push(segments);
+		apt_string_assign(&segment->text,literal,pool);
+		segment->slot = -1;
+	}
+
+	tmpl = apr_palloc(pool,sizeof(apt_text_template_t));
+	tmpl->segments = (apt_text_segment_t*)segments->elts;
+	tmpl->count = segments->nelts;
+	return tmpl;
+}
+
+/** Render text template into text stream */
+APT_DECLARE(apt_bool_t) apt_text_template_render(
+									const apt_text_template_t *tmpl,
+									const apt_str_t *values,
+									apt_text_stream_t *stream)
+{
+	apr_size_t i;
+	const apt_text_segment_t *segment;
+	for(i=0; i<tmpl->count; i++) {
+		segment = &tmpl->segments[i];
+		if(apt_text_string_insert(stream,segment->slot < 0 ? &segment->text : &values[segment->slot]) == FALSE) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/** Render text template into text stream, mark the stream as full, if there is no room left */
+APT_DECLARE(void) apt_text_template_stream_render(
+									const apt_text_template_t *tmpl,
+									const apt_str_t *values,
+									apt_text_stream_t *stream)
+{
+	if(stream->is_eos == TRUE) {
+		return;
+	}
+	if(apt_text_template_render(tmpl,values,stream) == FALSE) {
+		stream->is_eos = TRUE;
+	}
+}
+
+/** Insert text into text stream, mark the stream as full, if there is no room left */
+APT_DECLARE(void) apt_text_template_text_insert(apt_text_stream_t *stream, const char *text, apr_size_t length)
+{
+	apt_str_t str;
+	if(stream->is_eos == TRUE) {
+		return;
+	}
+	str.buf = (char*)text;
+	str.length = length;
+	if(apt_text_string_insert(stream,&str) == FALSE) {
+		stream->is_eos = TRUE;
+	}
+}
+
+/** Insert numeric value into text stream, mark the stream as full, if there is no room left */
+APT_DECLARE(void) apt_text_template_number_insert(apt_text_stream_t *stream, apr_size_t value)
+{
+	if(stream->is_eos == TRUE) {
+		return;
+	}
+	if(apt_text_size_value_insert(stream,value) == FALSE) {
+		stream->is_eos = TRUE;
+	}
+}
+
+/** Format numeric value of a slot */
+APT_DECLARE(void) apt_text_template_number_set(apt_str_t *value, char *buffer, apr_size_t size, apr_size_t number)
+{
+	apt_text_stream_t stream;
+	apt_text_stream_init(&stream,buffer,size);
+	apt_text_size_value_insert(&stream,number);
+	value->buf = buffer;
+	value->length = stream.pos - stream.text.buf;
+}
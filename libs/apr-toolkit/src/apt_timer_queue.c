@@ -21,15 +21,49 @@
 #include "apt_timer_queue.h"
 #include "apt_log.h"
 
-/** Timer queue */
+/** Number of levels (wheels) of the hierarchy */
+#define APT_TIMER_WHEEL_LEVELS  4
+/** Number of bits of time covered by each level */
+#define APT_TIMER_WHEEL_BITS    8
+/** Number of slots per level */
+#define APT_TIMER_WHEEL_SLOTS   (1 << APT_TIMER_WHEEL_BITS)
+/** Slot index mask */
+#define APT_TIMER_WHEEL_MASK    (APT_TIMER_WHEEL_SLOTS - 1)
+/** Number of words in the slot occupancy bitmap */
+#define APT_TIMER_WHEEL_WORDS   (APT_TIMER_WHEEL_SLOTS / 32)
+
+/** Head of the ring of timers in a slot */
+APR_RING_HEAD(apt_timer_head_t, apt_timer_t);
+
+/** Timer wheel (single level of the hierarchy) */
+typedef struct apt_timer_wheel_t apt_timer_wheel_t;
+struct apt_timer_wheel_t {
+	/** Slots of the wheel */
+	struct apt_timer_head_t slots[APT_TIMER_WHEEL_SLOTS];
+	/** Bitmap of non-empty slots */
+	apr_uint32_t            bitmap[APT_TIMER_WHEEL_WORDS];
+	/** Number of timers in the wheel */
+	apr_size_t              count;
+};
+
+/** 
+ * Timer queue implemented as a hierarchical timing wheel.
+ *
+ * Level 0 has a slot per millisecond for the next 256 msec, each upper level
+ * has a slot per full round of the level below it. Timers scheduled to upper
+ * levels are cascaded down as the time advances, so set, kill and advance
+ * do not depend on the number of scheduled timers.
+ */
 struct apt_timer_queue_t {
-	/** Ring head */
-	APR_RING_HEAD(apt_timer_head_t, apt_timer_t) head;
+	/** Levels of the hierarchy */
+	apt_timer_wheel_t wheels[APT_TIMER_WHEEL_LEVELS];
+	/** Number of scheduled timers */
+	apr_size_t        count;
 
 	/** Elapsed time */
-	apr_uint32_t  elapsed_time;
+	apr_uint32_t      elapsed_time;
 	/** Whether elapsed_time is reset or not */
-	apt_bool_t    reset;
+	apt_bool_t        reset;
 };
 
 /** Timer */
@@ -39,8 +73,12 @@ struct apt_timer_t {
 
 	/** Back pointer to queue */
 	apt_timer_queue_t   *queue;
-	/** Time next report is scheduled at */
+	/** Time the timer is scheduled to elapse at */
 	apr_uint32_t         scheduled_time;
+	/** Wheel the timer is currently in, NULL if not scheduled */
+	apt_timer_wheel_t   *wheel;
+	/** Slot of the wheel the timer is currently in */
+	apr_size_t           slot;
 
 	/** Timer proc */
 	apt_timer_proc_f     proc;
@@ -48,15 +86,26 @@ struct apt_timer_t {
 	void                *obj;
 };
 
-static apt_bool_t apt_timer_insert(apt_timer_queue_t *timer_queue, apt_timer_t *timer);
+static void apt_timer_insert(apt_timer_queue_t *timer_queue, apt_timer_t *timer);
+static void apt_timer_unlink(apt_timer_queue_t *timer_queue, apt_timer_t *timer);
 static apt_bool_t apt_timer_remove(apt_timer_queue_t *timer_queue, apt_timer_t *timer);
-static void apt_timers_reschedule(apt_timer_queue_t *timer_queue);
+static void apt_timers_process(apt_timer_queue_t *timer_queue);
 
 /** Create timer queue */
 APT_DECLARE(apt_timer_queue_t*) apt_timer_queue_create(apr_pool_t *pool)
 {
+	apr_size_t level;
+	apr_size_t slot;
 	apt_timer_queue_t *timer_queue = apr_palloc(pool,sizeof(apt_timer_queue_t));
-	APR_RING_INIT(&timer_queue->head, apt_timer_t, link);
+	for(level = 0; level < APT_TIMER_WHEEL_LEVELS; level++) {
+		apt_timer_wheel_t *wheel = &timer_queue->wheels[level];
+		for(slot = 0; slot < APT_TIMER_WHEEL_SLOTS; slot++) {
+			APR_RING_INIT(&wheel->slots[slot], apt_timer_t, link);
+		}
+		memset(wheel->bitmap,0,sizeof(wheel->bitmap));
+		wheel->count = 0;
+	}
+	timer_queue->count = 0;
 	timer_queue->elapsed_time = 0;
 	timer_queue->reset = FALSE;
 	return timer_queue;
@@ -71,9 +120,9 @@ APT_DECLARE(void) apt_timer_queue_destroy(apt_timer_queue_t *timer_queue)
 /** Advance scheduled timers */
 APT_DECLARE(void) apt_timer_queue_advance(apt_timer_queue_t *timer_queue, apr_uint32_t elapsed_time)
 {
-	apt_timer_t *timer;
+	apr_uint32_t skip;
 
-	if(APR_RING_EMPTY(&timer_queue->head, apt_timer_t, link)) {
+	if(!timer_queue->count) {
 		/* just return, nothing to do */
 		return;
 	}
@@ -83,47 +132,69 @@ APT_DECLARE(void) apt_timer_queue_advance(apt_timer_queue_t *timer_queue, apr_ui
 		return;
 	}
 
-	/* increment elapsed time */
-	timer_queue->elapsed_time += elapsed_time;
-	if(timer_queue->elapsed_time >= 0xFFFF) {
-#ifdef APT_TIMER_DEBUG
-		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Reschedule Timers [%u]",timer_queue->elapsed_time);
-#endif
-		apt_timers_reschedule(timer_queue);
-	}
+	while(elapsed_time) {
+		if(!timer_queue->wheels[0].count) {
+			/* nothing to fire till the end of the current round of level 0, skip ahead */
+			skip = APT_TIMER_WHEEL_MASK - (timer_queue->elapsed_time & APT_TIMER_WHEEL_MASK);
+			if(skip >= elapsed_time) {
+				timer_queue->elapsed_time += elapsed_time;
+				break;
+			}
+			timer_queue->elapsed_time += skip;
+			elapsed_time -= skip;
+		}
 
-	/* process timers */
-	do {
-		/* get first node (timer) */
-		timer = APR_RING_FIRST(&timer_queue->head);
+		/* process the next tick */
+		timer_queue->elapsed_time++;
+		elapsed_time--;
+		apt_timers_process(timer_queue);
 
-		if(timer->scheduled_time > timer_queue->elapsed_time) {
-			/* scheduled time is not elapsed yet */
+		if(!timer_queue->count || timer_queue->reset == TRUE) {
 			break;
 		}
-
-#ifdef APT_TIMER_DEBUG
-		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Timer Elapsed 0x%x [%u]",timer,timer->scheduled_time);
-#endif
-		/* remove the elapsed timer from the list */
-		APR_RING_REMOVE(timer, link);
-		timer->scheduled_time = 0;
-		/* process the elapsed timer */
-		timer->proc(timer,timer->obj);
 	}
-	while(!APR_RING_EMPTY(&timer_queue->head, apt_timer_t, link));
 }
 
 /** Is timer queue empty */
 APT_DECLARE(apt_bool_t) apt_timer_queue_is_empty(const apt_timer_queue_t *timer_queue)
 {
-	return APR_RING_EMPTY(&timer_queue->head, apt_timer_t, link) ? TRUE : FALSE;
+	return timer_queue->count ? FALSE : TRUE;
+}
+
+/** Find the first non-empty slot following the specified one, wrapping around the wheel */
+static apr_size_t apt_timer_wheel_slot_find(const apt_timer_wheel_t *wheel, apr_size_t slot)
+{
+	apr_size_t index = (slot + 1) & APT_TIMER_WHEEL_MASK;
+	apr_size_t scanned = 0;
+	apr_uint32_t word;
+	while(scanned < APT_TIMER_WHEEL_SLOTS) {
+		word = wheel->bitmap[index >> 5] >> (index & 31);
+		if(!word) {
+			/* skip the rest of the word */
+			scanned += 32 - (index & 31);
+			index = ((index | 31) + 1) & APT_TIMER_WHEEL_MASK;
+			continue;
+		}
+		while(!(word & 1)) {
+			word >>= 1;
+			index++;
+		}
+		return index;
+	}
+	return slot;
 }
 
 /** Get current timeout */
 APT_DECLARE(apt_bool_t) apt_timer_queue_timeout_get(apt_timer_queue_t *timer_queue, apr_uint32_t *timeout)
 {
+	apr_size_t level;
+	apr_size_t slot;
+	apr_uint32_t delta;
+	apr_uint32_t min_delta = 0;
+	apt_bool_t found = FALSE;
+	apt_timer_wheel_t *wheel;
 	apt_timer_t *timer;
+	struct apt_timer_head_t *head;
 
 	/* clear reset flag, if set */
 	if(timer_queue->reset == TRUE) {
@@ -131,17 +202,42 @@ APT_DECLARE(apt_bool_t) apt_timer_queue_timeout_get(apt_timer_queue_t *timer_que
 	}
 
 	/* is queue empty */
-	if(APR_RING_EMPTY(&timer_queue->head, apt_timer_t, link)) {
+	if(!timer_queue->count) {
 		return FALSE;
 	}
 
-	/* get first node (timer) */
-	timer = APR_RING_FIRST(&timer_queue->head);
-	if(!timer) {
+	/* the first non-empty slot of each level holds the nearest timers of that level,
+	while a timer of an upper level may still elapse prior to a timer of a lower one */
+	for(level = 0; level < APT_TIMER_WHEEL_LEVELS; level++) {
+		wheel = &timer_queue->wheels[level];
+		if(!wheel->count) {
+			continue;
+		}
+
+		slot = apt_timer_wheel_slot_find(wheel,
+			(timer_queue->elapsed_time >> (APT_TIMER_WHEEL_BITS * level)) & APT_TIMER_WHEEL_MASK);
+		head = &wheel->slots[slot];
+		for(timer = APR_RING_FIRST(head);
+				timer != APR_RING_SENTINEL(head, apt_timer_t, link);
+					timer = APR_RING_NEXT(timer, link)) {
+
+			delta = timer->scheduled_time - timer_queue->elapsed_time;
+			if(found == FALSE || delta < min_delta) {
+				min_delta = delta;
+				found = TRUE;
+			}
+			if(level == 0) {
+				/* all the timers of a level 0 slot elapse at the same time */
+				break;
+			}
+		}
+	}
+
+	if(found == FALSE) {
 		return FALSE;
 	}
 
-	*timeout = timer->scheduled_time - timer_queue->elapsed_time;
+	*timeout = min_delta;
 	return TRUE;
 }
 
@@ -152,6 +248,8 @@ APT_DECLARE(apt_timer_t*) apt_timer_create(apt_timer_queue_t *timer_queue, apt_t
 	APR_RING_ELEM_INIT(timer,link);
 	timer->queue = timer_queue;
 	timer->scheduled_time = 0;
+	timer->wheel = NULL;
+	timer->slot = 0;
 	timer->proc = proc;
 	timer->obj = obj;
 	return timer;
@@ -166,7 +264,7 @@ APT_DECLARE(apt_bool_t) apt_timer_set(apt_timer_t *timer, apr_uint32_t timeout)
 		return FALSE;
 	}
 
-	if(timer->scheduled_time) {
+	if(timer->wheel) {
 		/* remove timer first */
 		apt_timer_remove(queue,timer);
 	}
@@ -176,19 +274,14 @@ APT_DECLARE(apt_bool_t) apt_timer_set(apt_timer_t *timer, apr_uint32_t timeout)
 #ifdef APT_TIMER_DEBUG
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Set Timer 0x%x [%u]",timer,timer->scheduled_time);
 #endif
-	if(APR_RING_EMPTY(&queue->head, apt_timer_t, link)) {
-		APR_RING_INSERT_TAIL(&queue->head,timer,apt_timer_t,link);
-		return TRUE;
-	}
-
-	/* insert new node (timer) to sorted by scheduled time list */
-	return apt_timer_insert(queue,timer);
+	apt_timer_insert(queue,timer);
+	return TRUE;
 }
 
 /** Kill timer */
 APT_DECLARE(apt_bool_t) apt_timer_kill(apt_timer_t *timer)
 {
-	if(!timer->scheduled_time) {
+	if(!timer->wheel) {
 		return FALSE;
 	}
 
@@ -198,29 +291,52 @@ APT_DECLARE(apt_bool_t) apt_timer_kill(apt_timer_t *timer)
 	return apt_timer_remove(timer->queue,timer);
 }
 
-static apt_bool_t apt_timer_insert(apt_timer_queue_t *timer_queue, apt_timer_t *timer)
+static void apt_timer_insert(apt_timer_queue_t *timer_queue, apt_timer_t *timer)
 {
-	apt_timer_t *it;
-	for(it = APR_RING_LAST(&timer_queue->head);
-			it != APR_RING_SENTINEL(&timer_queue->head, apt_timer_t, link);
-				it = APR_RING_PREV(it, link)) {
-		
-		if(it->scheduled_time <= timer->scheduled_time) {
-			APR_RING_INSERT_AFTER(it,timer,link);
-			return TRUE;
+	apt_timer_wheel_t *wheel;
+	apr_size_t level;
+	apr_size_t slot;
+	apr_uint32_t delta = timer->scheduled_time - timer_queue->elapsed_time;
+
+	/* select the lowest level covering the time to elapse */
+	for(level = 0; level < APT_TIMER_WHEEL_LEVELS - 1; level++) {
+		if(delta < ((apr_uint32_t)1 << (APT_TIMER_WHEEL_BITS * (level + 1)))) {
+			break;
 		}
 	}
-	APR_RING_INSERT_HEAD(&timer_queue->head,timer,apt_timer_t,link);
-	return TRUE;
+
+	slot = (timer->scheduled_time >> (APT_TIMER_WHEEL_BITS * level)) & APT_TIMER_WHEEL_MASK;
+	wheel = &timer_queue->wheels[level];
+	APR_RING_INSERT_TAIL(&wheel->slots[slot],timer,apt_timer_t,link);
+	wheel->bitmap[slot >> 5] |= (apr_uint32_t)1 << (slot & 31);
+	wheel->count++;
+	timer_queue->count++;
+
+	timer->wheel = wheel;
+	timer->slot = slot;
 }
 
-static apt_bool_t apt_timer_remove(apt_timer_queue_t *timer_queue, apt_timer_t *timer)
+static void apt_timer_unlink(apt_timer_queue_t *timer_queue, apt_timer_t *timer)
 {
-	/* remove node (timer) from the list */
+	apt_timer_wheel_t *wheel = timer->wheel;
+
+	/* remove node (timer) from the slot */
 	APR_RING_REMOVE(timer,link);
+	if(APR_RING_EMPTY(&wheel->slots[timer->slot], apt_timer_t, link)) {
+		wheel->bitmap[timer->slot >> 5] &= ~((apr_uint32_t)1 << (timer->slot & 31));
+	}
+	wheel->count--;
+	timer_queue->count--;
+
+	timer->wheel = NULL;
+}
+
+static apt_bool_t apt_timer_remove(apt_timer_queue_t *timer_queue, apt_timer_t *timer)
+{
+	apt_timer_unlink(timer_queue,timer);
 	timer->scheduled_time = 0;
 
-	if(APR_RING_EMPTY(&timer_queue->head, apt_timer_t, link)) {
+	if(!timer_queue->count) {
 		/* reset elapsed time if no timers set */
 		timer_queue->elapsed_time = 0;
 		/* set reset flag */
@@ -229,14 +345,41 @@ static apt_bool_t apt_timer_remove(apt_timer_queue_t *timer_queue, apt_timer_t *
 	return TRUE;
 }
 
-static void apt_timers_reschedule(apt_timer_queue_t *timer_queue)
+static void apt_timers_process(apt_timer_queue_t *timer_queue)
 {
-	apt_timer_t *it;
-	for(it = APR_RING_LAST(&timer_queue->head);
-			it != APR_RING_SENTINEL(&timer_queue->head, apt_timer_t, link);
-				it = APR_RING_PREV(it, link)) {
+	apt_timer_t *timer;
+	apt_timer_wheel_t *wheel;
+	struct apt_timer_head_t *head;
+	apr_size_t level;
+	apr_uint32_t time = timer_queue->elapsed_time;
+
+	/* cascade timers of upper levels down, as the levels below them complete a round */
+	for(level = 1; level < APT_TIMER_WHEEL_LEVELS; level++) {
+		if(time & (((apr_uint32_t)1 << (APT_TIMER_WHEEL_BITS * level)) - 1)) {
+			break;
+		}
 
-		it->scheduled_time -= timer_queue->elapsed_time;
+		wheel = &timer_queue->wheels[level];
+		head = &wheel->slots[(time >> (APT_TIMER_WHEEL_BITS * level)) & APT_TIMER_WHEEL_MASK];
+		while(!APR_RING_EMPTY(head, apt_timer_t, link)) {
+			timer = APR_RING_FIRST(head);
+			apt_timer_unlink(timer_queue,timer);
+			apt_timer_insert(timer_queue,timer);
+		}
+	}
+
+	/* process elapsed timers, if a callback resets the elapsed time (kills the last timer),
+	the timers set afterwards may land in the same slot, those must not be fired now */
+	head = &timer_queue->wheels[0].slots[time & APT_TIMER_WHEEL_MASK];
+	while(timer_queue->reset == FALSE && !APR_RING_EMPTY(head, apt_timer_t, link)) {
+		timer = APR_RING_FIRST(head);
+#ifdef APT_TIMER_DEBUG
+		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Timer Elapsed 0x%x [%u]",timer,timer->scheduled_time);
+#endif
+		/* remove the elapsed timer from the wheel */
+		apt_timer_unlink(timer_queue,timer);
+		timer->scheduled_time = 0;
+		/* process the elapsed timer */
+		timer->proc(timer,timer->obj);
 	}
-	timer_queue->elapsed_time = 0;
 }
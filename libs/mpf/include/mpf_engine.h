@@ -157,6 +157,12 @@ MPF_DECLARE(apt_bool_t) mpf_engine_scheduler_rate_set(mpf_engine_t *engine, unsi
  */
 MPF_DECLARE(const char*) mpf_engine_id_get(const mpf_engine_t *engine);
 
+/**
+ * Get the number of media processing ticks which took longer than the scheduler resolution.
+ * @param engine the engine to get the counter of
+ */
+MPF_DECLARE(apr_size_t) mpf_engine_overrun_count_get(const mpf_engine_t *engine);
+
 
 APT_END_EXTERN_C
 
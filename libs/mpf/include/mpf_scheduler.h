@@ -60,6 +60,9 @@ MPF_DECLARE(apt_bool_t) mpf_scheduler_start(mpf_scheduler_t *scheduler);
 /** Stop scheduler */
 MPF_DECLARE(apt_bool_t) mpf_scheduler_stop(mpf_scheduler_t *scheduler);
 
+/** Get the number of media processing ticks which took longer than the resolution */
+MPF_DECLARE(apr_size_t) mpf_scheduler_overrun_count_get(const mpf_scheduler_t *scheduler);
+
 
 APT_END_EXTERN_C
 
@@ -450,3 +450,8 @@ MPF_DECLARE(const char*) mpf_engine_id_get(const mpf_engine_t *engine)
 {
 	return apt_task_name_get(engine->task);
 }
+
+MPF_DECLARE(apr_size_t) mpf_engine_overrun_count_get(const mpf_engine_t *engine)
+{
+	return mpf_scheduler_overrun_count_get(engine->scheduler);
+}
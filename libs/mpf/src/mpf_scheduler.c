@@ -48,6 +48,9 @@ struct mpf_scheduler_t {
 	mpf_scheduler_proc_f timer_proc;
 	void                *timer_obj;
 
+	/* number of media processing ticks which took longer than the resolution */
+	volatile apr_size_t  overrun_count;
+
 #ifdef ENABLE_MULTIMEDIA_TIMERS
 	unsigned int         timer_id;
 #else
@@ -73,6 +76,7 @@ MPF_DECLARE(mpf_scheduler_t*) mpf_scheduler_create(apr_pool_t *pool)
 	scheduler->timer_resolution = 0;
 	scheduler->timer_elapsed_time = 0;
 	scheduler->timer_obj = NULL;
+	scheduler->overrun_count = 0;
 	scheduler->timer_proc = NULL;
 	return scheduler;
 }
@@ -150,7 +154,11 @@ static void CALLBACK mm_timer_proc(UINT uID, UINT uMsg, DWORD_PTR dwUser, DWORD_
 {
 	mpf_scheduler_t *scheduler = (mpf_scheduler_t*) dwUser;
 	if(scheduler->media_proc) {
+		apr_time_t time_start = apr_time_now();
 		scheduler->media_proc(scheduler,scheduler->media_obj);
+		if(apr_time_now() - time_start > (apr_interval_time_t)scheduler->resolution * 1000) {
+			scheduler->overrun_count++;
+		}
 	}
 
 	if(scheduler->timer_proc) {
@@ -210,6 +218,9 @@ static void* APR_THREAD_FUNC timer_thread_proc(apr_thread_t *thread, void *data)
 
 		if(scheduler->media_proc) {
 			scheduler->media_proc(scheduler,scheduler->media_obj);
+			if(apr_time_now() - time_last > timeout) {
+				scheduler->overrun_count++;
+			}
 		}
 
 		if(scheduler->timer_proc) {
@@ -263,3 +274,8 @@ MPF_DECLARE(apt_bool_t) mpf_scheduler_stop(mpf_scheduler_t *scheduler)
 }
 
 #endif
+
+MPF_DECLARE(apr_size_t) mpf_scheduler_overrun_count_get(const mpf_scheduler_t *scheduler)
+{
+	return scheduler->overrun_count;
+}
@@ -60,6 +60,8 @@ struct mrcp_client_t {
 
 	/** Connection task message pool */
 	apt_task_msg_pool_t     *cnt_msg_pool;
+	/** Connection task message pool of received message batches */
+	apt_task_msg_pool_t     *cnt_batch_msg_pool;
 	
 	/** Event handler used in case of async start  */
 	mrcp_client_handler_f    on_start_complete;
@@ -122,6 +124,7 @@ typedef enum {
 	CONNECTION_AGENT_TASK_MSG_MODIFY_CHANNEL,
 	CONNECTION_AGENT_TASK_MSG_REMOVE_CHANNEL,
 	CONNECTION_AGENT_TASK_MSG_RECEIVE_MESSAGE,
+	CONNECTION_AGENT_TASK_MSG_RECEIVE_BATCH,
 	CONNECTION_AGENT_TASK_MSG_DISCONNECT
 } connection_agent_task_msg_type_e ;
 
@@ -133,18 +136,27 @@ struct connection_agent_task_msg_data_t {
 	apt_bool_t                 status;
 };
 
+typedef struct connection_agent_task_msg_batch_t connection_agent_task_msg_batch_t;
+struct connection_agent_task_msg_batch_t {
+	mrcp_channel_t            *channels[MRCP_RX_BATCH_SIZE];
+	mrcp_message_t            *messages[MRCP_RX_BATCH_SIZE];
+	apr_size_t                 count;
+};
+
 static apt_bool_t mrcp_client_channel_add_signal(mrcp_control_channel_t *channel, mrcp_control_descriptor_t *descriptor, apt_bool_t status);
 static apt_bool_t mrcp_client_channel_modify_signal(mrcp_control_channel_t *channel, mrcp_control_descriptor_t *descriptor, apt_bool_t status);
 static apt_bool_t mrcp_client_channel_remove_signal(mrcp_control_channel_t *channel, apt_bool_t status);
 static apt_bool_t mrcp_client_message_signal(mrcp_control_channel_t *channel, mrcp_message_t *message);
 static apt_bool_t mrcp_client_disconnect_signal(mrcp_control_channel_t *channel);
+static apt_bool_t mrcp_client_message_batch_signal(mrcp_control_channel_t **channels, mrcp_message_t **messages, apr_size_t count);
 
 static const mrcp_connection_event_vtable_t connection_method_vtable = {
 	mrcp_client_channel_add_signal,
 	mrcp_client_channel_modify_signal,
 	mrcp_client_channel_remove_signal,
 	mrcp_client_message_signal,
-	mrcp_client_disconnect_signal
+	mrcp_client_disconnect_signal,
+	mrcp_client_message_batch_signal
 };
 
 /* Task interface */
@@ -182,6 +194,7 @@ MRCP_DECLARE(mrcp_client_t*) mrcp_client_create(apt_dir_layout_t *dir_layout)
 	client->app_table = NULL;
 	client->session_table = NULL;
 	client->cnt_msg_pool = NULL;
+	client->cnt_batch_msg_pool = NULL;
 
 	msg_pool = apt_task_msg_pool_create_dynamic(0,pool);
 	client->task = apt_consumer_task_create(client,msg_pool,pool);
@@ -453,6 +466,7 @@ MRCP_DECLARE(apt_bool_t) mrcp_client_connection_agent_register(mrcp_client_t *cl
 	mrcp_client_connection_resource_factory_set(connection_agent,client->resource_factory);
 	mrcp_client_connection_agent_handler_set(connection_agent,client,&connection_method_vtable);
 	client->cnt_msg_pool = apt_task_msg_pool_create_dynamic(sizeof(connection_agent_task_msg_data_t),client->pool);
+	client->cnt_batch_msg_pool = apt_task_msg_pool_create_dynamic(sizeof(connection_agent_task_msg_batch_t),client->pool);
 	apr_hash_set(client->cnt_agent_table,id,APR_HASH_KEY_STRING,connection_agent);
 	if(client->task) {
 		apt_task_t *task = apt_consumer_task_base_get(client->task);
@@ -782,6 +796,15 @@ static apt_bool_t mrcp_client_msg_process(apt_task_t *task, apt_task_msg_t *msg)
 				case CONNECTION_AGENT_TASK_MSG_RECEIVE_MESSAGE:
 					mrcp_client_on_message_receive(data->channel,data->message);
 					break;
+				case CONNECTION_AGENT_TASK_MSG_RECEIVE_BATCH:
+				{
+					const connection_agent_task_msg_batch_t *batch = (const connection_agent_task_msg_batch_t*)msg->data;
+					apr_size_t i;
+					for(i = 0; i < batch->count; i++) {
+						mrcp_client_on_message_receive(batch->channels[i],batch->messages[i]);
+					}
+					break;
+				}
 				case CONNECTION_AGENT_TASK_MSG_DISCONNECT:
 					mrcp_client_on_disconnect(data->channel);
 					break;
@@ -973,6 +996,37 @@ static apt_bool_t mrcp_client_message_signal(mrcp_control_channel_t *channel, mr
 								TRUE);
 }
 
+static apt_bool_t mrcp_client_message_batch_signal(mrcp_control_channel_t **channels, mrcp_message_t **messages, apr_size_t count)
+{
+	apt_task_t *task;
+	apt_task_msg_t *task_msg;
+	connection_agent_task_msg_batch_t *batch;
+	apr_size_t i;
+	mrcp_client_t *client = mrcp_client_connection_agent_object_get(channels[0]->agent);
+	if(!client || !client->cnt_batch_msg_pool || count > MRCP_RX_BATCH_SIZE) {
+		return FALSE;
+	}
+	if(count == 1) {
+		return mrcp_client_message_signal(channels[0],messages[0]);
+	}
+
+	/* signal the messages received at once by a single task message */
+	task = apt_consumer_task_base_get(client->task);
+	task_msg = apt_task_msg_acquire(client->cnt_batch_msg_pool);
+	if(task_msg) {
+		task_msg->type = MRCP_CLIENT_CONNECTION_TASK_MSG;
+		task_msg->sub_type = CONNECTION_AGENT_TASK_MSG_RECEIVE_BATCH;
+		batch = (connection_agent_task_msg_batch_t*) task_msg->data;
+		for(i = 0; i < count; i++) {
+			batch->channels[i] = channels[i]->obj;
+			batch->messages[i] = messages[i];
+		}
+		batch->count = count;
+		return apt_task_msg_signal(task,task_msg);
+	}
+	return FALSE;
+}
+
 static apt_bool_t mrcp_client_disconnect_signal(mrcp_control_channel_t *channel)
 {
 	return mrcp_client_connection_task_msg_signal(
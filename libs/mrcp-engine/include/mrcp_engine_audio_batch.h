@@ -0,0 +1,133 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MRCP_ENGINE_AUDIO_BATCH_H
+#define MRCP_ENGINE_AUDIO_BATCH_H
+
+/**
+ * @file mrcp_engine_audio_batch.h
+ * @brief Batched Delivery of Audio to Engine Workers
+ *
+ * Frames written by the media thread (from the stream write method) are accumulated
+ * in a lock-free single-producer/single-consumer ring. Once a batch of the configured
+ * duration is available, or a voice activity or DTMF event is detected, the worker
+ * of the channel is signaled and the batch is passed to the on_audio_batch() handler
+ * in the context of that worker. The events are reported along with their offsets
+ * in the audio of the batch. The channel must be closed by mrcp_engine_worker_channel_close_ex(),
+ * so that no batch is passed to the handler after the channel is closed.
+ */
+
+#include "mrcp_engine_worker.h"
+#include "mpf_activity_detector.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Audio batch event types */
+typedef enum {
+	MRCP_AUDIO_BATCH_EVENT_ACTIVITY,    /**< start of voice activity */
+	MRCP_AUDIO_BATCH_EVENT_INACTIVITY,  /**< end of voice activity */
+	MRCP_AUDIO_BATCH_EVENT_NOINPUT,     /**< noinput timeout elapsed */
+	MRCP_AUDIO_BATCH_EVENT_DTMF_START,  /**< start of DTMF event (RFC4733) */
+	MRCP_AUDIO_BATCH_EVENT_DTMF_END     /**< end of DTMF event (RFC4733) */
+} mrcp_audio_batch_event_e;
+
+/** Audio batch event */
+struct mrcp_engine_audio_batch_event_t {
+	/** Event type */
+	mrcp_audio_batch_event_e type;
+	/** Offset of the event in the audio of the batch (bytes) */
+	apr_size_t               offset;
+	/** Event identifier (DTMF events only) */
+	apr_byte_t               event_id;
+	/** Event duration in timestamp units (DTMF end event only) */
+	apr_uint16_t             duration;
+};
+
+/** Batch of audio */
+struct mrcp_engine_audio_batch_t {
+	/** Linear PCM audio */
+	const char                             *data;
+	/** Size of audio (bytes) */
+	apr_size_t                              size;
+	/** Duration of audio (msec) */
+	apr_size_t                              duration;
+	/** Events occurred within the batch */
+	const mrcp_engine_audio_batch_event_t  *events;
+	/** Number of events */
+	apr_size_t                              event_count;
+	/** Number of bytes dropped due to ring overflow since the previous batch */
+	apr_size_t                              dropped;
+};
+
+/**
+ * Create audio batcher.
+ * @param worker_pool the worker pool to signal (NULL to poll by mrcp_engine_audio_batcher_read())
+ * @param channel the engine channel the audio is received on
+ * @param batch_duration the duration of a batch in msec
+ * @param max_sampling_rate the max sampling rate the ring is sized for
+ * @param pool the pool to allocate memory from
+ * @remark The ring holds up to 4 batches, frames which don't fit are dropped.
+ */
+MRCP_DECLARE(mrcp_engine_audio_batcher_t*) mrcp_engine_audio_batcher_create(
+												mrcp_engine_worker_pool_t *worker_pool,
+												mrcp_engine_channel_t *channel,
+												apr_size_t batch_duration,
+												apr_uint16_t max_sampling_rate,
+												apr_pool_t *pool);
+
+/** Set activity detector to run on written frames (the detector is accessed from the media thread only) */
+MRCP_DECLARE(void) mrcp_engine_audio_batcher_detector_set(mrcp_engine_audio_batcher_t *batcher, mpf_activity_detector_t *detector);
+
+/**
+ * Open audio batcher (from the stream open method).
+ * @param batcher the batcher to open
+ * @param descriptor the descriptor of linear PCM codec the frames are written in
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_audio_batcher_open(mrcp_engine_audio_batcher_t *batcher, const mpf_codec_descriptor_t *descriptor);
+
+/**
+ * Write frame (from the stream write method, never blocks).
+ * @param batcher the batcher to write to
+ * @param frame the frame to write
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_audio_batcher_write(mrcp_engine_audio_batcher_t *batcher, const mpf_frame_t *frame);
+
+/**
+ * Read next batch (from the consumer thread).
+ * @param batcher the batcher to read from
+ * @param batch the batch to fill (valid till the next read)
+ * @param flush whether to return an incomplete batch
+ * @return TRUE if a batch is read
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_audio_batcher_read(mrcp_engine_audio_batcher_t *batcher, mrcp_engine_audio_batch_t *batch, apt_bool_t flush);
+
+/**
+ * Read available batches and pass them to the handler of the worker pool (invoked by the worker).
+ * @remark Nothing is passed once the batcher is closed.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_audio_batcher_process(mrcp_engine_audio_batcher_t *batcher);
+
+/**
+ * Close audio batcher (invoked by the worker, see mrcp_engine_worker_channel_close_ex()).
+ * @param batcher the batcher to close
+ * @return FALSE if a signal of the worker is still pending
+ * @remark The worker is no longer signaled, frames may still be written till the stream is closed.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_audio_batcher_close(mrcp_engine_audio_batcher_t *batcher);
+
+APT_END_EXTERN_C
+
+#endif /* MRCP_ENGINE_AUDIO_BATCH_H */
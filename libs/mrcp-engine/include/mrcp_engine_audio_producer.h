@@ -0,0 +1,105 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MRCP_ENGINE_AUDIO_PRODUCER_H
+#define MRCP_ENGINE_AUDIO_PRODUCER_H
+
+/**
+ * @file mrcp_engine_audio_producer.h
+ * @brief Streaming of Synthesized Audio to Media Thread
+ *
+ * The engine writes synthesized audio in chunks of any size from its own thread,
+ * while the stream read method of the channel just takes frames off a lock-free
+ * single-producer/single-consumer ring. Playback of a stream is started once the
+ * prefetch depth is buffered, and silence is produced on underrun, so latency
+ * spikes of synthesis never stall the media processing loop.
+ */
+
+#include "mrcp_engine_impl.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Opaque audio producer declaration */
+typedef struct mrcp_engine_audio_producer_t mrcp_engine_audio_producer_t;
+
+/** Status of reading a frame */
+typedef enum {
+	MRCP_AUDIO_PRODUCER_AUDIO,       /**< frame of audio is read */
+	MRCP_AUDIO_PRODUCER_IDLE,        /**< nothing is written, frame is left empty */
+	MRCP_AUDIO_PRODUCER_PREFETCHING, /**< prefetch depth is not reached yet, frame is left empty */
+	MRCP_AUDIO_PRODUCER_UNDERRUN,    /**< stream is running out of audio, frame is left empty */
+	MRCP_AUDIO_PRODUCER_COMPLETE     /**< all the audio of the stream is read, frame is left empty */
+} mrcp_audio_producer_status_e;
+
+/**
+ * Create audio producer.
+ * @param prefetch_duration the duration of audio to buffer before playback is started (msec)
+ * @param capacity_duration the max duration of audio to hold (msec)
+ * @param max_sampling_rate the max sampling rate the ring is sized for
+ * @param pool the pool to allocate memory from
+ */
+MRCP_DECLARE(mrcp_engine_audio_producer_t*) mrcp_engine_audio_producer_create(
+												apr_size_t prefetch_duration,
+												apr_size_t capacity_duration,
+												apr_uint16_t max_sampling_rate,
+												apr_pool_t *pool);
+
+/**
+ * Open audio producer (from the stream open method).
+ * @param producer the producer to open
+ * @param descriptor the descriptor of linear PCM codec the frames are read in
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_audio_producer_open(mrcp_engine_audio_producer_t *producer, const mpf_codec_descriptor_t *descriptor);
+
+/**
+ * Write audio (from the engine thread, never blocks).
+ * @param producer the producer to write to
+ * @param data the audio to write
+ * @param size the size of audio
+ * @return the number of bytes written, less than size if the ring is full
+ */
+MRCP_DECLARE(apr_size_t) mrcp_engine_audio_producer_write(mrcp_engine_audio_producer_t *producer, const char *data, apr_size_t size);
+
+/** Get the number of bytes which can be written at the moment (from the engine thread) */
+MRCP_DECLARE(apr_size_t) mrcp_engine_audio_producer_space_get(const mrcp_engine_audio_producer_t *producer);
+
+/**
+ * Indicate the end of stream (from the engine thread).
+ * @return FALSE if too many complete streams are yet to be read
+ * @remark The next stream may be written right away, it is read after the completion of the current one.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_audio_producer_complete(mrcp_engine_audio_producer_t *producer);
+
+/**
+ * Read frame (from the stream read method, never blocks).
+ * @param producer the producer to read from
+ * @param frame the frame to fill
+ */
+MRCP_DECLARE(mrcp_audio_producer_status_e) mrcp_engine_audio_producer_read(mrcp_engine_audio_producer_t *producer, mpf_frame_t *frame);
+
+/**
+ * Discard the audio of the current stream (from the stream read method, e.g. on STOP).
+ * @remark The engine should stop writing the stream beforehand. The audio written so far
+ *         is discarded and the streams completed so far are not reported complete.
+ */
+MRCP_DECLARE(void) mrcp_engine_audio_producer_flush(mrcp_engine_audio_producer_t *producer);
+
+/** Get the number of underruns occurred */
+MRCP_DECLARE(apr_size_t) mrcp_engine_audio_producer_underrun_count_get(const mrcp_engine_audio_producer_t *producer);
+
+APT_END_EXTERN_C
+
+#endif /* MRCP_ENGINE_AUDIO_PRODUCER_H */
@@ -54,6 +54,9 @@ MRCP_DECLARE(mrcp_engine_t*) mrcp_engine_factory_engine_find(const mrcp_engine_f
 /** Start iterating over the engines in a factory */
 MRCP_DECLARE(apr_hash_index_t*) mrcp_engine_factory_engine_first(const mrcp_engine_factory_t *factory);
 
+/** Get the highest channel usage (percentage of max channel count) across the engines having the limit set */
+MRCP_DECLARE(apr_size_t) mrcp_engine_factory_channel_usage_get(const mrcp_engine_factory_t *factory);
+
 
 APT_END_EXTERN_C
 
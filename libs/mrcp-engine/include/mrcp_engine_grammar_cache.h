@@ -0,0 +1,138 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MRCP_ENGINE_GRAMMAR_CACHE_H
+#define MRCP_ENGINE_GRAMMAR_CACHE_H
+
+/**
+ * @file mrcp_engine_grammar_cache.h
+ * @brief Cache of Grammars Shared by Engine Channels
+ *
+ * Grammars defined by DEFINE-GRAMMAR or passed inline in RECOGNIZE are looked up by
+ * Content-Id, Content-Type and a hash of the content. The same grammar sent by any
+ * number of sessions is compiled by the engine only once, on the first miss, and the
+ * compiled artifact is shared by reference. Grammars no longer referenced are kept
+ * until the memory budget of the cache is exceeded and then evicted in LRU order.
+ */
+
+#include "mrcp_engine_impl.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Name of the engine param to set the memory budget of the cache (KB) */
+#define MRCP_ENGINE_GRAMMAR_CACHE_SIZE_PARAM "grammar-cache-size"
+
+/** Opaque grammar cache declaration */
+typedef struct mrcp_engine_grammar_cache_t mrcp_engine_grammar_cache_t;
+/** Opaque cached grammar declaration */
+typedef struct mrcp_engine_grammar_t mrcp_engine_grammar_t;
+/** Grammar compiler declaration */
+typedef struct mrcp_engine_grammar_compiler_t mrcp_engine_grammar_compiler_t;
+/** Grammar cache statistics declaration */
+typedef struct mrcp_engine_grammar_cache_stats_t mrcp_engine_grammar_cache_stats_t;
+
+/** Engine hooks to compile grammars and destroy compiled artifacts */
+struct mrcp_engine_grammar_compiler_t {
+	/**
+	 * Compile grammar on a cache miss (invoked outside the lock of the cache).
+	 * The artifact should be allocated from the specified pool of the grammar
+	 * and its size reported to be accounted in the memory budget.
+	 */
+	apt_bool_t (*compile)(void *obj, const mrcp_engine_grammar_t *grammar, apr_pool_t *pool, void **artifact, apr_size_t *size);
+	/** Destroy compiled artifact on eviction (optional) */
+	void (*destroy)(void *obj, const mrcp_engine_grammar_t *grammar, void *artifact);
+};
+
+/** Grammar cache statistics */
+struct mrcp_engine_grammar_cache_stats_t {
+	/** Number of grammars found in the cache */
+	apr_size_t hit_count;
+	/** Number of grammars compiled */
+	apr_size_t miss_count;
+	/** Number of grammars failed to compile */
+	apr_size_t failure_count;
+	/** Number of grammars evicted */
+	apr_size_t eviction_count;
+	/** Number of grammars cached */
+	apr_size_t grammar_count;
+	/** Memory used by the grammars cached (bytes) */
+	apr_size_t size;
+	/** Memory budget of the cache (bytes) */
+	apr_size_t max_size;
+};
+
+/**
+ * Create grammar cache.
+ * @param engine the engine to create the cache for
+ * @param compiler the engine hooks (if NULL, only the content of grammars is cached)
+ * @param obj the object to pass to the hooks
+ * @param pool the pool to allocate memory from
+ * @remark The memory budget is taken from the "grammar-cache-size" param of the engine, if set.
+ */
+MRCP_DECLARE(mrcp_engine_grammar_cache_t*) mrcp_engine_grammar_cache_create(
+											const mrcp_engine_t *engine,
+											const mrcp_engine_grammar_compiler_t *compiler,
+											void *obj,
+											apr_pool_t *pool);
+
+/** Destroy grammar cache along with all the grammars cached */
+MRCP_DECLARE(void) mrcp_engine_grammar_cache_destroy(mrcp_engine_grammar_cache_t *cache);
+
+/**
+ * Find or compile grammar and acquire a reference to it.
+ * @param cache the grammar cache
+ * @param content_id the Content-Id of the grammar (may be empty)
+ * @param content_type the Content-Type of the grammar
+ * @param content the content of the grammar
+ * @return the grammar to release by mrcp_engine_grammar_release(), or NULL on compilation failure
+ */
+MRCP_DECLARE(mrcp_engine_grammar_t*) mrcp_engine_grammar_acquire(
+										mrcp_engine_grammar_cache_t *cache,
+										const apt_str_t *content_id,
+										const apt_str_t *content_type,
+										const apt_str_t *content);
+
+/**
+ * Find or compile grammar defined by the body of DEFINE-GRAMMAR or RECOGNIZE request.
+ * @param cache the grammar cache
+ * @param request the request to take Content-Id, Content-Type and body from
+ * @return the grammar, or NULL if the request has no body or compilation fails
+ */
+MRCP_DECLARE(mrcp_engine_grammar_t*) mrcp_engine_grammar_request_acquire(
+										mrcp_engine_grammar_cache_t *cache,
+										const mrcp_message_t *request);
+
+/** Release reference to the grammar */
+MRCP_DECLARE(void) mrcp_engine_grammar_release(mrcp_engine_grammar_cache_t *cache, mrcp_engine_grammar_t *grammar);
+
+/** Get statistics of the cache */
+MRCP_DECLARE(void) mrcp_engine_grammar_cache_stats_get(mrcp_engine_grammar_cache_t *cache, mrcp_engine_grammar_cache_stats_t *stats);
+
+/** Get Content-Id of the grammar */
+MRCP_DECLARE(const apt_str_t*) mrcp_engine_grammar_content_id_get(const mrcp_engine_grammar_t *grammar);
+
+/** Get Content-Type of the grammar */
+MRCP_DECLARE(const apt_str_t*) mrcp_engine_grammar_content_type_get(const mrcp_engine_grammar_t *grammar);
+
+/** Get content of the grammar */
+MRCP_DECLARE(const apt_str_t*) mrcp_engine_grammar_content_get(const mrcp_engine_grammar_t *grammar);
+
+/** Get compiled artifact of the grammar */
+MRCP_DECLARE(void*) mrcp_engine_grammar_artifact_get(const mrcp_engine_grammar_t *grammar);
+
+APT_END_EXTERN_C
+
+#endif /* MRCP_ENGINE_GRAMMAR_CACHE_H */
@@ -26,6 +26,19 @@
 
 APT_BEGIN_EXTERN_C
 
+/*
+ * Threading contract.
+ *
+ * Unless the engine is declared concurrent (see mrcp_engine_concurrency_enable()), the user invokes
+ * the methods of the engine and all its channels from within a single task, so the engine needs no
+ * synchronization of its own. The MRCP server keeps processing all the sessions by its main task,
+ * even if more shards are configured, as long as any of the loaded engines is not concurrent.
+ *
+ * The methods of a concurrent engine may be invoked from within multiple tasks at the same time,
+ * while the methods of the same channel are still invoked from within a single task, one at a time.
+ * Responses and events may be sent from within any thread in either case.
+ */
+
 /** Destroy engine */
 apt_bool_t mrcp_engine_virtual_destroy(mrcp_engine_t *engine);
 
@@ -47,6 +47,12 @@ static APR_INLINE apt_bool_t mrcp_engine_close_respond(mrcp_engine_t *engine)
 }
 
 
+/** Declare the engine and its channels safe to be called from multiple server tasks concurrently */
+static APR_INLINE void mrcp_engine_concurrency_enable(mrcp_engine_t *engine)
+{
+	engine->concurrent = TRUE;
+}
+
 /** Get engine config */
 const mrcp_engine_config_t* mrcp_engine_config_get(const mrcp_engine_t *engine);
 
@@ -134,6 +134,8 @@ struct mrcp_engine_t {
 	apr_size_t                         cur_channel_count;
 	/** Is engine successfully opened */
 	apt_bool_t                         is_open;
+	/** Are the engine and its channels safe to be called from multiple server tasks concurrently */
+	apt_bool_t                         concurrent;
 	/** Pool to allocate memory from */
 	apr_pool_t                        *pool;
 
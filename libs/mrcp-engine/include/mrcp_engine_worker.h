@@ -0,0 +1,128 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MRCP_ENGINE_WORKER_H
+#define MRCP_ENGINE_WORKER_H
+
+/**
+ * @file mrcp_engine_worker.h
+ * @brief Pool of Worker Threads to Process Engine Channel Requests
+ *
+ * Channel methods (open, close, request) are signaled to the pool and processed
+ * in the context of one of its workers. A channel is always served by the same worker,
+ * so the order of the methods of a channel is preserved. Responses and events are sent
+ * back from the worker via mrcp_engine_channel_*_respond() and mrcp_engine_channel_message_send().
+ */
+
+#include "mrcp_engine_impl.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Name of the engine param to set the number of workers */
+#define MRCP_ENGINE_WORKER_COUNT_PARAM       "worker-count"
+/** Name of the engine param to set the max number of pending messages per worker */
+#define MRCP_ENGINE_WORKER_QUEUE_SIZE_PARAM  "worker-queue-size"
+
+/** Opaque engine worker pool declaration */
+typedef struct mrcp_engine_worker_pool_t mrcp_engine_worker_pool_t;
+/** Engine worker vtable declaration */
+typedef struct mrcp_engine_worker_vtable_t mrcp_engine_worker_vtable_t;
+/** Opaque audio batcher declaration (see mrcp_engine_audio_batch.h) */
+typedef struct mrcp_engine_audio_batcher_t mrcp_engine_audio_batcher_t;
+/** Audio batch declaration */
+typedef struct mrcp_engine_audio_batch_t mrcp_engine_audio_batch_t;
+/** Audio batch event declaration */
+typedef struct mrcp_engine_audio_batch_event_t mrcp_engine_audio_batch_event_t;
+
+/** Table of handlers invoked in the context of a worker */
+struct mrcp_engine_worker_vtable_t {
+	/** Open channel and send asynchronous response (if not set, the channel is opened right away) */
+	apt_bool_t (*on_channel_open)(mrcp_engine_channel_t *channel);
+	/** Close channel and send asynchronous response (if not set, the channel is closed right away) */
+	apt_bool_t (*on_channel_close)(mrcp_engine_channel_t *channel);
+	/** Process MRCP request and send asynchronous response */
+	apt_bool_t (*on_request_process)(mrcp_engine_channel_t *channel, mrcp_message_t *request);
+	/** Process batch of audio (optional, see mrcp_engine_audio_batch.h) */
+	apt_bool_t (*on_audio_batch)(mrcp_engine_channel_t *channel, const mrcp_engine_audio_batch_t *batch);
+};
+
+/**
+ * Create worker pool.
+ * @param engine the engine to create the pool for
+ * @param name the name of the workers
+ * @param vtable the table of handlers
+ * @param pool the pool to allocate memory from
+ * @remark The number of workers and the max size of their queues are taken from
+ *         the "worker-count" and "worker-queue-size" params of the engine, if set.
+ */
+MRCP_DECLARE(mrcp_engine_worker_pool_t*) mrcp_engine_worker_pool_create(
+									const mrcp_engine_t *engine,
+									const char *name,
+									const mrcp_engine_worker_vtable_t *vtable,
+									apr_pool_t *pool);
+
+/** Destroy worker pool */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_worker_pool_destroy(mrcp_engine_worker_pool_t *worker_pool);
+
+/** Start workers */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_worker_pool_start(mrcp_engine_worker_pool_t *worker_pool);
+
+/** Terminate workers and wait for their completion */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_worker_pool_terminate(mrcp_engine_worker_pool_t *worker_pool);
+
+/** Get the number of workers */
+MRCP_DECLARE(apr_size_t) mrcp_engine_worker_pool_count_get(const mrcp_engine_worker_pool_t *worker_pool);
+
+/** Get the number of messages rejected due to a full queue */
+MRCP_DECLARE(apr_size_t) mrcp_engine_worker_pool_rejected_count_get(const mrcp_engine_worker_pool_t *worker_pool);
+
+/**
+ * Signal channel open to the worker of the channel.
+ * @remark If the queue of the worker is full, a failure response is sent right away.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_worker_channel_open(mrcp_engine_worker_pool_t *worker_pool, mrcp_engine_channel_t *channel);
+
+/**
+ * Signal channel close to the worker of the channel.
+ * @remark Close is never rejected, otherwise the channel would be leaked.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_worker_channel_close(mrcp_engine_worker_pool_t *worker_pool, mrcp_engine_channel_t *channel);
+
+/**
+ * Signal close of the channel audio is batched for to the worker of the channel.
+ * @remark The batcher is closed first and the close is processed after the pending
+ *         audio signal, if any, so that on_audio_batch() is never invoked after on_channel_close().
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_worker_channel_close_ex(mrcp_engine_worker_pool_t *worker_pool, mrcp_engine_channel_t *channel, mrcp_engine_audio_batcher_t *batcher);
+
+/**
+ * Signal MRCP request to the worker of the channel.
+ * @remark If the queue of the worker is full, a method-failed response is sent right away.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_worker_request_process(mrcp_engine_worker_pool_t *worker_pool, mrcp_engine_channel_t *channel, mrcp_message_t *request);
+
+/**
+ * Signal availability of audio to the worker of the channel.
+ * @remark Used by the audio batcher, the signal is dropped if the queue of the worker is full.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_worker_audio_signal(mrcp_engine_worker_pool_t *worker_pool, mrcp_engine_channel_t *channel, mrcp_engine_audio_batcher_t *batcher);
+
+/** Process batch of audio by the handler of the worker pool */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_worker_audio_batch_process(mrcp_engine_worker_pool_t *worker_pool, mrcp_engine_channel_t *channel, const mrcp_engine_audio_batch_t *batch);
+
+APT_END_EXTERN_C
+
+#endif /* MRCP_ENGINE_WORKER_H */
@@ -0,0 +1,375 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <apr_atomic.h>
+#include "mrcp_engine_audio_batch.h"
+#include "apt_log.h"
+
+/** Number of batches the ring is sized for */
+#define MRCP_AUDIO_BATCH_RING_BATCHES  4
+/** Max number of pending events (must be power of 2) */
+#define MRCP_AUDIO_BATCH_MAX_EVENTS    32
+/** Size of linear PCM sample */
+#define MRCP_AUDIO_BATCH_SAMPLE_SIZE   2
+
+/** The worker is signaled and is yet to read the ring */
+#define MRCP_AUDIO_BATCH_STATE_SIGNALED 0x1
+/** The batcher is closed, the worker is no longer signaled */
+#define MRCP_AUDIO_BATCH_STATE_CLOSED   0x2
+
+typedef struct mrcp_audio_batch_ring_event_t mrcp_audio_batch_ring_event_t;
+
+/** Event pending in the ring */
+struct mrcp_audio_batch_ring_event_t {
+	/** Event */
+	mrcp_engine_audio_batch_event_t event;
+	/** Write position of the ring the event occurred at */
+	apr_uint32_t                    position;
+};
+
+/** Audio batcher */
+struct mrcp_engine_audio_batcher_t {
+	/** Worker pool to signal */
+	mrcp_engine_worker_pool_t      *worker_pool;
+	/** Engine channel */
+	mrcp_engine_channel_t          *channel;
+	/** Optional activity detector */
+	mpf_activity_detector_t        *detector;
+
+	/** Duration of a batch (msec) */
+	apr_size_t                      batch_duration;
+	/** Size of a batch (bytes) */
+	apr_uint32_t                    batch_size;
+	/** Max size of a batch (bytes) */
+	apr_uint32_t                    max_batch_size;
+	/** Number of bytes per msec */
+	apr_uint32_t                    bytes_per_msec;
+
+	/** Ring of audio (size is power of 2) */
+	char                           *ring;
+	/** Size of the ring */
+	apr_uint32_t                    ring_size;
+	/** Write position (modified by the producer only) */
+	volatile apr_uint32_t           write_pos;
+	/** Read position (modified by the consumer only) */
+	volatile apr_uint32_t           read_pos;
+
+	/** Ring of events */
+	mrcp_audio_batch_ring_event_t   events[MRCP_AUDIO_BATCH_MAX_EVENTS];
+	/** Event write position (modified by the producer only) */
+	volatile apr_uint32_t           event_write_pos;
+	/** Event read position (modified by the consumer only) */
+	volatile apr_uint32_t           event_read_pos;
+
+	/** Number of dropped bytes */
+	volatile apr_uint32_t           dropped;
+	/** State flags (MRCP_AUDIO_BATCH_STATE_*) */
+	volatile apr_uint32_t           state;
+
+	/** Audio of the batch being read (accessed by the consumer only) */
+	char                           *batch_data;
+	/** Events of the batch being read (accessed by the consumer only) */
+	mrcp_engine_audio_batch_event_t batch_events[MRCP_AUDIO_BATCH_MAX_EVENTS];
+};
+
+/** Create audio batcher */
+MRCP_DECLARE(mrcp_engine_audio_batcher_t*) mrcp_engine_audio_batcher_create(
+												mrcp_engine_worker_pool_t *worker_pool,
+												mrcp_engine_channel_t *channel,
+												apr_size_t batch_duration,
+												apr_uint16_t max_sampling_rate,
+												apr_pool_t *pool)
+{
+	mrcp_engine_audio_batcher_t *batcher;
+	apr_uint32_t ring_size = 1;
+	if(!batch_duration || !max_sampling_rate) {
+		return NULL;
+	}
+
+	batcher = apr_palloc(pool,sizeof(mrcp_engine_audio_batcher_t));
+	batcher->worker_pool = worker_pool;
+	batcher->channel = channel;
+	batcher->detector = NULL;
+	batcher->batch_duration = batch_duration;
+	batcher->max_batch_size = (apr_uint32_t)(batch_duration * max_sampling_rate / 1000 * MRCP_AUDIO_BATCH_SAMPLE_SIZE);
+	batcher->bytes_per_msec = max_sampling_rate / 1000 * MRCP_AUDIO_BATCH_SAMPLE_SIZE;
+	batcher->batch_size = batcher->max_batch_size;
+
+	/* round the size of the ring up to power of 2 to keep positions valid over wraparound */
+	while(ring_size < batcher->max_batch_size * MRCP_AUDIO_BATCH_RING_BATCHES) {
+		ring_size <<= 1;
+	}
+	batcher->ring_size = ring_size;
+	batcher->ring = apr_palloc(pool,ring_size);
+	batcher->write_pos = 0;
+	batcher->read_pos = 0;
+	batcher->event_write_pos = 0;
+	batcher->event_read_pos = 0;
+	batcher->dropped = 0;
+	batcher->state = 0;
+	batcher->batch_data = apr_palloc(pool,batcher->max_batch_size);
+	return batcher;
+}
+
+/** Set activity detector */
+MRCP_DECLARE(void) mrcp_engine_audio_batcher_detector_set(mrcp_engine_audio_batcher_t *batcher, mpf_activity_detector_t *detector)
+{
+	batcher->detector = detector;
+}
+
+/** Open audio batcher */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_audio_batcher_open(mrcp_engine_audio_batcher_t *batcher, const mpf_codec_descriptor_t *descriptor)
+{
+	apr_uint32_t bytes_per_msec;
+	apr_uint32_t batch_size;
+	if(!descriptor || !descriptor->sampling_rate) {
+		return FALSE;
+	}
+
+	bytes_per_msec = descriptor->sampling_rate / 1000 * descriptor->channel_count * MRCP_AUDIO_BATCH_SAMPLE_SIZE;
+	batch_size = (apr_uint32_t)batcher->batch_duration * bytes_per_msec;
+	if(!batch_size || batch_size > batcher->max_batch_size) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Open Audio Batcher: batch size [%u] exceeds [%u]",
+			batch_size,
+			batcher->max_batch_size);
+		return FALSE;
+	}
+
+	/* the stream is opened before any frame is written or read */
+	batcher->bytes_per_msec = bytes_per_msec;
+	batcher->batch_size = batch_size;
+	apr_atomic_set32(&batcher->write_pos,0);
+	apr_atomic_set32(&batcher->read_pos,0);
+	apr_atomic_set32(&batcher->event_write_pos,0);
+	apr_atomic_set32(&batcher->event_read_pos,0);
+	apr_atomic_set32(&batcher->dropped,0);
+	apr_atomic_set32(&batcher->state,0);
+	return TRUE;
+}
+
+/**
+ * Load position published by the other side.
+ * apr_atomic_read32() implies no barrier, while the data the position covers must be
+ * loaded after the position, therefore, use an operation with full barrier.
+ */
+static APR_INLINE apr_uint32_t mrcp_audio_batch_pos_load(volatile apr_uint32_t *pos)
+{
+	return apr_atomic_add32(pos,0);
+}
+
+/** Publish position to the other side after the data it covers is stored (full barrier) */
+static APR_INLINE void mrcp_audio_batch_pos_store(volatile apr_uint32_t *pos, apr_uint32_t value)
+{
+	/* the position is modified by its owner only, so the exchange always succeeds */
+	apr_atomic_cas32(pos,value,*pos);
+}
+
+/** Set and clear state flags, return the previous state */
+static apr_uint32_t mrcp_audio_batch_state_modify(volatile apr_uint32_t *state, apr_uint32_t set, apr_uint32_t clear)
+{
+	apr_uint32_t prev;
+	apr_uint32_t cur = apr_atomic_add32(state,0);
+	do {
+		prev = cur;
+		cur = apr_atomic_cas32(state,(prev | set) & ~clear,prev);
+	}
+	while(cur != prev);
+	return prev;
+}
+
+/** Write audio to the ring (producer) */
+static APR_INLINE void mrcp_engine_audio_ring_write(mrcp_engine_audio_batcher_t *batcher, const char *data, apr_uint32_t size)
+{
+	apr_uint32_t write_pos = batcher->write_pos;
+	apr_uint32_t offset;
+	apr_uint32_t part;
+	if(batcher->ring_size - (write_pos - mrcp_audio_batch_pos_load(&batcher->read_pos)) < size) {
+		apr_atomic_add32(&batcher->dropped,size);
+		return;
+	}
+
+	offset = write_pos & (batcher->ring_size - 1);
+	part = batcher->ring_size - offset;
+	if(part >= size) {
+		memcpy(batcher->ring + offset,data,size);
+	}
+	else {
+		memcpy(batcher->ring + offset,data,part);
+		memcpy(batcher->ring,data + part,size - part);
+	}
+	/* publish the audio after it is copied */
+	mrcp_audio_batch_pos_store(&batcher->write_pos,write_pos + size);
+}
+
+/** Write event to the ring (producer) */
+static APR_INLINE apt_bool_t mrcp_engine_audio_event_write(mrcp_engine_audio_batcher_t *batcher, mrcp_audio_batch_event_e type, apr_byte_t event_id, apr_uint16_t duration)
+{
+	mrcp_audio_batch_ring_event_t *ring_event;
+	apr_uint32_t event_write_pos = batcher->event_write_pos;
+	if(event_write_pos - mrcp_audio_batch_pos_load(&batcher->event_read_pos) >= MRCP_AUDIO_BATCH_MAX_EVENTS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Write Audio Batch Event [%d]: queue is full",type);
+		return FALSE;
+	}
+
+	ring_event = &batcher->events[event_write_pos & (MRCP_AUDIO_BATCH_MAX_EVENTS - 1)];
+	ring_event->event.type = type;
+	ring_event->event.offset = 0;
+	ring_event->event.event_id = event_id;
+	ring_event->event.duration = duration;
+	ring_event->position = batcher->write_pos;
+	mrcp_audio_batch_pos_store(&batcher->event_write_pos,event_write_pos + 1);
+	return TRUE;
+}
+
+/** Write frame */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_audio_batcher_write(mrcp_engine_audio_batcher_t *batcher, const mpf_frame_t *frame)
+{
+	apt_bool_t event = FALSE;
+	if((frame->type & MEDIA_FRAME_TYPE_AUDIO) == MEDIA_FRAME_TYPE_AUDIO) {
+		mrcp_engine_audio_ring_write(batcher,frame->codec_frame.buffer,(apr_uint32_t)frame->codec_frame.size);
+	}
+
+	if(batcher->detector) {
+		switch(mpf_activity_detector_process(batcher->detector,frame)) {
+			case MPF_DETECTOR_EVENT_ACTIVITY:
+				event = mrcp_engine_audio_event_write(batcher,MRCP_AUDIO_BATCH_EVENT_ACTIVITY,0,0);
+				break;
+			case MPF_DETECTOR_EVENT_INACTIVITY:
+				event = mrcp_engine_audio_event_write(batcher,MRCP_AUDIO_BATCH_EVENT_INACTIVITY,0,0);
+				break;
+			case MPF_DETECTOR_EVENT_NOINPUT:
+				event = mrcp_engine_audio_event_write(batcher,MRCP_AUDIO_BATCH_EVENT_NOINPUT,0,0);
+				break;
+			default:
+				break;
+		}
+	}
+
+	if((frame->type & MEDIA_FRAME_TYPE_EVENT) == MEDIA_FRAME_TYPE_EVENT) {
+		if(frame->marker == MPF_MARKER_START_OF_EVENT) {
+			event = mrcp_engine_audio_event_write(batcher,MRCP_AUDIO_BATCH_EVENT_DTMF_START,
+						frame->event_frame.event_id,0);
+		}
+		else if(frame->marker == MPF_MARKER_END_OF_EVENT) {
+			event = mrcp_engine_audio_event_write(batcher,MRCP_AUDIO_BATCH_EVENT_DTMF_END,
+						frame->event_frame.event_id,frame->event_frame.duration);
+		}
+	}
+
+	if(!batcher->worker_pool) {
+		return TRUE;
+	}
+
+	/* signal the worker once per complete batch or event, unless it's already signaled or the batcher is closed */
+	if(event == TRUE || batcher->write_pos - mrcp_audio_batch_pos_load(&batcher->read_pos) >= batcher->batch_size) {
+		if(apr_atomic_cas32(&batcher->state,MRCP_AUDIO_BATCH_STATE_SIGNALED,0) == 0) {
+			if(mrcp_engine_worker_audio_signal(batcher->worker_pool,batcher->channel,batcher) == FALSE) {
+				/* keep the closed flag, a close waiting for the signal proceeds */
+				mrcp_audio_batch_state_modify(&batcher->state,0,MRCP_AUDIO_BATCH_STATE_SIGNALED);
+			}
+		}
+	}
+	return TRUE;
+}
+
+/** Read next batch */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_audio_batcher_read(mrcp_engine_audio_batcher_t *batcher, mrcp_engine_audio_batch_t *batch, apt_bool_t flush)
+{
+	/* load the event position first, so that the audio of the loaded events is available too */
+	apr_uint32_t event_read_pos = batcher->event_read_pos;
+	apr_uint32_t event_write_pos = mrcp_audio_batch_pos_load(&batcher->event_write_pos);
+	apr_uint32_t read_pos = batcher->read_pos;
+	apr_uint32_t available = mrcp_audio_batch_pos_load(&batcher->write_pos) - read_pos;
+	apr_uint32_t size;
+	apr_uint32_t offset;
+	apr_uint32_t part;
+	apr_size_t event_count = 0;
+
+	if(available >= batcher->batch_size) {
+		size = batcher->batch_size;
+	}
+	else if(event_read_pos != event_write_pos || flush == TRUE) {
+		/* deliver an incomplete batch along with the pending events */
+		size = available;
+	}
+	else {
+		return FALSE;
+	}
+
+	if(!size && event_read_pos == event_write_pos) {
+		return FALSE;
+	}
+
+	offset = read_pos & (batcher->ring_size - 1);
+	part = batcher->ring_size - offset;
+	if(part >= size) {
+		memcpy(batcher->batch_data,batcher->ring + offset,size);
+	}
+	else {
+		memcpy(batcher->batch_data,batcher->ring + offset,part);
+		memcpy(batcher->batch_data + part,batcher->ring,size - part);
+	}
+
+	/* events are written in the order of positions, take the ones within the batch */
+	while(event_read_pos != event_write_pos) {
+		const mrcp_audio_batch_ring_event_t *ring_event = &batcher->events[event_read_pos & (MRCP_AUDIO_BATCH_MAX_EVENTS - 1)];
+		if(ring_event->position - read_pos > size) {
+			break;
+		}
+		batcher->batch_events[event_count] = ring_event->event;
+		batcher->batch_events[event_count].offset = ring_event->position - read_pos;
+		event_count++;
+		event_read_pos++;
+	}
+
+	/* release the space after the data is copied out */
+	mrcp_audio_batch_pos_store(&batcher->event_read_pos,event_read_pos);
+	mrcp_audio_batch_pos_store(&batcher->read_pos,read_pos + size);
+
+	batch->data = batcher->batch_data;
+	batch->size = size;
+	batch->duration = size / batcher->bytes_per_msec;
+	batch->events = batcher->batch_events;
+	batch->event_count = event_count;
+	batch->dropped = apr_atomic_xchg32(&batcher->dropped,0);
+	return TRUE;
+}
+
+/** Read available batches and pass them to the handler of the worker pool */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_audio_batcher_process(mrcp_engine_audio_batcher_t *batcher)
+{
+	mrcp_engine_audio_batch_t batch;
+	/* reset the flag first, a frame written meanwhile signals again */
+	apr_uint32_t state = mrcp_audio_batch_state_modify(&batcher->state,0,MRCP_AUDIO_BATCH_STATE_SIGNALED);
+	if(state & MRCP_AUDIO_BATCH_STATE_CLOSED) {
+		/* the signal was pending on close, the audio is no longer delivered */
+		return TRUE;
+	}
+	while(mrcp_engine_audio_batcher_read(batcher,&batch,FALSE) == TRUE) {
+		if(mrcp_engine_worker_audio_batch_process(batcher->worker_pool,batcher->channel,&batch) == FALSE) {
+			break;
+		}
+	}
+	return TRUE;
+}
+
+/** Close audio batcher (invoked by the worker) */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_audio_batcher_close(mrcp_engine_audio_batcher_t *batcher)
+{
+	apr_uint32_t state = mrcp_audio_batch_state_modify(&batcher->state,MRCP_AUDIO_BATCH_STATE_CLOSED,0);
+	/* a signal sent or being sent meanwhile is yet to be processed */
+	return (state & MRCP_AUDIO_BATCH_STATE_SIGNALED) ? FALSE : TRUE;
+}
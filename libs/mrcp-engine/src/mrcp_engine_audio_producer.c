@@ -0,0 +1,267 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <apr_atomic.h>
+#include "mrcp_engine_audio_producer.h"
+#include "apt_log.h"
+
+/** Size of linear PCM sample */
+#define MRCP_AUDIO_PRODUCER_SAMPLE_SIZE 2
+/** Max number of complete streams pending to be read (must be power of 2) */
+#define MRCP_AUDIO_PRODUCER_MAX_STREAMS 4
+
+/** Audio producer */
+struct mrcp_engine_audio_producer_t {
+	/** Duration of audio to prefetch (msec) */
+	apr_size_t            prefetch_duration;
+	/** Size of audio to prefetch (bytes) */
+	apr_uint32_t          prefetch_size;
+
+	/** Ring of audio (size is power of 2) */
+	char                 *ring;
+	/** Size of the ring */
+	apr_uint32_t          ring_size;
+	/** Write position (modified by the producer only) */
+	volatile apr_uint32_t write_pos;
+	/** Read position (modified by the consumer only) */
+	volatile apr_uint32_t read_pos;
+	/** End positions of complete streams */
+	apr_uint32_t          stream_ends[MRCP_AUDIO_PRODUCER_MAX_STREAMS];
+	/** Number of complete streams (modified by the producer only) */
+	volatile apr_uint32_t complete_seq;
+	/** Number of complete streams read to the end (modified by the consumer only) */
+	volatile apr_uint32_t read_seq;
+
+	/** Whether the stream is being prefetched (accessed by the consumer only) */
+	apt_bool_t            prefetching;
+	/** Whether any audio of the stream is read (accessed by the consumer only) */
+	apt_bool_t            started;
+	/** Number of underruns */
+	volatile apr_uint32_t underrun_count;
+};
+
+/** Create audio producer */
+MRCP_DECLARE(mrcp_engine_audio_producer_t*) mrcp_engine_audio_producer_create(
+												apr_size_t prefetch_duration,
+												apr_size_t capacity_duration,
+												apr_uint16_t max_sampling_rate,
+												apr_pool_t *pool)
+{
+	mrcp_engine_audio_producer_t *producer;
+	apr_uint32_t capacity;
+	apr_uint32_t ring_size = 1;
+	if(!capacity_duration || !max_sampling_rate || prefetch_duration > capacity_duration) {
+		return NULL;
+	}
+
+	capacity = (apr_uint32_t)(capacity_duration * max_sampling_rate / 1000 * MRCP_AUDIO_PRODUCER_SAMPLE_SIZE);
+	/* round the size of the ring up to power of 2 to keep positions valid over wraparound */
+	while(ring_size < capacity) {
+		ring_size <<= 1;
+	}
+
+	producer = apr_palloc(pool,sizeof(mrcp_engine_audio_producer_t));
+	producer->prefetch_duration = prefetch_duration;
+	producer->prefetch_size = (apr_uint32_t)(prefetch_duration * max_sampling_rate / 1000 * MRCP_AUDIO_PRODUCER_SAMPLE_SIZE);
+	producer->ring_size = ring_size;
+	producer->ring = apr_palloc(pool,ring_size);
+	producer->write_pos = 0;
+	producer->read_pos = 0;
+	producer->complete_seq = 0;
+	producer->read_seq = 0;
+	producer->prefetching = TRUE;
+	producer->started = FALSE;
+	producer->underrun_count = 0;
+	return producer;
+}
+
+/** Open audio producer */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_audio_producer_open(mrcp_engine_audio_producer_t *producer, const mpf_codec_descriptor_t *descriptor)
+{
+	apr_uint32_t prefetch_size;
+	if(!descriptor || !descriptor->sampling_rate) {
+		return FALSE;
+	}
+
+	prefetch_size = (apr_uint32_t)(producer->prefetch_duration * descriptor->sampling_rate / 1000 *
+		descriptor->channel_count * MRCP_AUDIO_PRODUCER_SAMPLE_SIZE);
+	if(prefetch_size > producer->ring_size) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Open Audio Producer: prefetch size [%u] exceeds [%u]",
+			prefetch_size,
+			producer->ring_size);
+		return FALSE;
+	}
+
+	/* the stream is opened before any audio is written or read */
+	producer->prefetch_size = prefetch_size;
+	apr_atomic_set32(&producer->write_pos,0);
+	apr_atomic_set32(&producer->read_pos,0);
+	apr_atomic_set32(&producer->complete_seq,0);
+	apr_atomic_set32(&producer->read_seq,0);
+	producer->prefetching = TRUE;
+	producer->started = FALSE;
+	return TRUE;
+}
+
+/** Load counter modified by the other side (read32 has no barrier, add32 has a full one) */
+static APR_INLINE apr_uint32_t mrcp_audio_producer_counter_load(volatile apr_uint32_t *counter)
+{
+	return apr_atomic_add32(counter,0);
+}
+
+/** Store counter after the data it refers to (the owner is the only writer, so the exchange succeeds) */
+static APR_INLINE void mrcp_audio_producer_counter_store(volatile apr_uint32_t *counter, apr_uint32_t value)
+{
+	apr_atomic_cas32(counter,value,*counter);
+}
+
+/** Write audio */
+MRCP_DECLARE(apr_size_t) mrcp_engine_audio_producer_write(mrcp_engine_audio_producer_t *producer, const char *data, apr_size_t size)
+{
+	apr_uint32_t write_pos = producer->write_pos;
+	apr_uint32_t space = producer->ring_size - (write_pos - mrcp_audio_producer_counter_load(&producer->read_pos));
+	apr_uint32_t offset;
+	apr_uint32_t part;
+	if(size > space) {
+		size = space;
+	}
+	if(!size) {
+		return 0;
+	}
+
+	offset = write_pos & (producer->ring_size - 1);
+	part = producer->ring_size - offset;
+	if(part >= size) {
+		memcpy(producer->ring + offset,data,size);
+	}
+	else {
+		memcpy(producer->ring + offset,data,part);
+		memcpy(producer->ring,data + part,size - part);
+	}
+	/* publish the audio after it is copied */
+	mrcp_audio_producer_counter_store(&producer->write_pos,write_pos + (apr_uint32_t)size);
+	return size;
+}
+
+/** Get available space */
+MRCP_DECLARE(apr_size_t) mrcp_engine_audio_producer_space_get(const mrcp_engine_audio_producer_t *producer)
+{
+	return producer->ring_size - (producer->write_pos -
+		mrcp_audio_producer_counter_load((volatile apr_uint32_t*)&producer->read_pos));
+}
+
+/** Indicate the end of stream */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_audio_producer_complete(mrcp_engine_audio_producer_t *producer)
+{
+	apr_uint32_t complete_seq = producer->complete_seq;
+	if(complete_seq - mrcp_audio_producer_counter_load(&producer->read_seq) >= MRCP_AUDIO_PRODUCER_MAX_STREAMS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Complete Audio Stream: [%d] streams are pending",
+			MRCP_AUDIO_PRODUCER_MAX_STREAMS);
+		return FALSE;
+	}
+
+	producer->stream_ends[complete_seq & (MRCP_AUDIO_PRODUCER_MAX_STREAMS - 1)] = producer->write_pos;
+	mrcp_audio_producer_counter_store(&producer->complete_seq,complete_seq + 1);
+	return TRUE;
+}
+
+/** Reset the state of the reader for the next stream */
+static APR_INLINE void mrcp_engine_audio_producer_reader_reset(mrcp_engine_audio_producer_t *producer)
+{
+	producer->prefetching = TRUE;
+	producer->started = FALSE;
+}
+
+/** Read frame */
+MRCP_DECLARE(mrcp_audio_producer_status_e) mrcp_engine_audio_producer_read(mrcp_engine_audio_producer_t *producer, mpf_frame_t *frame)
+{
+	/* load the completion sequence first, so that the entire audio of a complete stream is available too */
+	apr_uint32_t read_seq = producer->read_seq;
+	apt_bool_t complete = (mrcp_audio_producer_counter_load(&producer->complete_seq) != read_seq);
+	apr_uint32_t read_pos = producer->read_pos;
+	apr_uint32_t available = mrcp_audio_producer_counter_load(&producer->write_pos) - read_pos;
+	apr_uint32_t size = (apr_uint32_t)frame->codec_frame.size;
+	apr_uint32_t offset;
+	apr_uint32_t part;
+
+	if(complete) {
+		/* the audio of the next stream may already follow the end of the current one */
+		available = producer->stream_ends[read_seq & (MRCP_AUDIO_PRODUCER_MAX_STREAMS - 1)] - read_pos;
+	}
+
+	if(!available) {
+		if(complete) {
+			mrcp_audio_producer_counter_store(&producer->read_seq,read_seq + 1);
+			mrcp_engine_audio_producer_reader_reset(producer);
+			return MRCP_AUDIO_PRODUCER_COMPLETE;
+		}
+		if(producer->started == FALSE) {
+			return MRCP_AUDIO_PRODUCER_IDLE;
+		}
+	}
+
+	if(producer->prefetching == TRUE) {
+		if(available < producer->prefetch_size && !complete) {
+			return MRCP_AUDIO_PRODUCER_PREFETCHING;
+		}
+		producer->prefetching = FALSE;
+	}
+
+	if(available < size) {
+		if(!complete) {
+			/* rebuffer up to the prefetch depth before playback is resumed */
+			apr_atomic_inc32(&producer->underrun_count);
+			producer->prefetching = TRUE;
+			return MRCP_AUDIO_PRODUCER_UNDERRUN;
+		}
+		/* pad the tail of the stream with silence */
+		memset((char*)frame->codec_frame.buffer + available,0,size - available);
+		size = available;
+	}
+
+	offset = read_pos & (producer->ring_size - 1);
+	part = producer->ring_size - offset;
+	if(part >= size) {
+		memcpy(frame->codec_frame.buffer,producer->ring + offset,size);
+	}
+	else {
+		memcpy(frame->codec_frame.buffer,producer->ring + offset,part);
+		memcpy((char*)frame->codec_frame.buffer + part,producer->ring,size - part);
+	}
+	mrcp_audio_producer_counter_store(&producer->read_pos,read_pos + size);
+
+	producer->started = TRUE;
+	frame->type |= MEDIA_FRAME_TYPE_AUDIO;
+	return MRCP_AUDIO_PRODUCER_AUDIO;
+}
+
+/** Discard the audio of the current stream */
+MRCP_DECLARE(void) mrcp_engine_audio_producer_flush(mrcp_engine_audio_producer_t *producer)
+{
+	/* load the write position first, so that a stream completed meanwhile never ends before it */
+	apr_uint32_t write_pos = mrcp_audio_producer_counter_load(&producer->write_pos);
+	apr_uint32_t complete_seq = mrcp_audio_producer_counter_load(&producer->complete_seq);
+	/* the streams completed so far are discarded along with their audio */
+	mrcp_audio_producer_counter_store(&producer->read_pos,write_pos);
+	mrcp_audio_producer_counter_store(&producer->read_seq,complete_seq);
+	mrcp_engine_audio_producer_reader_reset(producer);
+}
+
+/** Get the number of underruns */
+MRCP_DECLARE(apr_size_t) mrcp_engine_audio_producer_underrun_count_get(const mrcp_engine_audio_producer_t *producer)
+{
+	return apr_atomic_read32((volatile apr_uint32_t*)&producer->underrun_count);
+}
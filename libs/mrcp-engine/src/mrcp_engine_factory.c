@@ -153,3 +153,25 @@ MRCP_DECLARE(apr_hash_index_t*) mrcp_engine_factory_engine_first(const mrcp_engi
 {
 	return apr_hash_first(factory->pool,factory->engines);
 }
+
+/** Get the highest channel usage across the engines */
+MRCP_DECLARE(apr_size_t) mrcp_engine_factory_channel_usage_get(const mrcp_engine_factory_t *factory)
+{
+	mrcp_engine_t *engine;
+	void *val;
+	apr_size_t usage;
+	apr_size_t max_usage = 0;
+	/* use the internal iterator of the hash, no memory is allocated */
+	apr_hash_index_t *it = apr_hash_first(NULL,factory->engines);
+	for(; it; it = apr_hash_next(it)) {
+		apr_hash_this(it,NULL,NULL,&val);
+		engine = val;
+		if(engine && engine->config && engine->config->max_channel_count) {
+			usage = engine->cur_channel_count * 100 / engine->config->max_channel_count;
+			if(usage > max_usage) {
+				max_usage = usage;
+			}
+		}
+	}
+	return max_usage;
+}
@@ -0,0 +1,413 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <apr_hash.h>
+#include <apr_ring.h>
+#include <apr_thread_mutex.h>
+#include "mrcp_engine_grammar_cache.h"
+#include "mrcp_generic_header.h"
+#include "mrcp_message.h"
+#include "apt_pool.h"
+#include "apt_log.h"
+
+/** Default memory budget of the cache (KB) */
+#define MRCP_ENGINE_GRAMMAR_CACHE_DEFAULT_SIZE 16384
+
+/** Cached grammar */
+struct mrcp_engine_grammar_t {
+	/** Ring entry (LRU list of the cache) */
+	APR_RING_ENTRY(mrcp_engine_grammar_t) link;
+	/** Next grammar with the same hash */
+	mrcp_engine_grammar_t *next;
+
+	/** Pool the grammar and its artifact are allocated from */
+	apr_pool_t            *pool;
+	/** Hash of Content-Id, Content-Type and content */
+	apr_uint64_t           hash;
+	/** Content-Id */
+	apt_str_t              content_id;
+	/** Content-Type */
+	apt_str_t              content_type;
+	/** Content */
+	apt_str_t              content;
+	/** Compiled artifact */
+	void                  *artifact;
+	/** Memory accounted in the budget of the cache */
+	apr_size_t             size;
+	/** Number of references */
+	apr_size_t             ref_count;
+};
+
+/** Grammar cache */
+struct mrcp_engine_grammar_cache_t {
+	/** Engine hooks */
+	const mrcp_engine_grammar_compiler_t *compiler;
+	/** Object to pass to the hooks */
+	void                                 *obj;
+
+	/** Guard of the cache */
+	apr_thread_mutex_t                   *guard;
+	/** Table of grammars (hash -> chain of grammars) */
+	apr_hash_t                           *table;
+	/** LRU list of grammars, most recently used first */
+	APR_RING_HEAD(mrcp_engine_grammar_head_t, mrcp_engine_grammar_t) lru;
+
+	/** Statistics */
+	mrcp_engine_grammar_cache_stats_t     stats;
+};
+
+/** Hash Content-Id, Content-Type and content (FNV-1a) */
+static apr_uint64_t mrcp_engine_grammar_hash(const apt_str_t *content_id, const apt_str_t *content_type, const apt_str_t *content)
+{
+	const apt_str_t *strs[3];
+	apr_size_t i;
+	apr_size_t j;
+	apr_uint64_t hash = APR_UINT64_C(14695981039346656037);
+
+	strs[0] = content_id;
+	strs[1] = content_type;
+	strs[2] = content;
+	for(i = 0; i < 3; i++) {
+		for(j = 0; j < strs[i]->length; j++) {
+			hash ^= (unsigned char)strs[i]->buf[j];
+			hash *= APR_UINT64_C(1099511628211);
+		}
+		/* separate the fields */
+		hash ^= 0xFF;
+		hash *= APR_UINT64_C(1099511628211);
+	}
+	return hash;
+}
+
+static APR_INLINE apt_bool_t mrcp_engine_grammar_str_equal(const apt_str_t *str1, const apt_str_t *str2)
+{
+	if(str1->length != str2->length)
+		return FALSE;
+	return (!str1->length || memcmp(str1->buf,str2->buf,str1->length) == 0) ? TRUE : FALSE;
+}
+
+/** Find grammar (the cache must be locked) */
+static mrcp_engine_grammar_t* mrcp_engine_grammar_find(
+								mrcp_engine_grammar_cache_t *cache,
+								apr_uint64_t hash,
+								const apt_str_t *content_id,
+								const apt_str_t *content_type,
+								const apt_str_t *content)
+{
+	mrcp_engine_grammar_t *grammar = apr_hash_get(cache->table,&hash,sizeof(hash));
+	for(; grammar; grammar = grammar->next) {
+		if(mrcp_engine_grammar_str_equal(&grammar->content,content) == TRUE &&
+			mrcp_engine_grammar_str_equal(&grammar->content_id,content_id) == TRUE &&
+			mrcp_engine_grammar_str_equal(&grammar->content_type,content_type) == TRUE) {
+			return grammar;
+		}
+	}
+	return NULL;
+}
+
+/** Insert grammar (the cache must be locked) */
+static void mrcp_engine_grammar_insert(mrcp_engine_grammar_cache_t *cache, mrcp_engine_grammar_t *grammar)
+{
+	grammar->next = apr_hash_get(cache->table,&grammar->hash,sizeof(grammar->hash));
+	if(grammar->next) {
+		/* an existing entry keeps its key, which is stored in the former head of the chain */
+		apr_hash_set(cache->table,&grammar->hash,sizeof(grammar->hash),NULL);
+	}
+	apr_hash_set(cache->table,&grammar->hash,sizeof(grammar->hash),grammar);
+	APR_RING_INSERT_HEAD(&cache->lru,grammar,mrcp_engine_grammar_t,link);
+	cache->stats.grammar_count++;
+	cache->stats.size += grammar->size;
+}
+
+/** Remove grammar (the cache must be locked) */
+static void mrcp_engine_grammar_remove(mrcp_engine_grammar_cache_t *cache, mrcp_engine_grammar_t *grammar)
+{
+	mrcp_engine_grammar_t *head = apr_hash_get(cache->table,&grammar->hash,sizeof(grammar->hash));
+	if(head == grammar) {
+		/* the key is stored in the head of the chain, therefore, it must be reset */
+		apr_hash_set(cache->table,&grammar->hash,sizeof(grammar->hash),NULL);
+		if(grammar->next) {
+			apr_hash_set(cache->table,&grammar->next->hash,sizeof(grammar->next->hash),grammar->next);
+		}
+	}
+	else {
+		while(head && head->next != grammar)
+			head = head->next;
+		if(head)
+			head->next = grammar->next;
+	}
+	grammar->next = NULL;
+	APR_RING_REMOVE(grammar,link);
+	cache->stats.grammar_count--;
+	cache->stats.size -= grammar->size;
+}
+
+/** Move the least recently used grammars, which are not referenced, to the list to destroy (the cache must be locked) */
+static void mrcp_engine_grammar_evict(mrcp_engine_grammar_cache_t *cache, struct mrcp_engine_grammar_head_t *evicted)
+{
+	mrcp_engine_grammar_t *grammar = APR_RING_LAST(&cache->lru);
+	mrcp_engine_grammar_t *prev;
+	while(cache->stats.size > cache->stats.max_size &&
+		grammar != APR_RING_SENTINEL(&cache->lru,mrcp_engine_grammar_t,link)) {
+		prev = APR_RING_PREV(grammar,link);
+		if(!grammar->ref_count) {
+			mrcp_engine_grammar_remove(cache,grammar);
+			APR_RING_INSERT_TAIL(evicted,grammar,mrcp_engine_grammar_t,link);
+			cache->stats.eviction_count++;
+		}
+		grammar = prev;
+	}
+}
+
+/** Destroy grammar (invoked outside the lock of the cache) */
+static void mrcp_engine_grammar_destroy(mrcp_engine_grammar_cache_t *cache, mrcp_engine_grammar_t *grammar)
+{
+	if(grammar->artifact && cache->compiler && cache->compiler->destroy) {
+		cache->compiler->destroy(cache->obj,grammar,grammar->artifact);
+	}
+	apr_pool_destroy(grammar->pool);
+}
+
+/** Destroy evicted grammars (invoked outside the lock of the cache) */
+static void mrcp_engine_grammar_list_destroy(mrcp_engine_grammar_cache_t *cache, struct mrcp_engine_grammar_head_t *list)
+{
+	mrcp_engine_grammar_t *grammar;
+	while(!APR_RING_EMPTY(list,mrcp_engine_grammar_t,link)) {
+		grammar = APR_RING_FIRST(list);
+		APR_RING_REMOVE(grammar,link);
+		mrcp_engine_grammar_destroy(cache,grammar);
+	}
+}
+
+/** Create and compile grammar (invoked outside the lock of the cache) */
+static mrcp_engine_grammar_t* mrcp_engine_grammar_create(
+								mrcp_engine_grammar_cache_t *cache,
+								apr_uint64_t hash,
+								const apt_str_t *content_id,
+								const apt_str_t *content_type,
+								const apt_str_t *content)
+{
+	mrcp_engine_grammar_t *grammar;
+	apr_size_t artifact_size = 0;
+	apr_pool_t *pool = apt_pool_create();
+	if(!pool)
+		return NULL;
+
+	grammar = apr_palloc(pool,sizeof(mrcp_engine_grammar_t));
+	APR_RING_ELEM_INIT(grammar,link);
+	grammar->next = NULL;
+	grammar->pool = pool;
+	grammar->hash = hash;
+	apt_string_copy(&grammar->content_id,content_id,pool);
+	apt_string_copy(&grammar->content_type,content_type,pool);
+	apt_string_copy(&grammar->content,content,pool);
+	grammar->artifact = NULL;
+	grammar->ref_count = 1;
+
+	if(cache->compiler && cache->compiler->compile) {
+		if(cache->compiler->compile(cache->obj,grammar,pool,&grammar->artifact,&artifact_size) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Compile Grammar <%s>",
+				grammar->content_id.buf ? grammar->content_id.buf : "");
+			mrcp_engine_grammar_destroy(cache,grammar);
+			return NULL;
+		}
+	}
+
+	grammar->size = sizeof(mrcp_engine_grammar_t) +
+		content_id->length + content_type->length + content->length + artifact_size;
+	return grammar;
+}
+
+/** Create grammar cache */
+MRCP_DECLARE(mrcp_engine_grammar_cache_t*) mrcp_engine_grammar_cache_create(
+											const mrcp_engine_t *engine,
+											const mrcp_engine_grammar_compiler_t *compiler,
+											void *obj,
+											apr_pool_t *pool)
+{
+	apr_size_t max_size = MRCP_ENGINE_GRAMMAR_CACHE_DEFAULT_SIZE;
+	mrcp_engine_grammar_cache_t *cache = apr_pcalloc(pool,sizeof(mrcp_engine_grammar_cache_t));
+	cache->compiler = compiler;
+	cache->obj = obj;
+	if(apr_thread_mutex_create(&cache->guard,APR_THREAD_MUTEX_DEFAULT,pool) != APR_SUCCESS) {
+		return NULL;
+	}
+	cache->table = apr_hash_make(pool);
+	APR_RING_INIT(&cache->lru,mrcp_engine_grammar_t,link);
+
+	if(engine) {
+		const char *str = mrcp_engine_param_get(engine,MRCP_ENGINE_GRAMMAR_CACHE_SIZE_PARAM);
+		if(str) {
+			max_size = atol(str);
+		}
+	}
+	cache->stats.max_size = max_size * 1024;
+	return cache;
+}
+
+/** Destroy grammar cache along with all the grammars cached */
+MRCP_DECLARE(void) mrcp_engine_grammar_cache_destroy(mrcp_engine_grammar_cache_t *cache)
+{
+	mrcp_engine_grammar_t *grammar;
+	struct mrcp_engine_grammar_head_t list;
+	APR_RING_INIT(&list,mrcp_engine_grammar_t,link);
+
+	apr_thread_mutex_lock(cache->guard);
+	while(!APR_RING_EMPTY(&cache->lru,mrcp_engine_grammar_t,link)) {
+		grammar = APR_RING_FIRST(&cache->lru);
+		if(grammar->ref_count) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Destroy Referenced Grammar <%s> [%"APR_SIZE_T_FMT"]",
+				grammar->content_id.buf ? grammar->content_id.buf : "",
+				grammar->ref_count);
+		}
+		mrcp_engine_grammar_remove(cache,grammar);
+		APR_RING_INSERT_TAIL(&list,grammar,mrcp_engine_grammar_t,link);
+	}
+	apr_thread_mutex_unlock(cache->guard);
+
+	mrcp_engine_grammar_list_destroy(cache,&list);
+	apr_thread_mutex_destroy(cache->guard);
+}
+
+/** Find or compile grammar and acquire a reference to it */
+MRCP_DECLARE(mrcp_engine_grammar_t*) mrcp_engine_grammar_acquire(
+										mrcp_engine_grammar_cache_t *cache,
+										const apt_str_t *content_id,
+										const apt_str_t *content_type,
+										const apt_str_t *content)
+{
+	mrcp_engine_grammar_t *grammar;
+	mrcp_engine_grammar_t *existing;
+	struct mrcp_engine_grammar_head_t evicted;
+	apr_uint64_t hash = mrcp_engine_grammar_hash(content_id,content_type,content);
+
+	apr_thread_mutex_lock(cache->guard);
+	grammar = mrcp_engine_grammar_find(cache,hash,content_id,content_type,content);
+	if(grammar) {
+		grammar->ref_count++;
+		APR_RING_REMOVE(grammar,link);
+		APR_RING_INSERT_HEAD(&cache->lru,grammar,mrcp_engine_grammar_t,link);
+		cache->stats.hit_count++;
+		apr_thread_mutex_unlock(cache->guard);
+		return grammar;
+	}
+	cache->stats.miss_count++;
+	apr_thread_mutex_unlock(cache->guard);
+
+	/* compile the grammar without holding the lock, so that other grammars can be
+	   looked up meanwhile; the same grammar might rarely be compiled concurrently */
+	grammar = mrcp_engine_grammar_create(cache,hash,content_id,content_type,content);
+
+	APR_RING_INIT(&evicted,mrcp_engine_grammar_t,link);
+	apr_thread_mutex_lock(cache->guard);
+	if(!grammar) {
+		cache->stats.failure_count++;
+		apr_thread_mutex_unlock(cache->guard);
+		return NULL;
+	}
+
+	existing = mrcp_engine_grammar_find(cache,hash,content_id,content_type,content);
+	if(existing) {
+		/* the same grammar has been compiled concurrently, use the one cached */
+		existing->ref_count++;
+		APR_RING_INSERT_TAIL(&evicted,grammar,mrcp_engine_grammar_t,link);
+		grammar = existing;
+	}
+	else {
+		mrcp_engine_grammar_insert(cache,grammar);
+		mrcp_engine_grammar_evict(cache,&evicted);
+	}
+	apr_thread_mutex_unlock(cache->guard);
+
+	mrcp_engine_grammar_list_destroy(cache,&evicted);
+	return grammar;
+}
+
+/** Find or compile grammar defined by the body of DEFINE-GRAMMAR or RECOGNIZE request */
+MRCP_DECLARE(mrcp_engine_grammar_t*) mrcp_engine_grammar_request_acquire(
+										mrcp_engine_grammar_cache_t *cache,
+										const mrcp_message_t *request)
+{
+	apt_str_t content_id;
+	apt_str_t content_type;
+	mrcp_generic_header_t *generic_header;
+	if(!request->body.length)
+		return NULL;
+
+	apt_string_reset(&content_id);
+	apt_string_reset(&content_type);
+	generic_header = mrcp_generic_header_get(request);
+	if(generic_header) {
+		if(mrcp_generic_header_property_check(request,GENERIC_HEADER_CONTENT_ID) == TRUE) {
+			content_id = generic_header->content_id;
+		}
+		if(mrcp_generic_header_property_check(request,GENERIC_HEADER_CONTENT_TYPE) == TRUE) {
+			content_type = generic_header->content_type;
+		}
+	}
+	return mrcp_engine_grammar_acquire(cache,&content_id,&content_type,&request->body);
+}
+
+/** Release reference to the grammar */
+MRCP_DECLARE(void) mrcp_engine_grammar_release(mrcp_engine_grammar_cache_t *cache, mrcp_engine_grammar_t *grammar)
+{
+	struct mrcp_engine_grammar_head_t evicted;
+	APR_RING_INIT(&evicted,mrcp_engine_grammar_t,link);
+
+	apr_thread_mutex_lock(cache->guard);
+	if(grammar->ref_count) {
+		grammar->ref_count--;
+	}
+	if(!grammar->ref_count) {
+		mrcp_engine_grammar_evict(cache,&evicted);
+	}
+	apr_thread_mutex_unlock(cache->guard);
+
+	mrcp_engine_grammar_list_destroy(cache,&evicted);
+}
+
+/** Get statistics of the cache */
+MRCP_DECLARE(void) mrcp_engine_grammar_cache_stats_get(mrcp_engine_grammar_cache_t *cache, mrcp_engine_grammar_cache_stats_t *stats)
+{
+	apr_thread_mutex_lock(cache->guard);
+	*stats = cache->stats;
+	apr_thread_mutex_unlock(cache->guard);
+}
+
+/** Get Content-Id of the grammar */
+MRCP_DECLARE(const apt_str_t*) mrcp_engine_grammar_content_id_get(const mrcp_engine_grammar_t *grammar)
+{
+	return &grammar->content_id;
+}
+
+/** Get Content-Type of the grammar */
+MRCP_DECLARE(const apt_str_t*) mrcp_engine_grammar_content_type_get(const mrcp_engine_grammar_t *grammar)
+{
+	return &grammar->content_type;
+}
+
+/** Get content of the grammar */
+MRCP_DECLARE(const apt_str_t*) mrcp_engine_grammar_content_get(const mrcp_engine_grammar_t *grammar)
+{
+	return &grammar->content;
+}
+
+/** Get compiled artifact of the grammar */
+MRCP_DECLARE(void*) mrcp_engine_grammar_artifact_get(const mrcp_engine_grammar_t *grammar)
+{
+	return grammar->artifact;
+}
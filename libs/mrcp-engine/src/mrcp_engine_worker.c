@@ -0,0 +1,404 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <apr_atomic.h>
+#include <apr_tables.h>
+#include "mrcp_engine_worker.h"
+#include "mrcp_engine_audio_batch.h"
+#include "mrcp_message.h"
+#include "apt_consumer_task.h"
+#include "apt_log.h"
+
+/** Default number of workers */
+#define MRCP_ENGINE_WORKER_DEFAULT_COUNT      1
+/** Max number of workers */
+#define MRCP_ENGINE_WORKER_MAX_COUNT          64
+/** Default max number of pending messages per worker */
+#define MRCP_ENGINE_WORKER_DEFAULT_QUEUE_SIZE 512
+/** Max number of pending messages per worker (capacity of the queue of consumer task is 1024) */
+#define MRCP_ENGINE_WORKER_MAX_QUEUE_SIZE     1000
+
+typedef enum {
+	MRCP_ENGINE_WORKER_MSG_OPEN_CHANNEL,
+	MRCP_ENGINE_WORKER_MSG_CLOSE_CHANNEL,
+	MRCP_ENGINE_WORKER_MSG_REQUEST_PROCESS,
+	MRCP_ENGINE_WORKER_MSG_AUDIO_PROCESS
+} mrcp_engine_worker_msg_type_e;
+
+typedef struct mrcp_engine_worker_msg_t mrcp_engine_worker_msg_t;
+
+/** Worker task message */
+struct mrcp_engine_worker_msg_t {
+	mrcp_engine_worker_msg_type_e type;
+	mrcp_engine_channel_t        *channel;
+	mrcp_message_t               *request;
+	mrcp_engine_audio_batcher_t  *batcher;
+};
+
+typedef struct mrcp_engine_worker_t mrcp_engine_worker_t;
+
+/** Engine worker (object of the consumer task) */
+struct mrcp_engine_worker_t {
+	/** Worker pool the worker belongs to */
+	mrcp_engine_worker_pool_t *worker_pool;
+	/** Messages the worker signals to itself, put aside while its queue is full (apt_task_msg_t*) */
+	apr_array_header_t        *deferred_msgs;
+};
+
+/** Engine worker pool */
+struct mrcp_engine_worker_pool_t {
+	/** Table of handlers */
+	const mrcp_engine_worker_vtable_t *vtable;
+	/** Array of workers */
+	apt_consumer_task_t              **workers;
+	/** Number of workers */
+	apr_size_t                         worker_count;
+	/** Max number of pending messages per worker */
+	apr_size_t                         max_queue_size;
+	/** Number of rejected messages */
+	volatile apr_uint32_t              rejected_count;
+};
+
+static apt_bool_t mrcp_engine_worker_msg_process(apt_task_t *task, apt_task_msg_t *msg);
+
+static apr_size_t mrcp_engine_worker_param_get(const mrcp_engine_t *engine, const char *name, apr_size_t default_value, apr_size_t max_value)
+{
+	apr_size_t value = default_value;
+	const char *str = mrcp_engine_param_get(engine,name);
+	if(str) {
+		value = atol(str);
+		if(!value) {
+			value = default_value;
+		}
+		else if(value > max_value) {
+			value = max_value;
+		}
+	}
+	return value;
+}
+
+/** Create worker pool */
+MRCP_DECLARE(mrcp_engine_worker_pool_t*) mrcp_engine_worker_pool_create(
+									const mrcp_engine_t *engine,
+									const char *name,
+									const mrcp_engine_worker_vtable_t *vtable,
+									apr_pool_t *pool)
+{
+	apr_size_t i;
+	apt_task_t *task;
+	apt_task_vtable_t *task_vtable;
+	apt_task_msg_pool_t *msg_pool;
+	mrcp_engine_worker_t *worker;
+	mrcp_engine_worker_pool_t *worker_pool;
+
+	if(!vtable || !vtable->on_request_process) {
+		return NULL;
+	}
+
+	worker_pool = apr_palloc(pool,sizeof(mrcp_engine_worker_pool_t));
+	worker_pool->vtable = vtable;
+	worker_pool->worker_count = MRCP_ENGINE_WORKER_DEFAULT_COUNT;
+	worker_pool->max_queue_size = MRCP_ENGINE_WORKER_DEFAULT_QUEUE_SIZE;
+	worker_pool->rejected_count = 0;
+	if(engine) {
+		worker_pool->worker_count = mrcp_engine_worker_param_get(
+			engine,
+			MRCP_ENGINE_WORKER_COUNT_PARAM,
+			MRCP_ENGINE_WORKER_DEFAULT_COUNT,
+			MRCP_ENGINE_WORKER_MAX_COUNT);
+		worker_pool->max_queue_size = mrcp_engine_worker_param_get(
+			engine,
+			MRCP_ENGINE_WORKER_QUEUE_SIZE_PARAM,
+			MRCP_ENGINE_WORKER_DEFAULT_QUEUE_SIZE,
+			MRCP_ENGINE_WORKER_MAX_QUEUE_SIZE);
+	}
+
+	/* the message pool is dynamic (malloc based), therefore, it is safe to share it among the workers */
+	msg_pool = apt_task_msg_pool_create_dynamic(sizeof(mrcp_engine_worker_msg_t),pool);
+	worker_pool->workers = apr_palloc(pool,sizeof(apt_consumer_task_t*) * worker_pool->worker_count);
+	for(i = 0; i < worker_pool->worker_count; i++) {
+		worker = apr_palloc(pool,sizeof(mrcp_engine_worker_t));
+		worker->worker_pool = worker_pool;
+		worker->deferred_msgs = apr_array_make(pool,1,sizeof(apt_task_msg_t*));
+		worker_pool->workers[i] = apt_consumer_task_create(worker,msg_pool,pool);
+		if(!worker_pool->workers[i]) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Engine Worker [%s] [%"APR_SIZE_T_FMT"]",name,i);
+			worker_pool->worker_count = i;
+			mrcp_engine_worker_pool_destroy(worker_pool);
+			return NULL;
+		}
+		task = apt_consumer_task_base_get(worker_pool->workers[i]);
+		if(worker_pool->worker_count > 1) {
+			apt_task_name_set(task,apr_psprintf(pool,"%s-%"APR_SIZE_T_FMT,name,i+1));
+		}
+		else {
+			apt_task_name_set(task,name);
+		}
+		task_vtable = apt_task_vtable_get(task);
+		if(task_vtable) {
+			task_vtable->process_msg = mrcp_engine_worker_msg_process;
+		}
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Create Engine Workers [%s] count [%"APR_SIZE_T_FMT"] queue size [%"APR_SIZE_T_FMT"]",
+		name,
+		worker_pool->worker_count,
+		worker_pool->max_queue_size);
+	return worker_pool;
+}
+
+/** Destroy worker pool */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_worker_pool_destroy(mrcp_engine_worker_pool_t *worker_pool)
+{
+	apr_size_t i;
+	int j;
+	mrcp_engine_worker_t *worker;
+	for(i = 0; i < worker_pool->worker_count; i++) {
+		if(worker_pool->workers[i]) {
+			worker = apt_consumer_task_object_get(worker_pool->workers[i]);
+			for(j = 0; j < worker->deferred_msgs->nelts; j++) {
+				apt_task_msg_release(APR_ARRAY_IDX(worker->deferred_msgs,j,apt_task_msg_t*));
+			}
+			worker->deferred_msgs->nelts = 0;
+			apt_task_destroy(apt_consumer_task_base_get(worker_pool->workers[i]));
+			worker_pool->workers[i] = NULL;
+		}
+	}
+	return TRUE;
+}
+
+/** Start workers */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_worker_pool_start(mrcp_engine_worker_pool_t *worker_pool)
+{
+	apr_size_t i;
+	apt_bool_t status = TRUE;
+	for(i = 0; i < worker_pool->worker_count; i++) {
+		if(apt_task_start(apt_consumer_task_base_get(worker_pool->workers[i])) == FALSE) {
+			status = FALSE;
+		}
+	}
+	return status;
+}
+
+/** Terminate workers and wait for their completion */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_worker_pool_terminate(mrcp_engine_worker_pool_t *worker_pool)
+{
+	apr_size_t i;
+	apt_bool_t status = TRUE;
+	for(i = 0; i < worker_pool->worker_count; i++) {
+		if(apt_task_terminate(apt_consumer_task_base_get(worker_pool->workers[i]),TRUE) == FALSE) {
+			status = FALSE;
+		}
+	}
+	return status;
+}
+
+/** Get the number of workers */
+MRCP_DECLARE(apr_size_t) mrcp_engine_worker_pool_count_get(const mrcp_engine_worker_pool_t *worker_pool)
+{
+	return worker_pool->worker_count;
+}
+
+/** Get the number of rejected messages */
+MRCP_DECLARE(apr_size_t) mrcp_engine_worker_pool_rejected_count_get(const mrcp_engine_worker_pool_t *worker_pool)
+{
+	return apr_atomic_read32((volatile apr_uint32_t*)&worker_pool->rejected_count);
+}
+
+/** Get the worker a channel is bound to */
+static APR_INLINE apt_consumer_task_t* mrcp_engine_worker_get(const mrcp_engine_worker_pool_t *worker_pool, const mrcp_engine_channel_t *channel)
+{
+	apr_size_t hash;
+	if(worker_pool->worker_count == 1) {
+		return worker_pool->workers[0];
+	}
+	/* channels are allocated from their own pools, drop the alignment bits and mix the rest */
+	hash = (apr_size_t)channel >> 4;
+	hash ^= hash >> 9;
+	hash *= 2654435761U;
+	hash ^= hash >> 16;
+	return worker_pool->workers[hash % worker_pool->worker_count];
+}
+
+static apt_bool_t mrcp_engine_worker_msg_signal(
+						mrcp_engine_worker_pool_t *worker_pool,
+						mrcp_engine_worker_msg_type_e type,
+						mrcp_engine_channel_t *channel,
+						mrcp_message_t *request,
+						mrcp_engine_audio_batcher_t *batcher,
+						apt_bool_t bounded)
+{
+	apt_bool_t status = FALSE;
+	apt_consumer_task_t *worker = mrcp_engine_worker_get(worker_pool,channel);
+	apt_task_t *task = apt_consumer_task_base_get(worker);
+	apt_task_msg_t *msg;
+
+	if(bounded == TRUE && apt_consumer_task_queue_size_get(worker) >= worker_pool->max_queue_size) {
+		apr_atomic_inc32(&worker_pool->rejected_count);
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Engine Worker Queue Is Full [%s] size [%"APR_SIZE_T_FMT"]",
+			apt_task_name_get(task),
+			worker_pool->max_queue_size);
+		return FALSE;
+	}
+
+	msg = apt_task_msg_get(task);
+	if(msg) {
+		mrcp_engine_worker_msg_t *worker_msg;
+		msg->type = TASK_MSG_USER;
+		worker_msg = (mrcp_engine_worker_msg_t*) msg->data;
+
+		worker_msg->type = type;
+		worker_msg->channel = channel;
+		worker_msg->request = request;
+		worker_msg->batcher = batcher;
+		status = apt_task_msg_signal(task,msg);
+	}
+	return status;
+}
+
+/** Signal channel open */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_worker_channel_open(mrcp_engine_worker_pool_t *worker_pool, mrcp_engine_channel_t *channel)
+{
+	if(mrcp_engine_worker_msg_signal(worker_pool,MRCP_ENGINE_WORKER_MSG_OPEN_CHANNEL,channel,NULL,NULL,TRUE) == FALSE) {
+		return mrcp_engine_channel_open_respond(channel,FALSE);
+	}
+	return TRUE;
+}
+
+/** Signal channel close */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_worker_channel_close(mrcp_engine_worker_pool_t *worker_pool, mrcp_engine_channel_t *channel)
+{
+	return mrcp_engine_worker_msg_signal(worker_pool,MRCP_ENGINE_WORKER_MSG_CLOSE_CHANNEL,channel,NULL,NULL,FALSE);
+}
+
+/** Signal close of the channel audio is batched for */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_worker_channel_close_ex(mrcp_engine_worker_pool_t *worker_pool, mrcp_engine_channel_t *channel, mrcp_engine_audio_batcher_t *batcher)
+{
+	return mrcp_engine_worker_msg_signal(worker_pool,MRCP_ENGINE_WORKER_MSG_CLOSE_CHANNEL,channel,NULL,batcher,FALSE);
+}
+
+/** Signal MRCP request */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_worker_request_process(mrcp_engine_worker_pool_t *worker_pool, mrcp_engine_channel_t *channel, mrcp_message_t *request)
+{
+	if(mrcp_engine_worker_msg_signal(worker_pool,MRCP_ENGINE_WORKER_MSG_REQUEST_PROCESS,channel,request,NULL,TRUE) == FALSE) {
+		/* one and only one response must be sent back to the request */
+		mrcp_message_t *response = mrcp_response_create(request,request->pool);
+		response->start_line.status_code = MRCP_STATUS_CODE_METHOD_FAILED;
+		return mrcp_engine_channel_message_send(channel,response);
+	}
+	return TRUE;
+}
+
+/** Signal availability of audio */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_worker_audio_signal(mrcp_engine_worker_pool_t *worker_pool, mrcp_engine_channel_t *channel, mrcp_engine_audio_batcher_t *batcher)
+{
+	return mrcp_engine_worker_msg_signal(worker_pool,MRCP_ENGINE_WORKER_MSG_AUDIO_PROCESS,channel,NULL,batcher,TRUE);
+}
+
+/** Process batch of audio */
+MRCP_DECLARE(apt_bool_t) mrcp_engine_worker_audio_batch_process(mrcp_engine_worker_pool_t *worker_pool, mrcp_engine_channel_t *channel, const mrcp_engine_audio_batch_t *batch)
+{
+	if(!worker_pool->vtable->on_audio_batch) {
+		return FALSE;
+	}
+	return worker_pool->vtable->on_audio_batch(channel,batch);
+}
+
+/** Put the close of the channel behind the pending audio signal (invoked by the worker) */
+static apt_bool_t mrcp_engine_worker_close_requeue(mrcp_engine_worker_t *worker, apt_consumer_task_t *consumer_task, const mrcp_engine_worker_msg_t *close_msg)
+{
+	mrcp_engine_worker_msg_t *worker_msg;
+	apt_task_msg_t *msg = apt_task_msg_get(apt_consumer_task_base_get(consumer_task));
+	if(!msg) {
+		return FALSE;
+	}
+	msg->type = TASK_MSG_USER;
+	worker_msg = (mrcp_engine_worker_msg_t*) msg->data;
+	*worker_msg = *close_msg;
+
+	/* the worker must not wait on its own queue, the message is put aside while the queue is full */
+	if(worker->deferred_msgs->nelts || apt_consumer_task_msg_trysignal(consumer_task,msg) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Defer Channel Close [%s] queue is full",
+			apt_task_name_get(apt_consumer_task_base_get(consumer_task)));
+		APR_ARRAY_PUSH(worker->deferred_msgs,apt_task_msg_t*) = msg;
+	}
+	return TRUE;
+}
+
+/** Signal the messages put aside, as long as there is room in the queue (invoked by the worker) */
+static void mrcp_engine_worker_deferred_signal(mrcp_engine_worker_t *worker, apt_consumer_task_t *consumer_task)
+{
+	int i;
+	int count = 0;
+	apt_task_msg_t **msgs = (apt_task_msg_t**)worker->deferred_msgs->elts;
+	while(count < worker->deferred_msgs->nelts &&
+		apt_consumer_task_msg_trysignal(consumer_task,msgs[count]) == TRUE) {
+		count++;
+	}
+	if(count) {
+		for(i = count; i < worker->deferred_msgs->nelts; i++) {
+			msgs[i - count] = msgs[i];
+		}
+		worker->deferred_msgs->nelts -= count;
+	}
+}
+
+static apt_bool_t mrcp_engine_worker_msg_process(apt_task_t *task, apt_task_msg_t *msg)
+{
+	apt_consumer_task_t *consumer_task = apt_task_object_get(task);
+	mrcp_engine_worker_t *worker = apt_consumer_task_object_get(consumer_task);
+	mrcp_engine_worker_pool_t *worker_pool = worker->worker_pool;
+	mrcp_engine_worker_msg_t *worker_msg = (mrcp_engine_worker_msg_t*)msg->data;
+	switch(worker_msg->type) {
+		case MRCP_ENGINE_WORKER_MSG_OPEN_CHANNEL:
+			if(worker_pool->vtable->on_channel_open) {
+				worker_pool->vtable->on_channel_open(worker_msg->channel);
+			}
+			else {
+				mrcp_engine_channel_open_respond(worker_msg->channel,TRUE);
+			}
+			break;
+		case MRCP_ENGINE_WORKER_MSG_CLOSE_CHANNEL:
+			if(worker_msg->batcher && mrcp_engine_audio_batcher_close(worker_msg->batcher) == FALSE) {
+				/* the audio signal is pending, put the close behind it to process no audio after the response */
+				if(mrcp_engine_worker_close_requeue(worker,consumer_task,worker_msg) == TRUE) {
+					break;
+				}
+			}
+			if(worker_pool->vtable->on_channel_close) {
+				worker_pool->vtable->on_channel_close(worker_msg->channel);
+			}
+			else {
+				mrcp_engine_channel_close_respond(worker_msg->channel);
+			}
+			break;
+		case MRCP_ENGINE_WORKER_MSG_REQUEST_PROCESS:
+			worker_pool->vtable->on_request_process(worker_msg->channel,worker_msg->request);
+			break;
+		case MRCP_ENGINE_WORKER_MSG_AUDIO_PROCESS:
+			mrcp_engine_audio_batcher_process(worker_msg->batcher);
+			break;
+		default:
+			break;
+	}
+
+	if(worker->deferred_msgs->nelts) {
+		/* a message has been taken from the queue, there might be room now */
+		mrcp_engine_worker_deferred_signal(worker,consumer_task);
+	}
+	return TRUE;
+}
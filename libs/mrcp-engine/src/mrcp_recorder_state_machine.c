@@ -48,6 +48,8 @@ struct mrcp_recorder_state_machine_t {
 	mrcp_message_t        *record;
 	/** properties used in set/get params */
 	mrcp_message_header_t *properties;
+	/** pool to allocate properties from (properties must not refer to the memory of requests) */
+	apr_pool_t            *pool;
 };
 
 typedef apt_bool_t (*recorder_method_f)(mrcp_recorder_state_machine_t *state_machine, mrcp_message_t *message);
@@ -92,7 +94,7 @@ static APR_INLINE void recorder_state_change(mrcp_recorder_state_machine_t *stat
 
 static apt_bool_t recorder_request_set_params(mrcp_recorder_state_machine_t *state_machine, mrcp_message_t *message)
 {
-	mrcp_header_fields_set(state_machine->properties,&message->header,message->pool);
+	mrcp_header_fields_set(state_machine->properties,&message->header,state_machine->pool);
 	return recorder_request_dispatch(state_machine,message);
 }
 
@@ -379,6 +381,7 @@ mrcp_state_machine_t* mrcp_recorder_state_machine_create(void *obj, mrcp_version
 	state_machine->state = RECORDER_STATE_IDLE;
 	state_machine->active_request = NULL;
 	state_machine->record = NULL;
+	state_machine->pool = pool;
 	state_machine->properties = mrcp_message_header_create(
 			mrcp_generic_header_vtable_get(version),
 			mrcp_recorder_header_vtable_get(version),
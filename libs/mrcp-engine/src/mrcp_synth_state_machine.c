@@ -54,6 +54,8 @@ struct mrcp_synth_state_machine_t {
 	apt_obj_list_t        *queue;
 	/** properties used in set/get params */
 	mrcp_message_header_t *properties;
+	/** pool to allocate properties from (properties must not refer to the memory of requests) */
+	apr_pool_t            *pool;
 };
 
 typedef apt_bool_t (*synth_method_f)(mrcp_synth_state_machine_t *state_machine, mrcp_message_t *message);
@@ -98,7 +100,7 @@ static APR_INLINE void synth_state_change(mrcp_synth_state_machine_t *state_mach
 
 static apt_bool_t synth_request_set_params(mrcp_synth_state_machine_t *state_machine, mrcp_message_t *message)
 {
-	mrcp_header_fields_set(state_machine->properties,&message->header,message->pool);
+	mrcp_header_fields_set(state_machine->properties,&message->header,state_machine->pool);
 	return synth_request_dispatch(state_machine,message);
 }
 
@@ -610,6 +612,7 @@ mrcp_state_machine_t* mrcp_synth_state_machine_create(void *obj, mrcp_version_e
 	state_machine->active_request = NULL;
 	state_machine->speaker = NULL;
 	state_machine->queue = apt_list_create(pool);
+	state_machine->pool = pool;
 	state_machine->properties = mrcp_message_header_create(
 			mrcp_generic_header_vtable_get(version),
 			mrcp_synth_header_vtable_get(version),
@@ -50,6 +50,8 @@ struct mrcp_verifier_state_machine_t {
 	mrcp_message_t        *verify;
 	/** properties used in set/get params */
 	mrcp_message_header_t *properties;
+	/** pool to allocate properties from (properties must not refer to the memory of requests) */
+	apr_pool_t            *pool;
 };
 
 typedef apt_bool_t (*verifier_method_f)(mrcp_verifier_state_machine_t *state_machine, mrcp_message_t *message);
@@ -94,7 +96,7 @@ static APR_INLINE void verifier_state_change(mrcp_verifier_state_machine_t *stat
 
 static apt_bool_t verifier_request_set_params(mrcp_verifier_state_machine_t *state_machine, mrcp_message_t *message)
 {
-	mrcp_header_fields_set(state_machine->properties,&message->header,message->pool);
+	mrcp_header_fields_set(state_machine->properties,&message->header,state_machine->pool);
 	return verifier_request_dispatch(state_machine,message);
 }
 
@@ -514,6 +516,7 @@ mrcp_state_machine_t* mrcp_verifier_state_machine_create(void *obj, mrcp_version
 	state_machine->state = VERIFIER_STATE_IDLE;
 	state_machine->active_request = NULL;
 	state_machine->verify = NULL;
+	state_machine->pool = pool;
 	state_machine->properties = mrcp_message_header_create(
 			mrcp_generic_header_vtable_get(version),
 			mrcp_verifier_header_vtable_get(version),
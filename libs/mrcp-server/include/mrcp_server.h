@@ -29,6 +29,43 @@
 
 APT_BEGIN_EXTERN_C
 
+/** Admission control settings declaration */
+typedef struct mrcp_server_admission_settings_t mrcp_server_admission_settings_t;
+/** Server load declaration */
+typedef struct mrcp_server_load_t mrcp_server_load_t;
+
+/** Admission control settings (thresholds new sessions are rejected at) */
+struct mrcp_server_admission_settings_t {
+	/** Max number of concurrent sessions (0 - not checked) */
+	apr_size_t max_session_count;
+	/** Max number of messages pending in the queue of a server task (0 - not checked) */
+	apr_size_t max_queue_depth;
+	/** Max number of media processing overruns per second (0 - not checked) */
+	apr_size_t max_overrun_count;
+	/** Max channel usage of an engine in percent of its max channel count (0 - not checked) */
+	apr_size_t max_channel_usage;
+	/** Interval in seconds sent in Retry-After along with rejection (0 - not sent) */
+	apr_size_t retry_after;
+};
+
+/** Server load */
+struct mrcp_server_load_t {
+	/** Number of sessions */
+	apr_size_t session_count;
+	/** Max number of messages pending in the queue of a server task */
+	apr_size_t queue_depth;
+	/** Number of media processing overruns within the last second */
+	apr_size_t overrun_count;
+	/** Total number of media processing overruns */
+	apr_size_t overrun_total;
+	/** Max channel usage of an engine in percent */
+	apr_size_t channel_usage;
+	/** Total number of sessions rejected by admission control */
+	apr_size_t rejected_count;
+	/** Whether any of the admission control thresholds is exceeded */
+	apt_bool_t overloaded;
+};
+
 /**
  * Create MRCP server instance.
  * @return the created server instance
@@ -66,6 +103,63 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_shutdown(mrcp_server_t *server);
  */
 MRCP_DECLARE(apt_bool_t) mrcp_server_destroy(mrcp_server_t *server);
 
+/**
+ * Set the number of shards sessions are distributed across.
+ * @param server the MRCP server to set the parameter for
+ * @param shard_count the number of shards (message processing tasks) including the main one
+ * @remark Should be called before the server is started. Sessions are assigned to the shards
+ *         by session id, and all the messages of a session are processed by the same shard.
+ *         Sessions are distributed only if all the loaded engines are concurrent, otherwise all
+ *         of them are processed by the main task (see mrcp_engine_iface.h).
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_shard_count_set(mrcp_server_t *server, apr_size_t shard_count);
+
+/**
+ * Set the max number of cleared session memory pools kept for reuse.
+ * @param server the MRCP server to set the parameter for
+ * @param pool_count the max number of pools to keep (0 - create and destroy a pool per session)
+ * @remark Should be called before the server is started. Session pools are cleared and reused
+ *         by subsequent sessions instead of being destroyed on session termination.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_session_pool_count_set(mrcp_server_t *server, apr_size_t pool_count);
+
+/**
+ * Allocate admission control settings.
+ * @param pool the pool to allocate memory from
+ */
+MRCP_DECLARE(mrcp_server_admission_settings_t*) mrcp_server_admission_settings_alloc(apr_pool_t *pool);
+
+/**
+ * Set admission control settings.
+ * @param server the MRCP server to set the settings for
+ * @param settings the settings to set (NULL - admit all the sessions)
+ * @remark New sessions are rejected (SIP/RTSP 503) while any of the thresholds is exceeded.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_admission_settings_set(mrcp_server_t *server, mrcp_server_admission_settings_t *settings);
+
+/**
+ * Get current load of the server.
+ * @param server the MRCP server to get the load of
+ * @param load the load to fill
+ * @remark Can be called from any thread, e.g. to report the load to an external load balancer.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_load_get(mrcp_server_t *server, mrcp_server_load_t *load);
+
+/**
+ * Check whether the load exceeds any of the admission control thresholds.
+ * @param settings the admission control settings (NULL - never exceeded)
+ * @param load the load to check
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_load_exceeded(const mrcp_server_admission_settings_t *settings, const mrcp_server_load_t *load);
+
+/**
+ * Calculate the number of media processing overruns per second.
+ * @param count the number of overruns counted since the previous sample
+ * @param elapsed the time elapsed since the previous sample
+ * @remark The load is sampled on demand, so the elapsed time may be much longer than a second.
+ */
+MRCP_DECLARE(apr_size_t) mrcp_server_overrun_rate_calculate(apr_size_t count, apr_interval_time_t elapsed);
+
 
 /**
  * Register MRCP resource factory.
@@ -31,8 +31,13 @@
 
 APT_BEGIN_EXTERN_C
 
+/** Length of the session id generated by the server */
+#define MRCP_SESSION_ID_HEX_STRING_LENGTH 16
+
 /** Opaque MRCP channel declaration */
 typedef struct mrcp_channel_t mrcp_channel_t;
+/** Opaque shard of the server core declaration */
+typedef struct mrcp_server_shard_t mrcp_server_shard_t;
 /** MRCP server session declaration */
 typedef struct mrcp_server_session_t mrcp_server_session_t;
 /** MRCP signaling message declaration */
@@ -79,6 +84,8 @@ struct mrcp_server_session_t {
 	mrcp_server_t              *server;
 	/** MRCP profile */
 	mrcp_server_profile_t      *profile;
+	/** Shard of the server core the session is processed by */
+	mrcp_server_shard_t        *shard;
 
 	/** Media context */
 	mpf_context_t              *context;
@@ -134,8 +141,8 @@ struct mrcp_server_profile_t {
 	mrcp_connection_agent_t   *connection_agent;
 };
 
-/** Create server session */
-mrcp_server_session_t* mrcp_server_session_create(void);
+/** Create server session (memory pool is acquired from the recycler, if specified) */
+mrcp_server_session_t* mrcp_server_session_create(apt_pool_recycler_t *recycler);
 
 /** Process signaling message */
 apt_bool_t mrcp_server_signaling_message_process(mrcp_signaling_message_t *signaling_message);
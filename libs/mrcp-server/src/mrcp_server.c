@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <apr_thread_mutex.h>
+#include <apr_atomic.h>
 #include "mrcp_server.h"
 #include "mrcp_server_session.h"
 #include "mrcp_message.h"
@@ -27,10 +29,33 @@
 #include "apt_pool.h"
 #include "apt_consumer_task.h"
 #include "apt_obj_list.h"
+#include "apt_text_stream.h"
 #include "apt_log.h"
 
 #define SERVER_TASK_NAME "MRCP Server"
 
+/** Default max number of cleared session pools kept for reuse */
+#define SERVER_SESSION_POOL_COUNT 100
+/** Interval media processing overruns are sampled at */
+#define SERVER_LOAD_SAMPLE_INTERVAL apr_time_from_sec(1)
+
+/** Shard of the server core, processing a subset of sessions in its own task */
+struct mrcp_server_shard_t {
+	/** Back pointer to server */
+	mrcp_server_t           *server;
+	/** Message processing task of the shard */
+	apt_consumer_task_t     *task;
+	/** Table of sessions processed by the shard */
+	apr_hash_t              *session_table;
+
+	/** Signaling task message pool */
+	apt_task_msg_pool_t     *signaling_msg_pool;
+	/** Connection task message pool */
+	apt_task_msg_pool_t     *connection_msg_pool;
+	/** Engine task message pool */
+	apt_task_msg_pool_t     *engine_msg_pool;
+};
+
 /** MRCP server */
 struct mrcp_server_t {
 	/** Main message processing task */
@@ -58,20 +83,41 @@ struct mrcp_server_t {
 	/** Table of profiles (mrcp_server_profile_t*) */
 	apr_hash_t              *profile_table;
 
-	/** Table of sessions */
-	apr_hash_t              *session_table;
-
-	/** Connection task message pool */
-	apt_task_msg_pool_t     *connection_msg_pool;
-	/** Engine task message pool */
-	apt_task_msg_pool_t     *engine_msg_pool;
+	/** Shards of the server core (mrcp_server_shard_t*), the first one is processed by the main task */
+	apr_array_header_t      *shards;
+	/** Number of sessions across the shards */
+	apr_size_t               session_count;
+	/** Guard of the session count and engine channels shared across the shards */
+	apr_thread_mutex_t      *guard;
+	/** Signal method of the main task messages are forwarded to the shards by */
+	apt_bool_t             (*signal_msg)(apt_task_t *task, apt_task_msg_t *msg);
+
+	/** Max number of cleared session pools kept for reuse (0 - no recycling) */
+	apr_size_t               session_pool_count;
+	/** Recycler of session pools */
+	apt_pool_recycler_t     *session_recycler;
+
+	/** Admission control settings (NULL - all the sessions are admitted) */
+	mrcp_server_admission_settings_t *admission_settings;
+	/** Guard of the load sampling */
+	apr_thread_mutex_t      *load_guard;
+	/** Total number of media processing overruns at the last sample */
+	apr_size_t               overrun_sample;
+	/** Time of the last sample */
+	apr_time_t               overrun_sample_time;
+	/** Number of media processing overruns per second calculated at the last sample */
+	apr_size_t               overrun_count;
+	/** Number of sessions rejected by admission control */
+	apr_size_t               rejected_count;
 
 	/** Dir layout structure */
 	apt_dir_layout_t        *dir_layout;
 	/** Time server started at */
 	apr_time_t               start_time;
-	/** Shutting down or not */
-	apt_bool_t               shutdown_requested;
+	/** Shutting down or not (accessed atomically) */
+	volatile apr_uint32_t    shutdown_requested;
+	/** Distribute sessions across the shards (all the engines are concurrent) */
+	apt_bool_t               sharding;
 	/** Memory pool */
 	apr_pool_t              *pool;
 };
@@ -81,9 +127,16 @@ typedef enum {
 	MRCP_SERVER_SIGNALING_TASK_MSG = TASK_MSG_USER,
 	MRCP_SERVER_CONNECTION_TASK_MSG,
 	MRCP_SERVER_ENGINE_TASK_MSG,
-	MRCP_SERVER_MEDIA_TASK_MSG
+	MRCP_SERVER_MEDIA_TASK_MSG,
+	MRCP_SERVER_SHARD_TASK_MSG
 } mrcp_server_task_msg_type_e;
 
+/* Shard interface */
+typedef enum {
+	SHARD_TASK_MSG_RELEASE_SESSIONS,
+	SHARD_TASK_MSG_SESSIONS_RELEASED
+} shard_task_msg_type_e;
+
 
 static apt_bool_t mrcp_server_offer_signal(mrcp_session_t *session, mrcp_session_descriptor_t *descriptor);
 static apt_bool_t mrcp_server_terminate_signal(mrcp_session_t *session);
@@ -165,6 +218,7 @@ const mrcp_engine_channel_event_vtable_t engine_channel_vtable = {
 };
 
 /* Task interface */
+static apt_bool_t mrcp_server_msg_signal(apt_task_t *task, apt_task_msg_t *msg);
 static apt_bool_t mrcp_server_msg_process(apt_task_t *task, apt_task_msg_t *msg);
 static apt_bool_t mrcp_server_start_request_process(apt_task_t *task);
 static apt_bool_t mrcp_server_terminate_request_process(apt_task_t *task);
@@ -174,18 +228,21 @@ static void mrcp_server_on_offline_complete(apt_task_t *task);
 static void mrcp_server_on_online_complete(apt_task_t *task);
 
 static mrcp_session_t* mrcp_server_sig_agent_session_create(mrcp_sig_agent_t *signaling_agent);
+static mrcp_server_shard_t* mrcp_server_shard_create(mrcp_server_t *server, const char *name);
 static apt_bool_t mrcp_server_do_terminate(mrcp_server_t *server);
-static void mrcp_server_sessions_release(mrcp_server_t *server);
+static void mrcp_server_sessions_release(mrcp_server_shard_t *shard);
+static APR_INLINE void mrcp_server_lock(mrcp_server_t *server);
+static APR_INLINE void mrcp_server_unlock(mrcp_server_t *server);
 
 
 /** Create MRCP server instance */
 MRCP_DECLARE(mrcp_server_t*) mrcp_server_create(apt_dir_layout_t *dir_layout)
 {
 	mrcp_server_t *server;
+	mrcp_server_shard_t *shard;
 	apr_pool_t *pool;
 	apt_task_t *task;
 	apt_task_vtable_t *vtable;
-	apt_task_msg_pool_t *msg_pool;
 	
 	pool = apt_pool_create();
 	if(!pool) {
@@ -205,23 +262,32 @@ MRCP_DECLARE(mrcp_server_t*) mrcp_server_create(apt_dir_layout_t *dir_layout)
 	server->cnt_agent_table = NULL;
 	server->rtp_settings_table = NULL;
 	server->profile_table = NULL;
-	server->session_table = NULL;
-	server->connection_msg_pool = NULL;
-	server->engine_msg_pool = NULL;
-	server->shutdown_requested = FALSE;
-
-	msg_pool = apt_task_msg_pool_create_dynamic(0,pool);
-
-	server->task = apt_consumer_task_create(server,msg_pool,pool);
-	if(!server->task) {
+	server->session_count = 0;
+	server->guard = NULL;
+	server->signal_msg = NULL;
+	server->session_pool_count = SERVER_SESSION_POOL_COUNT;
+	server->session_recycler = NULL;
+	server->admission_settings = NULL;
+	server->load_guard = NULL;
+	server->overrun_sample = 0;
+	server->overrun_sample_time = 0;
+	server->overrun_count = 0;
+	server->rejected_count = 0;
+	apr_atomic_set32(&server->shutdown_requested,FALSE);
+	server->sharding = FALSE;
+
+	server->shards = apr_array_make(pool,1,sizeof(mrcp_server_shard_t*));
+	shard = mrcp_server_shard_create(server,SERVER_TASK_NAME);
+	if(!shard) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Server Task");
 		return NULL;
 	}
+	server->task = shard->task;
 	task = apt_consumer_task_base_get(server->task);
-	apt_task_name_set(task,SERVER_TASK_NAME);
 	vtable = apt_task_vtable_get(task);
 	if(vtable) {
-		vtable->process_msg = mrcp_server_msg_process;
+		server->signal_msg = vtable->signal_msg;
+		vtable->signal_msg = mrcp_server_msg_signal;
 		vtable->process_start = mrcp_server_start_request_process;
 		vtable->process_terminate = mrcp_server_terminate_request_process;
 		vtable->on_start_complete = mrcp_server_on_start_complete;
@@ -240,11 +306,208 @@ MRCP_DECLARE(mrcp_server_t*) mrcp_server_create(apt_dir_layout_t *dir_layout)
 	server->cnt_agent_table = apr_hash_make(server->pool);
 
 	server->profile_table = apr_hash_make(server->pool);
-	
-	server->session_table = apr_hash_make(server->pool);
+
+	if(apr_thread_mutex_create(&server->load_guard,APR_THREAD_MUTEX_DEFAULT,server->pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Load Guard");
+		server->load_guard = NULL;
+	}
 	return server;
 }
 
+/** Set the number of shards (tasks) sessions are distributed across */
+MRCP_DECLARE(apt_bool_t) mrcp_server_shard_count_set(mrcp_server_t *server, apr_size_t shard_count)
+{
+	mrcp_server_shard_t *shard;
+	apt_task_t *task;
+	apr_size_t i;
+	if(!server || !server->task) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Server Instance");
+		return FALSE;
+	}
+	if(server->shards->nelts > 1) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Shards Already Created");
+		return FALSE;
+	}
+	if(shard_count <= 1) {
+		return TRUE;
+	}
+
+	if(apr_thread_mutex_create(&server->guard,APR_THREAD_MUTEX_DEFAULT,server->pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Server Guard");
+		server->guard = NULL;
+		return FALSE;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Shard Count [%"APR_SIZE_T_FMT"]",shard_count);
+	task = apt_consumer_task_base_get(server->task);
+	for(i = 1; i < shard_count; i++) {
+		shard = mrcp_server_shard_create(server,apr_psprintf(server->pool,SERVER_TASK_NAME"-%"APR_SIZE_T_FMT,i));
+		if(!shard) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Server Shard [%"APR_SIZE_T_FMT"]",i);
+			break;
+		}
+		apt_task_add(task,apt_consumer_task_base_get(shard->task));
+	}
+	return TRUE;
+}
+
+/** Set the max number of cleared session pools kept for reuse */
+MRCP_DECLARE(apt_bool_t) mrcp_server_session_pool_count_set(mrcp_server_t *server, apr_size_t pool_count)
+{
+	if(!server || server->session_recycler) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Set Session Pool Count");
+		return FALSE;
+	}
+	server->session_pool_count = pool_count;
+	return TRUE;
+}
+
+/** Allocate admission control settings */
+MRCP_DECLARE(mrcp_server_admission_settings_t*) mrcp_server_admission_settings_alloc(apr_pool_t *pool)
+{
+	mrcp_server_admission_settings_t *settings = apr_palloc(pool,sizeof(mrcp_server_admission_settings_t));
+	settings->max_session_count = 0;
+	settings->max_queue_depth = 0;
+	settings->max_overrun_count = 0;
+	settings->max_channel_usage = 0;
+	settings->retry_after = 0;
+	return settings;
+}
+
+/** Set admission control settings */
+MRCP_DECLARE(apt_bool_t) mrcp_server_admission_settings_set(mrcp_server_t *server, mrcp_server_admission_settings_t *settings)
+{
+	if(!server || !server->load_guard) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Set Admission Control Settings");
+		return FALSE;
+	}
+	if(settings) {
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Admission Control: sessions [%"APR_SIZE_T_FMT"] queue [%"APR_SIZE_T_FMT"] overruns [%"APR_SIZE_T_FMT"] channel usage [%"APR_SIZE_T_FMT"%%]",
+			settings->max_session_count,
+			settings->max_queue_depth,
+			settings->max_overrun_count,
+			settings->max_channel_usage);
+	}
+	apr_thread_mutex_lock(server->load_guard);
+	server->admission_settings = settings;
+	apr_thread_mutex_unlock(server->load_guard);
+	return TRUE;
+}
+
+/** Check whether the load exceeds any of the admission control thresholds */
+MRCP_DECLARE(apt_bool_t) mrcp_server_load_exceeded(const mrcp_server_admission_settings_t *settings, const mrcp_server_load_t *load)
+{
+	if(!settings) {
+		return FALSE;
+	}
+	if(settings->max_session_count && load->session_count >= settings->max_session_count) {
+		return TRUE;
+	}
+	if(settings->max_queue_depth && load->queue_depth >= settings->max_queue_depth) {
+		return TRUE;
+	}
+	if(settings->max_overrun_count && load->overrun_count >= settings->max_overrun_count) {
+		return TRUE;
+	}
+	if(settings->max_channel_usage && load->channel_usage >= settings->max_channel_usage) {
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/** Calculate the number of media processing overruns per second */
+MRCP_DECLARE(apr_size_t) mrcp_server_overrun_rate_calculate(apr_size_t count, apr_interval_time_t elapsed)
+{
+	if(elapsed <= 0) {
+		return count;
+	}
+	/* the count is averaged over the elapsed time, which may be longer than a second
+	if the load hasn't been sampled for a while */
+	return (apr_size_t)(((apr_uint64_t)count * SERVER_LOAD_SAMPLE_INTERVAL) / elapsed);
+}
+
+/** Get current load of the server */
+MRCP_DECLARE(apt_bool_t) mrcp_server_load_get(mrcp_server_t *server, mrcp_server_load_t *load)
+{
+	mrcp_server_shard_t *shard;
+	apr_hash_index_t *it;
+	void *val;
+	apr_size_t queue_depth;
+	apr_size_t overrun_total = 0;
+	apr_time_t now;
+	int i;
+
+	if(!server || !load || !server->load_guard) {
+		return FALSE;
+	}
+
+	mrcp_server_lock(server);
+	load->session_count = server->session_count;
+	mrcp_server_unlock(server);
+
+	load->queue_depth = 0;
+	for(i=0; i<server->shards->nelts; i++) {
+		shard = APR_ARRAY_IDX(server->shards,i,mrcp_server_shard_t*);
+		queue_depth = apt_consumer_task_queue_size_get(shard->task);
+		if(queue_depth > load->queue_depth) {
+			load->queue_depth = queue_depth;
+		}
+	}
+
+	apr_thread_mutex_lock(server->load_guard);
+	/* the tables are iterated by the internal iterators under the load guard */
+	for(it = apr_hash_first(NULL,server->media_engine_table); it; it = apr_hash_next(it)) {
+		apr_hash_this(it,NULL,NULL,&val);
+		if(val) {
+			overrun_total += mpf_engine_overrun_count_get(val);
+		}
+	}
+	now = apr_time_now();
+	if(!server->overrun_sample_time) {
+		server->overrun_sample = overrun_total;
+		server->overrun_sample_time = now;
+	}
+	else if(now - server->overrun_sample_time >= SERVER_LOAD_SAMPLE_INTERVAL) {
+		server->overrun_count = mrcp_server_overrun_rate_calculate(
+									overrun_total - server->overrun_sample,
+									now - server->overrun_sample_time);
+		server->overrun_sample = overrun_total;
+		server->overrun_sample_time = now;
+	}
+	load->overrun_count = server->overrun_count;
+	load->overrun_total = overrun_total;
+	load->channel_usage = mrcp_engine_factory_channel_usage_get(server->engine_factory);
+	load->rejected_count = server->rejected_count;
+	load->overloaded = mrcp_server_load_exceeded(server->admission_settings,load);
+	apr_thread_mutex_unlock(server->load_guard);
+	return TRUE;
+}
+
+/** Check whether sessions can be distributed across the shards */
+static apt_bool_t mrcp_server_sharding_check(mrcp_server_t *server)
+{
+	mrcp_engine_t *engine;
+	apr_hash_index_t *it;
+	void *val;
+	if(server->shards->nelts <= 1) {
+		return FALSE;
+	}
+
+	/* engines, which are not concurrent, must be called from within a single task */
+	it = mrcp_engine_factory_engine_first(server->engine_factory);
+	for(; it; it = apr_hash_next(it)) {
+		apr_hash_this(it,NULL,NULL,&val);
+		engine = val;
+		if(engine && engine->concurrent == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Engine [%s] Is Not Concurrent, Process Sessions by "SERVER_TASK_NAME" Only",
+				engine->id);
+			return FALSE;
+		}
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Distribute Sessions across Shards [%d]",server->shards->nelts);
+	return TRUE;
+}
+
 /** Start message processing loop */
 MRCP_DECLARE(apt_bool_t) mrcp_server_start(mrcp_server_t *server)
 {
@@ -253,6 +516,15 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_start(mrcp_server_t *server)
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Server");
 		return FALSE;
 	}
+	if(server->session_pool_count && !server->session_recycler) {
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Create Session Pool Recycler [%"APR_SIZE_T_FMT"]",server->session_pool_count);
+		/* sessions are processed by different threads, do not let them contend for a single allocator */
+		server->session_recycler = apt_pool_recycler_create_ex(server->session_pool_count,TRUE,server->pool);
+		if(!server->session_recycler) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Session Pool Recycler");
+		}
+	}
+	server->sharding = mrcp_server_sharding_check(server);
 	server->start_time = apr_time_now();
 	task = apt_consumer_task_base_get(server->task);
 	if(apt_task_start(task) == FALSE) {
@@ -302,7 +574,6 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_shutdown(mrcp_server_t *server)
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Shutdown Server Task");
 		return FALSE;
 	}
-	server->session_table = NULL;
 	uptime = apr_time_now() - server->start_time;
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Server Uptime [%"APR_TIME_T_FMT" sec]", apr_time_sec(uptime));
 	return TRUE;
@@ -345,9 +616,6 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_engine_register(mrcp_server_t *server, mrcp
 		return FALSE;
 	}
 	
-	if(!server->engine_msg_pool) {
-		server->engine_msg_pool = apt_task_msg_pool_create_dynamic(sizeof(engine_task_msg_data_t),server->pool);
-	}
 	engine->codec_manager = server->codec_manager;
 	engine->dir_layout = server->dir_layout;
 	engine->event_vtable = &engine_vtable;
@@ -481,7 +749,6 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_connection_agent_register(mrcp_server_t *se
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Register Connection Agent [%s]",id);
 	mrcp_server_connection_resource_factory_set(connection_agent,server->resource_factory);
 	mrcp_server_connection_agent_handler_set(connection_agent,server,&connection_method_vtable);
-	server->connection_msg_pool = apt_task_msg_pool_create_dynamic(sizeof(connection_agent_task_msg_data_t),server->pool);
 	apr_hash_set(server->cnt_agent_table,id,APR_HASH_KEY_STRING,connection_agent);
 	if(server->task) {
 		apt_task_t *task = apt_consumer_task_base_get(server->task);
@@ -637,44 +904,205 @@ MRCP_DECLARE(apr_pool_t*) mrcp_server_memory_pool_get(const mrcp_server_t *serve
 	return server->pool;
 }
 
+static APR_INLINE void mrcp_server_lock(mrcp_server_t *server)
+{
+	if(server->guard) {
+		apr_thread_mutex_lock(server->guard);
+	}
+}
+
+static APR_INLINE void mrcp_server_unlock(mrcp_server_t *server)
+{
+	if(server->guard) {
+		apr_thread_mutex_unlock(server->guard);
+	}
+}
+
+static mrcp_server_shard_t* mrcp_server_shard_create(mrcp_server_t *server, const char *name)
+{
+	apt_task_t *task;
+	apt_task_vtable_t *vtable;
+	apt_task_msg_pool_t *msg_pool;
+	mrcp_server_shard_t *shard = apr_palloc(server->pool,sizeof(mrcp_server_shard_t));
+	shard->server = server;
+
+	msg_pool = apt_task_msg_pool_create_dynamic(0,server->pool);
+	shard->task = apt_consumer_task_create(shard,msg_pool,server->pool);
+	if(!shard->task) {
+		return NULL;
+	}
+	task = apt_consumer_task_base_get(shard->task);
+	apt_task_name_set(task,name);
+	vtable = apt_task_vtable_get(task);
+	if(vtable) {
+		vtable->process_msg = mrcp_server_msg_process;
+	}
+
+	shard->session_table = apr_hash_make(server->pool);
+	shard->signaling_msg_pool = apt_task_msg_pool_create_dynamic(sizeof(mrcp_signaling_message_t*),server->pool);
+	shard->connection_msg_pool = apt_task_msg_pool_create_dynamic(sizeof(connection_agent_task_msg_data_t),server->pool);
+	shard->engine_msg_pool = apt_task_msg_pool_create_dynamic(sizeof(engine_task_msg_data_t),server->pool);
+
+	APR_ARRAY_PUSH(server->shards,mrcp_server_shard_t*) = shard;
+	return shard;
+}
+
+static APR_INLINE mrcp_server_shard_t* mrcp_server_main_shard_get(const mrcp_server_t *server)
+{
+	return APR_ARRAY_IDX(server->shards,0,mrcp_server_shard_t*);
+}
+
+/** Get the shard the session is processed by, select it by session id on the first use */
+static mrcp_server_shard_t* mrcp_server_session_shard_get(mrcp_server_t *server, mrcp_server_session_t *session)
+{
+	apr_ssize_t length;
+	apr_size_t index = 0;
+	if(session->shard) {
+		return session->shard;
+	}
+
+	if(server->sharding == TRUE) {
+		if(!session->base.id.length) {
+			/* generate session id in advance, otherwise it is generated on the initial offer */
+			apt_unique_id_generate(&session->base.id,MRCP_SESSION_ID_HEX_STRING_LENGTH,session->base.pool);
+		}
+		length = session->base.id.length;
+		index = apr_hashfunc_default(session->base.id.buf,&length) % server->shards->nelts;
+	}
+	session->shard = APR_ARRAY_IDX(server->shards,index,mrcp_server_shard_t*);
+	return session->shard;
+}
+
+/** Get the shard an MPF message container is to be processed by */
+static mrcp_server_shard_t* mrcp_server_mpf_message_shard_get(const mpf_message_container_t *mpf_message_container)
+{
+	apr_size_t i;
+	mrcp_server_session_t *session;
+	for(i=0; i<mpf_message_container->count; i++) {
+		const mpf_message_t *mpf_message = &mpf_message_container->messages[i];
+		if(mpf_message->context) {
+			session = mpf_engine_context_object_get(mpf_message->context);
+			if(session) {
+				return session->shard;
+			}
+		}
+	}
+	return NULL;
+}
+
+static apt_bool_t mrcp_server_shard_task_msg_signal(shard_task_msg_type_e type, mrcp_server_shard_t *shard)
+{
+	apt_task_t *task = apt_consumer_task_base_get(shard->task);
+	apt_task_msg_t *task_msg = apt_task_msg_get(task);
+	if(!task_msg) {
+		return FALSE;
+	}
+	task_msg->type = MRCP_SERVER_SHARD_TASK_MSG;
+	task_msg->sub_type = type;
+	return apt_task_msg_signal(task,task_msg);
+}
+
+apt_bool_t mrcp_server_session_admit(mrcp_server_t *server, mrcp_server_session_t *session, apr_size_t *retry_after)
+{
+	mrcp_server_load_t load;
+	if(!server->admission_settings) {
+		return TRUE;
+	}
+	if(mrcp_server_load_get(server,&load) == FALSE || load.overloaded == FALSE) {
+		return TRUE;
+	}
+
+	apr_thread_mutex_lock(server->load_guard);
+	server->rejected_count++;
+	*retry_after = server->admission_settings ? server->admission_settings->retry_after : 0;
+	apr_thread_mutex_unlock(server->load_guard);
+
+	apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Reject Session " APT_NAMESID_FMT" Overloaded: sessions [%"APR_SIZE_T_FMT"] queue [%"APR_SIZE_T_FMT"] overruns [%"APR_SIZE_T_FMT"] channel usage [%"APR_SIZE_T_FMT"%%]",
+		session->base.name,
+		MRCP_SESSION_SID(&session->base),
+		load.session_count,
+		load.queue_depth,
+		load.overrun_count,
+		load.channel_usage);
+	return FALSE;
+}
+
 void mrcp_server_session_add(mrcp_server_t *server, mrcp_server_session_t *session)
 {
+	mrcp_server_shard_t *shard;
 	if(!session->base.id.buf) 
 		return;
 
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Add Session " APT_SID_FMT,MRCP_SESSION_SID(&session->base));
-	apr_hash_set(server->session_table,session->base.id.buf,session->base.id.length,session);
+	shard = mrcp_server_session_shard_get(server,session);
+	apr_hash_set(shard->session_table,session->base.id.buf,session->base.id.length,session);
+
+	mrcp_server_lock(server);
+	server->session_count++;
+	mrcp_server_unlock(server);
 }
 
 void mrcp_server_session_remove(mrcp_server_t *server, mrcp_server_session_t *session)
 {
+	mrcp_server_shard_t *shard;
 	if(!session->base.id.buf) 
 		return;
 
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Remove Session " APT_SID_FMT,MRCP_SESSION_SID(&session->base));
-	apr_hash_set(server->session_table,session->base.id.buf,session->base.id.length,NULL);
+	shard = mrcp_server_session_shard_get(server,session);
+	if(!apr_hash_get(shard->session_table,session->base.id.buf,session->base.id.length)) {
+		return;
+	}
+	apr_hash_set(shard->session_table,session->base.id.buf,session->base.id.length,NULL);
+
+	mrcp_server_lock(server);
+	server->session_count--;
+	mrcp_server_unlock(server);
+}
+
+/** Check whether shutdown is requested and no sessions remain */
+static apt_bool_t mrcp_server_shutdown_ready(mrcp_server_t *server)
+{
+	apt_bool_t ready = FALSE;
+	mrcp_server_lock(server);
+	if(apr_atomic_read32(&server->shutdown_requested) == TRUE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Shutdown Pending: remaining sessions [%"APR_SIZE_T_FMT"]", server->session_count);
+		if(!server->session_count) {
+			ready = TRUE;
+		}
+	}
+	mrcp_server_unlock(server);
+	return ready;
 }
 
 void mrcp_server_session_idle_test(mrcp_server_t *server)
 {
-	if(server->shutdown_requested == TRUE) {
-		unsigned int count = apr_hash_count(server->session_table);
-		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Shutdown Pending: remaining sessions [%d]", count);
-		if(!count) {
+	if(mrcp_server_shutdown_ready(server) == TRUE) {
+		if(server->shards->nelts > 1) {
+			/* engines are closed from within the main task */
+			mrcp_server_shard_task_msg_signal(SHARD_TASK_MSG_SESSIONS_RELEASED,mrcp_server_main_shard_get(server));
+		}
+		else {
 			mrcp_server_do_terminate(server);
 		}
 	}
 }
 
-static APR_INLINE mrcp_server_session_t* mrcp_server_session_find(mrcp_server_t *server, const apt_str_t *session_id)
+void mrcp_server_engine_lock(mrcp_server_t *server)
+{
+	mrcp_server_lock(server);
+}
+
+void mrcp_server_engine_unlock(mrcp_server_t *server)
 {
-	return apr_hash_get(server->session_table,session_id->buf,session_id->length);
+	mrcp_server_unlock(server);
 }
 
 static apt_bool_t mrcp_server_start_request_process(apt_task_t *task)
 {
 	apt_consumer_task_t *consumer_task = apt_task_object_get(task);
-	mrcp_server_t *server = apt_consumer_task_object_get(consumer_task);
+	mrcp_server_shard_t *shard = apt_consumer_task_object_get(consumer_task);
+	mrcp_server_t *server = shard->server;
 
 	mrcp_engine_t *engine;
 	apr_hash_index_t *it;
@@ -710,16 +1138,16 @@ static apt_bool_t mrcp_server_do_terminate(mrcp_server_t *server)
 		}
 	}
 
-	server->shutdown_requested = FALSE;
+	apr_atomic_set32(&server->shutdown_requested,FALSE);
 	return apt_task_terminate_request_process(task);
 }
 
-static void mrcp_server_sessions_release(mrcp_server_t *server)
+static void mrcp_server_sessions_release(mrcp_server_shard_t *shard)
 {
 	mrcp_server_session_t *session;
 	apr_hash_index_t *it;
 	void *val;
-	it = apr_hash_first(NULL,server->session_table);
+	it = apr_hash_first(NULL,shard->session_table);
 	for(; it; it = apr_hash_next(it)) {
 		apr_hash_this(it,NULL,NULL,&val);
 		session = val;
@@ -734,9 +1162,10 @@ static void mrcp_server_sessions_release(mrcp_server_t *server)
 static apt_bool_t mrcp_server_terminate_request_process(apt_task_t *task)
 {
 	apt_consumer_task_t *consumer_task = apt_task_object_get(task);
-	mrcp_server_t *server = apt_consumer_task_object_get(consumer_task);
+	mrcp_server_shard_t *shard = apt_consumer_task_object_get(consumer_task);
+	mrcp_server_t *server = shard->server;
 
-	server->shutdown_requested = TRUE;
+	apr_atomic_set32(&server->shutdown_requested,TRUE);
 
 	return apt_task_offline(task);
 }
@@ -754,15 +1183,26 @@ static void mrcp_server_on_terminate_complete(apt_task_t *task)
 static void mrcp_server_on_offline_complete(apt_task_t *task)
 {
 	apt_consumer_task_t *consumer_task = apt_task_object_get(task);
-	mrcp_server_t *server = apt_consumer_task_object_get(consumer_task);
+	mrcp_server_shard_t *main_shard = apt_consumer_task_object_get(consumer_task);
+	mrcp_server_t *server = main_shard->server;
+	mrcp_server_shard_t *shard;
+	apr_size_t count;
+	int i;
 
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,SERVER_TASK_NAME" Taken Offline");
 	
-	if(server->shutdown_requested == TRUE) {
-		unsigned int count = apr_hash_count(server->session_table);
+	if(apr_atomic_read32(&server->shutdown_requested) == TRUE) {
+		mrcp_server_lock(server);
+		count = server->session_count;
+		mrcp_server_unlock(server);
 		if(count) {
-			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Shutdown Pending: release open sessions [%d]", count);
-			mrcp_server_sessions_release(server);
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Shutdown Pending: release open sessions [%"APR_SIZE_T_FMT"]", count);
+			/* sessions are released from within the tasks of their shards */
+			for(i=1; i<server->shards->nelts; i++) {
+				shard = APR_ARRAY_IDX(server->shards,i,mrcp_server_shard_t*);
+				mrcp_server_shard_task_msg_signal(SHARD_TASK_MSG_RELEASE_SESSIONS,shard);
+			}
+			mrcp_server_sessions_release(main_shard);
 		}
 		else {
 			mrcp_server_do_terminate(server);
@@ -775,6 +1215,22 @@ static void mrcp_server_on_online_complete(apt_task_t *task)
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,SERVER_TASK_NAME" Brought Online");
 }
 
+static apt_bool_t mrcp_server_msg_signal(apt_task_t *task, apt_task_msg_t *msg)
+{
+	apt_consumer_task_t *consumer_task = apt_task_object_get(task);
+	mrcp_server_shard_t *main_shard = apt_consumer_task_object_get(consumer_task);
+	mrcp_server_t *server = main_shard->server;
+
+	if(msg->type == MRCP_SERVER_MEDIA_TASK_MSG && server->shards->nelts > 1) {
+		/* media engines signal their parent (main) task, forward the message to the shard of the session */
+		mrcp_server_shard_t *shard = mrcp_server_mpf_message_shard_get((const mpf_message_container_t*) msg->data);
+		if(shard && shard != main_shard) {
+			return server->signal_msg(apt_consumer_task_base_get(shard->task),msg);
+		}
+	}
+	return server->signal_msg(task,msg);
+}
+
 static apt_bool_t mrcp_server_msg_process(apt_task_t *task, apt_task_msg_t *msg)
 {
 	switch(msg->type) {
@@ -850,6 +1306,24 @@ static apt_bool_t mrcp_server_msg_process(apt_task_t *task, apt_task_msg_t *msg)
 			mrcp_server_mpf_message_process(mpf_message_container);
 			break;
 		}
+		case MRCP_SERVER_SHARD_TASK_MSG:
+		{
+			apt_consumer_task_t *consumer_task = apt_task_object_get(task);
+			mrcp_server_shard_t *shard = apt_consumer_task_object_get(consumer_task);
+			switch(msg->sub_type) {
+				case SHARD_TASK_MSG_RELEASE_SESSIONS:
+					mrcp_server_sessions_release(shard);
+					break;
+				case SHARD_TASK_MSG_SESSIONS_RELEASED:
+					if(mrcp_server_shutdown_ready(shard->server) == TRUE) {
+						mrcp_server_do_terminate(shard->server);
+					}
+					break;
+				default:
+					break;
+			}
+			break;
+		}
 		default:
 		{
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Task Message Received [%d;%d]", msg->type,msg->sub_type);
@@ -862,7 +1336,9 @@ static apt_bool_t mrcp_server_msg_process(apt_task_t *task, apt_task_msg_t *msg)
 static apt_bool_t mrcp_server_signaling_task_msg_signal(mrcp_signaling_message_type_e type, mrcp_session_t *session, mrcp_session_descriptor_t *descriptor, mrcp_message_t *message)
 {
 	mrcp_signaling_message_t *signaling_message;
-	apt_task_msg_t *task_msg = apt_task_msg_acquire(session->signaling_agent->msg_pool);
+	mrcp_server_t *server = session->signaling_agent->parent;
+	mrcp_server_shard_t *shard = mrcp_server_session_shard_get(server,(mrcp_server_session_t*)session);
+	apt_task_msg_t *task_msg = apt_task_msg_acquire(shard->signaling_msg_pool);
 	mrcp_signaling_message_t **slot = ((mrcp_signaling_message_t**)task_msg->data);
 	task_msg->type = MRCP_SERVER_SIGNALING_TASK_MSG;
 	task_msg->sub_type = type;
@@ -875,7 +1351,7 @@ static apt_bool_t mrcp_server_signaling_task_msg_signal(mrcp_signaling_message_t
 	signaling_message->message = message;
 	*slot = signaling_message;
 	
-	return apt_task_msg_parent_signal(session->signaling_agent->task,task_msg);
+	return apt_task_msg_signal(apt_consumer_task_base_get(shard->task),task_msg);
 }
 
 static apt_bool_t mrcp_server_connection_task_msg_signal(
@@ -887,18 +1363,27 @@ static apt_bool_t mrcp_server_connection_task_msg_signal(
 							apt_bool_t                       status)
 {
 	mrcp_server_t *server = mrcp_server_connection_agent_object_get(agent);
-	apt_task_t *task = apt_consumer_task_base_get(server->task);
+	mrcp_channel_t *mrcp_channel = channel ? channel->obj : NULL;
+	mrcp_server_shard_t *shard;
 	connection_agent_task_msg_data_t *data;
-	apt_task_msg_t *task_msg = apt_task_msg_acquire(server->connection_msg_pool);
+	apt_task_msg_t *task_msg;
+	if(mrcp_channel) {
+		mrcp_server_session_t *session = (mrcp_server_session_t*)mrcp_server_channel_session_get(mrcp_channel);
+		shard = mrcp_server_session_shard_get(server,session);
+	}
+	else {
+		shard = mrcp_server_main_shard_get(server);
+	}
+	task_msg = apt_task_msg_acquire(shard->connection_msg_pool);
 	task_msg->type = MRCP_SERVER_CONNECTION_TASK_MSG;
 	task_msg->sub_type = type;
 	data = (connection_agent_task_msg_data_t*) task_msg->data;
-	data->channel = channel ? channel->obj : NULL;
+	data->channel = mrcp_channel;
 	data->descriptor = descriptor;
 	data->message = message;
 	data->status = status;
 
-	return apt_task_msg_signal(task,task_msg);
+	return apt_task_msg_signal(apt_consumer_task_base_get(shard->task),task_msg);
 }
 
 static apt_bool_t mrcp_server_engine_task_msg_signal(
@@ -907,9 +1392,10 @@ static apt_bool_t mrcp_server_engine_task_msg_signal(
 							apt_bool_t              status)
 {
 	mrcp_server_t *server = engine->event_obj;
-	apt_task_t *task = apt_consumer_task_base_get(server->task);
+	mrcp_server_shard_t *shard = mrcp_server_main_shard_get(server);
+	apt_task_t *task = apt_consumer_task_base_get(shard->task);
 	engine_task_msg_data_t *data;
-	apt_task_msg_t *task_msg = apt_task_msg_acquire(server->engine_msg_pool);
+	apt_task_msg_t *task_msg = apt_task_msg_acquire(shard->engine_msg_pool);
 	task_msg->type = MRCP_SERVER_ENGINE_TASK_MSG;
 	task_msg->sub_type = type;
 	data = (engine_task_msg_data_t*) task_msg->data;
@@ -930,9 +1416,10 @@ static apt_bool_t mrcp_server_channel_task_msg_signal(
 	mrcp_channel_t *channel = engine_channel->event_obj;
 	mrcp_session_t *session = mrcp_server_channel_session_get(channel);
 	mrcp_server_t *server = session->signaling_agent->parent;
-	apt_task_t *task = apt_consumer_task_base_get(server->task);
+	mrcp_server_shard_t *shard = mrcp_server_session_shard_get(server,(mrcp_server_session_t*)session);
+	apt_task_t *task = apt_consumer_task_base_get(shard->task);
 	engine_task_msg_data_t *data;
-	apt_task_msg_t *task_msg = apt_task_msg_acquire(server->engine_msg_pool);
+	apt_task_msg_t *task_msg = apt_task_msg_acquire(shard->engine_msg_pool);
 	task_msg->type = MRCP_SERVER_ENGINE_TASK_MSG;
 	task_msg->sub_type = type;
 	data = (engine_task_msg_data_t*) task_msg->data;
@@ -963,7 +1450,11 @@ static mrcp_server_profile_t* mrcp_server_profile_get_by_agent(mrcp_server_t *se
 static mrcp_session_t* mrcp_server_sig_agent_session_create(mrcp_sig_agent_t *signaling_agent)
 {
 	mrcp_server_t *server = signaling_agent->parent;
-	mrcp_server_session_t *session = mrcp_server_session_create();
+	mrcp_server_session_t *session = mrcp_server_session_create(server->session_recycler);
+	if(!session) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Session");
+		return NULL;
+	}
 	session->server = server;
 	session->profile = mrcp_server_profile_get_by_agent(server,session,signaling_agent);
 	if(!session->profile) {
@@ -34,8 +34,6 @@
 #define MRCP_SESSION_NAMESID(session) \
 	session->base.name, MRCP_SESSION_SID(&session->base)
 
-#define MRCP_SESSION_ID_HEX_STRING_LENGTH 16
-
 struct mrcp_channel_t {
 	/** Memory pool */
 	apr_pool_t             *pool;
@@ -77,9 +75,12 @@ struct mrcp_termination_slot_t {
 
 extern const mrcp_engine_channel_event_vtable_t engine_channel_vtable;
 
+apt_bool_t mrcp_server_session_admit(mrcp_server_t *server, mrcp_server_session_t *session, apr_size_t *retry_after);
 void mrcp_server_session_add(mrcp_server_t *server, mrcp_server_session_t *session);
 void mrcp_server_session_remove(mrcp_server_t *server, mrcp_server_session_t *session);
 void mrcp_server_session_idle_test(mrcp_server_t *server);
+void mrcp_server_engine_lock(mrcp_server_t *server);
+void mrcp_server_engine_unlock(mrcp_server_t *server);
 
 static apt_bool_t mrcp_server_signaling_message_dispatch(mrcp_server_session_t *session, mrcp_signaling_message_t *signaling_message);
 
@@ -99,9 +100,13 @@ static apt_bool_t state_machine_on_deactivate(mrcp_state_machine_t *state_machin
 
 static apt_bool_t mrcp_session_offers_compare(const mrcp_session_descriptor_t *offer1, const mrcp_session_descriptor_t *offer2);
 
-mrcp_server_session_t* mrcp_server_session_create()
+mrcp_server_session_t* mrcp_server_session_create(apt_pool_recycler_t *recycler)
 {
-	mrcp_server_session_t *session = (mrcp_server_session_t*) mrcp_session_create(sizeof(mrcp_server_session_t)-sizeof(mrcp_session_t));
+	mrcp_server_session_t *session = (mrcp_server_session_t*) mrcp_session_create_recycled(recycler,sizeof(mrcp_server_session_t)-sizeof(mrcp_session_t));
+	if(!session) {
+		return NULL;
+	}
+	session->shard = NULL;
 	session->context = NULL;
 	session->terminations = apr_array_make(session->base.pool,2,sizeof(mrcp_termination_slot_t));
 	session->channels = apr_array_make(session->base.pool,2,sizeof(mrcp_channel_t*));
@@ -126,6 +131,7 @@ static APR_INLINE mrcp_version_e mrcp_session_version_get(mrcp_server_session_t
 static mrcp_engine_channel_t* mrcp_server_engine_channel_create(mrcp_server_session_t *session, mrcp_channel_t *channel, const apt_str_t *resource_name)
 {
 	mrcp_engine_t *engine = NULL;
+	mrcp_engine_channel_t *engine_channel;
 	if(session->base.resource_engine_map) {
 		const char *engine_name = apr_table_get(session->base.resource_engine_map,resource_name->buf);
 		if(engine_name) {
@@ -166,7 +172,11 @@ static mrcp_engine_channel_t* mrcp_server_engine_channel_create(mrcp_server_sess
 		channel->state_machine->on_deactivate = state_machine_on_deactivate;
 	}
 
-	return mrcp_engine_channel_virtual_create(engine,mrcp_session_version_get(session),session->base.pool);
+	/* engines are shared across the shards of the server */
+	mrcp_server_engine_lock(session->server);
+	engine_channel = mrcp_engine_channel_virtual_create(engine,mrcp_session_version_get(session),session->base.pool);
+	mrcp_server_engine_unlock(session->server);
+	return engine_channel;
 }
 
 static mrcp_channel_t* mrcp_server_channel_create(mrcp_server_session_t *session, const apt_str_t *resource_name, apr_size_t id, apr_array_header_t *cmid_arr)
@@ -384,6 +394,23 @@ apt_bool_t mrcp_server_on_engine_channel_message(mrcp_channel_t *channel, mrcp_m
 static apt_bool_t mrcp_server_session_offer_process(mrcp_server_session_t *session, mrcp_session_descriptor_t *descriptor)
 {
 	if(!session->context) {
+		apr_size_t retry_after = 0;
+		if(session->state == SESSION_STATE_NONE && mrcp_server_session_admit(session->server,session,&retry_after) == FALSE) {
+			/* initial offer received, but the server is overloaded */
+			mrcp_session_descriptor_t *answer = mrcp_session_answer_create(descriptor,session->base.pool);
+			answer->status = MRCP_SESSION_STATUS_OVERLOADED;
+			answer->retry_after = retry_after;
+			session->offer = descriptor;
+			session->answer = answer;
+			mrcp_server_session_answer_send(session);
+			if(session->last_answer == answer) {
+				/* don't reuse the rejection for a subsequent offer */
+				session->last_offer = NULL;
+				session->last_answer = NULL;
+			}
+			return TRUE;
+		}
+
 		/* initial offer received, generate session id and add to session's table */
 		if(!session->base.id.length) {
 			apt_unique_id_generate(&session->base.id,MRCP_SESSION_ID_HEX_STRING_LENGTH,session->base.pool);
@@ -988,14 +1015,17 @@ static apt_bool_t mrcp_server_session_terminate_send(mrcp_server_session_t *sess
 		channel = APR_ARRAY_IDX(session->channels,i,mrcp_channel_t*);
 		if(!channel) continue;
 
-		if(channel->control_channel) {
-			mrcp_server_control_channel_destroy(channel->control_channel);
-			channel->control_channel = NULL;
-		}
 		if(channel->engine_channel) {
+			mrcp_server_engine_lock(server);
 			mrcp_engine_channel_virtual_destroy(channel->engine_channel);
+			mrcp_server_engine_unlock(server);
 			channel->engine_channel = NULL;
 		}
+		if(channel->control_channel) {
+			/* destroy control channel after engine channel, since received requests are released along with it */
+			mrcp_server_control_channel_destroy(channel->control_channel);
+			channel->control_channel = NULL;
+		}
 	}
 
 	mrcp_server_session_remove(session->server,session);
@@ -33,7 +33,8 @@ typedef enum {
 	MRCP_SESSION_STATUS_NO_SUCH_RESOURCE,     /**< no such resource found */
 	MRCP_SESSION_STATUS_UNACCEPTABLE_RESOURCE,/**< resource exists, but no implementation (plugin) found */
 	MRCP_SESSION_STATUS_UNAVAILABLE_RESOURCE, /**< resource exists, but is temporary unavailable */
-	MRCP_SESSION_STATUS_ERROR                 /**< internal error occurred */
+	MRCP_SESSION_STATUS_ERROR,                /**< internal error occurred */
+	MRCP_SESSION_STATUS_OVERLOADED            /**< server is temporary overloaded, new sessions are not admitted */
 } mrcp_session_status_e;
 
 /** MRCP session descriptor */
@@ -52,6 +53,8 @@ struct mrcp_session_descriptor_t {
 	mrcp_session_status_e status;
 	/** Response code (SIP for MRCPv2 and RTSP for MRCPv1) */
 	int                   response_code;
+	/** Interval in seconds the client is suggested to retry after (if overloaded) */
+	apr_size_t            retry_after;
 
 	/** MRCP control media array (mrcp_control_descriptor_t) */
 	apr_array_header_t   *control_media_arr;
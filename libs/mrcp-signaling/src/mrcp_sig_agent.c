@@ -104,11 +104,30 @@ MRCP_DECLARE(mrcp_session_t*) mrcp_session_create(apr_size_t padding)
 	return mrcp_session_create_ex(pool,TRUE,padding);
 }
 
+MRCP_DECLARE(mrcp_session_t*) mrcp_session_create_recycled(apt_pool_recycler_t *recycler, apr_size_t padding)
+{
+	mrcp_session_t *session;
+	apr_pool_t *pool;
+	if(!recycler) {
+		return mrcp_session_create(padding);
+	}
+
+	pool = apt_pool_recycler_acquire(recycler);
+	if(!pool) {
+		return NULL;
+	}
+
+	session = mrcp_session_create_ex(pool,TRUE,padding);
+	session->recycler = recycler;
+	return session;
+}
+
 MRCP_DECLARE(mrcp_session_t*) mrcp_session_create_ex(apr_pool_t *pool, apt_bool_t take_ownership, apr_size_t padding)
 {
 	mrcp_session_t *session;
 	session = apr_palloc(pool,sizeof(mrcp_session_t)+padding);
 	session->self_owned = take_ownership;
+	session->recycler = NULL;
 	session->pool = pool;
 	session->obj = NULL;
 	session->log_obj = NULL;
@@ -129,6 +148,12 @@ MRCP_DECLARE(mrcp_session_t*) mrcp_session_create_ex(apr_pool_t *pool, apt_bool_
 MRCP_DECLARE(void) mrcp_session_destroy(mrcp_session_t *session)
 {
 	if(session->pool && session->self_owned == TRUE) {
-		apr_pool_destroy(session->pool);
+		if(session->recycler) {
+			/* the session object itself is allocated from the pool, don't access it afterwards */
+			apt_pool_recycler_release(session->recycler,session->pool);
+		}
+		else {
+			apr_pool_destroy(session->pool);
+		}
 	}
 }
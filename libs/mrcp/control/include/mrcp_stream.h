@@ -23,6 +23,7 @@
  */ 
 
 #include "apt_text_message.h"
+#include "apt_pool.h"
 #include "mrcp_types.h"
 
 APT_BEGIN_EXTERN_C
@@ -43,9 +44,25 @@ MRCP_DECLARE(void) mrcp_parser_resource_set(mrcp_parser_t *parser, const apt_str
 /** Set verbose mode for the parser */
 MRCP_DECLARE(void) mrcp_parser_verbose_set(mrcp_parser_t *parser, apt_bool_t verbose);
 
+/**
+ * Set recycler to allocate per-message arenas from.
+ * @param parser the parser to set recycler for
+ * @param recycler the recycler (freelist of arenas)
+ * @remark Each parsed message owns its arena, which is released on mrcp_message_destroy()
+ */
+MRCP_DECLARE(void) mrcp_parser_recycler_set(mrcp_parser_t *parser, apt_pool_recycler_t *recycler);
+
 /** Parse MRCP stream */
 MRCP_DECLARE(apt_message_status_e) mrcp_parser_run(mrcp_parser_t *parser, apt_text_stream_t *stream, mrcp_message_t **message);
 
+/**
+ * Reset parser discarding the message being parsed.
+ * @param parser the parser to reset
+ * @remark The arena of a partially parsed message is released back to the recycler,
+ * the function should be called before the parser is abandoned (connection closed)
+ */
+MRCP_DECLARE(void) mrcp_parser_reset(mrcp_parser_t *parser);
+
 
 
 /** Create MRCP stream generator */
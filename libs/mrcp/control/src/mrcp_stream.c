@@ -26,6 +26,8 @@ struct mrcp_parser_t {
 	apt_message_parser_t          *base;
 	const mrcp_resource_factory_t *resource_factory;
 	mrcp_resource_t               *resource;
+	apt_pool_recycler_t           *recycler;
+	mrcp_message_t                *message;
 };
 
 /** MRCP generator */
@@ -64,6 +66,8 @@ MRCP_DECLARE(mrcp_parser_t*) mrcp_parser_create(const mrcp_resource_factory_t *r
 	parser->base = apt_message_parser_create(parser,&parser_vtable,pool);
 	parser->resource_factory = resource_factory;
 	parser->resource = NULL;
+	parser->recycler = NULL;
+	parser->message = NULL;
 	return parser;
 }
 
@@ -81,31 +85,75 @@ MRCP_DECLARE(void) mrcp_parser_verbose_set(mrcp_parser_t *parser, apt_bool_t ver
 	apt_message_parser_verbose_set(parser->base,verbose);
 }
 
+/** Set recycler to allocate per-message arenas from */
+MRCP_DECLARE(void) mrcp_parser_recycler_set(mrcp_parser_t *parser, apt_pool_recycler_t *recycler)
+{
+	parser->recycler = recycler;
+}
+
 /** Parse MRCP stream */
 MRCP_DECLARE(apt_message_status_e) mrcp_parser_run(mrcp_parser_t *parser, apt_text_stream_t *stream, mrcp_message_t **message)
 {
-	return apt_message_parser_run(parser->base,stream,(void**)message);
+	apt_message_status_e status = apt_message_parser_run(parser->base,stream,(void**)message);
+	if(status == APT_MESSAGE_STATUS_COMPLETE) {
+		/* the ownership of the message is passed to the caller */
+		parser->message = NULL;
+	}
+	else if(status == APT_MESSAGE_STATUS_INVALID) {
+		/* release the arena of the partially parsed message and start over */
+		mrcp_parser_reset(parser);
+	}
+	return status;
+}
+
+/** Reset parser discarding the message being parsed */
+MRCP_DECLARE(void) mrcp_parser_reset(mrcp_parser_t *parser)
+{
+	apt_message_parser_reset(parser->base);
+	if(parser->message) {
+		mrcp_message_destroy(parser->message);
+		parser->message = NULL;
+	}
 }
 
 /** Create message and read start line */
 static apt_bool_t mrcp_parser_on_start(apt_message_parser_t *parser, apt_message_context_t *context, apt_text_stream_t *stream, apr_pool_t *pool)
 {
 	mrcp_message_t *mrcp_message;
+	mrcp_parser_t *mrcp_parser = apt_message_parser_object_get(parser);
 	apt_str_t start_line;
 	/* read start line */
 	if(apt_text_line_read(stream,&start_line) == FALSE) {
 		return FALSE;
 	}
 
+	if(mrcp_parser->message) {
+		/* release the message left over from the previous (failed) attempt */
+		mrcp_message_destroy(mrcp_parser->message);
+		mrcp_parser->message = NULL;
+	}
+
 	/* create new MRCP message */
-	mrcp_message = mrcp_message_create(pool);
+	if(mrcp_parser->recycler) {
+		mrcp_message = mrcp_message_arena_create(mrcp_parser->recycler);
+		if(!mrcp_message) {
+			return FALSE;
+		}
+		/* header fields and body are allocated from the message arena as well */
+		pool = mrcp_message->pool;
+		context->pool = pool;
+	}
+	else {
+		mrcp_message = mrcp_message_create(pool);
+	}
+	mrcp_parser->message = mrcp_message;
+
 	/* parse start-line */
 	if(mrcp_start_line_parse(&mrcp_message->start_line,&start_line,mrcp_message->pool) == FALSE) {
 		return FALSE;
 	}
 
 	if(mrcp_message->start_line.version == MRCP_VERSION_1) {
-		mrcp_parser_t *mrcp_parser = apt_message_parser_object_get(parser);
 		if(!mrcp_parser->resource) {
 			return FALSE;
 		}
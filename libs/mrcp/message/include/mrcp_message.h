@@ -26,6 +26,7 @@
 #include "mrcp_start_line.h"
 #include "mrcp_header.h"
 #include "mrcp_generic_header.h"
+#include "apt_pool.h"
 
 APT_BEGIN_EXTERN_C
 
@@ -48,6 +49,8 @@ struct mrcp_message_t {
 	const mrcp_resource_t *resource;
 	/** Memory pool to allocate memory from */
 	apr_pool_t            *pool;
+	/** Recycler the pool (per-message arena) is owned by and released to on destroy, if any */
+	apt_pool_recycler_t   *recycler;
 };
 
 /**
@@ -56,6 +59,13 @@ struct mrcp_message_t {
  */
 MRCP_DECLARE(mrcp_message_t*) mrcp_message_create(apr_pool_t *pool);
 
+/**
+ * Create an MRCP message allocated from its own arena.
+ * @param recycler the recycler to acquire the arena from
+ * @remark The arena is released back to the recycler on mrcp_message_destroy()
+ */
+MRCP_DECLARE(mrcp_message_t*) mrcp_message_arena_create(apt_pool_recycler_t *recycler);
+
 /**
  * Create an MRCP request message.
  * @param resource the MRCP resource to use
@@ -103,6 +113,7 @@ MRCP_DECLARE(apt_bool_t) mrcp_message_validate(mrcp_message_t *message);
 /**
  * Destroy MRCP message.
  * @param message the message to destroy
+ * @remark If the message owns an arena, the arena is released and the message must not be referenced anymore
  */
 MRCP_DECLARE(void) mrcp_message_destroy(mrcp_message_t *message);
 
@@ -105,6 +105,20 @@ MRCP_DECLARE(mrcp_message_t*) mrcp_message_create(apr_pool_t *pool)
 	apt_string_reset(&message->body);
 	message->resource = NULL;
 	message->pool = pool;
+	message->recycler = NULL;
+	return message;
+}
+
+/** Create an MRCP message allocated from its own arena */
+MRCP_DECLARE(mrcp_message_t*) mrcp_message_arena_create(apt_pool_recycler_t *recycler)
+{
+	mrcp_message_t *message;
+	apr_pool_t *arena = apt_pool_recycler_acquire(recycler);
+	if(!arena) {
+		return NULL;
+	}
+	message = mrcp_message_create(arena);
+	message->recycler = recycler;
 	return message;
 }
 
@@ -157,6 +171,10 @@ MRCP_DECLARE(void) mrcp_message_destroy(mrcp_message_t *message)
 {
 	apt_string_reset(&message->body);
 	mrcp_message_header_destroy(&message->header);
+	if(message->recycler) {
+		/* the message itself is allocated from the arena */
+		apt_pool_recycler_release(message->recycler,message->pool);
+	}
 }
 
 /** Validate MRCP message */
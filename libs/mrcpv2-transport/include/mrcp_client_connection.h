@@ -95,6 +95,15 @@ MRCP_DECLARE(void) mrcp_client_connection_rx_size_set(
 MRCP_DECLARE(void) mrcp_client_connection_tx_size_set(
 								mrcp_connection_agent_t *agent,
 								apr_size_t size);
+/**
+ * Set max number of bytes queued for sending per connection.
+ * @param agent the agent to set the parameter for
+ * @param limit the max number of bytes allowed to be queued (0 - unlimited)
+ */
+MRCP_DECLARE(void) mrcp_client_connection_tx_queue_limit_set(
+								mrcp_connection_agent_t *agent,
+								apr_size_t limit);
+
 /**
  * Set request timeout.
  * @param agent the agent to set timeout for
@@ -122,6 +131,14 @@ MRCP_DECLARE(void*) mrcp_client_connection_agent_object_get(const mrcp_connectio
  */
 MRCP_DECLARE(const char*) mrcp_client_connection_agent_id_get(const mrcp_connection_agent_t *agent);
 
+/**
+ * Get the counters of the data sent through the connections of the agent.
+ * @param agent the agent to get the counters of
+ * @param stats the counters to fill
+ * @remark Can be called from any thread.
+ */
+MRCP_DECLARE(void) mrcp_client_connection_stats_get(mrcp_connection_agent_t *agent, mrcp_connection_agent_stats_t *stats);
+
 
 /**
  * Create control channel.
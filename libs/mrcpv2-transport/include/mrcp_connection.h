@@ -24,18 +24,56 @@
 
 #include <apr_poll.h>
 #include <apr_hash.h>
+#include <apr_thread_mutex.h>
 #ifdef WIN32
 #pragma warning(disable: 4127)
 #endif
 #include <apr_ring.h>
 #include "mrcp_connection_types.h"
 #include "mrcp_stream.h"
+#include "mrcp_header.h"
+#include "apt_poller_task.h"
 
 APT_BEGIN_EXTERN_C
 
 /** Size of the buffer used for MRCP rx/tx stream */
 #define MRCP_STREAM_BUFFER_SIZE 1024
 
+/** Default max number of bytes queued for sending per connection */
+#define MRCP_TX_QUEUE_LIMIT (1024 * 1024)
+
+/** Size of the buffer the messages sent within a poll cycle are generated in */
+#define MRCP_TX_BATCH_BUFFER_SIZE 8192
+
+/** Max number of vector elements written at once by a batch of messages */
+#define MRCP_TX_BATCH_VECTOR_SIZE 32
+
+/** Max number of cleared per-message arenas kept for reuse by a connection agent (8KB each) */
+#define MRCP_MESSAGE_ARENA_FREELIST_SIZE 16
+
+/** Number of entries in the per-connection cache of control channels (power of 2) */
+#define MRCP_CHANNEL_CACHE_SIZE 8
+
+/** Size of the buffer to compose Channel Identifier in without allocation */
+#define MRCP_CHANNEL_ID_BUFFER_SIZE 128
+
+/** Counters shared by the connections of an agent, updated atomically except for the byte count */
+typedef struct mrcp_connection_counters_t mrcp_connection_counters_t;
+struct mrcp_connection_counters_t {
+	/** Number of messages sent */
+	volatile apr_uint32_t tx_message_count;
+	/** Number of writes to the sockets */
+	volatile apr_uint32_t tx_write_count;
+	/** Number of failed writes */
+	volatile apr_uint32_t tx_failure_count;
+	/** Number of times a socket was not writable and the data had to be queued */
+	volatile apr_uint32_t tx_stall_count;
+	/** Total number of bytes passed through the outbound queues (64-bit, guarded by the mutex) */
+	apr_uint64_t          tx_queued_bytes;
+	/** Mutex guarding the byte count, which may not be accessed atomically */
+	apr_thread_mutex_t   *mutex;
+};
+
 /** MRCPv2 connection */
 struct mrcp_connection_t {
 	/** Ring entry */
@@ -66,9 +104,17 @@ struct mrcp_connection_t {
 	apr_size_t        use_count;
 	/** Opaque agent */
 	void             *agent;
+	/** Poller task the connection is served by */
+	apt_poller_task_t *task;
+	/** Counters of the agent to account the connection in (NULL - not accounted) */
+	mrcp_connection_counters_t *counters;
 
 	/** Table of control channels */
 	apr_hash_t       *channel_table;
+	/** Cache of recently looked up control channels indexed by hash of identifier */
+	mrcp_control_channel_t *channel_cache[MRCP_CHANNEL_CACHE_SIZE];
+	/** Next connection established from the same remote IP */
+	mrcp_connection_t *ip_next;
 
 	/** Rx buffer */
 	char             *rx_buffer;
@@ -86,12 +132,50 @@ struct mrcp_connection_t {
 	/** MRCP generator */
 	mrcp_generator_t *generator;
 
+	/** Outbound queue of data which could not be sent without blocking */
+	char             *tx_queue;
+	/** Allocated size of the outbound queue */
+	apr_size_t        tx_queue_size;
+	/** Length of the data in the outbound queue */
+	apr_size_t        tx_queue_length;
+	/** Offset of the data not sent yet */
+	apr_size_t        tx_queue_offset;
+	/** Max number of bytes allowed to be queued (0 - unlimited) */
+	apr_size_t        tx_queue_limit;
+	/** Number of times the socket was not writable and the data had to be queued */
+	apr_size_t        tx_stall_count;
+	/** Total number of bytes passed through the outbound queue */
+	apr_size_t        tx_queued_bytes;
+	/** Max number of bytes simultaneously pending in the outbound queue */
+	apr_size_t        tx_queue_peak;
+
+	/** Buffer to generate the messages of a batch in (NULL - messages are sent one by one) */
+	char             *tx_batch_buffer;
+	/** Size of the batch buffer */
+	apr_size_t        tx_batch_buffer_size;
+	/** Length of the data generated in the batch buffer */
+	apr_size_t        tx_batch_length;
+	/** Vector of the data of a batch to write at once */
+	struct iovec      tx_batch_vec[MRCP_TX_BATCH_VECTOR_SIZE];
+	/** Number of elements in the vector */
+	apr_int32_t       tx_batch_vec_count;
+	/** Number of messages sent through batches */
+	apr_size_t        tx_batch_message_count;
+	/** Number of batches written */
+	apr_size_t        tx_batch_count;
+
 	/** Inactivity timer  */
 	apt_timer_t      *inactivity_timer;
 	/** Termination timer  */
 	apt_timer_t      *termination_timer;
 };
 
+/** Initialize the counters of an agent. */
+apt_bool_t mrcp_connection_counters_init(mrcp_connection_counters_t *counters, apr_pool_t *pool);
+
+/** Get the counters of an agent. */
+void mrcp_connection_counters_get(mrcp_connection_counters_t *counters, mrcp_connection_agent_stats_t *stats);
+
 /** Create MRCP connection. */
 mrcp_connection_t* mrcp_connection_create(void);
 
@@ -104,9 +188,49 @@ apt_bool_t mrcp_connection_channel_add(mrcp_connection_t *connection, mrcp_contr
 /** Find Control Channel by Channel Identifier. */
 mrcp_control_channel_t* mrcp_connection_channel_find(const mrcp_connection_t *connection, const apt_str_t *identifier);
 
+/** Find Control Channel by Channel Identifier, looking up the cache of the connection first. */
+mrcp_control_channel_t* mrcp_connection_channel_lookup(mrcp_connection_t *connection, const apt_str_t *identifier);
+
+/** Compose Channel Identifier (id at resource) in the specified buffer, allocate from the pool only if it doesn't fit. */
+void mrcp_channel_identifier_compose(const mrcp_channel_id *channel_id, char *buf, apr_size_t size, apt_str_t *identifier, apr_pool_t *pool);
+
 /** Remove Control Channel from MRCP connection. */
 apt_bool_t mrcp_connection_channel_remove(mrcp_connection_t *connection, mrcp_control_channel_t *channel);
 
+/**
+ * Hold the message received through the control channel until the channel is destroyed.
+ * @remark The connection agent never releases held messages on its own, the session the channel
+ * belongs to may still refer to them; they are released once the session destroys the channel.
+ */
+void mrcp_control_channel_message_hold(mrcp_control_channel_t *channel, mrcp_message_t *message);
+
+/** Destroy the messages received through the control channel (release their arenas). */
+void mrcp_control_channel_messages_release(mrcp_control_channel_t *channel);
+
+/** Generate and send MRCP message through MRCP connection. */
+apt_bool_t mrcp_connection_message_send(mrcp_connection_t *connection, const mrcp_resource_factory_t *resource_factory, mrcp_message_t *message, void *log_obj);
+
+/** Generate MRCP message and add it to the batch of MRCP connection, the batch is sent on flush or once it's full. */
+apt_bool_t mrcp_connection_message_batch_add(mrcp_connection_t *connection, const mrcp_resource_factory_t *resource_factory, mrcp_message_t *message, void *log_obj);
+
+/** Send the batch of messages of MRCP connection at once. */
+apt_bool_t mrcp_connection_batch_flush(mrcp_connection_t *connection);
+
+/** Send data vector through MRCP connection, queue the remainder, if any, to be sent on POLLOUT. */
+apt_bool_t mrcp_connection_data_send(mrcp_connection_t *connection, const struct iovec *vec, apr_int32_t nvec);
+
+/** Send data from the outbound queue of MRCP connection. */
+apt_bool_t mrcp_connection_tx_queue_flush(mrcp_connection_t *connection);
+
+/** Check whether the outbound queue of MRCP connection has data to send. */
+static APR_INLINE apt_bool_t mrcp_connection_tx_queue_pending(const mrcp_connection_t *connection)
+{
+	return connection->tx_queue_length ? TRUE : FALSE;
+}
+
+/** Update POLLOUT request of MRCP connection according to the state of the outbound queue. */
+apt_bool_t mrcp_connection_pollout_update(mrcp_connection_t *connection, const apt_poller_task_t *task);
+
 /** Raise disconnect event for each channel from the specified connection. */
 apt_bool_t mrcp_connection_disconnect_raise(mrcp_connection_t *connection, const mrcp_connection_event_vtable_t *vtable);
 
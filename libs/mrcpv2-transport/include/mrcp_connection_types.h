@@ -29,6 +29,9 @@
 
 APT_BEGIN_EXTERN_C
 
+/** Max number of messages received at once delivered in a single batch */
+#define MRCP_RX_BATCH_SIZE 16
+
 /** Opaque MRCPv2 control descriptor declaration */
 typedef struct mrcp_control_descriptor_t mrcp_control_descriptor_t;
 
@@ -44,9 +47,29 @@ typedef struct mrcp_connection_agent_t mrcp_connection_agent_t;
 /** Opaque MRCPv2 connection agent factory declaration */
 typedef struct mrcp_ca_factory_t mrcp_ca_factory_t;
 
+/** Opaque list of MRCPv2 messages received through a control channel */
+typedef struct mrcp_received_message_t mrcp_received_message_t;
+
 /** MRCPv2 connection event vtable declaration */
 typedef struct mrcp_connection_event_vtable_t mrcp_connection_event_vtable_t;
 
+/** MRCPv2 connection agent statistics declaration */
+typedef struct mrcp_connection_agent_stats_t mrcp_connection_agent_stats_t;
+
+/** MRCPv2 connection agent statistics (accumulated over all the connections of the agent) */
+struct mrcp_connection_agent_stats_t {
+	/** Number of messages sent */
+	apr_size_t tx_message_count;
+	/** Number of writes to the sockets */
+	apr_size_t tx_write_count;
+	/** Number of failed writes */
+	apr_size_t tx_failure_count;
+	/** Number of times a socket was not writable and the data had to be queued */
+	apr_size_t tx_stall_count;
+	/** Total number of bytes passed through the outbound queues */
+	apr_uint64_t tx_queued_bytes;
+};
+
 /** MRCPv2 connection event vtable */
 struct mrcp_connection_event_vtable_t {
 	/** Channel add event handler */
@@ -59,6 +82,8 @@ struct mrcp_connection_event_vtable_t {
 	apt_bool_t (*on_receive)(mrcp_control_channel_t *channel, mrcp_message_t *message);
 	/** Disconnect event handler */
 	apt_bool_t (*on_disconnect)(mrcp_control_channel_t *channel);
+	/** Batch of messages receive event handler (optional, on_receive is raised per message otherwise) */
+	apt_bool_t (*on_receive_batch)(mrcp_control_channel_t **channels, mrcp_message_t **messages, apr_size_t count);
 };
 
 /** MRCPv2 control channel */
@@ -81,6 +106,10 @@ struct mrcp_control_channel_t {
 	apr_pool_t              *pool;
 	/** Channel identifier (id at resource) */
 	apt_str_t                identifier;
+	/** Hash of channel identifier (set once the channel is added to a connection) */
+	unsigned int             identifier_hash;
+	/** Messages received through the channel and held until the channel is destroyed */
+	mrcp_received_message_t *received_messages;
 };
 
 /** Send channel add response */
@@ -133,6 +162,29 @@ static APR_INLINE apt_bool_t mrcp_connection_message_receive(
 	return FALSE;
 }
 
+/** Send MRCP messages receive event (up to MRCP_RX_BATCH_SIZE messages at once) */
+static APR_INLINE apt_bool_t mrcp_connection_messages_receive(
+						const mrcp_connection_event_vtable_t *vtable,
+						mrcp_control_channel_t **channels,
+						mrcp_message_t **messages,
+						apr_size_t count)
+{
+	apr_size_t i;
+	apt_bool_t status = TRUE;
+	if(!vtable || !count) {
+		return FALSE;
+	}
+	if(vtable->on_receive_batch) {
+		return vtable->on_receive_batch(channels,messages,count);
+	}
+	for(i = 0; i < count; i++) {
+		if(mrcp_connection_message_receive(vtable,channels[i],messages[i]) == FALSE) {
+			status = FALSE;
+		}
+	}
+	return status;
+}
+
 APT_END_EXTERN_C
 
 #endif /* MRCP_CONNECTION_TYPES_H */
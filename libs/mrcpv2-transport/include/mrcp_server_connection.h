@@ -100,6 +100,25 @@ MRCP_DECLARE(void) mrcp_server_connection_tx_size_set(
 								mrcp_connection_agent_t *agent,
 								apr_size_t size);
 
+/**
+ * Set max number of bytes queued for sending per connection.
+ * @param agent the agent to set the parameter for
+ * @param limit the max number of bytes allowed to be queued (0 - unlimited)
+ */
+MRCP_DECLARE(void) mrcp_server_connection_tx_queue_limit_set(
+								mrcp_connection_agent_t *agent,
+								apr_size_t limit);
+
+/**
+ * Set the number of workers (poller threads) accepted connections are distributed across.
+ * @param agent the agent to set the parameter for
+ * @param worker_count the number of workers including the agent itself
+ * @remark Should be called before the agent is started.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_connection_worker_count_set(
+								mrcp_connection_agent_t *agent,
+								apr_size_t worker_count);
+
 /**
  * Set max shared use count for an MRCPv2 connection.
  * @param agent the agent to set the parameter for
@@ -145,6 +164,14 @@ MRCP_DECLARE(void*) mrcp_server_connection_agent_object_get(const mrcp_connectio
  */
 MRCP_DECLARE(const char*) mrcp_server_connection_agent_id_get(const mrcp_connection_agent_t *agent);
 
+/**
+ * Get the counters of the data sent through the connections of the agent.
+ * @param agent the agent to get the counters of
+ * @param stats the counters to fill
+ * @remark Can be called from any thread.
+ */
+MRCP_DECLARE(void) mrcp_server_connection_stats_get(mrcp_connection_agent_t *agent, mrcp_connection_agent_stats_t *stats);
+
 
 /**
  * Create control channel.
@@ -36,6 +36,11 @@ struct mrcp_connection_agent_t {
 	apt_bool_t                            offer_new_connection;
 	apr_size_t                            tx_buffer_size;
 	apr_size_t                            rx_buffer_size;
+	apr_size_t                            tx_queue_limit;
+	/** Freelist of per-message arenas */
+	apt_pool_recycler_t                  *message_recycler;
+	/** Counters of the data sent through the connections */
+	mrcp_connection_counters_t            counters;
 
 	void                                 *obj;
 	const mrcp_connection_event_vtable_t *vtable;
@@ -57,9 +62,18 @@ struct connection_task_msg_t {
 	mrcp_message_t            *message;
 };
 
+/** Messages received within a poll cycle to deliver at once */
+typedef struct mrcp_client_rx_batch_t mrcp_client_rx_batch_t;
+struct mrcp_client_rx_batch_t {
+	mrcp_control_channel_t *channels[MRCP_RX_BATCH_SIZE];
+	mrcp_message_t         *messages[MRCP_RX_BATCH_SIZE];
+	apr_size_t              count;
+};
+
 
 static apt_bool_t mrcp_client_agent_msg_process(apt_task_t *task, apt_task_msg_t *task_msg);
 static apt_bool_t mrcp_client_poller_signal_process(void *obj, const apr_pollfd_t *descriptor);
+static void mrcp_client_poller_msg_batch_process(void *obj);
 static void mrcp_client_timer_proc(apt_timer_t *timer, void *obj);
 
 /** Create connection agent. */
@@ -82,6 +96,10 @@ MRCP_DECLARE(mrcp_connection_agent_t*) mrcp_client_connection_agent_create(
 	agent->offer_new_connection = offer_new_connection;
 	agent->rx_buffer_size = MRCP_STREAM_BUFFER_SIZE;
 	agent->tx_buffer_size = MRCP_STREAM_BUFFER_SIZE;
+	agent->tx_queue_limit = MRCP_TX_QUEUE_LIMIT;
+	if(mrcp_connection_counters_init(&agent->counters,pool) == FALSE) {
+		return NULL;
+	}
 
 	msg_pool = apt_task_msg_pool_create_dynamic(sizeof(connection_task_msg_t),pool);
 
@@ -104,8 +122,11 @@ MRCP_DECLARE(mrcp_connection_agent_t*) mrcp_client_connection_agent_create(
 	if(vtable) {
 		vtable->process_msg = mrcp_client_agent_msg_process;
 	}
+	/* messages sent within a poll cycle are written at once, once all the task messages are processed */
+	apt_poller_task_msg_batch_handler_set(agent->task,mrcp_client_poller_msg_batch_process);
 
 	APR_RING_INIT(&agent->connection_list, mrcp_connection_t, link);
+	agent->message_recycler = apt_pool_recycler_create(MRCP_MESSAGE_ARENA_FREELIST_SIZE,pool);
 	return agent;
 }
 
@@ -169,6 +190,14 @@ MRCP_DECLARE(void) mrcp_client_connection_tx_size_set(
 	agent->tx_buffer_size = size;
 }
 
+/** Set max number of bytes queued for sending per connection */
+MRCP_DECLARE(void) mrcp_client_connection_tx_queue_limit_set(
+								mrcp_connection_agent_t *agent,
+								apr_size_t limit)
+{
+	agent->tx_queue_limit = limit;
+}
+
 /** Set request timeout */
 MRCP_DECLARE(void) mrcp_client_connection_timeout_set(
 								mrcp_connection_agent_t *agent,
@@ -196,6 +225,12 @@ MRCP_DECLARE(const char*) mrcp_client_connection_agent_id_get(const mrcp_connect
 	return apt_task_name_get(task);
 }
 
+/** Get the counters of the data sent */
+MRCP_DECLARE(void) mrcp_client_connection_stats_get(mrcp_connection_agent_t *agent, mrcp_connection_agent_stats_t *stats)
+{
+	mrcp_connection_counters_get(&agent->counters,stats);
+}
+
 
 /** Create control channel */
 MRCP_DECLARE(mrcp_control_channel_t*) mrcp_client_control_channel_create(mrcp_connection_agent_t *agent, void *obj, apr_pool_t *pool)
@@ -209,6 +244,7 @@ MRCP_DECLARE(mrcp_control_channel_t*) mrcp_client_control_channel_create(mrcp_co
 	channel->obj = obj;
 	channel->log_obj = NULL;
 	channel->pool = pool;
+	channel->received_messages = NULL;
 
 	channel->request_timer = apt_poller_task_timer_create(
 								agent->task,
@@ -227,7 +263,12 @@ MRCP_DECLARE(void) mrcp_client_control_channel_log_obj_set(mrcp_control_channel_
 /** Destroy MRCPv2 control channel */
 MRCP_DECLARE(apt_bool_t) mrcp_client_control_channel_destroy(mrcp_control_channel_t *channel)
 {
-	if(channel && channel->connection && channel->removed == TRUE) {
+	if(!channel) {
+		return TRUE;
+	}
+	/* responses and events received through the channel are no longer referenced, release their arenas */
+	mrcp_control_channel_messages_release(channel);
+	if(channel->connection && channel->removed == TRUE) {
 		mrcp_connection_t *connection = channel->connection;
 		channel->connection = NULL;
 		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Destroy TCP/MRCPv2 Connection %s",connection->id);
@@ -321,6 +362,9 @@ static mrcp_connection_t* mrcp_client_agent_connection_create(mrcp_connection_ag
 		local_ip,connection->l_sockaddr->port,
 		remote_ip,connection->r_sockaddr->port);
 
+	/* connected, never block the agent on send/receive from now on, partial writes are queued */
+	apr_socket_timeout_set(connection->sock,0);
+
 	memset(&connection->sock_pfd,0,sizeof(apr_pollfd_t));
 	connection->sock_pfd.desc_type = APR_POLL_SOCKET;
 	connection->sock_pfd.reqevents = APR_POLLIN;
@@ -335,13 +379,21 @@ static mrcp_connection_t* mrcp_client_agent_connection_create(mrcp_connection_ag
 	
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Established TCP/MRCPv2 Connection %s",connection->id);
 	connection->agent = agent;
+	connection->task = agent->task;
+	connection->counters = &agent->counters;
 	APR_RING_INSERT_TAIL(&agent->connection_list,connection,mrcp_connection_t,link);
 	
 	connection->parser = mrcp_parser_create(agent->resource_factory,connection->pool);
+	if(agent->message_recycler) {
+		mrcp_parser_recycler_set(connection->parser,agent->message_recycler);
+	}
 	connection->generator = mrcp_generator_create(agent->resource_factory,connection->pool);
 
 	connection->tx_buffer_size = agent->tx_buffer_size;
 	connection->tx_buffer = apr_palloc(connection->pool,connection->tx_buffer_size+1);
+	connection->tx_queue_limit = agent->tx_queue_limit;
+	connection->tx_batch_buffer_size = MRCP_TX_BATCH_BUFFER_SIZE;
+	connection->tx_batch_buffer = apr_palloc(connection->pool,connection->tx_batch_buffer_size+1);
 
 	connection->rx_buffer_size = agent->rx_buffer_size;
 	connection->rx_buffer = apr_palloc(connection->pool,connection->rx_buffer_size+1);
@@ -381,6 +433,8 @@ static apt_bool_t mrcp_client_agent_connection_remove(mrcp_connection_agent_t *a
 	APR_RING_REMOVE(connection,link);
 
 	if(connection->sock) {
+		/* write out the messages batched so far */
+		mrcp_connection_batch_flush(connection);
 		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Close TCP/MRCPv2 Connection %s",connection->id);
 		apt_poller_task_descriptor_remove(agent->task,&connection->sock_pfd);
 		apr_socket_close(connection->sock);
@@ -505,12 +559,19 @@ static apt_bool_t mrcp_client_agent_disconnect_raise(mrcp_connection_agent_t *ag
 	return TRUE;
 }
 
+static void mrcp_client_agent_connection_close(mrcp_connection_agent_t *agent, mrcp_connection_t *connection)
+{
+	apt_poller_task_descriptor_remove(agent->task,&connection->sock_pfd);
+	apr_socket_close(connection->sock);
+	connection->sock = NULL;
+
+	mrcp_client_agent_disconnect_raise(agent,connection);
+}
+
 static apt_bool_t mrcp_client_agent_messsage_send(mrcp_connection_agent_t *agent, mrcp_control_channel_t *channel, mrcp_message_t *message)
 {
-	apt_bool_t status = FALSE;
+	apt_bool_t status;
 	mrcp_connection_t *connection = channel->connection;
-	apt_text_stream_t stream;
-	apt_message_status_e result;
 
 	if(!connection || !connection->sock) {
 		apt_obj_log(APT_LOG_MARK,APT_PRIO_WARNING,channel->log_obj,"Null MRCPv2 Connection " APT_SIDRES_FMT,MRCP_MESSAGE_SIDRES(message));
@@ -518,33 +579,8 @@ static apt_bool_t mrcp_client_agent_messsage_send(mrcp_connection_agent_t *agent
 		return FALSE;
 	}
 
-	do {
-		apt_text_stream_init(&stream,connection->tx_buffer,connection->tx_buffer_size);
-		result = mrcp_generator_run(connection->generator,message,&stream);
-		if(result != APT_MESSAGE_STATUS_INVALID) {
-			stream.text.length = stream.pos - stream.text.buf;
-			*stream.pos = '\0';
-
-			apt_obj_log(APT_LOG_MARK,APT_PRIO_INFO,channel->log_obj,"Send MRCPv2 Data %s [%"APR_SIZE_T_FMT" bytes]\n%.*s",
-				connection->id,
-				stream.text.length,
-				connection->verbose == TRUE ? stream.text.length : 0,
-				stream.text.buf);
-
-			if(apr_socket_send(connection->sock,stream.text.buf,&stream.text.length) == APR_SUCCESS) {
-				status = TRUE;
-			}
-			else {
-				apt_obj_log(APT_LOG_MARK,APT_PRIO_WARNING,channel->log_obj,"Failed to Send MRCPv2 Data %s",
-					connection->id);
-			}
-		}
-		else {
-			apt_obj_log(APT_LOG_MARK,APT_PRIO_WARNING,channel->log_obj,"Failed to Generate MRCPv2 Data %s",
-				connection->id);
-		}
-	}
-	while(result == APT_MESSAGE_STATUS_INCOMPLETE);
+	/* the message is written along with the others sent within the same poll cycle */
+	status = mrcp_connection_message_batch_add(connection,agent->resource_factory,message,channel->log_obj);
 
 	if(status == TRUE) {
 		channel->active_request = message;
@@ -558,14 +594,23 @@ static apt_bool_t mrcp_client_agent_messsage_send(mrcp_connection_agent_t *agent
 	return status;
 }
 
-static apt_bool_t mrcp_client_message_handler(mrcp_connection_t *connection, mrcp_message_t *message, apt_message_status_e status)
+static void mrcp_client_rx_batch_deliver(mrcp_connection_agent_t *agent, mrcp_client_rx_batch_t *rx_batch)
+{
+	if(rx_batch->count) {
+		mrcp_connection_messages_receive(agent->vtable,rx_batch->channels,rx_batch->messages,rx_batch->count);
+		rx_batch->count = 0;
+	}
+}
+
+static apt_bool_t mrcp_client_message_handler(mrcp_connection_t *connection, mrcp_message_t *message, apt_message_status_e status, mrcp_client_rx_batch_t *rx_batch)
 {
 	if(status == APT_MESSAGE_STATUS_COMPLETE) {
 		/* message is completely parsed */
 		mrcp_control_channel_t *channel;
+		char buf[MRCP_CHANNEL_ID_BUFFER_SIZE];
 		apt_str_t identifier;
-		apt_id_resource_generate(&message->channel_id.session_id,&message->channel_id.resource_name,'@',&identifier,message->pool);
-		channel = mrcp_connection_channel_find(connection,&identifier);
+		mrcp_channel_identifier_compose(&message->channel_id,buf,sizeof(buf),&identifier,message->pool);
+		channel = mrcp_connection_channel_lookup(connection,&identifier);
 		if(channel) {
 			mrcp_connection_agent_t *agent = connection->agent;
 			if(message->start_line.message_type == MRCP_MESSAGE_TYPE_RESPONSE) {
@@ -574,6 +619,7 @@ static apt_bool_t mrcp_client_message_handler(mrcp_connection_t *connection, mrc
 					apt_obj_log(APT_LOG_MARK,APT_PRIO_WARNING,channel->log_obj,"Unexpected MRCP Response " APT_SIDRES_FMT" [%d]",
 						MRCP_MESSAGE_SIDRES(message),
 						message->start_line.request_id);
+					mrcp_message_destroy(message);
 					return FALSE;
 				}
 				if(channel->request_timer) {
@@ -582,13 +628,20 @@ static apt_bool_t mrcp_client_message_handler(mrcp_connection_t *connection, mrc
 				channel->active_request = NULL;
 			}
 
-			mrcp_connection_message_receive(agent->vtable,channel,message);
+			mrcp_control_channel_message_hold(channel,message);
+			rx_batch->channels[rx_batch->count] = channel;
+			rx_batch->messages[rx_batch->count] = message;
+			rx_batch->count++;
+			if(rx_batch->count == MRCP_RX_BATCH_SIZE) {
+				mrcp_client_rx_batch_deliver(agent,rx_batch);
+			}
 		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Find Channel " APT_SIDRES_FMT" in Connection %s [%d]",
 				MRCP_MESSAGE_SIDRES(message),
 				connection->id,
 				apr_hash_count(connection->channel_table));
+			mrcp_message_destroy(message);
 		}
 	}
 	return TRUE;
@@ -605,10 +658,25 @@ static apt_bool_t mrcp_client_poller_signal_process(void *obj, const apr_pollfd_
 	apt_text_stream_t *stream;
 	mrcp_message_t *message;
 	apt_message_status_e msg_status;
+	mrcp_client_rx_batch_t rx_batch;
 
 	if(!connection || !connection->sock) {
 		return FALSE;
 	}
+
+	if(descriptor->rtnevents & APR_POLLOUT) {
+		/* send the data queued while the socket was not writable */
+		if(mrcp_connection_tx_queue_flush(connection) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Send MRCPv2 Data %s",connection->id);
+			mrcp_client_agent_connection_close(agent,connection);
+			return TRUE;
+		}
+		mrcp_connection_pollout_update(connection,agent->task);
+		if(!(descriptor->rtnevents & ~APR_POLLOUT)) {
+			return TRUE;
+		}
+	}
+
 	stream = &connection->rx_stream;
 
 	/* calculate offset remaining from the previous receive / if any */
@@ -617,13 +685,13 @@ static apt_bool_t mrcp_client_poller_signal_process(void *obj, const apr_pollfd_
 	length = connection->rx_buffer_size - offset;
 
 	status = apr_socket_recv(connection->sock,stream->pos,&length);
+	if(APR_STATUS_IS_EAGAIN(status)) {
+		/* non-blocking socket, nothing to read yet */
+		return TRUE;
+	}
 	if(status == APR_EOF || length == 0) {
 		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"TCP/MRCPv2 Peer Disconnected %s",connection->id);
-		apt_poller_task_descriptor_remove(agent->task,&connection->sock_pfd);
-		apr_socket_close(connection->sock);
-		connection->sock = NULL;
-
-		mrcp_client_agent_disconnect_raise(agent,connection);
+		mrcp_client_agent_connection_close(agent,connection);
 		return TRUE;
 	}
 	
@@ -639,13 +707,17 @@ static apt_bool_t mrcp_client_poller_signal_process(void *obj, const apr_pollfd_
 	/* reset pos */
 	apt_text_stream_reset(stream);
 
+	/* messages parsed out of the received data are delivered in batches rather than one by one */
+	rx_batch.count = 0;
 	do {
 		msg_status = mrcp_parser_run(connection->parser,stream,&message);
-		if(mrcp_client_message_handler(connection,message,msg_status) == FALSE) {
+		if(mrcp_client_message_handler(connection,message,msg_status,&rx_batch) == FALSE) {
+			mrcp_client_rx_batch_deliver(agent,&rx_batch);
 			return FALSE;
 		}
 	}
 	while(apt_text_is_eos(stream) == FALSE);
+	mrcp_client_rx_batch_deliver(agent,&rx_batch);
 
 	/* scroll remaining stream */
 	apt_text_stream_scroll(stream);
@@ -677,6 +749,27 @@ static apt_bool_t mrcp_client_agent_msg_process(apt_task_t *task, apt_task_msg_t
 	return TRUE;
 }
 
+/* Write the messages batched within the poll cycle */
+static void mrcp_client_poller_msg_batch_process(void *obj)
+{
+	mrcp_connection_agent_t *agent = obj;
+	mrcp_connection_t *connection;
+
+	for(connection = APR_RING_FIRST(&agent->connection_list);
+			connection != APR_RING_SENTINEL(&agent->connection_list, mrcp_connection_t, link);
+				connection = APR_RING_NEXT(connection, link)) {
+		if(!connection->sock) continue;
+
+		if(mrcp_connection_batch_flush(connection) == FALSE) {
+			/* the pending requests are canceled once the disconnect is detected on receive */
+			apr_socket_shutdown(connection->sock,APR_SHUTDOWN_READWRITE);
+			continue;
+		}
+		/* request POLLOUT if anything is left in the outbound queue */
+		mrcp_connection_pollout_update(connection,agent->task);
+	}
+}
+
 /* Timer callback */
 static void mrcp_client_timer_proc(apt_timer_t *timer, void *obj)
 {
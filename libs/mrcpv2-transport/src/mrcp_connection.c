@@ -14,12 +14,59 @@
  * limitations under the License.
  */
 
+#include <stdlib.h>
+#include <apr_atomic.h>
 #include "mrcp_connection.h"
+#include "mrcp_message.h"
 #include "apt_pool.h"
+#include "apt_log.h"
+
+/** Message received through a control channel */
+struct mrcp_received_message_t {
+	/** The received message */
+	mrcp_message_t          *message;
+	/** Next received message */
+	mrcp_received_message_t *next;
+};
+
+/** Compute hash of Channel Identifier */
+static APR_INLINE unsigned int mrcp_channel_identifier_hash(const apt_str_t *identifier)
+{
+	apr_ssize_t length = identifier->length;
+	return apr_hashfunc_default(identifier->buf,&length);
+}
+
+apt_bool_t mrcp_connection_counters_init(mrcp_connection_counters_t *counters, apr_pool_t *pool)
+{
+	apr_atomic_set32(&counters->tx_message_count,0);
+	apr_atomic_set32(&counters->tx_write_count,0);
+	apr_atomic_set32(&counters->tx_failure_count,0);
+	apr_atomic_set32(&counters->tx_stall_count,0);
+	/* a 32-bit byte count would wrap at 4GB, there is no portable 64-bit atomic in APR 1.x */
+	counters->tx_queued_bytes = 0;
+	if(apr_thread_mutex_create(&counters->mutex,APR_THREAD_MUTEX_DEFAULT,pool) != APR_SUCCESS) {
+		counters->mutex = NULL;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+void mrcp_connection_counters_get(mrcp_connection_counters_t *counters, mrcp_connection_agent_stats_t *stats)
+{
+	stats->tx_message_count = apr_atomic_read32(&counters->tx_message_count);
+	stats->tx_write_count = apr_atomic_read32(&counters->tx_write_count);
+	stats->tx_failure_count = apr_atomic_read32(&counters->tx_failure_count);
+	stats->tx_stall_count = apr_atomic_read32(&counters->tx_stall_count);
+	apr_thread_mutex_lock(counters->mutex);
+	stats->tx_queued_bytes = counters->tx_queued_bytes;
+	apr_thread_mutex_unlock(counters->mutex);
+}
 
 mrcp_connection_t* mrcp_connection_create(void)
 {
 	mrcp_connection_t *connection;
+	/* the connection is created by one task, served by another one and may be destroyed by the user,
+	the allocator must be guarded */
 	apr_pool_t *pool = apt_pool_create();
 	if(!pool) {
 		return NULL;
@@ -35,14 +82,33 @@ mrcp_connection_t* mrcp_connection_create(void)
 	connection->verbose = TRUE;
 	connection->access_count = 0;
 	connection->use_count = 0;
+	connection->agent = NULL;
+	connection->counters = NULL;
+	connection->task = NULL;
 	APR_RING_ELEM_INIT(connection,link);
 	connection->channel_table = apr_hash_make(pool);
+	memset(connection->channel_cache,0,sizeof(connection->channel_cache));
+	connection->ip_next = NULL;
 	connection->parser = NULL;
 	connection->generator = NULL;
 	connection->rx_buffer = NULL;
 	connection->rx_buffer_size = 0;
 	connection->tx_buffer = NULL;
 	connection->tx_buffer_size = 0;
+	connection->tx_queue = NULL;
+	connection->tx_queue_size = 0;
+	connection->tx_queue_length = 0;
+	connection->tx_queue_offset = 0;
+	connection->tx_queue_limit = MRCP_TX_QUEUE_LIMIT;
+	connection->tx_stall_count = 0;
+	connection->tx_queued_bytes = 0;
+	connection->tx_queue_peak = 0;
+	connection->tx_batch_buffer = NULL;
+	connection->tx_batch_buffer_size = 0;
+	connection->tx_batch_length = 0;
+	connection->tx_batch_vec_count = 0;
+	connection->tx_batch_message_count = 0;
+	connection->tx_batch_count = 0;
 	connection->inactivity_timer = NULL;
 	connection->termination_timer = NULL;
 
@@ -52,6 +118,27 @@ mrcp_connection_t* mrcp_connection_create(void)
 void mrcp_connection_destroy(mrcp_connection_t *connection)
 {
 	if(connection && connection->pool) {
+		if(connection->tx_stall_count) {
+			apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Outbound Queue Stats %s: stalls [%"APR_SIZE_T_FMT"] queued [%"APR_SIZE_T_FMT" bytes] peak [%"APR_SIZE_T_FMT" bytes]",
+				connection->id,
+				connection->tx_stall_count,
+				connection->tx_queued_bytes,
+				connection->tx_queue_peak);
+		}
+		if(connection->tx_batch_count) {
+			apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Outbound Batch Stats %s: messages [%"APR_SIZE_T_FMT"] writes [%"APR_SIZE_T_FMT"]",
+				connection->id,
+				connection->tx_batch_message_count,
+				connection->tx_batch_count);
+		}
+		if(connection->tx_queue) {
+			free(connection->tx_queue);
+			connection->tx_queue = NULL;
+		}
+		if(connection->parser) {
+			/* release the arena of a message the connection was closed in the middle of */
+			mrcp_parser_reset(connection->parser);
+		}
 		apr_pool_destroy(connection->pool);
 	}
 }
@@ -62,6 +149,8 @@ apt_bool_t mrcp_connection_channel_add(mrcp_connection_t *connection, mrcp_contr
 		return FALSE;
 	}
 	apr_hash_set(connection->channel_table,channel->identifier.buf,channel->identifier.length,channel);
+	channel->identifier_hash = mrcp_channel_identifier_hash(&channel->identifier);
+	connection->channel_cache[channel->identifier_hash & (MRCP_CHANNEL_CACHE_SIZE - 1)] = channel;
 	channel->connection = connection;
 	connection->access_count++;
 	connection->use_count++;
@@ -76,17 +165,384 @@ mrcp_control_channel_t* mrcp_connection_channel_find(const mrcp_connection_t *co
 	return apr_hash_get(connection->channel_table,identifier->buf,identifier->length);
 }
 
+mrcp_control_channel_t* mrcp_connection_channel_lookup(mrcp_connection_t *connection, const apt_str_t *identifier)
+{
+	mrcp_control_channel_t **entry;
+	mrcp_control_channel_t *channel;
+	unsigned int hash;
+	if(!connection || !identifier) {
+		return NULL;
+	}
+
+	hash = mrcp_channel_identifier_hash(identifier);
+	entry = &connection->channel_cache[hash & (MRCP_CHANNEL_CACHE_SIZE - 1)];
+	channel = *entry;
+	if(channel && channel->identifier_hash == hash && apt_string_compare(&channel->identifier,identifier) == TRUE) {
+		return channel;
+	}
+
+	channel = apr_hash_get(connection->channel_table,identifier->buf,identifier->length);
+	if(channel) {
+		*entry = channel;
+	}
+	return channel;
+}
+
+void mrcp_channel_identifier_compose(const mrcp_channel_id *channel_id, char *buf, apr_size_t size, apt_str_t *identifier, apr_pool_t *pool)
+{
+	apr_size_t length = channel_id->session_id.length + channel_id->resource_name.length + 1;
+	if(length >= size) {
+		apt_id_resource_generate(&channel_id->session_id,&channel_id->resource_name,'@',identifier,pool);
+		return;
+	}
+	memcpy(buf,channel_id->session_id.buf,channel_id->session_id.length);
+	buf[channel_id->session_id.length] = '@';
+	memcpy(buf + channel_id->session_id.length + 1,channel_id->resource_name.buf,channel_id->resource_name.length);
+	buf[length] = '\0';
+	identifier->buf = buf;
+	identifier->length = length;
+}
+
 apt_bool_t mrcp_connection_channel_remove(mrcp_connection_t *connection, mrcp_control_channel_t *channel)
 {
+	mrcp_control_channel_t **entry;
 	if(!connection || !channel) {
 		return FALSE;
 	}
 	apr_hash_set(connection->channel_table,channel->identifier.buf,channel->identifier.length,NULL);
+	entry = &connection->channel_cache[channel->identifier_hash & (MRCP_CHANNEL_CACHE_SIZE - 1)];
+	if(*entry == channel) {
+		*entry = NULL;
+	}
 	channel->connection = NULL;
 	connection->access_count--;
 	return TRUE;
 }
 
+void mrcp_control_channel_message_hold(mrcp_control_channel_t *channel, mrcp_message_t *message)
+{
+	mrcp_received_message_t *item;
+	if(!channel || !message || !message->recycler) {
+		/* the message doesn't own an arena, nothing to release later */
+		return;
+	}
+	/* allocate the list item from the arena of the message itself */
+	item = apr_palloc(message->pool,sizeof(mrcp_received_message_t));
+	item->message = message;
+	item->next = channel->received_messages;
+	channel->received_messages = item;
+}
+
+void mrcp_control_channel_messages_release(mrcp_control_channel_t *channel)
+{
+	mrcp_received_message_t *next;
+	mrcp_received_message_t *item = channel->received_messages;
+	channel->received_messages = NULL;
+	while(item) {
+		/* the item is allocated from the arena being released */
+		next = item->next;
+		mrcp_message_destroy(item->message);
+		item = next;
+	}
+}
+
+/** Append data to the outbound queue */
+static apt_bool_t mrcp_connection_tx_queue_append(mrcp_connection_t *connection, const char *data, apr_size_t length)
+{
+	apr_size_t required = connection->tx_queue_length + length;
+	if(required > connection->tx_queue_size && connection->tx_queue_offset) {
+		/* move the data not sent yet to the beginning of the queue */
+		connection->tx_queue_length -= connection->tx_queue_offset;
+		memmove(connection->tx_queue,connection->tx_queue + connection->tx_queue_offset,connection->tx_queue_length);
+		connection->tx_queue_offset = 0;
+		required = connection->tx_queue_length + length;
+	}
+	if(required > connection->tx_queue_size) {
+		char *tx_queue;
+		apr_size_t size = connection->tx_queue_size ? connection->tx_queue_size : MRCP_STREAM_BUFFER_SIZE;
+		while(size < required) {
+			size *= 2;
+		}
+		tx_queue = realloc(connection->tx_queue,size);
+		if(!tx_queue) {
+			return FALSE;
+		}
+		connection->tx_queue = tx_queue;
+		connection->tx_queue_size = size;
+	}
+	memcpy(connection->tx_queue + connection->tx_queue_length,data,length);
+	connection->tx_queue_length += length;
+	connection->tx_queued_bytes += length;
+	if(connection->counters) {
+		apr_thread_mutex_lock(connection->counters->mutex);
+		connection->counters->tx_queued_bytes += length;
+		apr_thread_mutex_unlock(connection->counters->mutex);
+	}
+	if(connection->tx_queue_length - connection->tx_queue_offset > connection->tx_queue_peak) {
+		connection->tx_queue_peak = connection->tx_queue_length - connection->tx_queue_offset;
+	}
+	return TRUE;
+}
+
+apt_bool_t mrcp_connection_message_send(mrcp_connection_t *connection, const mrcp_resource_factory_t *resource_factory, mrcp_message_t *message, void *log_obj)
+{
+	apt_bool_t status = FALSE;
+	apt_text_stream_t stream;
+	apt_message_status_e result;
+	struct iovec vec[2];
+	apr_int32_t nvec = 1;
+
+	/* generate start-line and header section only, the body is sent right from the message */
+	apt_text_stream_init(&stream,connection->tx_buffer,connection->tx_buffer_size);
+	if(mrcp_message_generate(resource_factory,message,&stream) == TRUE) {
+		stream.text.length = stream.pos - stream.text.buf;
+		vec[0].iov_base = stream.text.buf;
+		vec[0].iov_len = stream.text.length;
+		if(message->body.length) {
+			vec[1].iov_base = message->body.buf;
+			vec[1].iov_len = message->body.length;
+			nvec++;
+		}
+
+		apt_obj_log(APT_LOG_MARK,APT_PRIO_INFO,log_obj,"Send MRCPv2 Data %s [%"APR_SIZE_T_FMT" bytes]\n%.*s%.*s",
+				connection->id,
+				stream.text.length + message->body.length,
+				connection->verbose == TRUE ? stream.text.length : 0,
+				stream.text.buf,
+				connection->verbose == TRUE ? message->body.length : 0,
+				message->body.length ? message->body.buf : "");
+
+		status = mrcp_connection_data_send(connection,vec,nvec);
+		if(status == FALSE) {
+			apt_obj_log(APT_LOG_MARK,APT_PRIO_WARNING,log_obj,"Failed to Send MRCPv2 Data %s",connection->id);
+		}
+		else if(connection->counters) {
+			apr_atomic_inc32(&connection->counters->tx_message_count);
+		}
+		return status;
+	}
+
+	/* header section doesn't fit the tx buffer, generate the message in chunks */
+	do {
+		apt_text_stream_init(&stream,connection->tx_buffer,connection->tx_buffer_size);
+		result = mrcp_generator_run(connection->generator,message,&stream);
+		if(result != APT_MESSAGE_STATUS_INVALID) {
+			stream.text.length = stream.pos - stream.text.buf;
+			*stream.pos = '\0';
+
+			apt_obj_log(APT_LOG_MARK,APT_PRIO_INFO,log_obj,"Send MRCPv2 Data %s [%"APR_SIZE_T_FMT" bytes]\n%.*s",
+					connection->id,
+					stream.text.length,
+					connection->verbose == TRUE ? stream.text.length : 0,
+					stream.text.buf);
+
+			vec[0].iov_base = stream.text.buf;
+			vec[0].iov_len = stream.text.length;
+			if(mrcp_connection_data_send(connection,vec,1) == TRUE) {
+				status = TRUE;
+			}
+			else {
+				apt_obj_log(APT_LOG_MARK,APT_PRIO_WARNING,log_obj,"Failed to Send MRCPv2 Data %s",connection->id);
+				status = FALSE;
+				break;
+			}
+		}
+		else {
+			apt_obj_log(APT_LOG_MARK,APT_PRIO_WARNING,log_obj,"Failed to Generate MRCPv2 Data %s",connection->id);
+		}
+	}
+	while(result == APT_MESSAGE_STATUS_INCOMPLETE);
+
+	if(status == TRUE && connection->counters) {
+		apr_atomic_inc32(&connection->counters->tx_message_count);
+	}
+	return status;
+}
+
+apt_bool_t mrcp_connection_message_batch_add(mrcp_connection_t *connection, const mrcp_resource_factory_t *resource_factory, mrcp_message_t *message, void *log_obj)
+{
+	apt_text_stream_t stream;
+	apr_int32_t nvec = message->body.length ? 2 : 1;
+	if(!connection->tx_batch_buffer) {
+		return mrcp_connection_message_send(connection,resource_factory,message,log_obj);
+	}
+
+	if(connection->tx_batch_vec_count + nvec > MRCP_TX_BATCH_VECTOR_SIZE) {
+		if(mrcp_connection_batch_flush(connection) == FALSE) {
+			return FALSE;
+		}
+	}
+
+	/* generate start-line and header section right after the messages already in the batch */
+	apt_text_stream_init(&stream,
+		connection->tx_batch_buffer + connection->tx_batch_length,
+		connection->tx_batch_buffer_size - connection->tx_batch_length);
+	if(mrcp_message_generate(resource_factory,message,&stream) == FALSE) {
+		if(!connection->tx_batch_length) {
+			/* header section doesn't fit the batch buffer at all, send the message on its own */
+			return mrcp_connection_message_send(connection,resource_factory,message,log_obj);
+		}
+		/* the batch buffer is exhausted, send what is there and start over */
+		if(mrcp_connection_batch_flush(connection) == FALSE) {
+			return FALSE;
+		}
+		return mrcp_connection_message_batch_add(connection,resource_factory,message,log_obj);
+	}
+	stream.text.length = stream.pos - stream.text.buf;
+
+	apt_obj_log(APT_LOG_MARK,APT_PRIO_INFO,log_obj,"Send MRCPv2 Data %s [%"APR_SIZE_T_FMT" bytes]\n%.*s%.*s",
+			connection->id,
+			stream.text.length + message->body.length,
+			connection->verbose == TRUE ? stream.text.length : 0,
+			stream.text.buf,
+			connection->verbose == TRUE ? message->body.length : 0,
+			message->body.length ? message->body.buf : "");
+
+	/* the body is referenced right from the message, which outlives the batch */
+	connection->tx_batch_vec[connection->tx_batch_vec_count].iov_base = stream.text.buf;
+	connection->tx_batch_vec[connection->tx_batch_vec_count].iov_len = stream.text.length;
+	connection->tx_batch_vec_count++;
+	if(message->body.length) {
+		connection->tx_batch_vec[connection->tx_batch_vec_count].iov_base = message->body.buf;
+		connection->tx_batch_vec[connection->tx_batch_vec_count].iov_len = message->body.length;
+		connection->tx_batch_vec_count++;
+	}
+	connection->tx_batch_length += stream.text.length;
+	connection->tx_batch_message_count++;
+	if(connection->counters) {
+		apr_atomic_inc32(&connection->counters->tx_message_count);
+	}
+	return TRUE;
+}
+
+apt_bool_t mrcp_connection_batch_flush(mrcp_connection_t *connection)
+{
+	apt_bool_t status;
+	if(!connection->tx_batch_vec_count) {
+		return TRUE;
+	}
+
+	/* whatever is not written is copied to the outbound queue, the batch can be reused right away */
+	status = mrcp_connection_data_send(connection,connection->tx_batch_vec,connection->tx_batch_vec_count);
+	connection->tx_batch_vec_count = 0;
+	connection->tx_batch_length = 0;
+	connection->tx_batch_count++;
+	if(status == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Send MRCPv2 Data %s",connection->id);
+	}
+	return status;
+}
+
+apt_bool_t mrcp_connection_data_send(mrcp_connection_t *connection, const struct iovec *vec, apr_int32_t nvec)
+{
+	apr_int32_t i;
+	apr_size_t sent = 0;
+	apr_size_t remaining = 0;
+	apt_bool_t queued = connection->tx_queue_length ? TRUE : FALSE;
+	if(!connection->sock) {
+		return FALSE;
+	}
+
+	if(queued == FALSE) {
+		/* nothing queued, try to send the whole vector at once */
+		apr_status_t status = apr_socket_sendv(connection->sock,vec,nvec,&sent);
+		if(connection->counters) {
+			apr_atomic_inc32(&connection->counters->tx_write_count);
+		}
+		if(status != APR_SUCCESS && !APR_STATUS_IS_EAGAIN(status)) {
+			if(connection->counters) {
+				apr_atomic_inc32(&connection->counters->tx_failure_count);
+			}
+			return FALSE;
+		}
+	}
+
+	for(i = 0; i < nvec; i++) {
+		remaining += vec[i].iov_len;
+	}
+	remaining -= sent;
+	if(!remaining) {
+		return TRUE;
+	}
+
+	if(connection->tx_queue_limit &&
+		connection->tx_queue_length - connection->tx_queue_offset + remaining > connection->tx_queue_limit) {
+		/* the peer doesn't keep up, shut the connection down rather than buffering infinitely */
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Outbound Queue Limit Exceeded %s [%"APR_SIZE_T_FMT" bytes]",
+			connection->id,
+			connection->tx_queue_limit);
+		apr_socket_shutdown(connection->sock,APR_SHUTDOWN_READWRITE);
+		return FALSE;
+	}
+
+	if(queued == FALSE) {
+		connection->tx_stall_count++;
+		if(connection->counters) {
+			apr_atomic_inc32(&connection->counters->tx_stall_count);
+		}
+	}
+
+	/* queue the data not sent, preserving the order of the data already queued */
+	for(i = 0; i < nvec; i++) {
+		if(sent >= vec[i].iov_len) {
+			sent -= vec[i].iov_len;
+			continue;
+		}
+		if(mrcp_connection_tx_queue_append(connection,(const char*)vec[i].iov_base + sent,vec[i].iov_len - sent) == FALSE) {
+			return FALSE;
+		}
+		sent = 0;
+	}
+	return TRUE;
+}
+
+apt_bool_t mrcp_connection_tx_queue_flush(mrcp_connection_t *connection)
+{
+	apr_status_t status;
+	apr_size_t length = connection->tx_queue_length - connection->tx_queue_offset;
+	if(!length) {
+		return TRUE;
+	}
+	if(!connection->sock) {
+		return FALSE;
+	}
+
+	status = apr_socket_send(connection->sock,connection->tx_queue + connection->tx_queue_offset,&length);
+	if(connection->counters) {
+		apr_atomic_inc32(&connection->counters->tx_write_count);
+	}
+	if(status != APR_SUCCESS && !APR_STATUS_IS_EAGAIN(status)) {
+		if(connection->counters) {
+			apr_atomic_inc32(&connection->counters->tx_failure_count);
+		}
+		return FALSE;
+	}
+
+	connection->tx_queue_offset += length;
+	if(connection->tx_queue_offset == connection->tx_queue_length) {
+		/* the queue is drained */
+		connection->tx_queue_offset = 0;
+		connection->tx_queue_length = 0;
+	}
+	return TRUE;
+}
+
+apt_bool_t mrcp_connection_pollout_update(mrcp_connection_t *connection, const apt_poller_task_t *task)
+{
+	apr_int16_t reqevents = connection->sock_pfd.reqevents & ~APR_POLLOUT;
+	if(connection->tx_queue_length) {
+		reqevents |= APR_POLLOUT;
+	}
+	if(!connection->sock || reqevents == connection->sock_pfd.reqevents) {
+		return TRUE;
+	}
+
+	/* requested events cannot be modified in place, re-add the descriptor */
+	apt_poller_task_descriptor_remove(task,&connection->sock_pfd);
+	connection->sock_pfd.reqevents = reqevents;
+	return apt_poller_task_descriptor_add(task,&connection->sock_pfd);
+}
+
 apt_bool_t mrcp_connection_disconnect_raise(mrcp_connection_t *connection, const mrcp_connection_event_vtable_t *vtable)
 {
 	if(vtable && vtable->on_disconnect) {
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <apr_tables.h>
+#include <apr_thread_mutex.h>
 #include "mrcp_connection.h"
 #include "mrcp_server_connection.h"
 #include "mrcp_control_descriptor.h"
@@ -24,21 +26,46 @@
 #include "apt_pool.h"
 #include "apt_log.h"
 
+/** MRCPv2 connection worker (reactor) */
+typedef struct mrcp_connection_worker_t mrcp_connection_worker_t;
+struct mrcp_connection_worker_t {
+	/** Agent the worker belongs to */
+	mrcp_connection_agent_t *agent;
+	/** Poller task connections of the worker are served by */
+	apt_poller_task_t       *task;
+	/** Number of connections currently served by the worker */
+	apr_size_t               connection_count;
+};
 
 struct mrcp_connection_agent_t {
 	apr_pool_t                           *pool;
+	/** Poller task of the agent (the first worker) */
 	apt_poller_task_t                    *task;
 	const mrcp_resource_factory_t        *resource_factory;
 
+	/** Array of workers (mrcp_connection_worker_t*), accepted connections are distributed across */
+	apr_array_header_t                   *workers;
+	/** Max number of connections per worker */
+	apr_size_t                            max_connection_count;
+	/** Mutex guarding the data shared across the workers (created if more than one worker is used) */
+	apr_thread_mutex_t                   *mutex;
+
 	/** List (ring) of MRCP connections */
 	APR_RING_HEAD(mrcp_connection_head_t, mrcp_connection_t) connection_list;
+	/** Table of MRCP connections indexed by remote IP */
+	apr_hash_t                           *connection_table;
 	/** Table of pending control channels */
 	apr_hash_t                           *pending_channel_table;
+	/** Freelist of per-message arenas */
+	apt_pool_recycler_t                  *message_recycler;
+	/** Counters of the data sent through the connections */
+	mrcp_connection_counters_t            counters;
 
 	apt_bool_t                            force_new_connection;
 	apr_size_t                            max_shared_use_count;
 	apr_size_t                            tx_buffer_size;
 	apr_size_t                            rx_buffer_size;
+	apr_size_t                            tx_queue_limit;
 	apr_uint32_t                          inactivity_timeout;
 	apr_uint32_t                          termination_timeout;
 
@@ -55,7 +82,8 @@ typedef enum {
 	CONNECTION_TASK_MSG_ADD_CHANNEL,
 	CONNECTION_TASK_MSG_MODIFY_CHANNEL,
 	CONNECTION_TASK_MSG_REMOVE_CHANNEL,
-	CONNECTION_TASK_MSG_SEND_MESSAGE
+	CONNECTION_TASK_MSG_SEND_MESSAGE,
+	CONNECTION_TASK_MSG_ADD_CONNECTION
 } connection_task_msg_type_e;
 
 typedef struct connection_task_msg_t connection_task_msg_t;
@@ -65,6 +93,7 @@ struct connection_task_msg_t {
 	mrcp_control_channel_t    *channel;
 	mrcp_control_descriptor_t *descriptor;
 	mrcp_message_t            *message;
+	mrcp_connection_t         *connection;
 };
 
 static apt_bool_t mrcp_server_agent_on_destroy(apt_task_t *task);
@@ -74,9 +103,27 @@ static apt_bool_t mrcp_server_poller_signal_process(void *obj, const apr_pollfd_
 static apt_bool_t mrcp_server_agent_listening_socket_create(mrcp_connection_agent_t *agent);
 static void mrcp_server_agent_listening_socket_destroy(mrcp_connection_agent_t *agent);
 
+static apt_bool_t mrcp_server_worker_connection_add(mrcp_connection_worker_t *worker, mrcp_connection_t *connection);
+
 static void mrcp_server_inactivity_timer_proc(apt_timer_t *timer, void *obj);
 static void mrcp_server_termination_timer_proc(apt_timer_t *timer, void *obj);
 
+/** Lock the data shared across the workers (if any) */
+static APR_INLINE void mrcp_server_agent_lock(mrcp_connection_agent_t *agent)
+{
+	if(agent->mutex) {
+		apr_thread_mutex_lock(agent->mutex);
+	}
+}
+
+/** Unlock the data shared across the workers (if any) */
+static APR_INLINE void mrcp_server_agent_unlock(mrcp_connection_agent_t *agent)
+{
+	if(agent->mutex) {
+		apr_thread_mutex_unlock(agent->mutex);
+	}
+}
+
 /** Create connection agent */
 MRCP_DECLARE(mrcp_connection_agent_t*) mrcp_server_connection_agent_create(
 										const char *id,
@@ -90,6 +137,7 @@ MRCP_DECLARE(mrcp_connection_agent_t*) mrcp_server_connection_agent_create(
 	apt_task_vtable_t *vtable;
 	apt_task_msg_pool_t *msg_pool;
 	mrcp_connection_agent_t *agent;
+	mrcp_connection_worker_t *worker;
 
 	if(!listen_ip) {
 		return NULL;
@@ -105,25 +153,37 @@ MRCP_DECLARE(mrcp_connection_agent_t*) mrcp_server_connection_agent_create(
 	agent->max_shared_use_count = 100;
 	agent->rx_buffer_size = MRCP_STREAM_BUFFER_SIZE;
 	agent->tx_buffer_size = MRCP_STREAM_BUFFER_SIZE;
+	agent->tx_queue_limit = MRCP_TX_QUEUE_LIMIT;
 	agent->inactivity_timeout = 600000; /* 10 min */
 	agent->termination_timeout = 3000; /* 3 sec */
+	agent->max_connection_count = max_connection_count;
+	agent->mutex = NULL;
+	agent->workers = apr_array_make(pool,1,sizeof(mrcp_connection_worker_t*));
+	worker = apr_palloc(pool,sizeof(mrcp_connection_worker_t));
+	APR_ARRAY_PUSH(agent->workers,mrcp_connection_worker_t*) = worker;
+	worker->agent = agent;
+	worker->connection_count = 0;
 
 	apr_sockaddr_info_get(&agent->sockaddr,listen_ip,APR_INET,listen_port,0,pool);
 	if(!agent->sockaddr) {
 		return NULL;
 	}
+	if(mrcp_connection_counters_init(&agent->counters,pool) == FALSE) {
+		return NULL;
+	}
 
 	msg_pool = apt_task_msg_pool_create_dynamic(sizeof(connection_task_msg_t),pool);
 	
 	agent->task = apt_poller_task_create(
 					max_connection_count + 1,
 					mrcp_server_poller_signal_process,
-					agent,
+					worker,
 					msg_pool,
 					pool);
 	if(!agent->task) {
 		return NULL;
 	}
+	worker->task = agent->task;
 
 	task = apt_poller_task_base_get(agent->task);
 	if(task) {
@@ -137,7 +197,9 @@ MRCP_DECLARE(mrcp_connection_agent_t*) mrcp_server_connection_agent_create(
 	}
 
 	APR_RING_INIT(&agent->connection_list, mrcp_connection_t, link);
+	agent->connection_table = apr_hash_make(pool);
 	agent->pending_channel_table = apr_hash_make(pool);
+	agent->message_recycler = apt_pool_recycler_create(MRCP_MESSAGE_ARENA_FREELIST_SIZE,pool);
 
 	if(mrcp_server_agent_listening_socket_create(agent) != TRUE) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Listening Socket [%s] %s:%hu", 
@@ -151,9 +213,11 @@ MRCP_DECLARE(mrcp_connection_agent_t*) mrcp_server_connection_agent_create(
 static apt_bool_t mrcp_server_agent_on_destroy(apt_task_t *task)
 {
 	apt_poller_task_t *poller_task = apt_task_object_get(task);
-	mrcp_connection_agent_t *agent = apt_poller_task_object_get(poller_task);
+	mrcp_connection_worker_t *worker = apt_poller_task_object_get(poller_task);
 
-	mrcp_server_agent_listening_socket_destroy(agent);
+	if(worker->task == worker->agent->task) {
+		mrcp_server_agent_listening_socket_destroy(worker->agent);
+	}
 	apt_poller_task_cleanup(poller_task);
 	return TRUE;
 }
@@ -218,6 +282,75 @@ MRCP_DECLARE(void) mrcp_server_connection_tx_size_set(
 	agent->tx_buffer_size = size;
 }
 
+/** Set max number of bytes queued for sending per connection */
+MRCP_DECLARE(void) mrcp_server_connection_tx_queue_limit_set(
+								mrcp_connection_agent_t *agent,
+								apr_size_t limit)
+{
+	agent->tx_queue_limit = limit;
+}
+
+/** Set the number of workers (poller threads) accepted connections are distributed across */
+MRCP_DECLARE(apt_bool_t) mrcp_server_connection_worker_count_set(
+								mrcp_connection_agent_t *agent,
+								apr_size_t worker_count)
+{
+	apt_task_t *task;
+	apt_task_t *parent_task;
+	apt_task_vtable_t *vtable;
+	apt_task_msg_pool_t *msg_pool;
+	mrcp_connection_worker_t *worker;
+	const char *id;
+
+	if(worker_count <= (apr_size_t)agent->workers->nelts) {
+		/* workers can only be added, before the agent is started */
+		return FALSE;
+	}
+
+	if(!agent->mutex) {
+		if(apr_thread_mutex_create(&agent->mutex,APR_THREAD_MUTEX_DEFAULT,agent->pool) != APR_SUCCESS) {
+			agent->mutex = NULL;
+			return FALSE;
+		}
+	}
+
+	parent_task = apt_poller_task_base_get(agent->task);
+	id = apt_task_name_get(parent_task);
+	while((apr_size_t)agent->workers->nelts < worker_count) {
+		worker = apr_palloc(agent->pool,sizeof(mrcp_connection_worker_t));
+		worker->agent = agent;
+		worker->connection_count = 0;
+
+		msg_pool = apt_task_msg_pool_create_dynamic(sizeof(connection_task_msg_t),agent->pool);
+		worker->task = apt_poller_task_create(
+						agent->max_connection_count,
+						mrcp_server_poller_signal_process,
+						worker,
+						msg_pool,
+						agent->pool);
+		if(!worker->task) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create MRCPv2 Worker [%s] [%d]",id,agent->workers->nelts);
+			return FALSE;
+		}
+
+		task = apt_poller_task_base_get(worker->task);
+		apt_task_name_set(task,apr_psprintf(agent->pool,"%s-%d",id,agent->workers->nelts));
+
+		vtable = apt_poller_task_vtable_get(worker->task);
+		if(vtable) {
+			vtable->destroy = mrcp_server_agent_on_destroy;
+			vtable->process_msg = mrcp_server_agent_msg_process;
+		}
+
+		/* workers are started and terminated along with the agent */
+		apt_task_add(parent_task,task);
+		APR_ARRAY_PUSH(agent->workers,mrcp_connection_worker_t*) = worker;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set MRCPv2 Agent Worker Count [%s] [%d]",id,agent->workers->nelts);
+	return TRUE;
+}
+
 /** Set max shared use count for an MRCPv2 connection */
 MRCP_DECLARE(void) mrcp_server_connection_max_shared_use_set(
 								mrcp_connection_agent_t *agent,
@@ -262,6 +395,12 @@ MRCP_DECLARE(const char*) mrcp_server_connection_agent_id_get(const mrcp_connect
 	return apt_task_name_get(task);
 }
 
+/** Get the counters of the data sent */
+MRCP_DECLARE(void) mrcp_server_connection_stats_get(mrcp_connection_agent_t *agent, mrcp_connection_agent_stats_t *stats)
+{
+	mrcp_connection_counters_get(&agent->counters,stats);
+}
+
 
 /** Create MRCPv2 control channel */
 MRCP_DECLARE(mrcp_control_channel_t*) mrcp_server_control_channel_create(mrcp_connection_agent_t *agent, void *obj, apr_pool_t *pool)
@@ -275,13 +414,19 @@ MRCP_DECLARE(mrcp_control_channel_t*) mrcp_server_control_channel_create(mrcp_co
 	channel->obj = obj;
 	channel->log_obj = NULL;
 	channel->pool = pool;
+	channel->received_messages = NULL;
 	return channel;
 }
 
 /** Destroy MRCPv2 control channel */
 MRCP_DECLARE(apt_bool_t) mrcp_server_control_channel_destroy(mrcp_control_channel_t *channel)
 {
-	if(channel && channel->connection && channel->removed == TRUE) {
+	if(!channel) {
+		return TRUE;
+	}
+	/* requests received through the channel are no longer referenced, release their arenas */
+	mrcp_control_channel_messages_release(channel);
+	if(channel->connection && channel->removed == TRUE) {
 		mrcp_connection_t *connection = channel->connection;
 		channel->connection = NULL;
 		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Destroy TCP/MRCPv2 Connection %s",connection->id);
@@ -298,8 +443,20 @@ static apt_bool_t mrcp_server_control_message_signal(
 								mrcp_control_descriptor_t *descriptor,
 								mrcp_message_t *message)
 {
-	apt_task_t *task = apt_poller_task_base_get(agent->task);
-	apt_task_msg_t *task_msg = apt_task_msg_get(task);
+	apt_task_t *task;
+	apt_task_msg_t *task_msg;
+	apt_poller_task_t *poller_task = agent->task;
+	if(channel && type != CONNECTION_TASK_MSG_ADD_CHANNEL) {
+		/* pending channels are processed by the agent, assigned ones by the worker serving the connection */
+		mrcp_server_agent_lock(agent);
+		if(channel->connection && channel->connection->task) {
+			poller_task = channel->connection->task;
+		}
+		mrcp_server_agent_unlock(agent);
+	}
+
+	task = apt_poller_task_base_get(poller_task);
+	task_msg = apt_task_msg_get(task);
 	if(task_msg) {
 		connection_task_msg_t *msg = (connection_task_msg_t*)task_msg->data;
 		msg->type = type;
@@ -307,6 +464,7 @@ static apt_bool_t mrcp_server_control_message_signal(
 		msg->channel = channel;
 		msg->descriptor = descriptor;
 		msg->message = message;
+		msg->connection = NULL;
 		apt_task_msg_signal(task,task_msg);
 	}
 	return TRUE;
@@ -397,14 +555,19 @@ static void mrcp_server_agent_listening_socket_destroy(mrcp_connection_agent_t *
 /** Associate control channel with MRCPv2 connection */
 static mrcp_control_channel_t* mrcp_connection_channel_associate(mrcp_connection_agent_t *agent, mrcp_connection_t *connection, const mrcp_message_t *message)
 {
+	char buf[MRCP_CHANNEL_ID_BUFFER_SIZE];
 	apt_str_t identifier;
 	mrcp_control_channel_t *channel;
 	if(!connection || !message) {
 		return NULL;
 	}
-	apt_id_resource_generate(&message->channel_id.session_id,&message->channel_id.resource_name,'@',&identifier,connection->pool);
-	channel = mrcp_connection_channel_find(connection,&identifier);
+	/* the identifier is composed on the stack, it's used for lookup only */
+	mrcp_channel_identifier_compose(&message->channel_id,buf,sizeof(buf),&identifier,message->pool);
+	/* channels are added to and removed from the connection by the worker serving it only,
+	which is the caller, so the lookup needs no lock */
+	channel = mrcp_connection_channel_lookup(connection,&identifier);
 	if(!channel) {
+		mrcp_server_agent_lock(agent);
 		channel = apr_hash_get(agent->pending_channel_table,identifier.buf,identifier.length);
 		if(channel) {
 			apr_hash_set(agent->pending_channel_table,identifier.buf,identifier.length,NULL);
@@ -415,50 +578,93 @@ static mrcp_control_channel_t* mrcp_connection_channel_associate(mrcp_connection
 				apr_hash_count(agent->pending_channel_table),
 				apr_hash_count(connection->channel_table));
 		}
+		mrcp_server_agent_unlock(agent);
 	}
 	return channel;
 }
 
+/** Find the most recent connection established from the specified remote IP */
 static mrcp_connection_t* mrcp_connection_find(mrcp_connection_agent_t *agent, const apt_str_t *remote_ip)
 {
-	mrcp_connection_t *connection;
 	if(!agent || !remote_ip) {
 		return NULL;
 	}
-
-	for(connection = APR_RING_FIRST(&agent->connection_list);
-			connection != APR_RING_SENTINEL(&agent->connection_list, mrcp_connection_t, link);
-				connection = APR_RING_NEXT(connection, link)) {
-		if(apt_string_compare(&connection->remote_ip,remote_ip) == TRUE) {
-			return connection;
-		}
-	}
-
-	return NULL;
+	return apr_hash_get(agent->connection_table,remote_ip->buf,remote_ip->length);
 }
 
 static apt_bool_t mrcp_connection_add(mrcp_connection_agent_t *agent, mrcp_connection_t *connection)
 {
+	mrcp_server_agent_lock(agent);
 	APR_RING_INSERT_TAIL(&agent->connection_list,connection,mrcp_connection_t,link);
+	/* connections from the same remote IP are chained, the most recent one is indexed */
+	connection->ip_next = apr_hash_get(agent->connection_table,connection->remote_ip.buf,connection->remote_ip.length);
+	if(connection->ip_next) {
+		/* the key references the remote IP of the replaced connection, remove the entry first */
+		apr_hash_set(agent->connection_table,connection->remote_ip.buf,connection->remote_ip.length,NULL);
+	}
+	apr_hash_set(agent->connection_table,connection->remote_ip.buf,connection->remote_ip.length,connection);
+	mrcp_server_agent_unlock(agent);
 	if(connection->inactivity_timer) {
 		apt_timer_set(connection->inactivity_timer,agent->inactivity_timeout);
 	}
 	return TRUE;
 }
 
+/** Remove connection from the index by remote IP */
+static void mrcp_connection_unindex(mrcp_connection_agent_t *agent, mrcp_connection_t *connection)
+{
+	mrcp_connection_t *head = apr_hash_get(agent->connection_table,connection->remote_ip.buf,connection->remote_ip.length);
+	if(head == connection) {
+		apr_hash_set(agent->connection_table,connection->remote_ip.buf,connection->remote_ip.length,NULL);
+		if(connection->ip_next) {
+			apr_hash_set(agent->connection_table,connection->ip_next->remote_ip.buf,connection->ip_next->remote_ip.length,connection->ip_next);
+		}
+	}
+	else {
+		for(; head; head = head->ip_next) {
+			if(head->ip_next == connection) {
+				head->ip_next = connection->ip_next;
+				break;
+			}
+		}
+	}
+	connection->ip_next = NULL;
+}
+
 static apt_bool_t mrcp_connection_remove(mrcp_connection_agent_t *agent, mrcp_connection_t *connection)
 {
 	if(connection->inactivity_timer) {
 		apt_timer_kill(connection->inactivity_timer);
 	}
+	mrcp_server_agent_lock(agent);
 	APR_RING_REMOVE(connection,link);
+	mrcp_connection_unindex(agent,connection);
+	mrcp_server_agent_unlock(agent);
 	return TRUE;
 }
 
+/** Select the least loaded worker to serve a new connection */
+static mrcp_connection_worker_t* mrcp_server_agent_worker_select(mrcp_connection_agent_t *agent)
+{
+	int i;
+	mrcp_connection_worker_t *worker;
+	mrcp_connection_worker_t *selected = APR_ARRAY_IDX(agent->workers,0,mrcp_connection_worker_t*);
+	for(i = 1; i < agent->workers->nelts; i++) {
+		worker = APR_ARRAY_IDX(agent->workers,i,mrcp_connection_worker_t*);
+		if(worker->connection_count < selected->connection_count) {
+			selected = worker;
+		}
+	}
+	selected->connection_count++;
+	return selected;
+}
+
 static apt_bool_t mrcp_server_agent_connection_accept(mrcp_connection_agent_t *agent)
 {
 	char *local_ip = NULL;
 	char *remote_ip = NULL;
+	apr_size_t pending_count;
+	mrcp_connection_worker_t *worker;
 	
 	mrcp_connection_t *connection = mrcp_connection_create();
 
@@ -483,33 +689,79 @@ static apt_bool_t mrcp_server_agent_connection_accept(mrcp_connection_agent_t *a
 		local_ip,connection->l_sockaddr->port,
 		remote_ip,connection->r_sockaddr->port);
 
-	if(apr_hash_count(agent->pending_channel_table) == 0) {
+	mrcp_server_agent_lock(agent);
+	pending_count = apr_hash_count(agent->pending_channel_table);
+	worker = pending_count ? mrcp_server_agent_worker_select(agent) : NULL;
+	mrcp_server_agent_unlock(agent);
+	if(!worker) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Reject Unexpected TCP/MRCPv2 Connection %s",connection->id);
 		apr_socket_close(connection->sock);
 		mrcp_connection_destroy(connection);
 		return FALSE;
 	}
 
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Accepted TCP/MRCPv2 Connection %s",connection->id);
+	connection->agent = agent;
+	connection->task = worker->task;
+	connection->counters = &agent->counters;
+	if(worker->task != agent->task) {
+		/* hand the connection over to the worker */
+		apt_task_t *task = apt_poller_task_base_get(worker->task);
+		apt_task_msg_t *task_msg = apt_task_msg_get(task);
+		if(task_msg) {
+			connection_task_msg_t *msg = (connection_task_msg_t*)task_msg->data;
+			msg->type = CONNECTION_TASK_MSG_ADD_CONNECTION;
+			msg->agent = agent;
+			msg->channel = NULL;
+			msg->descriptor = NULL;
+			msg->message = NULL;
+			msg->connection = connection;
+			return apt_task_msg_signal(task,task_msg);
+		}
+
+		mrcp_server_agent_lock(agent);
+		worker->connection_count--;
+		mrcp_server_agent_unlock(agent);
+		apr_socket_close(connection->sock);
+		mrcp_connection_destroy(connection);
+		return FALSE;
+	}
+	return mrcp_server_worker_connection_add(worker,connection);
+}
+
+/** Start serving accepted connection by the worker */
+static apt_bool_t mrcp_server_worker_connection_add(mrcp_connection_worker_t *worker, mrcp_connection_t *connection)
+{
+	mrcp_connection_agent_t *agent = worker->agent;
+
+	/* never block the worker on send/receive, partial writes are queued */
+	apr_socket_timeout_set(connection->sock,0);
+	connection->task = worker->task;
+
 	memset(&connection->sock_pfd,0,sizeof(apr_pollfd_t));
 	connection->sock_pfd.desc_type = APR_POLL_SOCKET;
 	connection->sock_pfd.reqevents = APR_POLLIN;
 	connection->sock_pfd.desc.s = connection->sock;
 	connection->sock_pfd.client_data = connection;
-	if(apt_poller_task_descriptor_add(agent->task, &connection->sock_pfd) != TRUE) {
+	if(apt_poller_task_descriptor_add(worker->task, &connection->sock_pfd) != TRUE) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Add to Pollset %s",connection->id);
+		mrcp_server_agent_lock(agent);
+		worker->connection_count--;
+		mrcp_server_agent_unlock(agent);
 		apr_socket_close(connection->sock);
 		mrcp_connection_destroy(connection);
 		return FALSE;
 	}
 
-	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Accepted TCP/MRCPv2 Connection %s",connection->id);
-	connection->agent = agent;
-
 	connection->parser = mrcp_parser_create(agent->resource_factory,connection->pool);
+	if(agent->message_recycler) {
+		mrcp_parser_recycler_set(connection->parser,agent->message_recycler);
+	}
 	connection->generator = mrcp_generator_create(agent->resource_factory,connection->pool);
 
 	connection->tx_buffer_size = agent->tx_buffer_size;
 	connection->tx_buffer = apr_palloc(connection->pool,connection->tx_buffer_size+1);
+	connection->tx_queue_limit = agent->tx_queue_limit;
 
 	connection->rx_buffer_size = agent->rx_buffer_size;
 	connection->rx_buffer = apr_palloc(connection->pool,connection->rx_buffer_size+1);
@@ -523,7 +775,7 @@ static apt_bool_t mrcp_server_agent_connection_accept(mrcp_connection_agent_t *a
 
 	if(agent->inactivity_timeout) {
 		connection->inactivity_timer = apt_poller_task_timer_create(
-										agent->task,
+										worker->task,
 										mrcp_server_inactivity_timer_proc,
 										connection,
 										connection->pool);
@@ -536,9 +788,14 @@ static apt_bool_t mrcp_server_agent_connection_accept(mrcp_connection_agent_t *a
 static apt_bool_t mrcp_server_agent_connection_close(mrcp_connection_agent_t *agent, mrcp_connection_t *connection, apt_bool_t timedout)
 {
 	if(connection->sock) {
-		apt_poller_task_descriptor_remove(agent->task,&connection->sock_pfd);
+		mrcp_connection_worker_t *worker = apt_poller_task_object_get(connection->task);
+		apt_poller_task_descriptor_remove(connection->task,&connection->sock_pfd);
 		apr_socket_close(connection->sock);
 		connection->sock = NULL;
+
+		mrcp_server_agent_lock(agent);
+		worker->connection_count--;
+		mrcp_server_agent_unlock(agent);
 	}
 	mrcp_connection_remove(agent,connection);
 	if(connection->access_count) {
@@ -548,7 +805,7 @@ static apt_bool_t mrcp_server_agent_connection_close(mrcp_connection_agent_t *ag
 		else {
 			if(agent->termination_timeout) {
 				connection->termination_timer = apt_poller_task_timer_create(
-												agent->task,
+												connection->task,
 												mrcp_server_termination_timer_proc,
 												connection,
 												connection->pool);
@@ -606,6 +863,7 @@ static apt_bool_t mrcp_server_agent_channel_add(mrcp_connection_agent_t *agent,
 		else {
 			mrcp_connection_t *connection = NULL;
 			/* try to find any existing connection */
+			mrcp_server_agent_lock(agent);
 			connection = mrcp_connection_find(agent,&offer->ip);
 			if(connection) {
 				if(agent->max_shared_use_count && connection->use_count >= agent->max_shared_use_count) {
@@ -620,13 +878,16 @@ static apt_bool_t mrcp_server_agent_channel_add(mrcp_connection_agent_t *agent,
 				/* no existing conection found, force a new one */
 				answer->connection_type = MRCP_CONNECTION_TYPE_NEW;
 			}
+			mrcp_server_agent_unlock(agent);
 		}
 	}
 
+	mrcp_server_agent_lock(agent);
 	apr_hash_set(agent->pending_channel_table,channel->identifier.buf,channel->identifier.length,channel);
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Add Pending Control Channel <%s> [%d]",
 			channel->identifier.buf,
 			apr_hash_count(agent->pending_channel_table));
+	mrcp_server_agent_unlock(agent);
 	/* send response */
 	return mrcp_control_channel_add_respond(agent->vtable,channel,answer,TRUE);
 }
@@ -642,9 +903,32 @@ static apt_bool_t mrcp_server_agent_channel_modify(mrcp_connection_agent_t *agen
 	return mrcp_control_channel_modify_respond(agent->vtable,channel,answer,TRUE);
 }
 
-static apt_bool_t mrcp_server_agent_channel_remove(mrcp_connection_agent_t *agent, mrcp_control_channel_t *channel)
+/** Forward task message to the worker serving the connection the channel has been assigned to */
+static apt_bool_t mrcp_server_agent_msg_forward(apt_poller_task_t *poller_task, const connection_task_msg_t *msg)
 {
-	mrcp_connection_t *connection = channel->connection;
+	apt_task_t *task = apt_poller_task_base_get(poller_task);
+	apt_task_msg_t *task_msg = apt_task_msg_get(task);
+	if(!task_msg) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Forward Task Message <%s>",msg->channel->identifier.buf);
+		return FALSE;
+	}
+	*(connection_task_msg_t*)task_msg->data = *msg;
+	return apt_task_msg_signal(task,task_msg);
+}
+
+static apt_bool_t mrcp_server_agent_channel_remove(mrcp_connection_worker_t *worker, const connection_task_msg_t *msg)
+{
+	mrcp_connection_agent_t *agent = worker->agent;
+	mrcp_control_channel_t *channel = msg->channel;
+	mrcp_connection_t *connection;
+	/* the lock is held throughout, so the channel cannot be assigned to a connection meanwhile */
+	mrcp_server_agent_lock(agent);
+	connection = channel->connection;
+	if(connection && connection->task != worker->task) {
+		/* the channel has been assigned to a connection served by another worker meanwhile */
+		mrcp_server_agent_unlock(agent);
+		return mrcp_server_agent_msg_forward(connection->task,msg);
+	}
 	if(connection) {
 		mrcp_connection_channel_remove(connection,channel);
 		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Remove Control Channel <%s> [%d]",
@@ -669,47 +953,47 @@ static apt_bool_t mrcp_server_agent_channel_remove(mrcp_connection_agent_t *agen
 				channel->identifier.buf,
 				apr_hash_count(agent->pending_channel_table));
 	}
+	mrcp_server_agent_unlock(agent);
 	/* send response */
 	return mrcp_control_channel_remove_respond(agent->vtable,channel,TRUE);
 }
 
 static apt_bool_t mrcp_server_agent_messsage_send(mrcp_connection_agent_t *agent, mrcp_connection_t *connection, mrcp_message_t *message)
 {
-	apt_bool_t status = FALSE;
-	apt_text_stream_t stream;
-	apt_message_status_e result;
+	apt_bool_t status;
 	if(!connection || !connection->sock) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Null MRCPv2 Connection " APT_SIDRES_FMT,MRCP_MESSAGE_SIDRES(message));
 		return FALSE;
 	}
 
-	do {
-		apt_text_stream_init(&stream,connection->tx_buffer,connection->tx_buffer_size);
-		result = mrcp_generator_run(connection->generator,message,&stream);
-		if(result != APT_MESSAGE_STATUS_INVALID) {
-			stream.text.length = stream.pos - stream.text.buf;
-			*stream.pos = '\0';
-
-			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Send MRCPv2 Data %s [%"APR_SIZE_T_FMT" bytes]\n%.*s",
-					connection->id,
-					stream.text.length,
-					connection->verbose == TRUE ? stream.text.length : 0,
-					stream.text.buf);
-
-			if(apr_socket_send(connection->sock,stream.text.buf,&stream.text.length) == APR_SUCCESS) {
-				status = TRUE;
-			}
-			else {
-				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Send MRCPv2 Data");
-			}
-		}
-		else {
-			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Generate MRCPv2 Data");
-		}
+	status = mrcp_connection_message_send(connection,agent->resource_factory,message,NULL);
+	/* request POLLOUT if anything is left in the outbound queue */
+	mrcp_connection_pollout_update(connection,connection->task);
+	return status;
+}
+
+static apt_bool_t mrcp_server_agent_channel_message_send(mrcp_connection_worker_t *worker, const connection_task_msg_t *msg)
+{
+	mrcp_connection_agent_t *agent = worker->agent;
+	mrcp_control_channel_t *channel = msg->channel;
+	mrcp_connection_t *connection;
+	mrcp_server_agent_lock(agent);
+	connection = channel->connection;
+	if(!connection) {
+		/* the channel is not assigned to any connection */
+		mrcp_server_agent_unlock(agent);
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Null MRCPv2 Connection " APT_SIDRES_FMT,MRCP_MESSAGE_SIDRES(msg->message));
+		return FALSE;
+	}
+	mrcp_server_agent_unlock(agent);
+	if(connection->task != worker->task) {
+		/* the channel has been assigned to a connection served by another worker meanwhile */
+		return mrcp_server_agent_msg_forward(connection->task,msg);
 	}
-	while(result == APT_MESSAGE_STATUS_INCOMPLETE);
 
-	return status;
+	/* the channel can only be removed from the connection by this worker, which serves the connection,
+	so the connection and the channel are used without the lock */
+	return mrcp_server_agent_messsage_send(agent,connection,msg->message);
 }
 
 static apt_bool_t mrcp_server_message_handler(mrcp_connection_t *connection, mrcp_message_t *message, apt_message_status_e status)
@@ -724,12 +1008,14 @@ static apt_bool_t mrcp_server_message_handler(mrcp_connection_t *connection, mrc
 				apt_timer_set(connection->inactivity_timer,agent->inactivity_timeout);
 			}
 
+			mrcp_control_channel_message_hold(channel,message);
 			mrcp_connection_message_receive(agent->vtable,channel,message);
 		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Find Channel " APT_SIDRES_FMT " in Connection %s",
 				MRCP_MESSAGE_SIDRES(message),
 				connection->id);
+			mrcp_message_destroy(message);
 		}
 	}
 	else if(status == APT_MESSAGE_STATUS_INVALID) {
@@ -750,7 +1036,8 @@ static apt_bool_t mrcp_server_message_handler(mrcp_connection_t *connection, mrc
 /* Receive MRCP message through TCP/MRCPv2 connection */
 static apt_bool_t mrcp_server_poller_signal_process(void *obj, const apr_pollfd_t *descriptor)
 {
-	mrcp_connection_agent_t *agent = obj;
+	mrcp_connection_worker_t *worker = obj;
+	mrcp_connection_agent_t *agent = worker->agent;
 	mrcp_connection_t *connection = descriptor->client_data;
 	apr_status_t status;
 	apr_size_t offset;
@@ -766,6 +1053,19 @@ static apt_bool_t mrcp_server_poller_signal_process(void *obj, const apr_pollfd_
 	if(!connection || !connection->sock) {
 		return FALSE;
 	}
+
+	if(descriptor->rtnevents & APR_POLLOUT) {
+		/* send the data queued while the socket was not writable */
+		if(mrcp_connection_tx_queue_flush(connection) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Send MRCPv2 Data %s",connection->id);
+			return mrcp_server_agent_connection_close(agent,connection,FALSE);
+		}
+		mrcp_connection_pollout_update(connection,connection->task);
+		if(!(descriptor->rtnevents & ~APR_POLLOUT)) {
+			return TRUE;
+		}
+	}
+
 	stream = &connection->rx_stream;
 
 	/* calculate offset remaining from the previous receive / if any */
@@ -774,6 +1074,10 @@ static apt_bool_t mrcp_server_poller_signal_process(void *obj, const apr_pollfd_
 	length = connection->rx_buffer_size - offset;
 
 	status = apr_socket_recv(connection->sock,stream->pos,&length);
+	if(APR_STATUS_IS_EAGAIN(status)) {
+		/* non-blocking socket, nothing to read yet */
+		return TRUE;
+	}
 	if(status == APR_EOF || length == 0) {
 		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"TCP/MRCPv2 Peer Disconnected %s",connection->id);
 		return mrcp_server_agent_connection_close(agent,connection,FALSE);
@@ -809,7 +1113,8 @@ static apt_bool_t mrcp_server_poller_signal_process(void *obj, const apr_pollfd_
 static apt_bool_t mrcp_server_agent_msg_process(apt_task_t *task, apt_task_msg_t *task_msg)
 {
 	apt_poller_task_t *poller_task = apt_task_object_get(task);
-	mrcp_connection_agent_t *agent = apt_poller_task_object_get(poller_task);
+	mrcp_connection_worker_t *worker = apt_poller_task_object_get(poller_task);
+	mrcp_connection_agent_t *agent = worker->agent;
 	connection_task_msg_t *msg = (connection_task_msg_t*) task_msg->data;
 	switch(msg->type) {
 		case CONNECTION_TASK_MSG_ADD_CHANNEL:
@@ -819,10 +1124,13 @@ static apt_bool_t mrcp_server_agent_msg_process(apt_task_t *task, apt_task_msg_t
 			mrcp_server_agent_channel_modify(agent,msg->channel,msg->descriptor);
 			break;
 		case CONNECTION_TASK_MSG_REMOVE_CHANNEL:
-			mrcp_server_agent_channel_remove(agent,msg->channel);
+			mrcp_server_agent_channel_remove(worker,msg);
 			break;
 		case CONNECTION_TASK_MSG_SEND_MESSAGE:
-			mrcp_server_agent_messsage_send(agent,msg->channel->connection,msg->message);
+			mrcp_server_agent_channel_message_send(worker,msg);
+			break;
+		case CONNECTION_TASK_MSG_ADD_CONNECTION:
+			mrcp_server_worker_connection_add(worker,msg->connection);
 			break;
 	}
 
@@ -45,6 +45,21 @@ struct rtsp_server_vtable_t {
 	apt_bool_t (*handle_message)(rtsp_server_t *server, rtsp_server_session_t *session, rtsp_message_t *message);
 };
 
+/** RTSP server statistics declaration */
+typedef struct rtsp_server_stats_t rtsp_server_stats_t;
+
+/** RTSP server statistics */
+struct rtsp_server_stats_t {
+	/** Number of active sessions */
+	apr_size_t active_session_count;
+	/** Number of active connections */
+	apr_size_t active_connection_count;
+	/** Total number of sessions created */
+	apr_size_t total_session_count;
+	/** Total number of connections accepted */
+	apr_size_t total_connection_count;
+};
+
 /**
  * Create RTSP server.
  * @param id the identifier of the server
@@ -84,6 +99,30 @@ RTSP_DECLARE(apt_bool_t) rtsp_server_start(rtsp_server_t *server);
  */
 RTSP_DECLARE(apt_bool_t) rtsp_server_terminate(rtsp_server_t *server);
 
+/**
+ * Set the number of workers (poller threads) accepted connections are distributed across.
+ * @param server the server to set the parameter for
+ * @param worker_count the number of workers including the server itself
+ * @remark Should be called before the server is started.
+ */
+RTSP_DECLARE(apt_bool_t) rtsp_server_worker_count_set(rtsp_server_t *server, apr_size_t worker_count);
+
+/**
+ * Set the max number of cleared session and connection pools kept for reuse.
+ * @param server the server to set the parameter for
+ * @param pool_count the max number of pools of each kind (0 - create and destroy a pool per object)
+ * @remark Should be called before the server is started.
+ */
+RTSP_DECLARE(apt_bool_t) rtsp_server_pool_count_set(rtsp_server_t *server, apr_size_t pool_count);
+
+/**
+ * Get the counters of sessions and connections.
+ * @param server the server to get the counters of
+ * @param stats the counters to fill
+ * @remark Can be called from any thread.
+ */
+RTSP_DECLARE(void) rtsp_server_stats_get(rtsp_server_t *server, rtsp_server_stats_t *stats);
+
 /**
  * Get task.
  * @param server the server to get task from
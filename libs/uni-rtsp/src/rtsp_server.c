@@ -19,6 +19,9 @@
 #endif
 #include <apr_ring.h>
 #include <apr_hash.h>
+#include <apr_tables.h>
+#include <apr_thread_mutex.h>
+#include <apr_atomic.h>
 #include "rtsp_server.h"
 #include "rtsp_stream.h"
 #include "apt_poller_task.h"
@@ -29,14 +32,48 @@
 
 #define RTSP_SESSION_ID_HEX_STRING_LENGTH 16
 #define RTSP_STREAM_BUFFER_SIZE 1024
+#define RTSP_SERVER_POOL_COUNT 100
 
 typedef struct rtsp_server_connection_t rtsp_server_connection_t;
 
+/** RTSP server worker (reactor) */
+typedef struct rtsp_server_worker_t rtsp_server_worker_t;
+struct rtsp_server_worker_t {
+	/** RTSP server, worker belongs to */
+	rtsp_server_t     *server;
+	/** Poller task connections of the worker are served by */
+	apt_poller_task_t *task;
+	/** Number of connections currently served by the worker */
+	apr_size_t         connection_count;
+};
+
 /** RTSP server */
 struct rtsp_server_t {
 	apr_pool_t                 *pool;
+	/** Poller task of the server (the first worker) */
 	apt_poller_task_t          *task;
 
+	/** Array of workers (rtsp_server_worker_t*), accepted connections are distributed across */
+	apr_array_header_t         *workers;
+	/** Max number of connections per worker */
+	apr_size_t                  max_connection_count;
+	/** Mutex guarding the data shared across the workers (created if more than one worker is used) */
+	apr_thread_mutex_t         *mutex;
+
+	/** Max number of cleared session and connection pools kept for reuse (0 - no reuse) */
+	apr_size_t                  pool_count;
+	/** Recycler of session pools */
+	apt_pool_recycler_t        *session_recycler;
+	/** Recycler of connection pools */
+	apt_pool_recycler_t        *connection_recycler;
+
+	/** Number of active sessions and connections */
+	volatile apr_uint32_t       active_session_count;
+	volatile apr_uint32_t       active_connection_count;
+	/** Total number of sessions and connections served */
+	volatile apr_uint32_t       total_session_count;
+	volatile apr_uint32_t       total_connection_count;
+
 	/** List (ring) of RTSP connections */
 	APR_RING_HEAD(rtsp_server_connection_head_t, rtsp_server_connection_t) connection_list;
 
@@ -70,6 +107,8 @@ struct rtsp_server_connection_t {
 
 	/** RTSP server, connection belongs to */
 	rtsp_server_t     *server;
+	/** Poller task of the worker serving the connection */
+	apt_poller_task_t *task;
 
 	/** Session table (rtsp_server_session_t*) */
 	apr_hash_t        *session_table;
@@ -113,7 +152,8 @@ struct rtsp_server_session_t {
 typedef enum {
 	TASK_MSG_SEND_MESSAGE,
 	TASK_MSG_TERMINATE_SESSION,
-	TASK_MSG_RELEASE_SESSION
+	TASK_MSG_RELEASE_SESSION,
+	TASK_MSG_ADD_CONNECTION
 } task_msg_data_type_e;
 
 typedef struct task_msg_data_t task_msg_data_t;
@@ -123,6 +163,7 @@ struct task_msg_data_t {
 	rtsp_server_t         *server;
 	rtsp_server_session_t *session;
 	rtsp_message_t        *message;
+	rtsp_server_connection_t *connection;
 };
 
 static apt_bool_t rtsp_server_on_destroy(apt_task_t *task);
@@ -135,9 +176,28 @@ static apt_bool_t rtsp_server_session_terminate_request(rtsp_server_t *server, r
 
 static apt_bool_t rtsp_server_listening_socket_create(rtsp_server_t *server);
 static void rtsp_server_listening_socket_destroy(rtsp_server_t *server);
+static void rtsp_server_connections_destroy(rtsp_server_t *server);
+
+static apt_bool_t rtsp_server_worker_connection_add(rtsp_server_worker_t *worker, rtsp_server_connection_t *rtsp_connection);
 
 static void rtsp_server_inactivity_timer_proc(apt_timer_t *timer, void *obj);
 
+/** Lock the data shared across the workers (if any) */
+static APR_INLINE void rtsp_server_lock(rtsp_server_t *server)
+{
+	if(server->mutex) {
+		apr_thread_mutex_lock(server->mutex);
+	}
+}
+
+/** Unlock the data shared across the workers (if any) */
+static APR_INLINE void rtsp_server_unlock(rtsp_server_t *server)
+{
+	if(server->mutex) {
+		apr_thread_mutex_unlock(server->mutex);
+	}
+}
+
 /** Get string identifier */
 static const char* rtsp_server_id_get(const rtsp_server_t *server)
 {
@@ -160,6 +220,7 @@ RTSP_DECLARE(rtsp_server_t*) rtsp_server_create(
 	apt_task_vtable_t *vtable;
 	apt_task_msg_pool_t *msg_pool;
 	rtsp_server_t *server;
+	rtsp_server_worker_t *worker;
 
 	if(!listen_ip) {
 		return NULL;
@@ -178,6 +239,20 @@ RTSP_DECLARE(rtsp_server_t*) rtsp_server_create(
 
 	server->inactivity_timeout = (apr_uint32_t)connection_timeout * 1000;
 	server->online = TRUE;
+	server->max_connection_count = max_connection_count;
+	server->mutex = NULL;
+	server->workers = apr_array_make(pool,1,sizeof(rtsp_server_worker_t*));
+	server->pool_count = RTSP_SERVER_POOL_COUNT;
+	server->session_recycler = NULL;
+	server->connection_recycler = NULL;
+	server->active_session_count = 0;
+	server->active_connection_count = 0;
+	server->total_session_count = 0;
+	server->total_connection_count = 0;
+	worker = apr_palloc(pool,sizeof(rtsp_server_worker_t));
+	APR_ARRAY_PUSH(server->workers,rtsp_server_worker_t*) = worker;
+	worker->server = server;
+	worker->connection_count = 0;
 
 	server->listen_sock = NULL;
 	server->sockaddr = NULL;
@@ -191,12 +266,13 @@ RTSP_DECLARE(rtsp_server_t*) rtsp_server_create(
 	server->task = apt_poller_task_create(
 						max_connection_count + 1,
 						rtsp_server_poller_signal_process,
-						server,
+						worker,
 						msg_pool,
 						pool);
 	if(!server->task) {
 		return NULL;
 	}
+	worker->task = server->task;
 
 	task = apt_poller_task_base_get(server->task);
 	if(task) {
@@ -225,9 +301,12 @@ RTSP_DECLARE(rtsp_server_t*) rtsp_server_create(
 static apt_bool_t rtsp_server_on_destroy(apt_task_t *task)
 {
 	apt_poller_task_t *poller_task = apt_task_object_get(task);
-	rtsp_server_t *server = apt_poller_task_object_get(poller_task);
+	rtsp_server_worker_t *worker = apt_poller_task_object_get(poller_task);
 
-	rtsp_server_listening_socket_destroy(server);
+	if(worker->task == worker->server->task) {
+		rtsp_server_listening_socket_destroy(worker->server);
+		rtsp_server_connections_destroy(worker->server);
+	}
 	apt_poller_task_cleanup(poller_task);
 	return TRUE;
 }
@@ -252,6 +331,86 @@ RTSP_DECLARE(apt_bool_t) rtsp_server_terminate(rtsp_server_t *server)
 	return apt_poller_task_terminate(server->task);
 }
 
+/** Set the number of workers (poller threads) accepted connections are distributed across */
+RTSP_DECLARE(apt_bool_t) rtsp_server_worker_count_set(rtsp_server_t *server, apr_size_t worker_count)
+{
+	apt_task_t *task;
+	apt_task_t *parent_task;
+	apt_task_vtable_t *vtable;
+	apt_task_msg_pool_t *msg_pool;
+	rtsp_server_worker_t *worker;
+	const char *id;
+
+	if(worker_count <= (apr_size_t)server->workers->nelts) {
+		/* workers can only be added, before the server is started */
+		return FALSE;
+	}
+
+	if(!server->mutex) {
+		if(apr_thread_mutex_create(&server->mutex,APR_THREAD_MUTEX_DEFAULT,server->pool) != APR_SUCCESS) {
+			server->mutex = NULL;
+			return FALSE;
+		}
+	}
+
+	parent_task = apt_poller_task_base_get(server->task);
+	id = apt_task_name_get(parent_task);
+	while((apr_size_t)server->workers->nelts < worker_count) {
+		worker = apr_palloc(server->pool,sizeof(rtsp_server_worker_t));
+		worker->server = server;
+		worker->connection_count = 0;
+
+		msg_pool = apt_task_msg_pool_create_dynamic(sizeof(task_msg_data_t),server->pool);
+		worker->task = apt_poller_task_create(
+						server->max_connection_count,
+						rtsp_server_poller_signal_process,
+						worker,
+						msg_pool,
+						server->pool);
+		if(!worker->task) {
+			apt_log(RTSP_LOG_MARK,APT_PRIO_WARNING,"Failed to Create RTSP Worker [%s] [%d]",id,server->workers->nelts);
+			return FALSE;
+		}
+
+		task = apt_poller_task_base_get(worker->task);
+		apt_task_name_set(task,apr_psprintf(server->pool,"%s-%d",id,server->workers->nelts));
+
+		vtable = apt_poller_task_vtable_get(worker->task);
+		if(vtable) {
+			vtable->destroy = rtsp_server_on_destroy;
+			vtable->process_msg = rtsp_server_task_msg_process;
+		}
+
+		/* workers are started and terminated along with the server */
+		apt_task_add(parent_task,task);
+		APR_ARRAY_PUSH(server->workers,rtsp_server_worker_t*) = worker;
+	}
+
+	apt_log(RTSP_LOG_MARK,APT_PRIO_INFO,"Set RTSP Server Worker Count [%s] [%d]",id,server->workers->nelts);
+	return TRUE;
+}
+
+/** Set the max number of cleared session and connection pools kept for reuse */
+RTSP_DECLARE(apt_bool_t) rtsp_server_pool_count_set(rtsp_server_t *server, apr_size_t pool_count)
+{
+	if(server->session_recycler || server->connection_recycler) {
+		/* recyclers are created on the first accepted connection */
+		apt_log(RTSP_LOG_MARK,APT_PRIO_WARNING,"Failed to Set RTSP Pool Count [%s]",rtsp_server_id_get(server));
+		return FALSE;
+	}
+	server->pool_count = pool_count;
+	return TRUE;
+}
+
+/** Get the counters of sessions and connections */
+RTSP_DECLARE(void) rtsp_server_stats_get(rtsp_server_t *server, rtsp_server_stats_t *stats)
+{
+	stats->active_session_count = apr_atomic_read32(&server->active_session_count);
+	stats->active_connection_count = apr_atomic_read32(&server->active_connection_count);
+	stats->total_session_count = apr_atomic_read32(&server->total_session_count);
+	stats->total_connection_count = apr_atomic_read32(&server->total_connection_count);
+}
+
 /** Get task */
 RTSP_DECLARE(apt_task_t*) rtsp_server_task_get(const rtsp_server_t *server)
 {
@@ -304,14 +463,23 @@ static apt_bool_t rtsp_server_control_message_signal(
 								rtsp_server_session_t *session,
 								rtsp_message_t *message)
 {
-	apt_task_t *task = apt_poller_task_base_get(server->task);
-	apt_task_msg_t *task_msg = apt_task_msg_get(task);
+	apt_task_t *task;
+	apt_task_msg_t *task_msg;
+	apt_poller_task_t *poller_task = server->task;
+	if(session->connection) {
+		/* sessions are processed by the worker serving the connection */
+		poller_task = session->connection->task;
+	}
+
+	task = apt_poller_task_base_get(poller_task);
+	task_msg = apt_task_msg_get(task);
 	if(task_msg) {
 		task_msg_data_t *data = (task_msg_data_t*)task_msg->data;
 		data->type = type;
 		data->server = server;
 		data->session = session;
 		data->message = message;
+		data->connection = NULL;
 		apt_task_msg_signal(task,task_msg);
 	}
 	return TRUE;
@@ -335,14 +503,38 @@ RTSP_DECLARE(apt_bool_t) rtsp_server_session_release(rtsp_server_t *server, rtsp
 	return rtsp_server_control_message_signal(TASK_MSG_RELEASE_SESSION,server,session,NULL);
 }
 
+/** Acquire pool from the recycler (if any) */
+static APR_INLINE apr_pool_t* rtsp_server_pool_acquire(apt_pool_recycler_t *recycler)
+{
+	if(recycler) {
+		return apt_pool_recycler_acquire(recycler);
+	}
+	return apt_pool_create();
+}
+
+/** Release pool back to the recycler (if any) */
+static APR_INLINE void rtsp_server_pool_release(apt_pool_recycler_t *recycler, apr_pool_t *pool)
+{
+	if(recycler) {
+		apt_pool_recycler_release(recycler,pool);
+	}
+	else {
+		apr_pool_destroy(pool);
+	}
+}
+
 /* Create RTSP session */
-static rtsp_server_session_t* rtsp_server_session_create(rtsp_server_t *server)
+static rtsp_server_session_t* rtsp_server_session_create(rtsp_server_t *server, rtsp_server_connection_t *rtsp_connection)
 {
 	rtsp_server_session_t *session;
-	apr_pool_t *pool = apt_pool_create();
+	apr_pool_t *pool = rtsp_server_pool_acquire(server->session_recycler);
+	if(!pool) {
+		return NULL;
+	}
 	session = apr_palloc(pool,sizeof(rtsp_server_session_t));
 	session->pool = pool;
 	session->obj = NULL;
+	session->connection = rtsp_connection;
 	session->last_cseq = 0;
 	session->active_request = NULL;
 	session->request_queue = apt_list_create(pool);
@@ -352,27 +544,32 @@ static rtsp_server_session_t* rtsp_server_session_create(rtsp_server_t *server)
 	apt_unique_id_generate(&session->id,RTSP_SESSION_ID_HEX_STRING_LENGTH,pool);
 	apt_log(RTSP_LOG_MARK,APT_PRIO_NOTICE,"Create RTSP Session " APT_SID_FMT,session->id.buf);
 	if(server->vtable->create_session(server,session) != TRUE) {
-		apr_pool_destroy(pool);
+		rtsp_server_pool_release(server->session_recycler,pool);
 		return NULL;
 	}
+	apr_atomic_inc32(&server->active_session_count);
+	apr_atomic_inc32(&server->total_session_count);
 	return session;
 }
 
 /* Destroy RTSP session */
-static void rtsp_server_session_destroy(rtsp_server_session_t *session)
+static void rtsp_server_session_destroy(rtsp_server_t *server, rtsp_server_session_t *session)
 {
 	apt_log(RTSP_LOG_MARK,APT_PRIO_NOTICE,"Destroy RTSP Session " APT_SID_FMT,
 		session ? session->id.buf : "(null)");
 	if(session && session->pool) {
-		apr_pool_destroy(session->pool);
+		apr_atomic_dec32(&server->active_session_count);
+		rtsp_server_pool_release(server->session_recycler,session->pool);
 	}
 }
 
 /** Destroy RTSP connection */
 static void rtsp_server_connection_destroy(rtsp_server_connection_t *rtsp_connection)
 {
+	rtsp_server_t *server = rtsp_connection->server;
 	apt_log(RTSP_LOG_MARK,APT_PRIO_NOTICE,"Destroy RTSP Connection %s",rtsp_connection->id);
-	apr_pool_destroy(rtsp_connection->pool);
+	apr_atomic_dec32(&server->active_connection_count);
+	rtsp_server_pool_release(server->connection_recycler,rtsp_connection->pool);
 }
 
 /* Finally terminate RTSP session */
@@ -399,7 +596,7 @@ static apt_bool_t rtsp_server_session_do_terminate(rtsp_server_t *server, rtsp_s
 	if(rtsp_connection) {
 		apr_hash_set(rtsp_connection->session_table,session->id.buf,session->id.length,NULL);
 	}
-	rtsp_server_session_destroy(session);
+	rtsp_server_session_destroy(server,session);
 
 	if(rtsp_connection && !rtsp_connection->sock) {
 		if(apr_hash_count(rtsp_connection->session_table) == 0) {
@@ -468,11 +665,10 @@ static apt_bool_t rtsp_server_session_message_handle(rtsp_server_t *server, rtsp
 static rtsp_server_session_t* rtsp_server_session_setup_process(rtsp_server_t *server, rtsp_server_connection_t *rtsp_connection, rtsp_message_t *message)
 {
 	/* create new session */
-	rtsp_server_session_t *session = rtsp_server_session_create(server);
+	rtsp_server_session_t *session = rtsp_server_session_create(server,rtsp_connection);
 	if(!session) {
 		return NULL;
 	}
-	session->connection = rtsp_connection;
 	apt_log(RTSP_LOG_MARK,APT_PRIO_INFO,"Add RTSP Session " APT_SID_FMT,session->id.buf);
 	apr_hash_set(rtsp_connection->session_table,session->id.buf,session->id.length,session);
 	return session;
@@ -520,7 +716,8 @@ static apt_bool_t rtsp_server_session_request_process(rtsp_server_t *server, rts
 		if(session) {
 			session->active_request = message;
 			if(rtsp_server_session_message_handle(server,session,message) != TRUE) {
-				rtsp_server_session_destroy(session);
+				apr_hash_set(rtsp_connection->session_table,session->id.buf,session->id.length,NULL);
+				rtsp_server_session_destroy(server,session);
 			}
 		}
 		else {
@@ -765,15 +962,48 @@ static void rtsp_server_listening_socket_destroy(rtsp_server_t *server)
 	}
 }
 
+/** Select the least loaded worker to serve a new connection */
+static rtsp_server_worker_t* rtsp_server_worker_select(rtsp_server_t *server)
+{
+	int i;
+	rtsp_server_worker_t *worker;
+	rtsp_server_worker_t *selected = APR_ARRAY_IDX(server->workers,0,rtsp_server_worker_t*);
+	for(i = 1; i < server->workers->nelts; i++) {
+		worker = APR_ARRAY_IDX(server->workers,i,rtsp_server_worker_t*);
+		if(worker->connection_count < selected->connection_count) {
+			selected = worker;
+		}
+	}
+	selected->connection_count++;
+	return selected;
+}
+
 /* Accept RTSP connection */
 static apt_bool_t rtsp_server_connection_accept(rtsp_server_t *server)
 {
 	rtsp_server_connection_t *rtsp_connection;
+	rtsp_server_worker_t *worker;
 	char *local_ip = NULL;
 	char *remote_ip = NULL;
 	apr_sockaddr_t *l_sockaddr = NULL;
 	apr_sockaddr_t *r_sockaddr = NULL;
-	apr_pool_t *pool = apt_pool_create();
+	apr_pool_t *pool;
+
+	if(server->pool_count && !server->connection_recycler) {
+		/* connections are accepted by the server task only, workers get the recyclers along with connections */
+		apt_log(RTSP_LOG_MARK,APT_PRIO_INFO,"Create RTSP Pool Recyclers [%s] [%"APR_SIZE_T_FMT"]",
+			rtsp_server_id_get(server),
+			server->pool_count);
+		/* the pools are used by different workers, do not let them contend for a single allocator */
+		server->session_recycler = apt_pool_recycler_create_ex(server->pool_count,TRUE,server->pool);
+		server->connection_recycler = apt_pool_recycler_create_ex(server->pool_count,TRUE,server->pool);
+		if(!server->session_recycler || !server->connection_recycler) {
+			apt_log(RTSP_LOG_MARK,APT_PRIO_WARNING,"Failed to Create RTSP Pool Recyclers");
+			server->pool_count = 0;
+		}
+	}
+
+	pool = rtsp_server_pool_acquire(server->connection_recycler);
 	if(!pool) {
 		return FALSE;
 	}
@@ -786,14 +1016,14 @@ static apt_bool_t rtsp_server_connection_accept(rtsp_server_t *server)
 
 	if(apr_socket_accept(&rtsp_connection->sock,server->listen_sock,rtsp_connection->pool) != APR_SUCCESS) {
 		apt_log(RTSP_LOG_MARK,APT_PRIO_WARNING,"Failed to Accept RTSP Connection");
-		apr_pool_destroy(pool);
+		rtsp_server_pool_release(server->connection_recycler,pool);
 		return FALSE;
 	}
 
 	if(apr_socket_addr_get(&l_sockaddr,APR_LOCAL,rtsp_connection->sock) != APR_SUCCESS ||
 		apr_socket_addr_get(&r_sockaddr,APR_REMOTE,rtsp_connection->sock) != APR_SUCCESS) {
 		apt_log(RTSP_LOG_MARK,APT_PRIO_WARNING,"Failed to Get RTSP Socket Address");
-		apr_pool_destroy(pool);
+		rtsp_server_pool_release(server->connection_recycler,pool);
 		return FALSE;
 	}
 
@@ -803,52 +1033,124 @@ static apt_bool_t rtsp_server_connection_accept(rtsp_server_t *server)
 	rtsp_connection->id = apr_psprintf(pool,"%s:%hu <-> %s:%hu",
 		local_ip,l_sockaddr->port,
 		remote_ip,r_sockaddr->port);
+	rtsp_connection->server = server;
+
+	rtsp_server_lock(server);
+	worker = rtsp_server_worker_select(server);
+	rtsp_server_unlock(server);
+
+	rtsp_connection->task = worker->task;
+	if(worker->task != server->task) {
+		/* hand the connection over to the worker */
+		apt_task_t *task = apt_poller_task_base_get(worker->task);
+		apt_task_msg_t *task_msg = apt_task_msg_get(task);
+		if(task_msg) {
+			task_msg_data_t *data = (task_msg_data_t*)task_msg->data;
+			data->type = TASK_MSG_ADD_CONNECTION;
+			data->server = server;
+			data->session = NULL;
+			data->message = NULL;
+			data->connection = rtsp_connection;
+			return apt_task_msg_signal(task,task_msg);
+		}
+
+		rtsp_server_lock(server);
+		worker->connection_count--;
+		rtsp_server_unlock(server);
+		apr_socket_close(rtsp_connection->sock);
+		rtsp_server_pool_release(server->connection_recycler,pool);
+		return FALSE;
+	}
+	return rtsp_server_worker_connection_add(worker,rtsp_connection);
+}
+
+/** Start serving accepted connection by the worker */
+static apt_bool_t rtsp_server_worker_connection_add(rtsp_server_worker_t *worker, rtsp_server_connection_t *rtsp_connection)
+{
+	rtsp_server_t *server = worker->server;
+	rtsp_connection->task = worker->task;
 
 	memset(&rtsp_connection->sock_pfd,0,sizeof(apr_pollfd_t));
 	rtsp_connection->sock_pfd.desc_type = APR_POLL_SOCKET;
 	rtsp_connection->sock_pfd.reqevents = APR_POLLIN;
 	rtsp_connection->sock_pfd.desc.s = rtsp_connection->sock;
 	rtsp_connection->sock_pfd.client_data = rtsp_connection;
-	if(apt_poller_task_descriptor_add(server->task,&rtsp_connection->sock_pfd) != TRUE) {
+	if(apt_poller_task_descriptor_add(worker->task,&rtsp_connection->sock_pfd) != TRUE) {
 		apt_log(RTSP_LOG_MARK,APT_PRIO_WARNING,"Failed to Add to Pollset %s",rtsp_connection->id);
+		rtsp_server_lock(server);
+		worker->connection_count--;
+		rtsp_server_unlock(server);
 		apr_socket_close(rtsp_connection->sock);
-		apr_pool_destroy(pool);
+		rtsp_server_pool_release(server->connection_recycler,rtsp_connection->pool);
 		return FALSE;
 	}
 
 	apt_log(RTSP_LOG_MARK,APT_PRIO_NOTICE,"Accepted RTSP Connection %s",rtsp_connection->id);
+	apr_atomic_inc32(&server->active_connection_count);
+	apr_atomic_inc32(&server->total_connection_count);
 	rtsp_connection->session_table = apr_hash_make(rtsp_connection->pool);
 	apt_text_stream_init(&rtsp_connection->rx_stream,rtsp_connection->rx_buffer,sizeof(rtsp_connection->rx_buffer)-1);
 	apt_text_stream_init(&rtsp_connection->tx_stream,rtsp_connection->tx_buffer,sizeof(rtsp_connection->tx_buffer)-1);
 	rtsp_connection->parser = rtsp_parser_create(rtsp_connection->pool);
 	rtsp_connection->generator = rtsp_generator_create(rtsp_connection->pool);
-	rtsp_connection->server = server;
 
 	rtsp_connection->inactivity_timer = NULL;
 	if(server->inactivity_timeout) {
 		rtsp_connection->inactivity_timer = apt_poller_task_timer_create(
-												server->task,
+												worker->task,
 												rtsp_server_inactivity_timer_proc,
 												rtsp_connection,
 												rtsp_connection->pool);
 	}
 
+	rtsp_server_lock(server);
 	APR_RING_INSERT_TAIL(&server->connection_list,rtsp_connection,rtsp_server_connection_t,link);
+	rtsp_server_unlock(server);
 	if(rtsp_connection->inactivity_timer) {
 		apt_timer_set(rtsp_connection->inactivity_timer,server->inactivity_timeout);
 	}
 	return TRUE;
 }
 
+/** Destroy the connections remaining on shutdown along with their sessions */
+static void rtsp_server_connections_destroy(rtsp_server_t *server)
+{
+	rtsp_server_connection_t *rtsp_connection;
+	rtsp_server_session_t *session;
+	apr_hash_index_t *it;
+	void *val;
+	/* recycled pools have own allocators, they are not destroyed along with the pool of the server */
+	while(!APR_RING_EMPTY(&server->connection_list,rtsp_server_connection_t,link)) {
+		rtsp_connection = APR_RING_FIRST(&server->connection_list);
+		APR_RING_REMOVE(rtsp_connection,link);
+		if(rtsp_connection->sock) {
+			apr_socket_close(rtsp_connection->sock);
+			rtsp_connection->sock = NULL;
+		}
+
+		it = apr_hash_first(rtsp_connection->pool,rtsp_connection->session_table);
+		for(; it; it = apr_hash_next(it)) {
+			apr_hash_this(it,NULL,NULL,&val);
+			session = val;
+			if(session) {
+				rtsp_server_session_destroy(server,session);
+			}
+		}
+		rtsp_server_connection_destroy(rtsp_connection);
+	}
+}
+
 /** Close connection */
 static apt_bool_t rtsp_server_connection_close(rtsp_server_t *server, rtsp_server_connection_t *rtsp_connection)
 {
 	apr_size_t remaining_sessions = 0;
+	rtsp_server_worker_t *worker;
 	if(!rtsp_connection || !rtsp_connection->sock) {
 		return FALSE;
 	}
 	apt_log(RTSP_LOG_MARK,APT_PRIO_INFO,"Close RTSP Connection %s",rtsp_connection->id);
-	apt_poller_task_descriptor_remove(server->task,&rtsp_connection->sock_pfd);
+	worker = apt_poller_task_object_get(rtsp_connection->task);
+	apt_poller_task_descriptor_remove(rtsp_connection->task,&rtsp_connection->sock_pfd);
 	apr_socket_close(rtsp_connection->sock);
 	rtsp_connection->sock = NULL;
 
@@ -856,7 +1158,10 @@ static apt_bool_t rtsp_server_connection_close(rtsp_server_t *server, rtsp_serve
 		apt_timer_kill(rtsp_connection->inactivity_timer);
 	}
 
+	rtsp_server_lock(server);
 	APR_RING_REMOVE(rtsp_connection,link);
+	worker->connection_count--;
+	rtsp_server_unlock(server);
 
 	remaining_sessions = apr_hash_count(rtsp_connection->session_table);
 	if(remaining_sessions) {
@@ -895,7 +1200,8 @@ static void rtsp_server_inactivity_timer_proc(apt_timer_t *timer, void *obj)
 /* Receive RTSP message through RTSP connection */
 static apt_bool_t rtsp_server_poller_signal_process(void *obj, const apr_pollfd_t *descriptor)
 {
-	rtsp_server_t *server = obj;
+	rtsp_server_worker_t *worker = obj;
+	rtsp_server_t *server = worker->server;
 	rtsp_server_connection_t *rtsp_connection = descriptor->client_data;
 	apr_status_t status;
 	apr_size_t offset;
@@ -904,7 +1210,7 @@ static apt_bool_t rtsp_server_poller_signal_process(void *obj, const apr_pollfd_
 	rtsp_message_t *message;
 	apt_message_status_e msg_status;
 
-	if(descriptor->desc.s == server->listen_sock) {
+	if(worker->task == server->task && descriptor->desc.s == server->listen_sock) {
 		return rtsp_server_connection_accept(server);
 	}
 
@@ -949,24 +1255,25 @@ static apt_bool_t rtsp_server_poller_signal_process(void *obj, const apr_pollfd_
 static void rtsp_server_on_offline(apt_task_t *task)
 {
 	apt_poller_task_t *poller_task = apt_task_object_get(task);
-	rtsp_server_t *server = apt_poller_task_object_get(poller_task);
+	rtsp_server_worker_t *worker = apt_poller_task_object_get(poller_task);
 
-	server->online = FALSE;
+	worker->server->online = FALSE;
 }
 
 static void rtsp_server_on_online(apt_task_t *task)
 {
 	apt_poller_task_t *poller_task = apt_task_object_get(task);
-	rtsp_server_t *server = apt_poller_task_object_get(poller_task);
+	rtsp_server_worker_t *worker = apt_poller_task_object_get(poller_task);
 
-	server->online = TRUE;
+	worker->server->online = TRUE;
 }
 
 /* Process task message */
 static apt_bool_t rtsp_server_task_msg_process(apt_task_t *task, apt_task_msg_t *task_msg)
 {
 	apt_poller_task_t *poller_task = apt_task_object_get(task);
-	rtsp_server_t *server = apt_poller_task_object_get(poller_task);
+	rtsp_server_worker_t *worker = apt_poller_task_object_get(poller_task);
+	rtsp_server_t *server = worker->server;
 
 	task_msg_data_t *data = (task_msg_data_t*) task_msg->data;
 	switch(data->type) {
@@ -979,6 +1286,9 @@ static apt_bool_t rtsp_server_task_msg_process(apt_task_t *task, apt_task_msg_t
 		case TASK_MSG_RELEASE_SESSION:
 			rtsp_server_session_do_release(server,data->session);
 			break;
+		case TASK_MSG_ADD_CONNECTION:
+			rtsp_server_worker_connection_add(worker,data->connection);
+			break;
 	}
 
 	return TRUE;
@@ -23,11 +23,18 @@
  */ 
 
 #include "mrcp_sig_types.h"
+#include "apt_text_template.h"
 
 APT_BEGIN_EXTERN_C
 
-/** Generate SDP string by MRCP descriptor */
-MRCP_DECLARE(apr_size_t) sdp_string_generate_by_mrcp_descriptor(char *buffer, apr_size_t size, const mrcp_session_descriptor_t *descriptor, apt_bool_t offer);
+/** Opaque SDP templates declaration */
+typedef struct mrcp_sdp_templates_t mrcp_sdp_templates_t;
+
+/** Create SDP templates (session and media lines precompiled once, the origin is taken from the descriptor) */
+MRCP_DECLARE(mrcp_sdp_templates_t*) sdp_templates_create(apr_pool_t *pool);
+
+/** Generate SDP string by MRCP descriptor using precompiled SDP templates */
+MRCP_DECLARE(apr_size_t) sdp_string_generate_by_mrcp_descriptor(char *buffer, apr_size_t size, const mrcp_session_descriptor_t *descriptor, const mrcp_sdp_templates_t *templates, apt_bool_t offer);
 
 /** Generate MRCP descriptor by SDP session */
 MRCP_DECLARE(apt_bool_t) mrcp_descriptor_generate_by_sdp_session(mrcp_session_descriptor_t* descriptor, const sdp_session_t *sdp, const char *force_destination_ip, apr_pool_t *pool);
@@ -26,15 +26,146 @@
 #include "apt_text_stream.h"
 #include "apt_log.h"
 
-static apr_size_t sdp_rtp_media_generate(char *buffer, apr_size_t size, const mrcp_session_descriptor_t *descriptor, const mpf_rtp_media_descriptor_t *audio_descriptor);
-static apr_size_t sdp_control_media_generate(char *buffer, apr_size_t size, const mrcp_session_descriptor_t *descriptor, const mrcp_control_descriptor_t *control_media, apt_bool_t offer);
+static void sdp_rtp_media_generate(apt_text_stream_t *stream, const mrcp_sdp_templates_t *templates, const mrcp_session_descriptor_t *descriptor, const mpf_rtp_media_descriptor_t *audio_descriptor);
+static void sdp_control_media_generate(apt_text_stream_t *stream, const mrcp_sdp_templates_t *templates, const mrcp_control_descriptor_t *control_media, apt_bool_t offer);
 
 static apt_bool_t mpf_rtp_media_generate(mpf_rtp_media_descriptor_t *rtp_media, const sdp_media_t *sdp_media, const apt_str_t *ip, apr_pool_t *pool);
 static apt_bool_t mrcp_control_media_generate(mrcp_control_descriptor_t *mrcp_media, const sdp_media_t *sdp_media, const apt_str_t *ip, apr_pool_t *pool);
 static apt_bool_t mrcp_control_medias_generate(mrcp_session_descriptor_t* descriptor, const sdp_media_t *sdp_media, const apt_str_t *ip, apr_pool_t *pool);
 
+/** Templates of the SDP lines */
+typedef enum {
+	SDP_TEMPLATE_SESSION,
+	SDP_TEMPLATE_RTP_MEDIA,
+	SDP_TEMPLATE_CONNECTION,
+	SDP_TEMPLATE_RTPMAP,
+	SDP_TEMPLATE_FMTP,
+	SDP_TEMPLATE_DIRECTION,
+	SDP_TEMPLATE_PTIME,
+	SDP_TEMPLATE_MID,
+	SDP_TEMPLATE_CONTROL_MEDIA,
+	SDP_TEMPLATE_CONTROL_SETUP,
+	SDP_TEMPLATE_RESOURCE,
+	SDP_TEMPLATE_CHANNEL,
+	SDP_TEMPLATE_CMID,
+
+	SDP_TEMPLATE_COUNT
+} sdp_template_e;
+
+/** Slots of the SDP templates (all the templates share the same slots) */
+typedef enum {
+	SDP_SLOT_ORIGIN,
+	SDP_SLOT_IP,
+	SDP_SLOT_PORT,
+	SDP_SLOT_PROTO,
+	SDP_SLOT_PAYLOAD_TYPE,
+	SDP_SLOT_CODEC,
+	SDP_SLOT_RATE,
+	SDP_SLOT_FORMAT,
+	SDP_SLOT_DIRECTION,
+	SDP_SLOT_PTIME,
+	SDP_SLOT_MID,
+	SDP_SLOT_SETUP,
+	SDP_SLOT_CONNECTION,
+	SDP_SLOT_SESSION_ID,
+	SDP_SLOT_RESOURCE,
+	SDP_SLOT_CMID,
+
+	SDP_SLOT_COUNT
+} sdp_slot_e;
+
+/** Names of the SDP template slots */
+static const char *sdp_slot_names[SDP_SLOT_COUNT] = {
+	"origin",
+	"ip",
+	"port",
+	"proto",
+	"pt",
+	"codec",
+	"rate",
+	"format",
+	"direction",
+	"ptime",
+	"mid",
+	"setup",
+	"connection",
+	"session-id",
+	"resource",
+	"cmid"
+};
+
+/** Texts of the SDP templates */
+static const char *sdp_template_texts[SDP_TEMPLATE_COUNT] = {
+	"v=0\r\no=${origin} 0 0 IN IP4 ${ip}\r\ns=-\r\nc=IN IP4 ${ip}\r\nt=0 0\r\n",
+	"m=audio ${port} RTP/AVP",
+	"c=IN IP4 ${ip}\r\n",
+	"a=rtpmap:${pt} ${codec}/${rate}\r\n",
+	"a=fmtp:${pt} ${format}\r\n",
+	"a=${direction}\r\n",
+	"a=ptime:${ptime}\r\n",
+	"a=mid:${mid}\r\n",
+	"m=application ${port} ${proto} 1\r\n",
+	"a=setup:${setup}\r\na=connection:${connection}\r\n",
+	"a=resource:${resource}\r\n",
+	"a=channel:${session-id}@${resource}\r\n",
+	"a=cmid:${cmid}\r\n"
+};
+
+/** Precompiled SDP templates */
+struct mrcp_sdp_templates_t {
+	/** Compiled templates indexed by sdp_template_e */
+	apt_text_template_t *templates[SDP_TEMPLATE_COUNT];
+};
+
+/** Values of the SDP template slots */
+typedef struct sdp_slot_values_t sdp_slot_values_t;
+struct sdp_slot_values_t {
+	/** Values indexed by sdp_slot_e */
+	apt_str_t values[SDP_SLOT_COUNT];
+	/** Buffers of the numeric values */
+	char      numbers[SDP_SLOT_COUNT][24];
+};
+
+/** Render SDP template into SDP stream, the stream is marked as full, if there is no room left */
+static APR_INLINE void sdp_template_render(apt_text_stream_t *stream, const mrcp_sdp_templates_t *templates, sdp_template_e id, const sdp_slot_values_t *slots)
+{
+	apt_text_template_stream_render(templates->templates[id],slots->values,stream);
+}
+
+/** Set string value of SDP template slot */
+static APR_INLINE void sdp_slot_string_set(sdp_slot_values_t *slots, sdp_slot_e slot, const apt_str_t *str)
+{
+	if(str) {
+		slots->values[slot] = *str;
+	}
+	else {
+		apt_string_reset(&slots->values[slot]);
+	}
+}
+
+/** Set numeric value of SDP template slot */
+static APR_INLINE void sdp_slot_number_set(sdp_slot_values_t *slots, sdp_slot_e slot, apr_size_t value)
+{
+	apt_text_template_number_set(&slots->values[slot],slots->numbers[slot],sizeof(slots->numbers[slot]),value);
+}
+
+/** Create SDP templates */
+MRCP_DECLARE(mrcp_sdp_templates_t*) sdp_templates_create(apr_pool_t *pool)
+{
+	int i;
+	mrcp_sdp_templates_t *templates = apr_palloc(pool,sizeof(mrcp_sdp_templates_t));
+	for(i=0; i<SDP_TEMPLATE_COUNT; i++) {
+		templates->templates[i] = apt_text_template_compile(sdp_template_texts[i],sdp_slot_names,SDP_SLOT_COUNT,pool);
+		if(!templates->templates[i]) {
+			apt_log(SIP_LOG_MARK,APT_PRIO_WARNING,"Failed to Compile SDP Template [%d]",i);
+			return NULL;
+		}
+	}
+	return templates;
+}
+
 /** Generate SDP string by MRCP descriptor */
-MRCP_DECLARE(apr_size_t) sdp_string_generate_by_mrcp_descriptor(char *buffer, apr_size_t size, const mrcp_session_descriptor_t *descriptor, apt_bool_t offer)
+MRCP_DECLARE(apr_size_t) sdp_string_generate_by_mrcp_descriptor(char *buffer, apr_size_t size, const mrcp_session_descriptor_t *descriptor, const mrcp_sdp_templates_t *templates, apt_bool_t offer)
 {
 	apr_size_t i;
 	apr_size_t count;
@@ -44,43 +175,51 @@ MRCP_DECLARE(apr_size_t) sdp_string_generate_by_mrcp_descriptor(char *buffer, ap
 	mpf_rtp_media_descriptor_t *video_media;
 	apr_size_t control_index = 0;
 	mrcp_control_descriptor_t *control_media;
-	apr_size_t offset = 0;
-	const char *ip = descriptor->ext_ip.buf ? descriptor->ext_ip.buf : (descriptor->ip.buf ? descriptor->ip.buf : "0.0.0.0");
+	sdp_slot_values_t slots;
+	apt_text_stream_t stream;
 	buffer[0] = '\0';
-	offset += snprintf(buffer+offset,size-offset,
-			"v=0\r\n"
-			"o=%s 0 0 IN IP4 %s\r\n"
-			"s=-\r\n"
-			"c=IN IP4 %s\r\n"
-			"t=0 0\r\n",
-			descriptor->origin.buf ? descriptor->origin.buf : "-",
-			ip,
-			ip);
+	if(!templates) {
+		apt_log(SIP_LOG_MARK,APT_PRIO_WARNING,"Failed to Generate SDP: no templates");
+		return 0;
+	}
+
+	apt_text_stream_init(&stream,buffer,size);
+	apt_string_set(&slots.values[SDP_SLOT_ORIGIN],descriptor->origin.buf ? descriptor->origin.buf : "-");
+	apt_string_set(&slots.values[SDP_SLOT_IP],
+		descriptor->ext_ip.buf ? descriptor->ext_ip.buf : (descriptor->ip.buf ? descriptor->ip.buf : "0.0.0.0"));
+	sdp_template_render(&stream,templates,SDP_TEMPLATE_SESSION,&slots);
 	count = mrcp_session_media_count_get(descriptor);
 	for(i=0; i<count; i++) {
 		audio_media = mrcp_session_audio_media_get(descriptor,audio_index);
 		if(audio_media && audio_media->id == i) {
 			/* generate audio media */
 			audio_index++;
-			offset += sdp_rtp_media_generate(buffer+offset,size-offset,descriptor,audio_media);
+			sdp_rtp_media_generate(&stream,templates,descriptor,audio_media);
 			continue;
 		}
 		video_media = mrcp_session_video_media_get(descriptor,video_index);
 		if(video_media && video_media->id == i) {
 			/* generate video media */
 			video_index++;
-			offset += sdp_rtp_media_generate(buffer+offset,size-offset,descriptor,video_media);
+			sdp_rtp_media_generate(&stream,templates,descriptor,video_media);
 			continue;
 		}
 		control_media = mrcp_session_control_media_get(descriptor,control_index);
 		if(control_media && control_media->id == i) {
 			/** generate mrcp control media */
 			control_index++;
-			offset += sdp_control_media_generate(buffer+offset,size-offset,descriptor,control_media,offer);
+			sdp_control_media_generate(&stream,templates,control_media,offer);
 			continue;
 		}
 	}
-	return offset;
+
+	if(stream.is_eos == TRUE) {
+		apt_log(SIP_LOG_MARK,APT_PRIO_WARNING,"Failed to Generate SDP: not enough room [%"APR_SIZE_T_FMT" bytes]",size);
+		buffer[0] = '\0';
+		return 0;
+	}
+	*stream.pos = '\0';
+	return stream.pos - buffer;
 }
 
 /** Generate MRCP descriptor by SDP session */
@@ -174,137 +313,103 @@ MRCP_DECLARE(apt_bool_t) mrcp_resource_discovery_generate_by_sdp_session(mrcp_se
 }
 
 /** Generate SDP media by RTP media descriptor */
-static apr_size_t sdp_rtp_media_generate(char *buffer, apr_size_t size, const mrcp_session_descriptor_t *descriptor, const mpf_rtp_media_descriptor_t *audio_media)
+static void sdp_rtp_media_generate(apt_text_stream_t *stream, const mrcp_sdp_templates_t *templates, const mrcp_session_descriptor_t *descriptor, const mpf_rtp_media_descriptor_t *audio_media)
 {
-	apr_size_t offset = 0;
+	sdp_slot_values_t slots;
 	if(audio_media->state == MPF_MEDIA_ENABLED) {
 		int codec_count = 0;
 		int i;
 		mpf_codec_descriptor_t *codec_descriptor;
 		apr_array_header_t *descriptor_arr = audio_media->codec_list.descriptor_arr;
-		const apt_str_t *direction_str;
 		if(!descriptor_arr) {
-			return 0;
+			return;
 		}
 
-		offset += snprintf(buffer+offset,size-offset,"m=audio %d RTP/AVP",audio_media->port);
+		sdp_slot_number_set(&slots,SDP_SLOT_PORT,audio_media->port);
+		sdp_template_render(stream,templates,SDP_TEMPLATE_RTP_MEDIA,&slots);
 		for(i=0; i<descriptor_arr->nelts; i++) {
 			codec_descriptor = &APR_ARRAY_IDX(descriptor_arr,i,mpf_codec_descriptor_t);
 			if(codec_descriptor->enabled == TRUE) {
-				offset += snprintf(buffer+offset,size-offset," %d",codec_descriptor->payload_type);
+				APT_TEXT_TEMPLATE_LITERAL_INSERT(stream," ");
+				apt_text_template_number_insert(stream,codec_descriptor->payload_type);
 				codec_count++;
 			}
 		}
 		if(!codec_count){
 			/* SDP m line should have at least one media format listed; use a reserved RTP payload type */
-			offset += snprintf(buffer+offset,size-offset," %d",RTP_PT_RESERVED);
+			APT_TEXT_TEMPLATE_LITERAL_INSERT(stream," ");
+			apt_text_template_number_insert(stream,RTP_PT_RESERVED);
 		}
-		offset += snprintf(buffer+offset,size-offset,"\r\n");
+		APT_TEXT_TEMPLATE_LITERAL_INSERT(stream,"\r\n");
 		
 		if(descriptor->ip.length && audio_media->ip.length && 
 			apt_string_compare(&descriptor->ip,&audio_media->ip) != TRUE) {
-			const char *media_ip = audio_media->ext_ip.buf ? audio_media->ext_ip.buf : audio_media->ip.buf;
-			offset += snprintf(buffer+offset,size-offset,"c=IN IP4 %s\r\n",media_ip);
+			sdp_slot_string_set(&slots,SDP_SLOT_IP,audio_media->ext_ip.buf ? &audio_media->ext_ip : &audio_media->ip);
+			sdp_template_render(stream,templates,SDP_TEMPLATE_CONNECTION,&slots);
 		}
 		
 		for(i=0; i<descriptor_arr->nelts; i++) {
 			codec_descriptor = &APR_ARRAY_IDX(descriptor_arr,i,mpf_codec_descriptor_t);
 			if(codec_descriptor->enabled == TRUE && codec_descriptor->name.buf) {
-				offset += snprintf(buffer+offset,size-offset,"a=rtpmap:%d %s/%d\r\n",
-					codec_descriptor->payload_type,
-					codec_descriptor->name.buf,
-					codec_descriptor->sampling_rate);
+				sdp_slot_number_set(&slots,SDP_SLOT_PAYLOAD_TYPE,codec_descriptor->payload_type);
+				sdp_slot_string_set(&slots,SDP_SLOT_CODEC,&codec_descriptor->name);
+				sdp_slot_number_set(&slots,SDP_SLOT_RATE,codec_descriptor->sampling_rate);
+				sdp_template_render(stream,templates,SDP_TEMPLATE_RTPMAP,&slots);
 				if(codec_descriptor->format.buf) {
-					offset += snprintf(buffer+offset,size-offset,"a=fmtp:%d %s\r\n",
-						codec_descriptor->payload_type,
-						codec_descriptor->format.buf);
+					sdp_slot_string_set(&slots,SDP_SLOT_FORMAT,&codec_descriptor->format);
+					sdp_template_render(stream,templates,SDP_TEMPLATE_FMTP,&slots);
 				}
 			}
 		}
 		
-		direction_str = mpf_rtp_direction_str_get(audio_media->direction);
-		if(direction_str) {
-			offset += snprintf(buffer+offset,size-offset,"a=%s\r\n",direction_str->buf);
+		sdp_slot_string_set(&slots,SDP_SLOT_DIRECTION,mpf_rtp_direction_str_get(audio_media->direction));
+		if(slots.values[SDP_SLOT_DIRECTION].buf) {
+			sdp_template_render(stream,templates,SDP_TEMPLATE_DIRECTION,&slots);
 		}
 		
 		if(audio_media->ptime) {
-			offset += snprintf(buffer+offset,size-offset,"a=ptime:%hu\r\n",audio_media->ptime);
+			sdp_slot_number_set(&slots,SDP_SLOT_PTIME,audio_media->ptime);
+			sdp_template_render(stream,templates,SDP_TEMPLATE_PTIME,&slots);
 		}
 	}
 	else {
-		offset += snprintf(buffer+offset,size-offset,"m=audio 0 RTP/AVP %d\r\n",RTP_PT_RESERVED);
+		apt_string_set(&slots.values[SDP_SLOT_PORT],"0");
+		sdp_template_render(stream,templates,SDP_TEMPLATE_RTP_MEDIA,&slots);
+		APT_TEXT_TEMPLATE_LITERAL_INSERT(stream," ");
+		apt_text_template_number_insert(stream,RTP_PT_RESERVED);
+		APT_TEXT_TEMPLATE_LITERAL_INSERT(stream,"\r\n");
 	}
 
-	offset += snprintf(buffer+offset,size-offset,"a=mid:%"APR_SIZE_T_FMT"\r\n",audio_media->mid);
-	return offset;
+	sdp_slot_number_set(&slots,SDP_SLOT_MID,audio_media->mid);
+	sdp_template_render(stream,templates,SDP_TEMPLATE_MID,&slots);
 }
 
 /** Generate SDP media by MRCP control media descriptor */
-static apr_size_t sdp_control_media_generate(char *buffer, apr_size_t size, const mrcp_session_descriptor_t *descriptor, const mrcp_control_descriptor_t *control_media, apt_bool_t offer)
+static void sdp_control_media_generate(apt_text_stream_t *stream, const mrcp_sdp_templates_t *templates, const mrcp_control_descriptor_t *control_media, apt_bool_t offer)
 {
 	int i;
-	apr_size_t offset = 0;
-	const apt_str_t *proto;
-	const apt_str_t *setup_type;
-	const apt_str_t *connection_type;
-	proto = mrcp_proto_get(control_media->proto);
-	setup_type = mrcp_setup_type_get(control_media->setup_type);
-	connection_type = mrcp_connection_type_get(control_media->connection_type);
+	sdp_slot_values_t slots;
+	sdp_slot_number_set(&slots,SDP_SLOT_PORT,control_media->port);
+	sdp_slot_string_set(&slots,SDP_SLOT_PROTO,mrcp_proto_get(control_media->proto));
+	sdp_template_render(stream,templates,SDP_TEMPLATE_CONTROL_MEDIA,&slots);
+	if(control_media->port) {
+		sdp_slot_string_set(&slots,SDP_SLOT_SETUP,mrcp_setup_type_get(control_media->setup_type));
+		sdp_slot_string_set(&slots,SDP_SLOT_CONNECTION,mrcp_connection_type_get(control_media->connection_type));
+		sdp_template_render(stream,templates,SDP_TEMPLATE_CONTROL_SETUP,&slots);
+	}
+	sdp_slot_string_set(&slots,SDP_SLOT_RESOURCE,&control_media->resource_name);
 	if(offer == TRUE) { /* offer */
-		if(control_media->port) {
-			offset += snprintf(buffer+offset,size-offset,
-				"m=application %d %s 1\r\n"
-				"a=setup:%s\r\n"
-				"a=connection:%s\r\n"
-				"a=resource:%s\r\n",
-				control_media->port,
-				proto ? proto->buf : "",
-				setup_type ? setup_type->buf : "",
-				connection_type ? connection_type->buf : "",
-				control_media->resource_name.buf);
-
-		}
-		else {
-			offset += snprintf(buffer+offset,size-offset,
-				"m=application %d %s 1\r\n"
-				"a=resource:%s\r\n",
-				control_media->port,
-				proto ? proto->buf : "",
-				control_media->resource_name.buf);
-		}
+		sdp_template_render(stream,templates,SDP_TEMPLATE_RESOURCE,&slots);
 	}
 	else { /* answer */
-		if(control_media->port) {
-			offset += snprintf(buffer+offset,size-offset,
-				"m=application %d %s 1\r\n"
-				"a=setup:%s\r\n"
-				"a=connection:%s\r\n"
-				"a=channel:%s@%s\r\n",
-				control_media->port,
-				proto ? proto->buf : "",
-				setup_type ? setup_type->buf : "",
-				connection_type ? connection_type->buf : "",
-				control_media->session_id.buf,
-				control_media->resource_name.buf);
-		}
-		else {
-			offset += snprintf(buffer+offset,size-offset,
-				"m=application %d %s 1\r\n"
-				"a=channel:%s@%s\r\n",
-				control_media->port,
-				proto ? proto->buf : "",
-				control_media->session_id.buf,
-				control_media->resource_name.buf);
-		}
+		sdp_slot_string_set(&slots,SDP_SLOT_SESSION_ID,&control_media->session_id);
+		sdp_template_render(stream,templates,SDP_TEMPLATE_CHANNEL,&slots);
 	}
 
 	for(i=0; i<control_media->cmid_arr->nelts; i++) {
-		offset += snprintf(buffer+offset,size-offset,
-			"a=cmid:%"APR_SIZE_T_FMT"\r\n",
-			APR_ARRAY_IDX(control_media->cmid_arr,i,apr_size_t));
+		sdp_slot_number_set(&slots,SDP_SLOT_CMID,APR_ARRAY_IDX(control_media->cmid_arr,i,apr_size_t));
+		sdp_template_render(stream,templates,SDP_TEMPLATE_CMID,&slots);
 	}
-
-	return offset;
 }
 
 /** Generate RTP media descriptor by SDP media */
@@ -45,6 +45,8 @@ struct mrcp_sofia_agent_t {
 	char                       *sip_from_str;
 	char                       *sip_bind_str;
 
+	mrcp_sdp_templates_t       *sdp_templates;
+
 	mrcp_sofia_task_t          *task;
 	nua_t                      *nua;
 };
@@ -103,6 +105,12 @@ MRCP_DECLARE(mrcp_sig_agent_t*) mrcp_sofiasip_client_agent_create(const char *id
 		return NULL;
 	}
 
+	/* precompile the SDP lines once for all the sessions */
+	sofia_agent->sdp_templates = sdp_templates_create(pool);
+	if(!sofia_agent->sdp_templates) {
+		return NULL;
+	}
+
 	apt_log(SIP_LOG_MARK,APT_PRIO_NOTICE,"Create SofiaSIP Agent [%s] ["SOFIA_SIP_VERSION"] %s",
 			id,sofia_agent->sip_bind_str);
 	sofia_agent->nua = NULL;
@@ -281,6 +289,7 @@ static apt_bool_t mrcp_sofia_session_offer(mrcp_session_t *session, mrcp_session
 {
 	char sdp_str[2048];
 	const char *local_sdp_str = NULL;
+	const mrcp_sdp_templates_t *sdp_templates = NULL;
 	apt_bool_t res = FALSE;
 	mrcp_sofia_session_t *sofia_session = session->obj;
 	if(!sofia_session) {
@@ -293,9 +302,10 @@ static apt_bool_t mrcp_sofia_session_offer(mrcp_session_t *session, mrcp_session
 			if(sofia_agent->config->origin) {
 				apt_string_set(&descriptor->origin,sofia_agent->config->origin);
 			}
+			sdp_templates = sofia_agent->sdp_templates;
 		}
 	}
-	if(sdp_string_generate_by_mrcp_descriptor(sdp_str,sizeof(sdp_str),descriptor,TRUE) > 0) {
+	if(sdp_string_generate_by_mrcp_descriptor(sdp_str,sizeof(sdp_str),descriptor,sdp_templates,TRUE) > 0) {
 		local_sdp_str = sdp_str;
 		sofia_session->descriptor = descriptor;
 		apt_obj_log(SIP_LOG_MARK,APT_PRIO_INFO,session->log_obj,"Local SDP " APT_NAMESID_FMT "\n%s", 
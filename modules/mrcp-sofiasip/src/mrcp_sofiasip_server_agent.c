@@ -43,6 +43,8 @@ struct mrcp_sofia_agent_t {
 	char                       *sip_contact_str;
 	char                       *sip_bind_str;
 
+	mrcp_sdp_templates_t       *sdp_templates;
+
 	mrcp_sofia_task_t          *task;
 	apt_bool_t                  online;
 };
@@ -103,6 +105,12 @@ MRCP_DECLARE(mrcp_sig_agent_t*) mrcp_sofiasip_server_agent_create(const char *id
 		return NULL;
 	}
 
+	/* precompile the SDP lines once for all the sessions */
+	sofia_agent->sdp_templates = sdp_templates_create(pool);
+	if(!sofia_agent->sdp_templates) {
+		return NULL;
+	}
+
 	apt_log(SIP_LOG_MARK,APT_PRIO_NOTICE,"Create SofiaSIP Agent [%s] ["SOFIA_SIP_VERSION"] %s",
 				id,sofia_agent->sip_bind_str);
 	sofia_agent->task = mrcp_sofia_task_create(mrcp_sofia_nua_create,sofia_agent,NULL,pool);
@@ -246,6 +254,8 @@ static int sip_status_get(mrcp_session_status_e status)
 			return 480;
 		case MRCP_SESSION_STATUS_ERROR:
 			return 500;
+		case MRCP_SESSION_STATUS_OVERLOADED:
+			return 503;
 	}
 	return 200;
 }
@@ -263,8 +273,13 @@ static apt_bool_t mrcp_sofia_on_session_answer(mrcp_session_t *session, mrcp_ses
 
 	if(descriptor->status != MRCP_SESSION_STATUS_OK) {
 		int status = sip_status_get(descriptor->status);
+		const char *retry_after_str = NULL;
+		if(descriptor->retry_after) {
+			retry_after_str = apr_psprintf(session->pool,"%"APR_SIZE_T_FMT,descriptor->retry_after);
+		}
 		nua_respond(sofia_session->nh, status, sip_status_phrase(status),
 					TAG_IF(sofia_agent->sip_contact_str,SIPTAG_CONTACT_STR(sofia_agent->sip_contact_str)),
+					TAG_IF(retry_after_str,SIPTAG_RETRY_AFTER_STR(retry_after_str)),
 					TAG_END());
 		return TRUE;
 	}
@@ -273,7 +288,7 @@ static apt_bool_t mrcp_sofia_on_session_answer(mrcp_session_t *session, mrcp_ses
 		apt_string_set(&descriptor->origin,sofia_agent->config->origin);
 	}
 
-	if(sdp_string_generate_by_mrcp_descriptor(sdp_str,sizeof(sdp_str),descriptor,FALSE) > 0) {
+	if(sdp_string_generate_by_mrcp_descriptor(sdp_str,sizeof(sdp_str),descriptor,sofia_agent->sdp_templates,FALSE) > 0) {
 		local_sdp_str = sdp_str;
 		apt_log(SIP_LOG_MARK,APT_PRIO_INFO,"Local SDP " APT_NAMESID_FMT "\n%s", 
 			session->name,
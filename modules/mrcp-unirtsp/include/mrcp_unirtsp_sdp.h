@@ -23,6 +23,7 @@
  */ 
 
 #include "mrcp_session_descriptor.h"
+#include "apt_text_template.h"
 
 APT_BEGIN_EXTERN_C
 
@@ -43,16 +44,24 @@ MRCP_DECLARE(mrcp_session_descriptor_t*) mrcp_descriptor_generate_by_rtsp_respon
 											apr_pool_t *pool,
 											su_home_t *home);
 
-/** Generate RTSP request by MRCP descriptor */
+/** Opaque SDP templates declaration */
+typedef struct rtsp_sdp_templates_t rtsp_sdp_templates_t;
+
+/** Create SDP templates (session and media lines precompiled once, the origin is taken from the descriptor) */
+MRCP_DECLARE(rtsp_sdp_templates_t*) rtsp_sdp_templates_create(apr_pool_t *pool);
+
+/** Generate RTSP request by MRCP descriptor using precompiled SDP templates */
 MRCP_DECLARE(rtsp_message_t*) rtsp_request_generate_by_mrcp_descriptor(
 											const mrcp_session_descriptor_t *descriptor, 
 											const apr_table_t *resource_map, 
+											const rtsp_sdp_templates_t *sdp_templates,
 											apr_pool_t *pool);
-/** Generate RTSP response by MRCP descriptor */
+/** Generate RTSP response by MRCP descriptor using precompiled SDP templates */
 MRCP_DECLARE(rtsp_message_t*) rtsp_response_generate_by_mrcp_descriptor(
 											const rtsp_message_t *request, 
 											const mrcp_session_descriptor_t *descriptor, 
 											const apr_table_t *resource_map, 
+											const rtsp_sdp_templates_t *sdp_templates,
 											apr_pool_t *pool);
 
 /** Generate RTSP resource discovery request */
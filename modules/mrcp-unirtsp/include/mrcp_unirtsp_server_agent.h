@@ -51,6 +51,12 @@ struct rtsp_server_config_t {
 	/** Inactivity timeout for an RTSP connection [sec] */
 	apr_size_t   inactivity_timeout;
 
+	/** Number of workers (poller threads) RTSP connections are distributed across */
+	apr_size_t   worker_count;
+
+	/** Max number of cleared session and connection pools kept for reuse */
+	apr_size_t   pool_count;
+
 	/** Force destination IP address. Should be used only in case 
 	SDP contains incorrect connection address (local IP address behind NAT) */
 	apt_bool_t   force_destination;
@@ -38,6 +38,7 @@ struct mrcp_unirtsp_agent_t {
 	rtsp_client_t        *rtsp_client;
 
 	rtsp_client_config_t *config;
+	rtsp_sdp_templates_t *sdp_templates;
 };
 
 struct mrcp_unirtsp_session_t {
@@ -92,6 +93,12 @@ MRCP_DECLARE(mrcp_sig_agent_t*) mrcp_unirtsp_client_agent_create(const char *id,
 		return NULL;
 	}
 
+	/* precompile the SDP lines once for all the sessions */
+	agent->sdp_templates = rtsp_sdp_templates_create(pool);
+	if(!agent->sdp_templates) {
+		return NULL;
+	}
+
 	agent->rtsp_client = rtsp_client_create(
 								id,
 								config->max_connection_count,
@@ -342,7 +349,7 @@ static apt_bool_t mrcp_unirtsp_session_offer(mrcp_session_t *mrcp_session, mrcp_
 		apt_string_set(&descriptor->origin,agent->config->origin);
 	}
 
-	request = rtsp_request_generate_by_mrcp_descriptor(descriptor,session->rtsp_settings->resource_map,mrcp_session->pool);
+	request = rtsp_request_generate_by_mrcp_descriptor(descriptor,session->rtsp_settings->resource_map,agent->sdp_templates,mrcp_session->pool);
 	return rtsp_client_session_request(agent->rtsp_client,session->rtsp_session,request);
 }
 
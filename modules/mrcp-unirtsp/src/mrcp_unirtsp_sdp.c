@@ -22,13 +22,107 @@
 #include "mrcp_unirtsp_logger.h"
 #include "mpf_rtp_attribs.h"
 #include "mpf_rtp_pt.h"
-#include "apt_text_stream.h"
 #include "apt_log.h"
 
+/** Templates of the SDP lines */
+typedef enum {
+	SDP_TEMPLATE_SESSION,
+	SDP_TEMPLATE_RTP_MEDIA,
+	SDP_TEMPLATE_RTPMAP,
+	SDP_TEMPLATE_FMTP,
+	SDP_TEMPLATE_DIRECTION,
+	SDP_TEMPLATE_PTIME,
+
+	SDP_TEMPLATE_COUNT
+} sdp_template_e;
+
+/** Slots of the SDP templates (all the templates share the same slots) */
+typedef enum {
+	SDP_SLOT_ORIGIN,
+	SDP_SLOT_IP,
+	SDP_SLOT_PORT,
+	SDP_SLOT_PAYLOAD_TYPE,
+	SDP_SLOT_CODEC,
+	SDP_SLOT_RATE,
+	SDP_SLOT_FORMAT,
+	SDP_SLOT_DIRECTION,
+	SDP_SLOT_PTIME,
+
+	SDP_SLOT_COUNT
+} sdp_slot_e;
+
+/** Names of the SDP template slots */
+static const char *sdp_slot_names[SDP_SLOT_COUNT] = {
+	"origin",
+	"ip",
+	"port",
+	"pt",
+	"codec",
+	"rate",
+	"format",
+	"direction",
+	"ptime"
+};
+
+/** Texts of the SDP templates */
+static const char *sdp_template_texts[SDP_TEMPLATE_COUNT] = {
+	"v=0\r\no=${origin} 0 0 IN IP4 ${ip}\r\ns=-\r\nc=IN IP4 ${ip}\r\nt=0 0\r\n",
+	"m=audio ${port} RTP/AVP",
+	"a=rtpmap:${pt} ${codec}/${rate}\r\n",
+	"a=fmtp:${pt} ${format}\r\n",
+	"a=${direction}\r\n",
+	"a=ptime:${ptime}\r\n"
+};
+
+/** Precompiled SDP templates */
+struct rtsp_sdp_templates_t {
+	/** Compiled templates indexed by sdp_template_e */
+	apt_text_template_t *templates[SDP_TEMPLATE_COUNT];
+};
+
+/** Values of the SDP template slots */
+typedef struct sdp_slot_values_t sdp_slot_values_t;
+struct sdp_slot_values_t {
+	/** Values indexed by sdp_slot_e */
+	apt_str_t values[SDP_SLOT_COUNT];
+	/** Buffers of the numeric values */
+	char      numbers[SDP_SLOT_COUNT][24];
+};
+
+/** Render SDP template into SDP stream, the stream is marked as full, if there is no room left */
+static APR_INLINE void sdp_template_render(apt_text_stream_t *stream, const rtsp_sdp_templates_t *templates, sdp_template_e id, const sdp_slot_values_t *slots)
+{
+	apt_text_template_stream_render(templates->templates[id],slots->values,stream);
+}
+
+/** Set numeric value of SDP template slot */
+static APR_INLINE void sdp_slot_number_set(sdp_slot_values_t *slots, sdp_slot_e slot, apr_size_t value)
+{
+	apt_text_template_number_set(&slots->values[slot],slots->numbers[slot],sizeof(slots->numbers[slot]),value);
+}
+
+/** Generate SDP session level lines (v=, o=, s=, c=, t=) */
+static void sdp_session_generate(apt_text_stream_t *stream, const rtsp_sdp_templates_t *templates, const mrcp_session_descriptor_t *descriptor)
+{
+	sdp_slot_values_t slots;
+	if(!templates) {
+		apt_log(RTSP_LOG_MARK,APT_PRIO_WARNING,"Failed to Generate SDP: no templates");
+		stream->is_eos = TRUE;
+		return;
+	}
+	apt_string_set(&slots.values[SDP_SLOT_ORIGIN],descriptor->origin.buf ? descriptor->origin.buf : "-");
+	apt_string_set(&slots.values[SDP_SLOT_IP],
+		descriptor->ext_ip.buf ? descriptor->ext_ip.buf : (descriptor->ip.buf ? descriptor->ip.buf : "0.0.0.0"));
+	sdp_template_render(stream,templates,SDP_TEMPLATE_SESSION,&slots);
+}
+
 /** Generate SDP media by RTP media descriptor */
-static apr_size_t sdp_rtp_media_generate(char *buffer, apr_size_t size, const mrcp_session_descriptor_t *descriptor, const mpf_rtp_media_descriptor_t *audio_media)
+static void sdp_rtp_media_generate(apt_text_stream_t *stream, const rtsp_sdp_templates_t *templates, const mpf_rtp_media_descriptor_t *audio_media)
 {
-	apr_size_t offset = 0;
+	sdp_slot_values_t slots;
+	if(stream->is_eos == TRUE) {
+		return;
+	}
 	if(audio_media->state == MPF_MEDIA_ENABLED) {
 		int codec_count = 0;
 		int i;
@@ -36,51 +130,69 @@ static apr_size_t sdp_rtp_media_generate(char *buffer, apr_size_t size, const mr
 		apr_array_header_t *descriptor_arr = audio_media->codec_list.descriptor_arr;
 		const apt_str_t *direction_str;
 		if(!descriptor_arr) {
-			return 0;
+			return;
 		}
-		offset += snprintf(buffer+offset,size-offset,"m=audio %d RTP/AVP",audio_media->port);
+
+		sdp_slot_number_set(&slots,SDP_SLOT_PORT,audio_media->port);
+		sdp_template_render(stream,templates,SDP_TEMPLATE_RTP_MEDIA,&slots);
 		for(i=0; i<descriptor_arr->nelts; i++) {
 			codec_descriptor = &APR_ARRAY_IDX(descriptor_arr,i,mpf_codec_descriptor_t);
 			if(codec_descriptor->enabled == TRUE) {
-				offset += snprintf(buffer+offset,size-offset," %d",codec_descriptor->payload_type);
+				APT_TEXT_TEMPLATE_LITERAL_INSERT(stream," ");
+				apt_text_template_number_insert(stream,codec_descriptor->payload_type);
 				codec_count++;
 			}
 		}
 		if(!codec_count){
 			/* SDP m line should have at least one media format listed; use a reserved RTP payload type */
-			offset += snprintf(buffer+offset,size-offset," %d",RTP_PT_RESERVED);
+			APT_TEXT_TEMPLATE_LITERAL_INSERT(stream," ");
+			apt_text_template_number_insert(stream,RTP_PT_RESERVED);
 		}
-		offset += snprintf(buffer+offset,size-offset,"\r\n");
+		APT_TEXT_TEMPLATE_LITERAL_INSERT(stream,"\r\n");
 
 		for(i=0; i<descriptor_arr->nelts; i++) {
 			codec_descriptor = &APR_ARRAY_IDX(descriptor_arr,i,mpf_codec_descriptor_t);
 			if(codec_descriptor->enabled == TRUE && codec_descriptor->name.buf) {
-				offset += snprintf(buffer+offset,size-offset,"a=rtpmap:%d %s/%d\r\n",
-					codec_descriptor->payload_type,
-					codec_descriptor->name.buf,
-					codec_descriptor->sampling_rate);
+				sdp_slot_number_set(&slots,SDP_SLOT_PAYLOAD_TYPE,codec_descriptor->payload_type);
+				slots.values[SDP_SLOT_CODEC] = codec_descriptor->name;
+				sdp_slot_number_set(&slots,SDP_SLOT_RATE,codec_descriptor->sampling_rate);
+				sdp_template_render(stream,templates,SDP_TEMPLATE_RTPMAP,&slots);
 				if(codec_descriptor->format.buf) {
-					offset += snprintf(buffer+offset,size-offset,"a=fmtp:%d %s\r\n",
-						codec_descriptor->payload_type,
-						codec_descriptor->format.buf);
+					slots.values[SDP_SLOT_FORMAT] = codec_descriptor->format;
+					sdp_template_render(stream,templates,SDP_TEMPLATE_FMTP,&slots);
 				}
 			}
 		}
 
 		direction_str = mpf_rtp_direction_str_get(audio_media->direction);
 		if(direction_str) {
-			offset += snprintf(buffer+offset,size-offset,"a=%s\r\n",direction_str->buf);
+			slots.values[SDP_SLOT_DIRECTION] = *direction_str;
+			sdp_template_render(stream,templates,SDP_TEMPLATE_DIRECTION,&slots);
 		}
 		
 		if(audio_media->ptime) {
-			offset += snprintf(buffer+offset,size-offset,"a=ptime:%hu\r\n",audio_media->ptime);
+			sdp_slot_number_set(&slots,SDP_SLOT_PTIME,audio_media->ptime);
+			sdp_template_render(stream,templates,SDP_TEMPLATE_PTIME,&slots);
 		}
 	}
 	else {
-		offset += snprintf(buffer+offset,size-offset,"m=audio 0 RTP/AVP %d\r\n",RTP_PT_RESERVED);
+		apt_string_set(&slots.values[SDP_SLOT_PORT],"0");
+		sdp_template_render(stream,templates,SDP_TEMPLATE_RTP_MEDIA,&slots);
+		APT_TEXT_TEMPLATE_LITERAL_INSERT(stream," ");
+		apt_text_template_number_insert(stream,RTP_PT_RESERVED);
+		APT_TEXT_TEMPLATE_LITERAL_INSERT(stream,"\r\n");
 	}
+}
 
-	return offset;
+/** Complete SDP stream, return the length of the generated SDP or 0 on failure */
+static apr_size_t sdp_stream_complete(apt_text_stream_t *stream)
+{
+	if(stream->is_eos == TRUE) {
+		apt_log(RTSP_LOG_MARK,APT_PRIO_WARNING,"Failed to Generate SDP: not enough room [%"APR_SIZE_T_FMT" bytes]",
+			stream->text.length);
+		return 0;
+	}
+	return stream->pos - stream->text.buf;
 }
 
 /** Generate RTP media descriptor by SDP media */
@@ -298,8 +410,23 @@ MRCP_DECLARE(mrcp_session_descriptor_t*) mrcp_descriptor_generate_by_rtsp_respon
 	return descriptor;
 }
 
+/** Create SDP templates */
+MRCP_DECLARE(rtsp_sdp_templates_t*) rtsp_sdp_templates_create(apr_pool_t *pool)
+{
+	int i;
+	rtsp_sdp_templates_t *templates = apr_palloc(pool,sizeof(rtsp_sdp_templates_t));
+	for(i=0; i<SDP_TEMPLATE_COUNT; i++) {
+		templates->templates[i] = apt_text_template_compile(sdp_template_texts[i],sdp_slot_names,SDP_SLOT_COUNT,pool);
+		if(!templates->templates[i]) {
+			apt_log(RTSP_LOG_MARK,APT_PRIO_WARNING,"Failed to Compile SDP Template [%d]",i);
+			return NULL;
+		}
+	}
+	return templates;
+}
+
 /** Generate RTSP request by MRCP descriptor */
-MRCP_DECLARE(rtsp_message_t*) rtsp_request_generate_by_mrcp_descriptor(const mrcp_session_descriptor_t *descriptor, const apr_table_t *resource_map, apr_pool_t *pool)
+MRCP_DECLARE(rtsp_message_t*) rtsp_request_generate_by_mrcp_descriptor(const mrcp_session_descriptor_t *descriptor, const apr_table_t *resource_map, const rtsp_sdp_templates_t *sdp_templates, apr_pool_t *pool)
 {
 	apr_size_t i;
 	apr_size_t count;
@@ -307,11 +434,10 @@ MRCP_DECLARE(rtsp_message_t*) rtsp_request_generate_by_mrcp_descriptor(const mrc
 	mpf_rtp_media_descriptor_t *audio_media;
 	apr_size_t video_index = 0;
 	mpf_rtp_media_descriptor_t *video_media;
-	apr_size_t offset = 0;
+	apr_size_t offset;
 	char buffer[2048];
-	apr_size_t size = sizeof(buffer);
+	apt_text_stream_t stream;
 	rtsp_message_t *request;
-	const char *ip = descriptor->ext_ip.buf ? descriptor->ext_ip.buf : (descriptor->ip.buf ? descriptor->ip.buf : "0.0.0.0");
 
 	request = rtsp_request_create(pool);
 	request->start_line.common.request_line.resource_name = rtsp_name_get_by_mrcp_name(
@@ -324,23 +450,15 @@ MRCP_DECLARE(rtsp_message_t*) rtsp_request_generate_by_mrcp_descriptor(const mrc
 
 	request->start_line.common.request_line.method_id = RTSP_METHOD_SETUP;
 
-	buffer[0] = '\0';
-	offset += snprintf(buffer+offset,size-offset,
-			"v=0\r\n"
-			"o=%s 0 0 IN IP4 %s\r\n"
-			"s=-\r\n"
-			"c=IN IP4 %s\r\n"
-			"t=0 0\r\n",
-			descriptor->origin.buf ? descriptor->origin.buf : "-",
-			ip,
-			ip);
+	apt_text_stream_init(&stream,buffer,sizeof(buffer));
+	sdp_session_generate(&stream,sdp_templates,descriptor);
 	count = mrcp_session_media_count_get(descriptor);
 	for(i=0; i<count; i++) {
 		audio_media = mrcp_session_audio_media_get(descriptor,audio_index);
 		if(audio_media && audio_media->id == i) {
 			/* generate audio media */
 			audio_index++;
-			offset += sdp_rtp_media_generate(buffer+offset,size-offset,descriptor,audio_media);
+			sdp_rtp_media_generate(&stream,sdp_templates,audio_media);
 			request->header.transport.client_port_range.min = audio_media->port;
 			request->header.transport.client_port_range.max = audio_media->port+1;
 			continue;
@@ -349,7 +467,7 @@ MRCP_DECLARE(rtsp_message_t*) rtsp_request_generate_by_mrcp_descriptor(const mrc
 		if(video_media && video_media->id == i) {
 			/* generate video media */
 			video_index++;
-			offset += sdp_rtp_media_generate(buffer+offset,size-offset,descriptor,video_media);
+			sdp_rtp_media_generate(&stream,sdp_templates,video_media);
 			continue;
 		}
 	}
@@ -359,6 +477,7 @@ MRCP_DECLARE(rtsp_message_t*) rtsp_request_generate_by_mrcp_descriptor(const mrc
 	request->header.transport.delivery = RTSP_DELIVERY_UNICAST;
 	rtsp_header_property_add(&request->header,RTSP_HEADER_FIELD_TRANSPORT,request->pool);
 
+	offset = sdp_stream_complete(&stream);
 	if(offset) {
 		apt_string_assign_n(&request->body,buffer,offset,pool);
 		request->header.content_type = RTSP_CONTENT_TYPE_SDP;
@@ -370,7 +489,7 @@ MRCP_DECLARE(rtsp_message_t*) rtsp_request_generate_by_mrcp_descriptor(const mrc
 }
 
 /** Generate RTSP response by MRCP descriptor */
-MRCP_DECLARE(rtsp_message_t*) rtsp_response_generate_by_mrcp_descriptor(const rtsp_message_t *request, const mrcp_session_descriptor_t *descriptor, const apr_table_t *resource_map, apr_pool_t *pool)
+MRCP_DECLARE(rtsp_message_t*) rtsp_response_generate_by_mrcp_descriptor(const rtsp_message_t *request, const mrcp_session_descriptor_t *descriptor, const apr_table_t *resource_map, const rtsp_sdp_templates_t *sdp_templates, apr_pool_t *pool)
 {
 	rtsp_message_t *response = NULL;
 
@@ -388,12 +507,25 @@ MRCP_DECLARE(rtsp_message_t*) rtsp_response_generate_by_mrcp_descriptor(const rt
 		case MRCP_SESSION_STATUS_ERROR:
 			response = rtsp_response_create(request,RTSP_STATUS_CODE_INTERNAL_SERVER_ERROR,RTSP_REASON_PHRASE_INTERNAL_SERVER_ERROR,pool);
 			break;
+		case MRCP_SESSION_STATUS_OVERLOADED:
+			response = rtsp_response_create(request,RTSP_STATUS_CODE_SERVICE_UNAVAILABLE,RTSP_REASON_PHRASE_SERVICE_UNAVAILABLE,pool);
+			break;
 	}
 
 	if(!response) {
 		return NULL;
 	}
 
+	if(descriptor->status == MRCP_SESSION_STATUS_OVERLOADED && descriptor->retry_after) {
+		apt_header_field_t *header_field = apt_header_field_create_c(
+											"Retry-After",
+											apr_psprintf(pool,"%"APR_SIZE_T_FMT,descriptor->retry_after),
+											pool);
+		if(header_field) {
+			apt_header_section_field_add(&response->header.header_section,header_field);
+		}
+	}
+
 	if(descriptor->status == MRCP_SESSION_STATUS_OK) {
 		apr_size_t i;
 		apr_size_t count;
@@ -401,21 +533,12 @@ MRCP_DECLARE(rtsp_message_t*) rtsp_response_generate_by_mrcp_descriptor(const rt
 		mpf_rtp_media_descriptor_t *audio_media;
 		apr_size_t video_index = 0;
 		mpf_rtp_media_descriptor_t *video_media;
-		apr_size_t offset = 0;
+		apr_size_t offset;
 		char buffer[2048];
-		apr_size_t size = sizeof(buffer);
-		const char *ip = descriptor->ext_ip.buf ? descriptor->ext_ip.buf : (descriptor->ip.buf ? descriptor->ip.buf : "0.0.0.0");
+		apt_text_stream_t stream;
 
-		buffer[0] = '\0';
-		offset += snprintf(buffer+offset,size-offset,
-				"v=0\r\n"
-				"o=%s 0 0 IN IP4 %s\r\n"
-				"s=-\r\n"
-				"c=IN IP4 %s\r\n"
-				"t=0 0\r\n",
-				descriptor->origin.buf ? descriptor->origin.buf : "-",
-				ip,
-				ip);
+		apt_text_stream_init(&stream,buffer,sizeof(buffer));
+		sdp_session_generate(&stream,sdp_templates,descriptor);
 		count = mrcp_session_media_count_get(descriptor);
 		for(i=0; i<count; i++) {
 			audio_media = mrcp_session_audio_media_get(descriptor,audio_index);
@@ -423,7 +546,7 @@ MRCP_DECLARE(rtsp_message_t*) rtsp_response_generate_by_mrcp_descriptor(const rt
 				/* generate audio media */
 				rtsp_transport_t *transport;
 				audio_index++;
-				offset += sdp_rtp_media_generate(buffer+offset,size-offset,descriptor,audio_media);
+				sdp_rtp_media_generate(&stream,sdp_templates,audio_media);
 				transport = &response->header.transport;
 				transport->server_port_range.min = audio_media->port;
 				transport->server_port_range.max = audio_media->port+1;
@@ -434,7 +557,7 @@ MRCP_DECLARE(rtsp_message_t*) rtsp_response_generate_by_mrcp_descriptor(const rt
 			if(video_media && video_media->id == i) {
 				/* generate video media */
 				video_index++;
-				offset += sdp_rtp_media_generate(buffer+offset,size-offset,descriptor,video_media);
+				sdp_rtp_media_generate(&stream,sdp_templates,video_media);
 				continue;
 			}
 		}
@@ -445,6 +568,7 @@ MRCP_DECLARE(rtsp_message_t*) rtsp_response_generate_by_mrcp_descriptor(const rt
 		response->header.transport.delivery = RTSP_DELIVERY_UNICAST;
 		rtsp_header_property_add(&response->header,RTSP_HEADER_FIELD_TRANSPORT,response->pool);
 
+		offset = sdp_stream_complete(&stream);
 		if(offset) {
 			apt_string_assign_n(&response->body,buffer,offset,pool);
 			response->header.content_type = RTSP_CONTENT_TYPE_SDP;
@@ -37,6 +37,7 @@ struct mrcp_unirtsp_agent_t {
 	rtsp_server_t        *rtsp_server;
 
 	rtsp_server_config_t *config;
+	rtsp_sdp_templates_t *sdp_templates;
 };
 
 struct mrcp_unirtsp_session_t {
@@ -88,6 +89,12 @@ MRCP_DECLARE(mrcp_sig_agent_t*) mrcp_unirtsp_server_agent_create(const char *id,
 		return NULL;
 	}
 
+	/* precompile the SDP lines once for all the sessions */
+	agent->sdp_templates = rtsp_sdp_templates_create(pool);
+	if(!agent->sdp_templates) {
+		return NULL;
+	}
+
 	agent->rtsp_server = rtsp_server_create(
 							id,
 							config->local_ip,
@@ -101,6 +108,11 @@ MRCP_DECLARE(mrcp_sig_agent_t*) mrcp_unirtsp_server_agent_create(const char *id,
 		return NULL;
 	}
 
+	if(config->worker_count > 1) {
+		rtsp_server_worker_count_set(agent->rtsp_server,config->worker_count);
+	}
+	rtsp_server_pool_count_set(agent->rtsp_server,config->pool_count);
+
 	task = rtsp_server_task_get(agent->rtsp_server);
 	agent->sig_agent->task = task;
 
@@ -118,6 +130,8 @@ MRCP_DECLARE(rtsp_server_config_t*) mrcp_unirtsp_server_config_alloc(apr_pool_t
 	config->resource_map = apr_table_make(pool,2);
 	config->max_connection_count = 100;
 	config->inactivity_timeout = 600; /* sec */
+	config->worker_count = 1;
+	config->pool_count = 100;
 	config->force_destination = FALSE;
 	return config;
 }
@@ -304,6 +318,7 @@ static apt_bool_t mrcp_unirtsp_on_session_answer(mrcp_session_t *mrcp_session, m
 						request,
 						descriptor,
 						agent->config->resource_map,
+						agent->sdp_templates,
 						mrcp_session->pool);
 	}
 	else if(request->start_line.common.request_line.method_id == RTSP_METHOD_TEARDOWN) {
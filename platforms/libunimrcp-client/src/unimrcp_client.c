@@ -509,6 +509,7 @@ static apt_bool_t unimrcp_client_mrcpv2_uac_load(unimrcp_client_loader_t *loader
 	apt_bool_t offer_new_connection = FALSE;
 	const char *rx_buffer_size = NULL;
 	const char *tx_buffer_size = NULL;
+	const char *tx_queue_limit = NULL;
 	const char *request_timeout = NULL;
 
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading MRCPv2 Agent <%s>",id);
@@ -534,6 +535,11 @@ static apt_bool_t unimrcp_client_mrcpv2_uac_load(unimrcp_client_loader_t *loader
 				tx_buffer_size = cdata_text_get(elem);
 			}
 		}
+		else if(strcasecmp(elem->name,"tx-queue-limit") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				tx_queue_limit = cdata_text_get(elem);
+			}
+		}
 		else if(strcasecmp(elem->name,"request-timeout") == 0) {
 			if(is_cdata_valid(elem) == TRUE) {
 				request_timeout = cdata_text_get(elem);
@@ -552,6 +558,9 @@ static apt_bool_t unimrcp_client_mrcpv2_uac_load(unimrcp_client_loader_t *loader
 		if(tx_buffer_size) {
 			mrcp_client_connection_tx_size_set(agent,atol(tx_buffer_size));
 		}
+		if(tx_queue_limit) {
+			mrcp_client_connection_tx_queue_limit_set(agent,atol(tx_queue_limit));
+		}
 		if(request_timeout) {
 			mrcp_client_connection_timeout_set(agent,atol(request_timeout));
 		}
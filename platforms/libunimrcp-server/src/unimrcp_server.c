@@ -30,6 +30,7 @@
 #include "mrcp_unirtsp_logger.h"
 #include "mrcp_server_connection.h"
 #include "apt_net.h"
+#include "apt_pool.h"
 #include "apt_log.h"
 
 #define CONF_FILE_NAME            "unimrcpserver.xml"
@@ -111,9 +112,22 @@ MRCP_DECLARE(mrcp_server_t*) unimrcp_server_start(apt_dir_layout_t *dir_layout)
 /** Shutdown UniMRCP server */
 MRCP_DECLARE(apt_bool_t) unimrcp_server_shutdown(mrcp_server_t *server)
 {
+	int i;
+	apr_size_t created;
+	apr_size_t active;
 	if(mrcp_server_shutdown(server) == FALSE) {
 		return FALSE;
 	}
+	for(i = 0; i < APT_POOL_ALLOCATOR_COUNT; i++) {
+		created = active = 0;
+		apt_pool_stats_get(i,&created,&active);
+		if(created) {
+			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Pool Stats [%s]: created [%"APR_SIZE_T_FMT"] active [%"APR_SIZE_T_FMT"]",
+				apt_pool_allocator_type_name_get(i),
+				created,
+				active);
+		}
+	}
 	return mrcp_server_destroy(server);
 }
 
@@ -452,6 +466,16 @@ static apt_bool_t unimrcp_server_rtsp_uas_load(unimrcp_server_loader_t *loader,
 				config->inactivity_timeout = atol(cdata_text_get(elem));
 			}
 		}
+		else if(strcasecmp(elem->name,"worker-count") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				config->worker_count = atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"pool-count") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				config->pool_count = atol(cdata_text_get(elem));
+			}
+		}
 		else if(strcasecmp(elem->name,"resource-map") == 0) {
 			const apr_xml_attr *name_attr;
 			const apr_xml_attr *value_attr;
@@ -492,6 +516,8 @@ static apt_bool_t unimrcp_server_mrcpv2_uas_load(unimrcp_server_loader_t *loader
 	apr_size_t termination_timeout = 3; /* sec */
 	apr_size_t rx_buffer_size = 0;
 	apr_size_t tx_buffer_size = 0;
+	const char *tx_queue_limit = NULL;
+	apr_size_t worker_count = 1;
 
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading MRCPv2 Agent <%s>",id);
 	for(elem = root->first_child; elem; elem = elem->next) {
@@ -539,6 +565,16 @@ static apt_bool_t unimrcp_server_mrcpv2_uas_load(unimrcp_server_loader_t *loader
 				tx_buffer_size = atol(cdata_text_get(elem));
 			}
 		}
+		else if(strcasecmp(elem->name,"tx-queue-limit") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				tx_queue_limit = cdata_text_get(elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"worker-count") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				worker_count = atol(cdata_text_get(elem));
+			}
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
@@ -557,6 +593,12 @@ static apt_bool_t unimrcp_server_mrcpv2_uas_load(unimrcp_server_loader_t *loader
 		if(tx_buffer_size) {
 			mrcp_server_connection_tx_size_set(agent,tx_buffer_size);
 		}
+		if(tx_queue_limit) {
+			mrcp_server_connection_tx_queue_limit_set(agent,atol(tx_queue_limit));
+		}
+		if(worker_count > 1) {
+			mrcp_server_connection_worker_count_set(agent,worker_count);
+		}
 		mrcp_server_connection_max_shared_use_set(agent,max_shared_use_count);
 		mrcp_server_connection_timeout_set(agent,inactivity_timeout);
 		mrcp_server_connection_term_timeout_set(agent,termination_timeout);
@@ -1015,6 +1057,60 @@ static apt_bool_t unimrcp_server_properties_load(unimrcp_server_loader_t *loader
 			loader->ext_ip = unimrcp_server_ip_address_get(loader,elem);
 			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Property ext-ip:%s",loader->ext_ip);
 		}
+		else if(strcasecmp(elem->name,"shard-count") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				apr_size_t shard_count = atol(cdata_text_get(elem));
+				apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Property shard-count:%"APR_SIZE_T_FMT,shard_count);
+				mrcp_server_shard_count_set(loader->server,shard_count);
+			}
+		}
+		else if(strcasecmp(elem->name,"pool-allocator") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				apr_size_t max_free = 0;
+				const apr_xml_attr *attr;
+				apt_pool_allocator_e type = apt_pool_allocator_type_find(cdata_text_get(elem));
+				for(attr = elem->attr; attr; attr = attr->next) {
+					if(strcasecmp(attr->name,"max-free") == 0) {
+						max_free = atol(attr->value);
+					}
+				}
+				apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Property pool-allocator:%s",cdata_text_get(elem));
+				apt_pool_allocator_default_set(type,max_free);
+			}
+		}
+		else if(strcasecmp(elem->name,"admission-control") == 0) {
+			const apr_xml_attr *attr;
+			mrcp_server_admission_settings_t *settings = mrcp_server_admission_settings_alloc(mrcp_server_memory_pool_get(loader->server));
+			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Property admission-control");
+			for(attr = elem->attr; attr; attr = attr->next) {
+				if(strcasecmp(attr->name,"max-sessions") == 0) {
+					settings->max_session_count = atol(attr->value);
+				}
+				else if(strcasecmp(attr->name,"max-queue-depth") == 0) {
+					settings->max_queue_depth = atol(attr->value);
+				}
+				else if(strcasecmp(attr->name,"max-overruns") == 0) {
+					settings->max_overrun_count = atol(attr->value);
+				}
+				else if(strcasecmp(attr->name,"max-channel-usage") == 0) {
+					settings->max_channel_usage = atol(attr->value);
+				}
+				else if(strcasecmp(attr->name,"retry-after") == 0) {
+					settings->retry_after = atol(attr->value);
+				}
+				else {
+					apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Attribute <%s>",attr->name);
+				}
+			}
+			mrcp_server_admission_settings_set(loader->server,settings);
+		}
+		else if(strcasecmp(elem->name,"session-pool-count") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				apr_size_t pool_count = atol(cdata_text_get(elem));
+				apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Property session-pool-count:%"APR_SIZE_T_FMT,pool_count);
+				mrcp_server_session_pool_count_set(loader->server,pool_count);
+			}
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
@@ -23,6 +23,7 @@
  */ 
 
 #include "apt_log.h"
+#include "umcloadgenerator.h"
 
 class UmcFramework;
 
@@ -38,6 +39,7 @@ public:
 
 protected:
 	bool LoadOptions(int argc, const char * const *argv, apr_pool_t *pool);
+	bool LoadThinkTime(const char* pValue);
 	bool RunCmdLine();
 	bool ProcessCmdLine(char* pCmdLine);
 	static void Usage();
@@ -50,6 +52,7 @@ private:
 		const char*        m_DirLayoutConf;
 		const char*        m_LogPriority;
 		const char*        m_LogOutput;
+		UmcLoadParams      m_LoadParams;
 
 		UmcOptions() : 
 			m_RootDirPath(NULL), m_DirLayoutConf(NULL), 
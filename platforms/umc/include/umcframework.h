@@ -24,10 +24,13 @@
 
 #include <apr_xml.h>
 #include <apr_hash.h>
+#include <apr_thread_cond.h>
 #include "apt_consumer_task.h"
 #include "umcsession.h"
 
 class UmcScenario;
+class UmcLoadGenerator;
+struct UmcLoadParams;
 
 class UmcFramework : public UmcSessionMethodProvider
 {
@@ -47,6 +50,9 @@ public:
 	void ShowScenarios();
 	void ShowSessions();
 
+	bool RunLoad(const UmcLoadParams* pParams);
+	void WaitLoad();
+
 protected:
 	bool CreateMrcpClient();
 	void DestroyMrcpClient();
@@ -60,17 +66,23 @@ protected:
 	bool LoadScenario(const char* pFilePath);
 	void DestroyScenarios();
 
+	UmcSession* StartSession(const char* pScenarioName, const char* pProfileName);
+
 	bool ProcessRunRequest(const char* pScenarioName, const char* pProfileName);
 	void ProcessStopRequest(const char* id);
 	void ProcessKillRequest(const char* id);
 	void ProcessShowScenarios();
 	void ProcessShowSessions();
 	void ProcessSessionExit(UmcSession* pUmcSession);
+	void ProcessRunLoadRequest(const UmcLoadParams* pParams);
+	void ProcessLoadTimer();
+	void CompleteLoad();
 
 	bool AddSession(UmcSession* pSession);
 	bool RemoveSession(UmcSession* pSession);
 
 	void ExitSession(UmcSession* pUmcSession);
+	void ReportMetric(UmcSession* pUmcSession, UmcSessionMetric metric, apr_interval_time_t latency);
 
 /* ============================ HANDLERS =================================== */
 
@@ -78,6 +90,7 @@ protected:
 	friend void UmcOnStartComplete(apt_task_t* pTask);
 	friend void UmcOnTerminateComplete(apt_task_t* pTask);
 	friend apt_bool_t AppMessageHandler(const mrcp_app_message_t* pAppMessage);
+	friend void UmcOnLoadTimer(apt_timer_t* pTimer, void* pObj);
 
 private:
 /* ============================ DATA ======================================= */
@@ -90,6 +103,12 @@ private:
 
 	apr_hash_t*          m_pScenarioTable;
 	apr_hash_t*          m_pSessionTable;
+
+	UmcLoadGenerator*    m_pLoadGenerator;
+	apt_timer_t*         m_pLoadTimer;
+	bool                 m_LoadRunning;
+	apr_thread_mutex_t*  m_pLoadMutex;
+	apr_thread_cond_t*   m_pLoadCond;
 };
 
 #endif /* UMC_FRAMEWORK_H */
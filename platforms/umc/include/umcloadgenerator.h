@@ -0,0 +1,140 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UMC_LOAD_GENERATOR_H
+#define UMC_LOAD_GENERATOR_H
+
+/**
+ * @file umcloadgenerator.h
+ * @brief UMC Load Generator
+ *
+ * The load is generated by a number of virtual users, each running sessions
+ * of the scenario one after another with a random think time in between.
+ * New sessions are admitted at the calls-per-second rate, which is linearly
+ * ramped up over the ramp time.
+ */
+
+#include "umcsession.h"
+
+/** Parameters of load */
+struct UmcLoadParams
+{
+	const char*  m_pScenarioName;
+	const char*  m_pProfileName;
+	/** Number of virtual users (max number of concurrent sessions) */
+	apr_size_t   m_Concurrency;
+	/** Target rate of new sessions (calls per second) */
+	float        m_Rate;
+	/** Time to ramp the rate up to the target (sec) */
+	apr_size_t   m_RampTime;
+	/** Time to admit new sessions (sec) */
+	apr_size_t   m_Duration;
+	/** Min and max think time of virtual users between sessions (msec) */
+	apr_size_t   m_ThinkTimeMin;
+	apr_size_t   m_ThinkTimeMax;
+
+	UmcLoadParams() :
+		m_pScenarioName(NULL), m_pProfileName(NULL),
+		m_Concurrency(1), m_Rate(1), m_RampTime(0), m_Duration(60),
+		m_ThinkTimeMin(0), m_ThinkTimeMax(0) {}
+};
+
+/** Latency samples of a session metric */
+class UmcLatencyStats
+{
+public:
+/* ============================ CREATORS =================================== */
+	UmcLatencyStats();
+
+/* ============================ MANIPULATORS =============================== */
+	void Init(apr_pool_t* pool);
+	void Add(apr_interval_time_t latency);
+	void Report(const char* pName);
+
+private:
+/* ============================ DATA ======================================= */
+	apr_array_header_t* m_pSamples; /* apr_uint32_t usec */
+	apr_uint64_t        m_Sum;
+};
+
+class UmcLoadGenerator
+{
+public:
+/* ============================ CREATORS =================================== */
+	UmcLoadGenerator(const UmcLoadParams& params);
+
+/* ============================ MANIPULATORS =============================== */
+	bool Create(apr_pool_t* pool);
+	void Start(apr_time_t now);
+
+	/** Get the number of sessions to launch at the moment */
+	apr_size_t Tick(apr_time_t now);
+
+	void OnSessionFailure(apr_time_t now);
+	void OnSessionExit(UmcSession* pSession, apr_time_t now);
+	void OnSessionMetric(UmcSessionMetric metric, apr_interval_time_t latency);
+
+	void Report();
+
+/* ============================ ACCESSORS ================================== */
+	const UmcLoadParams& GetParams() const;
+
+/* ============================ INQUIRIES ================================== */
+	/** Check whether the admission of new sessions is over and no session is left */
+	bool IsComplete() const;
+	/** Check whether the sessions left after the admission are running for too long */
+	bool IsOverdue(apr_time_t now) const;
+
+protected:
+/* ============================ MANIPULATORS =============================== */
+	void AddIdleUser(apr_time_t now);
+
+private:
+/* ============================ DATA ======================================= */
+	UmcLoadParams    m_Params;
+
+	apr_time_t       m_StartTime;
+	apr_time_t       m_LastTickTime;
+	apr_time_t       m_StopTime;
+	bool             m_Admitting;
+	/** Number of sessions allowed to be launched by the rate */
+	double           m_Credit;
+
+	/** Times virtual users become ready to launch the next session at */
+	apr_time_t*      m_pIdleUsers;
+	apr_size_t       m_IdleUserCount;
+
+	apr_size_t       m_ActiveCount;
+	apr_size_t       m_PeakActiveCount;
+	apr_size_t       m_LaunchedCount;
+	apr_size_t       m_CompletedCount;
+	apr_size_t       m_FailedCount;
+
+	UmcLatencyStats  m_Stats[UMC_METRIC_COUNT];
+};
+
+/* ============================ INLINE METHODS ============================= */
+inline const UmcLoadParams& UmcLoadGenerator::GetParams() const
+{
+	return m_Params;
+}
+
+inline bool UmcLoadGenerator::IsComplete() const
+{
+	return !m_Admitting && !m_ActiveCount;
+}
+
+#endif /* UMC_LOAD_GENERATOR_H */
@@ -27,6 +27,17 @@
 class UmcScenario;
 class UmcSession;
 
+/** Latencies measured by a session */
+enum UmcSessionMetric
+{
+	UMC_METRIC_SESSION_SETUP,           /* from session start to the first channel added */
+	UMC_METRIC_FIRST_RESPONSE,          /* from the first request sent to its response */
+	UMC_METRIC_RECOGNITION_COMPLETE,    /* from the request sent to RECOGNITION-COMPLETE */
+	UMC_METRIC_SPEAK_COMPLETE,          /* from the request sent to SPEAK-COMPLETE */
+
+	UMC_METRIC_COUNT
+};
+
 class UmcSessionEventHandler
 {
 public:
@@ -51,6 +62,7 @@ public:
 
 /* ============================ MANIPULATORS =============================== */
 	virtual void ExitSession(UmcSession* pUmcSession) = 0;
+	virtual void ReportMetric(UmcSession* pUmcSession, UmcSessionMetric metric, apr_interval_time_t latency) {}
 };
 
 class UmcSession : protected UmcSessionEventHandler
@@ -75,6 +87,9 @@ public:
 
 	const char* GetId() const;
 
+/* ============================ INQUIRIES ================================== */
+	bool IsFailed() const;
+
 protected:
 /* ============================ MANIPULATORS =============================== */
 	virtual bool Start() = 0;
@@ -113,6 +128,8 @@ protected:
 	const char* GetMrcpSessionId() const;
 	mrcp_message_t* GetMrcpMessage() const;
 
+	void ReportMetric(UmcSessionMetric metric, apr_time_t startTime);
+
 /* ============================ DATA ======================================= */
 	const UmcScenario*          m_pScenario;
 	const char*                 m_pMrcpProfile;
@@ -127,6 +144,12 @@ private:
 	mrcp_message_t*             m_pMrcpMessage; /* last message sent */
 	bool                        m_Running;
 	bool                        m_Terminating;
+	bool                        m_Failed;
+
+	apr_time_t                  m_RunTime;
+	apr_time_t                  m_RequestTime; /* time the last message is sent at */
+	bool                        m_ChannelAdded;
+	bool                        m_ResponseReceived;
 };
 
 /* ============================ INLINE METHODS ============================= */
@@ -166,4 +189,9 @@ inline mrcp_message_t* UmcSession::GetMrcpMessage() const
 	return m_pMrcpMessage;
 }
 
+inline bool UmcSession::IsFailed() const
+{
+	return m_Failed;
+}
+
 #endif /* UMC_SESSION_H */
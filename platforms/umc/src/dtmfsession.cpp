@@ -387,7 +387,7 @@ mrcp_message_t* DtmfSession::CreateRecognizeRequest(mrcp_channel_t* pMrcpChannel
 
 bool DtmfSession::ParseNLSMLResult(mrcp_message_t* pMrcpMessage)
 {
-	nlsml_result_t *pResult = nlsml_result_parse(pMrcpMessage->body.buf, pMrcpMessage->body.length, pMrcpMessage->pool);
+	nlsml_result_t *pResult = nlsml_result_fast_parse(pMrcpMessage->body.buf, pMrcpMessage->body.length, pMrcpMessage->pool);
 	if(!pResult)
 		return false;
 
@@ -419,7 +419,7 @@ mrcp_message_t* RecogSession::CreateRecognizeRequest(mrcp_channel_t* pMrcpChanne
 
 bool RecogSession::ParseNLSMLResult(mrcp_message_t* pMrcpMessage)
 {
-	nlsml_result_t *pResult = nlsml_result_parse(pMrcpMessage->body.buf, pMrcpMessage->body.length, pMrcpMessage->pool);
+	nlsml_result_t *pResult = nlsml_result_fast_parse(pMrcpMessage->body.buf, pMrcpMessage->body.length, pMrcpMessage->pool);
 	if(!pResult)
 		return false;
 
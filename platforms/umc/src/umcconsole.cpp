@@ -22,6 +22,16 @@
 #include "apt_pool.h"
 #include "uni_revision.h"
 
+/* options which have no short form */
+enum UmcLongOption
+{
+	UMC_OPT_PROFILE = 256,
+	UMC_OPT_CONCURRENCY,
+	UMC_OPT_RATE,
+	UMC_OPT_RAMP,
+	UMC_OPT_DURATION,
+	UMC_OPT_THINK_TIME
+};
 
 UmcConsole::UmcConsole() :
 	m_pFramework(NULL)
@@ -119,8 +129,17 @@ bool UmcConsole::Run(int argc, const char * const *argv)
 	/* create demo framework */
 	if(m_pFramework->Create(pDirLayout,pool))
 	{
-		/* run command line  */
-		RunCmdLine();
+		if(m_Options.m_LoadParams.m_pScenarioName)
+		{
+			/* run load without command line and wait for its completion */
+			if(m_pFramework->RunLoad(&m_Options.m_LoadParams))
+				m_pFramework->WaitLoad();
+		}
+		else
+		{
+			/* run command line  */
+			RunCmdLine();
+		}
 		/* destroy demo framework */
 		m_pFramework->Destroy();
 	}
@@ -272,6 +291,20 @@ void UmcConsole::Usage()
 		"   -o [--log-output] mode   : Set the log output mode.\n"
 		"                              (0-none, 1-console only, 2-file only, 3-both)\n"
 		"\n"
+		"   -b [--load] scenario     : Run the scenario in load mode (without command line).\n"
+		"\n"
+		"   --profile name           : Set the MRCP profile to run the load with.\n"
+		"\n"
+		"   --concurrency number     : Set the number of concurrent sessions (1 by default).\n"
+		"\n"
+		"   --rate cps               : Set the rate of new sessions per second (1 by default).\n"
+		"\n"
+		"   --ramp sec               : Set the time to ramp the rate up (0 by default).\n"
+		"\n"
+		"   --duration sec           : Set the time to launch new sessions for (60 by default).\n"
+		"\n"
+		"   --think-time msec[-msec] : Set the (random) pause between sessions of a user (0 by default).\n"
+		"\n"
 		"   -v [--version]           : Show the version.\n"
 		"\n"
 		"   -h [--help]              : Show the help.\n"
@@ -292,6 +325,13 @@ bool UmcConsole::LoadOptions(int argc, const char * const *argv, apr_pool_t *poo
 		{ "dir-layout",  'c', TRUE,  "path to dir layout conf" },  /* -c arg or --dir-layout arg */
 		{ "log-prio",    'l', TRUE,  "log priority" },             /* -l arg or --log-prio arg */
 		{ "log-output",  'o', TRUE,  "log output mode" },          /* -o arg or --log-output arg */
+		{ "load",        'b', TRUE,  "scenario to run load of" },  /* -b arg or --load arg */
+		{ "profile",     UMC_OPT_PROFILE,     TRUE, "MRCP profile" },        /* --profile arg */
+		{ "concurrency", UMC_OPT_CONCURRENCY, TRUE, "concurrent sessions" }, /* --concurrency arg */
+		{ "rate",        UMC_OPT_RATE,        TRUE, "sessions per second" }, /* --rate arg */
+		{ "ramp",        UMC_OPT_RAMP,        TRUE, "ramp-up time" },        /* --ramp arg */
+		{ "duration",    UMC_OPT_DURATION,    TRUE, "load duration" },       /* --duration arg */
+		{ "think-time",  UMC_OPT_THINK_TIME,  TRUE, "think time" },          /* --think-time arg */
 		{ "version",     'v', FALSE, "show version" },             /* -v or --version */
 		{ "help",        'h', FALSE, "show help" },                /* -h or --help */
 		{ NULL, 0, 0, NULL },                                      /* end */
@@ -319,6 +359,31 @@ bool UmcConsole::LoadOptions(int argc, const char * const *argv, apr_pool_t *poo
 				if(optarg) 
 				m_Options.m_LogOutput = optarg;
 				break;
+			case 'b':
+				m_Options.m_LoadParams.m_pScenarioName = optarg;
+				break;
+			case UMC_OPT_PROFILE:
+				m_Options.m_LoadParams.m_pProfileName = optarg;
+				break;
+			case UMC_OPT_CONCURRENCY:
+				m_Options.m_LoadParams.m_Concurrency = atol(optarg);
+				break;
+			case UMC_OPT_RATE:
+				m_Options.m_LoadParams.m_Rate = (float)atof(optarg);
+				break;
+			case UMC_OPT_RAMP:
+				m_Options.m_LoadParams.m_RampTime = atol(optarg);
+				break;
+			case UMC_OPT_DURATION:
+				m_Options.m_LoadParams.m_Duration = atol(optarg);
+				break;
+			case UMC_OPT_THINK_TIME:
+				if(!LoadThinkTime(optarg))
+				{
+					Usage();
+					return false;
+				}
+				break;
 			case 'v':
 				printf("%s", UNI_FULL_VERSION_STRING);
 				return FALSE;
@@ -336,3 +401,24 @@ bool UmcConsole::LoadOptions(int argc, const char * const *argv, apr_pool_t *poo
 
 	return true;
 }
+
+bool UmcConsole::LoadThinkTime(const char* pValue)
+{
+	/* either fixed "msec" or random within "min-max" */
+	char* pEnd;
+	long value = strtol(pValue,&pEnd,10);
+	if(pEnd == pValue || value < 0)
+		return false;
+
+	m_Options.m_LoadParams.m_ThinkTimeMin = value;
+	m_Options.m_LoadParams.m_ThinkTimeMax = value;
+	if(*pEnd == '-')
+	{
+		const char* pMax = pEnd + 1;
+		value = strtol(pMax,&pEnd,10);
+		if(pEnd == pMax || value < (long)m_Options.m_LoadParams.m_ThinkTimeMin)
+			return false;
+		m_Options.m_LoadParams.m_ThinkTimeMax = value;
+	}
+	return *pEnd == '\0';
+}
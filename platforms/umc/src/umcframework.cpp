@@ -22,6 +22,7 @@
 #include "dtmfscenario.h"
 #include "setparamscenario.h"
 #include "verifierscenario.h"
+#include "umcloadgenerator.h"
 #include "unimrcp_client.h"
 #include "apt_log.h"
 
@@ -32,8 +33,12 @@ typedef struct
 	char                      m_ProfileName[128];
 	const mrcp_app_message_t* m_pAppMessage;
 	UmcSession*               m_pSession;
+	const UmcLoadParams*      m_pLoadParams;
 } UmcTaskMsg;
 
+/** Interval sessions of load are launched at (msec) */
+#define UMC_LOAD_TICK_INTERVAL 20
+
 enum UmcTaskMsgType
 {
 	UMC_TASK_CLIENT_MSG,
@@ -42,13 +47,15 @@ enum UmcTaskMsgType
 	UMC_TASK_KILL_SESSION_MSG,
 	UMC_TASK_SHOW_SCENARIOS_MSG,
 	UMC_TASK_SHOW_SESSIONS_MSG,
-	UMC_TASK_EXIT_SESSION_MSG
+	UMC_TASK_EXIT_SESSION_MSG,
+	UMC_TASK_RUN_LOAD_MSG
 };
 
 apt_bool_t UmcProcessMsg(apt_task_t* pTask, apt_task_msg_t* pMsg);
 void UmcOnStartComplete(apt_task_t* pTask);
 void UmcOnTerminateComplete(apt_task_t* pTask);
 apt_bool_t AppMessageHandler(const mrcp_app_message_t* pAppMessage);
+void UmcOnLoadTimer(apt_timer_t* pTimer, void* pObj);
 
 
 UmcFramework::UmcFramework() :
@@ -58,7 +65,12 @@ UmcFramework::UmcFramework() :
 	m_pMrcpClient(NULL),
 	m_pMrcpApplication(NULL),
 	m_pScenarioTable(NULL),
-	m_pSessionTable(NULL)
+	m_pSessionTable(NULL),
+	m_pLoadGenerator(NULL),
+	m_pLoadTimer(NULL),
+	m_LoadRunning(false),
+	m_pLoadMutex(NULL),
+	m_pLoadCond(NULL)
 {
 }
 
@@ -73,6 +85,8 @@ bool UmcFramework::Create(apt_dir_layout_t* pDirLayout, apr_pool_t* pool)
 
 	m_pSessionTable = apr_hash_make(m_pPool);
 	m_pScenarioTable = apr_hash_make(m_pPool);
+	apr_thread_mutex_create(&m_pLoadMutex,APR_THREAD_MUTEX_UNNESTED,m_pPool);
+	apr_thread_cond_create(&m_pLoadCond,m_pPool);
 	return CreateTask();
 }
 
@@ -80,6 +94,22 @@ void UmcFramework::Destroy()
 {
 	DestroyTask();
 
+	if(m_pLoadGenerator)
+	{
+		delete m_pLoadGenerator;
+		m_pLoadGenerator = NULL;
+	}
+	if(m_pLoadCond)
+	{
+		apr_thread_cond_destroy(m_pLoadCond);
+		m_pLoadCond = NULL;
+	}
+	if(m_pLoadMutex)
+	{
+		apr_thread_mutex_destroy(m_pLoadMutex);
+		m_pLoadMutex = NULL;
+	}
+
 	m_pScenarioTable = NULL;
 	m_pSessionTable = NULL;
 }
@@ -342,17 +372,16 @@ bool UmcFramework::RemoveSession(UmcSession* pSession)
 	return true;
 }
 
-bool UmcFramework::ProcessRunRequest(const char* pScenarioName, const char* pProfileName)
+UmcSession* UmcFramework::StartSession(const char* pScenarioName, const char* pProfileName)
 {
 	UmcScenario* pScenario = (UmcScenario*) apr_hash_get(m_pScenarioTable,pScenarioName,APR_HASH_KEY_STRING);
 	if(!pScenario)
-		return false;
+		return NULL;
 
 	UmcSession* pSession = pScenario->CreateSession();
 	if(!pSession)
-		return false;
+		return NULL;
 
-	printf("[%s]\n",pSession->GetId());
 	if(pProfileName && *pProfileName != '\0')
 		pSession->SetMrcpProfile(pProfileName);
 	pSession->SetMrcpApplication(m_pMrcpApplication);
@@ -360,10 +389,20 @@ bool UmcFramework::ProcessRunRequest(const char* pScenarioName, const char* pPro
 	if(!pSession->Run())
 	{
 		delete pSession;
-		return false;
+		return NULL;
 	}
 
 	AddSession(pSession);
+	return pSession;
+}
+
+bool UmcFramework::ProcessRunRequest(const char* pScenarioName, const char* pProfileName)
+{
+	UmcSession* pSession = StartSession(pScenarioName,pProfileName);
+	if(!pSession)
+		return false;
+
+	printf("[%s]\n",pSession->GetId());
 	return true;
 }
 
@@ -442,10 +481,91 @@ void UmcFramework::ProcessSessionExit(UmcSession* pUmcSession)
 	if(!pUmcSession)
 		return;
 
+	if(m_pLoadGenerator)
+		m_pLoadGenerator->OnSessionExit(pUmcSession,apr_time_now());
+
 	RemoveSession(pUmcSession);
 	delete pUmcSession;
 }
 
+void UmcFramework::ProcessRunLoadRequest(const UmcLoadParams* pParams)
+{
+	if(m_pLoadGenerator || !pParams->m_pScenarioName)
+	{
+		CompleteLoad();
+		return;
+	}
+
+	if(!apr_hash_get(m_pScenarioTable,pParams->m_pScenarioName,APR_HASH_KEY_STRING))
+	{
+		printf("No Such Scenario [%s]\n",pParams->m_pScenarioName);
+		CompleteLoad();
+		return;
+	}
+
+	m_pLoadGenerator = new UmcLoadGenerator(*pParams);
+	m_pLoadGenerator->Create(m_pPool);
+	if(!m_pLoadTimer)
+		m_pLoadTimer = apt_consumer_task_timer_create(m_pTask,UmcOnLoadTimer,this,m_pPool);
+
+	printf("Run Load [%s] concurrency [%" APR_SIZE_T_FMT "] rate [%.2f cps] ramp [%" APR_SIZE_T_FMT " sec] duration [%" APR_SIZE_T_FMT " sec]\n",
+		pParams->m_pScenarioName,
+		pParams->m_Concurrency,
+		pParams->m_Rate,
+		pParams->m_RampTime,
+		pParams->m_Duration);
+	m_pLoadGenerator->Start(apr_time_now());
+	ProcessLoadTimer();
+}
+
+void UmcFramework::ProcessLoadTimer()
+{
+	if(!m_pLoadGenerator)
+		return;
+
+	apr_time_t now = apr_time_now();
+	apr_size_t count = m_pLoadGenerator->Tick(now);
+	const UmcLoadParams& params = m_pLoadGenerator->GetParams();
+	for(apr_size_t i = 0; i < count; i++)
+	{
+		if(!StartSession(params.m_pScenarioName,params.m_pProfileName))
+			m_pLoadGenerator->OnSessionFailure(now);
+	}
+
+	if(m_pLoadGenerator->IsComplete())
+	{
+		m_pLoadGenerator->Report();
+		delete m_pLoadGenerator;
+		m_pLoadGenerator = NULL;
+		CompleteLoad();
+		return;
+	}
+
+	if(m_pLoadGenerator->IsOverdue(now))
+	{
+		/* terminate the sessions which don't complete on their own */
+		UmcSession* pSession;
+		void* pVal;
+		apr_hash_index_t* it = apr_hash_first(m_pPool,m_pSessionTable);
+		for(; it; it = apr_hash_next(it)) 
+		{
+			apr_hash_this(it,NULL,NULL,&pVal);
+			pSession = (UmcSession*) pVal;
+			if(pSession)
+				pSession->Terminate();
+		}
+	}
+	apt_timer_set(m_pLoadTimer,UMC_LOAD_TICK_INTERVAL);
+}
+
+void UmcFramework::CompleteLoad()
+{
+	apr_thread_mutex_lock(m_pLoadMutex);
+	m_LoadRunning = false;
+	apr_thread_cond_signal(m_pLoadCond);
+	apr_thread_mutex_unlock(m_pLoadMutex);
+}
+
 void UmcFramework::RunSession(const char* pScenarioName, const char* pProfileName)
 {
 	apt_task_t* pTask = apt_consumer_task_base_get(m_pTask);
@@ -521,6 +641,38 @@ void UmcFramework::ShowSessions()
 	apt_task_msg_signal(pTask,pTaskMsg);
 }
 
+bool UmcFramework::RunLoad(const UmcLoadParams* pParams)
+{
+	apt_task_t* pTask = apt_consumer_task_base_get(m_pTask);
+	apt_task_msg_t* pTaskMsg = apt_task_msg_get(pTask);
+	if(!pTaskMsg) 
+		return false;
+
+	m_LoadRunning = true;
+	pTaskMsg->type = TASK_MSG_USER;
+	pTaskMsg->sub_type = UMC_TASK_RUN_LOAD_MSG;
+
+	UmcTaskMsg* pUmcMsg = (UmcTaskMsg*) pTaskMsg->data;
+	pUmcMsg->m_pLoadParams = pParams;
+	pUmcMsg->m_pAppMessage = NULL;
+	apt_task_msg_signal(pTask,pTaskMsg);
+	return true;
+}
+
+void UmcFramework::WaitLoad()
+{
+	apr_thread_mutex_lock(m_pLoadMutex);
+	while(m_LoadRunning)
+		apr_thread_cond_wait(m_pLoadCond,m_pLoadMutex);
+	apr_thread_mutex_unlock(m_pLoadMutex);
+}
+
+void UmcFramework::ReportMetric(UmcSession* pUmcSession, UmcSessionMetric metric, apr_interval_time_t latency)
+{
+	if(m_pLoadGenerator)
+		m_pLoadGenerator->OnSessionMetric(metric,latency);
+}
+
 void UmcFramework::ExitSession(UmcSession* pUmcSession)
 {
 	apt_task_t* pTask = apt_consumer_task_base_get(m_pTask);
@@ -599,6 +751,12 @@ apt_bool_t AppOnResourceDiscover(mrcp_application_t* pApplication, mrcp_session_
 	return pEventHandler->OnResourceDiscover(pDescriptor,status);
 }
 
+void UmcOnLoadTimer(apt_timer_t* pTimer, void* pObj)
+{
+	UmcFramework* pFramework = (UmcFramework*) pObj;
+	pFramework->ProcessLoadTimer();
+}
+
 void UmcOnStartComplete(apt_task_t* pTask)
 {
 	apt_consumer_task_t* pConsumerTask = (apt_consumer_task_t*) apt_task_object_get(pTask);
@@ -673,6 +831,11 @@ apt_bool_t UmcProcessMsg(apt_task_t *pTask, apt_task_msg_t *pMsg)
 			pFramework->ProcessSessionExit(pUmcMsg->m_pSession);
 			break;
 		}
+		case UMC_TASK_RUN_LOAD_MSG:
+		{
+			pFramework->ProcessRunLoadRequest(pUmcMsg->m_pLoadParams);
+			break;
+		}
 	}
 	return TRUE;
 }
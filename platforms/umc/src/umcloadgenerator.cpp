@@ -0,0 +1,234 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <apr_tables.h>
+#include "umcloadgenerator.h"
+
+/** Time the sessions left after the admission are allowed to run for (usec) */
+#define UMC_LOAD_GRACE_TIME apr_time_from_sec(30)
+
+static const char* UmcMetricNames[UMC_METRIC_COUNT] =
+{
+	"Session Setup",
+	"First Response",
+	"RECOGNITION-COMPLETE",
+	"SPEAK-COMPLETE"
+};
+
+static int UmcLatencyCompare(const void* pLeft, const void* pRight)
+{
+	apr_uint32_t left = *(const apr_uint32_t*)pLeft;
+	apr_uint32_t right = *(const apr_uint32_t*)pRight;
+	if(left < right)
+		return -1;
+	return left > right ? 1 : 0;
+}
+
+UmcLatencyStats::UmcLatencyStats() :
+	m_pSamples(NULL),
+	m_Sum(0)
+{
+}
+
+void UmcLatencyStats::Init(apr_pool_t* pool)
+{
+	m_pSamples = apr_array_make(pool,1024,sizeof(apr_uint32_t));
+	m_Sum = 0;
+}
+
+void UmcLatencyStats::Add(apr_interval_time_t latency)
+{
+	if(latency < 0)
+		latency = 0;
+	APR_ARRAY_PUSH(m_pSamples,apr_uint32_t) = (apr_uint32_t)latency;
+	m_Sum += latency;
+}
+
+void UmcLatencyStats::Report(const char* pName)
+{
+	int count = m_pSamples->nelts;
+	if(!count)
+	{
+		printf("%-22s %8d\n",pName,0);
+		return;
+	}
+
+	apr_uint32_t* pSamples = (apr_uint32_t*)m_pSamples->elts;
+	qsort(pSamples,count,sizeof(apr_uint32_t),UmcLatencyCompare);
+
+#define UMC_PERCENTILE(p) (pSamples[((count - 1) * (p)) / 100] / 1000.0)
+	printf("%-22s %8d %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n",
+		pName,
+		count,
+		pSamples[0] / 1000.0,
+		(double)m_Sum / count / 1000.0,
+		UMC_PERCENTILE(50),
+		UMC_PERCENTILE(90),
+		UMC_PERCENTILE(95),
+		UMC_PERCENTILE(99),
+		pSamples[count - 1] / 1000.0);
+#undef UMC_PERCENTILE
+}
+
+
+UmcLoadGenerator::UmcLoadGenerator(const UmcLoadParams& params) :
+	m_Params(params),
+	m_StartTime(0),
+	m_LastTickTime(0),
+	m_StopTime(0),
+	m_Admitting(false),
+	m_Credit(0),
+	m_pIdleUsers(NULL),
+	m_IdleUserCount(0),
+	m_ActiveCount(0),
+	m_PeakActiveCount(0),
+	m_LaunchedCount(0),
+	m_CompletedCount(0),
+	m_FailedCount(0)
+{
+	if(!m_Params.m_Concurrency)
+		m_Params.m_Concurrency = 1;
+	if(m_Params.m_ThinkTimeMax < m_Params.m_ThinkTimeMin)
+		m_Params.m_ThinkTimeMax = m_Params.m_ThinkTimeMin;
+}
+
+bool UmcLoadGenerator::Create(apr_pool_t* pool)
+{
+	m_pIdleUsers = (apr_time_t*) apr_palloc(pool,sizeof(apr_time_t) * m_Params.m_Concurrency);
+	for(int i = 0; i < UMC_METRIC_COUNT; i++)
+		m_Stats[i].Init(pool);
+	return true;
+}
+
+void UmcLoadGenerator::Start(apr_time_t now)
+{
+	srand((unsigned int)now);
+	m_StartTime = m_LastTickTime = now;
+	m_StopTime = now + apr_time_from_sec(m_Params.m_Duration);
+	m_Admitting = true;
+	m_Credit = 0;
+
+	/* all the virtual users are ready right away */
+	for(m_IdleUserCount = 0; m_IdleUserCount < m_Params.m_Concurrency; m_IdleUserCount++)
+		m_pIdleUsers[m_IdleUserCount] = now;
+}
+
+apr_size_t UmcLoadGenerator::Tick(apr_time_t now)
+{
+	if(!m_Admitting)
+		return 0;
+
+	if(now >= m_StopTime)
+	{
+		m_Admitting = false;
+		m_StopTime = now;
+		return 0;
+	}
+
+	/* accumulate the sessions allowed by the rate since the last tick */
+	double rate = m_Params.m_Rate;
+	apr_interval_time_t elapsed = now - m_StartTime;
+	apr_interval_time_t rampTime = apr_time_from_sec(m_Params.m_RampTime);
+	if(elapsed < rampTime)
+		rate = rate * elapsed / rampTime;
+	m_Credit += rate * (now - m_LastTickTime) / APR_USEC_PER_SEC;
+	m_LastTickTime = now;
+	/* never burst more than the virtual users can take */
+	if(m_Credit > m_Params.m_Concurrency)
+		m_Credit = (double)m_Params.m_Concurrency;
+
+	apr_size_t count = 0;
+	apr_size_t i = 0;
+	while(i < m_IdleUserCount && m_Credit >= 1)
+	{
+		if(m_pIdleUsers[i] > now)
+		{
+			i++;
+			continue;
+		}
+
+		/* the user is done with thinking, take it off the idle list */
+		m_pIdleUsers[i] = m_pIdleUsers[--m_IdleUserCount];
+		m_Credit -= 1;
+		count++;
+	}
+
+	m_LaunchedCount += count;
+	m_ActiveCount += count;
+	if(m_ActiveCount > m_PeakActiveCount)
+		m_PeakActiveCount = m_ActiveCount;
+	return count;
+}
+
+void UmcLoadGenerator::AddIdleUser(apr_time_t now)
+{
+	apr_size_t thinkTime = m_Params.m_ThinkTimeMin;
+	if(m_Params.m_ThinkTimeMax > m_Params.m_ThinkTimeMin)
+		thinkTime += rand() % (m_Params.m_ThinkTimeMax - m_Params.m_ThinkTimeMin + 1);
+
+	if(m_ActiveCount)
+		m_ActiveCount--;
+	if(m_IdleUserCount < m_Params.m_Concurrency)
+		m_pIdleUsers[m_IdleUserCount++] = now + apr_time_from_msec(thinkTime);
+}
+
+void UmcLoadGenerator::OnSessionFailure(apr_time_t now)
+{
+	m_FailedCount++;
+	AddIdleUser(now);
+}
+
+void UmcLoadGenerator::OnSessionExit(UmcSession* pSession, apr_time_t now)
+{
+	if(pSession->IsFailed())
+		m_FailedCount++;
+	else
+		m_CompletedCount++;
+	AddIdleUser(now);
+}
+
+void UmcLoadGenerator::OnSessionMetric(UmcSessionMetric metric, apr_interval_time_t latency)
+{
+	if(metric < UMC_METRIC_COUNT)
+		m_Stats[metric].Add(latency);
+}
+
+bool UmcLoadGenerator::IsOverdue(apr_time_t now) const
+{
+	return !m_Admitting && now - m_StopTime > UMC_LOAD_GRACE_TIME;
+}
+
+void UmcLoadGenerator::Report()
+{
+	double duration = (double)(m_StopTime - m_StartTime) / APR_USEC_PER_SEC;
+	printf("\nLoad Report [%s]\n"
+		"Duration [%.1f sec] Rate [%.2f cps] Peak Concurrency [%" APR_SIZE_T_FMT "]\n"
+		"Sessions: launched [%" APR_SIZE_T_FMT "] completed [%" APR_SIZE_T_FMT "] failed [%" APR_SIZE_T_FMT "]\n\n",
+		m_Params.m_pScenarioName,
+		duration,
+		duration > 0 ? m_LaunchedCount / duration : 0.0,
+		m_PeakActiveCount,
+		m_LaunchedCount,
+		m_CompletedCount,
+		m_FailedCount);
+
+	printf("%-22s %8s %9s %9s %9s %9s %9s %9s %9s\n",
+		"Latency (msec)","count","min","avg","p50","p90","p95","p99","max");
+	for(int i = 0; i < UMC_METRIC_COUNT; i++)
+		m_Stats[i].Report(UmcMetricNames[i]);
+}
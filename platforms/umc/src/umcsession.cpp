@@ -17,6 +17,9 @@
 #include "umcsession.h"
 #include "umcscenario.h"
 #include "mrcp_message.h"
+#include "mrcp_resource.h"
+#include "mrcp_synth_resource.h"
+#include "mrcp_recog_resource.h"
 #include "apt_pool.h"
 
 UmcSession::UmcSession(const UmcScenario* pScenario) :
@@ -27,7 +30,12 @@ UmcSession::UmcSession(const UmcScenario* pScenario) :
 	m_pMrcpSession(NULL),
 	m_pMrcpMessage(NULL),
 	m_Running(false),
-	m_Terminating(false)
+	m_Terminating(false),
+	m_Failed(false),
+	m_RunTime(0),
+	m_RequestTime(0),
+	m_ChannelAdded(false),
+	m_ResponseReceived(false)
 {
 	static int id = 0;
 	if(id == INT_MAX)
@@ -54,6 +62,8 @@ bool UmcSession::Run()
 	if(!m_pMrcpProfile || !m_pMrcpApplication)
 		return false;
 
+	m_RunTime = apr_time_now();
+
 	/* create session */
 	if(!CreateMrcpSession(m_pMrcpProfile))
 		return false;
@@ -97,6 +107,9 @@ bool UmcSession::OnSessionTerminate(mrcp_sig_status_code_e status)
 	if(!m_Terminating)
 		return false;
 
+	if(status != MRCP_SIG_STATUS_CODE_SUCCESS)
+		m_Failed = true;
+
 	m_Terminating = false;
 	DestroyMrcpSession();
 	if(m_pMethodProvider)
@@ -111,7 +124,17 @@ bool UmcSession::OnSessionUpdate(mrcp_sig_status_code_e status)
 
 bool UmcSession::OnChannelAdd(mrcp_channel_t* pMrcpChannel, mrcp_sig_status_code_e status)
 {
-	return m_Running;
+	if(!m_Running)
+		return false;
+
+	if(status != MRCP_SIG_STATUS_CODE_SUCCESS)
+		m_Failed = true;
+	else if(!m_ChannelAdded)
+	{
+		m_ChannelAdded = true;
+		ReportMetric(UMC_METRIC_SESSION_SETUP,m_RunTime);
+	}
+	return true;
 }
 
 bool UmcSession::OnChannelRemove(mrcp_channel_t* pMrcpChannel, mrcp_sig_status_code_e status)
@@ -131,6 +154,26 @@ bool UmcSession::OnMessageReceive(mrcp_channel_t* pMrcpChannel, mrcp_message_t*
 	if(m_pMrcpMessage->start_line.request_id != pMrcpMessage->start_line.request_id)
 		return false;
 
+	if(pMrcpMessage->start_line.message_type == MRCP_MESSAGE_TYPE_RESPONSE)
+	{
+		if(!m_ResponseReceived)
+		{
+			m_ResponseReceived = true;
+			ReportMetric(UMC_METRIC_FIRST_RESPONSE,m_RequestTime);
+		}
+		if(pMrcpMessage->start_line.status_code != MRCP_STATUS_CODE_SUCCESS && 
+			pMrcpMessage->start_line.status_code != MRCP_STATUS_CODE_SUCCESS_WITH_IGNORE)
+			m_Failed = true;
+	}
+	else if(pMrcpMessage->start_line.message_type == MRCP_MESSAGE_TYPE_EVENT && pMrcpMessage->resource)
+	{
+		if(pMrcpMessage->resource->id == MRCP_RECOGNIZER_RESOURCE &&
+			pMrcpMessage->start_line.method_id == RECOGNIZER_RECOGNITION_COMPLETE)
+			ReportMetric(UMC_METRIC_RECOGNITION_COMPLETE,m_RequestTime);
+		else if(pMrcpMessage->resource->id == MRCP_SYNTHESIZER_RESOURCE &&
+			pMrcpMessage->start_line.method_id == SYNTHESIZER_SPEAK_COMPLETE)
+			ReportMetric(UMC_METRIC_SPEAK_COMPLETE,m_RequestTime);
+	}
 	return true;
 }
 
@@ -195,6 +238,7 @@ bool UmcSession::SendMrcpRequest(mrcp_channel_t* pMrcpChannel, mrcp_message_t* p
 		return false;
 
 	m_pMrcpMessage = pMrcpMessage;
+	m_RequestTime = apr_time_now();
 	return (mrcp_application_message_send(m_pMrcpSession,pMrcpChannel,pMrcpMessage) == TRUE);
 }
 
@@ -239,6 +283,12 @@ mrcp_message_t* UmcSession::CreateMrcpMessage(
 	return mrcp_application_message_create(m_pMrcpSession,pMrcpChannel,method_id);
 }
 
+void UmcSession::ReportMetric(UmcSessionMetric metric, apr_time_t startTime)
+{
+	if(m_pMethodProvider && startTime)
+		m_pMethodProvider->ReportMetric(this,metric,apr_time_now() - startTime);
+}
+
 const char* UmcSession::GetMrcpSessionId() const
 {
 	if(!m_pMrcpSession)
@@ -312,7 +312,7 @@ static apt_bool_t recog_application_on_message_receive(mrcp_application_t *appli
 	}
 	else if(message->start_line.message_type == MRCP_MESSAGE_TYPE_EVENT) {
 		if(message->start_line.method_id == RECOGNIZER_RECOGNITION_COMPLETE) {
-			nlsml_result_t *result = nlsml_result_parse(message->body.buf, message->body.length, message->pool);
+			nlsml_result_t *result = nlsml_result_fast_parse(message->body.buf, message->body.length, message->pool);
 			if(result) {
 				nlsml_result_trace(result, message->pool);
 			}
@@ -43,11 +43,24 @@ static apt_bool_t cmdline_process(mrcp_server_t *server, char *cmdline)
 	else if(strcasecmp(name,"online") == 0) {
 		mrcp_server_online(server);
 	}
+	else if(strcasecmp(name,"load") == 0) {
+		mrcp_server_load_t load;
+		if(mrcp_server_load_get(server,&load) == TRUE) {
+			printf("sessions: %"APR_SIZE_T_FMT" queue: %"APR_SIZE_T_FMT" overruns: %"APR_SIZE_T_FMT" channel usage: %"APR_SIZE_T_FMT"%% rejected: %"APR_SIZE_T_FMT" overloaded: %s\n",
+				load.session_count,
+				load.queue_depth,
+				load.overrun_count,
+				load.channel_usage,
+				load.rejected_count,
+				load.overloaded == TRUE ? "yes" : "no");
+		}
+	}
 	else if(strcasecmp(name,"help") == 0) {
 		printf("usage:\n");
 		printf("- loglevel [level] (set loglevel, one of 0,1...7)\n");
 		printf("- offline (take server offline)\n");
 		printf("- online (bring server online)\n");
+		printf("- load (show current load)\n");
 		printf("- quit, exit\n");
 	}
 	else {
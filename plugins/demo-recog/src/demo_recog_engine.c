@@ -29,14 +29,14 @@
 
 #include "mrcp_recog_engine.h"
 #include "mpf_activity_detector.h"
-#include "apt_consumer_task.h"
+#include "mrcp_engine_worker.h"
+#include "mrcp_engine_grammar_cache.h"
 #include "apt_log.h"
 
 #define RECOG_ENGINE_TASK_NAME "Demo Recog Engine"
 
 typedef struct demo_recog_engine_t demo_recog_engine_t;
 typedef struct demo_recog_channel_t demo_recog_channel_t;
-typedef struct demo_recog_msg_t demo_recog_msg_t;
 
 /** Declaration of recognizer engine methods */
 static apt_bool_t demo_recog_engine_destroy(mrcp_engine_t *engine);
@@ -84,7 +84,9 @@ static const mpf_audio_stream_vtable_t audio_stream_vtable = {
 
 /** Declaration of demo recognizer engine */
 struct demo_recog_engine_t {
-	apt_consumer_task_t    *task;
+	mrcp_engine_worker_pool_t   *workers;
+	/** Grammars shared by the channels */
+	mrcp_engine_grammar_cache_t *grammars;
 };
 
 /** Declaration of demo recognizer channel */
@@ -104,23 +106,21 @@ struct demo_recog_channel_t {
 	mpf_activity_detector_t *detector;
 	/** File to write utterance to */
 	FILE                    *audio_out;
+	/** Grammars defined by DEFINE-GRAMMAR (Content-Id -> mrcp_engine_grammar_t) */
+	apr_hash_t              *grammars;
+	/** Inline grammar of the last RECOGNIZE */
+	mrcp_engine_grammar_t   *inline_grammar;
 };
 
-typedef enum {
-	DEMO_RECOG_MSG_OPEN_CHANNEL,
-	DEMO_RECOG_MSG_CLOSE_CHANNEL,
-	DEMO_RECOG_MSG_REQUEST_PROCESS
-} demo_recog_msg_type_e;
-
-/** Declaration of demo recognizer task message */
-struct demo_recog_msg_t {
-	demo_recog_msg_type_e  type;
-	mrcp_engine_channel_t *channel; 
-	mrcp_message_t        *request;
-};
+static apt_bool_t demo_recog_channel_request_dispatch(mrcp_engine_channel_t *channel, mrcp_message_t *request);
+static apt_bool_t demo_recog_channel_close_process(mrcp_engine_channel_t *channel);
 
-static apt_bool_t demo_recog_msg_signal(demo_recog_msg_type_e type, mrcp_engine_channel_t *channel, mrcp_message_t *request);
-static apt_bool_t demo_recog_msg_process(apt_task_t *task, apt_task_msg_t *msg);
+/** Declaration of recognizer worker handlers (invoked in the context of engine workers) */
+static const mrcp_engine_worker_vtable_t worker_vtable = {
+	NULL,
+	demo_recog_channel_close_process,
+	demo_recog_channel_request_dispatch
+};
 
 /** Declare this macro to set plugin version */
 MRCP_PLUGIN_VERSION_DECLARE
@@ -138,39 +138,35 @@ MRCP_PLUGIN_LOG_SOURCE_IMPLEMENT(RECOG_PLUGIN,"RECOG-PLUGIN")
 /** Create demo recognizer engine */
 MRCP_PLUGIN_DECLARE(mrcp_engine_t*) mrcp_plugin_create(apr_pool_t *pool)
 {
+	mrcp_engine_t *engine;
 	demo_recog_engine_t *demo_engine = apr_palloc(pool,sizeof(demo_recog_engine_t));
-	apt_task_t *task;
-	apt_task_vtable_t *vtable;
-	apt_task_msg_pool_t *msg_pool;
-
-	msg_pool = apt_task_msg_pool_create_dynamic(sizeof(demo_recog_msg_t),pool);
-	demo_engine->task = apt_consumer_task_create(demo_engine,msg_pool,pool);
-	if(!demo_engine->task) {
-		return NULL;
-	}
-	task = apt_consumer_task_base_get(demo_engine->task);
-	apt_task_name_set(task,RECOG_ENGINE_TASK_NAME);
-	vtable = apt_task_vtable_get(task);
-	if(vtable) {
-		vtable->process_msg = demo_recog_msg_process;
-	}
+	demo_engine->workers = NULL;
+	demo_engine->grammars = NULL;
 
 	/* create engine base */
-	return mrcp_engine_create(
+	engine = mrcp_engine_create(
 				MRCP_RECOGNIZER_RESOURCE,  /* MRCP resource identifier */
 				demo_engine,               /* object to associate */
 				&engine_vtable,            /* virtual methods table of engine */
 				pool);                     /* pool to allocate memory from */
+	if(engine) {
+		/* channels share nothing but the workers, the server may process sessions by multiple tasks */
+		mrcp_engine_concurrency_enable(engine);
+	}
+	return engine;
 }
 
 /** Destroy recognizer engine */
 static apt_bool_t demo_recog_engine_destroy(mrcp_engine_t *engine)
 {
 	demo_recog_engine_t *demo_engine = engine->obj;
-	if(demo_engine->task) {
-		apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-		apt_task_destroy(task);
-		demo_engine->task = NULL;
+	if(demo_engine->workers) {
+		mrcp_engine_worker_pool_destroy(demo_engine->workers);
+		demo_engine->workers = NULL;
+	}
+	if(demo_engine->grammars) {
+		mrcp_engine_grammar_cache_destroy(demo_engine->grammars);
+		demo_engine->grammars = NULL;
 	}
 	return TRUE;
 }
@@ -179,20 +175,28 @@ static apt_bool_t demo_recog_engine_destroy(mrcp_engine_t *engine)
 static apt_bool_t demo_recog_engine_open(mrcp_engine_t *engine)
 {
 	demo_recog_engine_t *demo_engine = engine->obj;
-	if(demo_engine->task) {
-		apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-		apt_task_start(task);
+	/* create cache of grammars (the memory budget is set by the optional
+	   "grammar-cache-size" param of the engine); there is nothing to compile
+	   in the demo, so only the content of grammars is cached */
+	demo_engine->grammars = mrcp_engine_grammar_cache_create(engine,NULL,NULL,engine->pool);
+	if(!demo_engine->grammars) {
+		return mrcp_engine_open_respond(engine,FALSE);
 	}
-	return mrcp_engine_open_respond(engine,TRUE);
+	/* create workers to process channel requests (the number of workers
+	   is set by the optional "worker-count" param of the engine) */
+	demo_engine->workers = mrcp_engine_worker_pool_create(engine,RECOG_ENGINE_TASK_NAME,&worker_vtable,engine->pool);
+	if(!demo_engine->workers) {
+		return mrcp_engine_open_respond(engine,FALSE);
+	}
+	return mrcp_engine_open_respond(engine,mrcp_engine_worker_pool_start(demo_engine->workers));
 }
 
 /** Close recognizer engine */
 static apt_bool_t demo_recog_engine_close(mrcp_engine_t *engine)
 {
 	demo_recog_engine_t *demo_engine = engine->obj;
-	if(demo_engine->task) {
-		apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-		apt_task_terminate(task,TRUE);
+	if(demo_engine->workers) {
+		mrcp_engine_worker_pool_terminate(demo_engine->workers);
 	}
 	return mrcp_engine_close_respond(engine);
 }
@@ -209,6 +213,8 @@ static mrcp_engine_channel_t* demo_recog_engine_channel_create(mrcp_engine_t *en
 	recog_channel->stop_response = NULL;
 	recog_channel->detector = mpf_activity_detector_create(pool);
 	recog_channel->audio_out = NULL;
+	recog_channel->grammars = apr_hash_make(pool);
+	recog_channel->inline_grammar = NULL;
 
 	capabilities = mpf_sink_stream_capabilities_create(pool);
 	mpf_codec_capabilities_add(
@@ -244,19 +250,71 @@ static apt_bool_t demo_recog_channel_destroy(mrcp_engine_channel_t *channel)
 /** Open engine channel (asynchronous response MUST be sent)*/
 static apt_bool_t demo_recog_channel_open(mrcp_engine_channel_t *channel)
 {
-	return demo_recog_msg_signal(DEMO_RECOG_MSG_OPEN_CHANNEL,channel,NULL);
+	demo_recog_channel_t *demo_channel = channel->method_obj;
+	return mrcp_engine_worker_channel_open(demo_channel->demo_engine->workers,channel);
 }
 
 /** Close engine channel (asynchronous response MUST be sent)*/
 static apt_bool_t demo_recog_channel_close(mrcp_engine_channel_t *channel)
 {
-	return demo_recog_msg_signal(DEMO_RECOG_MSG_CLOSE_CHANNEL,channel,NULL);
+	demo_recog_channel_t *demo_channel = channel->method_obj;
+	return mrcp_engine_worker_channel_close(demo_channel->demo_engine->workers,channel);
 }
 
 /** Process MRCP channel request (asynchronous response MUST be sent)*/
 static apt_bool_t demo_recog_channel_request_process(mrcp_engine_channel_t *channel, mrcp_message_t *request)
 {
-	return demo_recog_msg_signal(DEMO_RECOG_MSG_REQUEST_PROCESS,channel,request);
+	demo_recog_channel_t *demo_channel = channel->method_obj;
+	return mrcp_engine_worker_request_process(demo_channel->demo_engine->workers,channel,request);
+}
+
+/** Process DEFINE-GRAMMAR request */
+static apt_bool_t demo_recog_channel_grammar_define(mrcp_engine_channel_t *channel, mrcp_message_t *request, mrcp_message_t *response)
+{
+	demo_recog_channel_t *recog_channel = channel->method_obj;
+	mrcp_engine_grammar_cache_t *cache = recog_channel->demo_engine->grammars;
+	mrcp_engine_grammar_t *grammar;
+	mrcp_engine_grammar_t *prev_grammar;
+	const apt_str_t *content_id;
+
+	if(!request->body.length) {
+		return FALSE;
+	}
+
+	/* grammar sent by any other session before is taken from the cache */
+	grammar = mrcp_engine_grammar_request_acquire(cache,request);
+	if(!grammar) {
+		apt_log(RECOG_LOG_MARK,APT_PRIO_WARNING,"Failed to Define Grammar " APT_SIDRES_FMT, MRCP_MESSAGE_SIDRES(request));
+		response->start_line.status_code = MRCP_STATUS_CODE_METHOD_FAILED;
+		return FALSE;
+	}
+
+	/* the grammar replaces the one previously defined with the same Content-Id */
+	content_id = mrcp_engine_grammar_content_id_get(grammar);
+	prev_grammar = apr_hash_get(recog_channel->grammars,content_id->buf,content_id->length);
+	apr_hash_set(recog_channel->grammars,content_id->buf,content_id->length,grammar);
+	if(prev_grammar) {
+		mrcp_engine_grammar_release(cache,prev_grammar);
+	}
+	return mrcp_engine_channel_message_send(channel,response);
+}
+
+/** Release grammars referenced by the channel */
+static void demo_recog_channel_grammars_release(demo_recog_channel_t *recog_channel)
+{
+	mrcp_engine_grammar_cache_t *cache = recog_channel->demo_engine->grammars;
+	apr_hash_index_t *it;
+	void *val;
+	for(it = apr_hash_first(NULL,recog_channel->grammars); it; it = apr_hash_next(it)) {
+		apr_hash_this(it,NULL,NULL,&val);
+		mrcp_engine_grammar_release(cache,val);
+	}
+	apr_hash_clear(recog_channel->grammars);
+
+	if(recog_channel->inline_grammar) {
+		mrcp_engine_grammar_release(cache,recog_channel->inline_grammar);
+		recog_channel->inline_grammar = NULL;
+	}
 }
 
 /** Process RECOGNIZE request */
@@ -273,6 +331,20 @@ static apt_bool_t demo_recog_channel_recognize(mrcp_engine_channel_t *channel, m
 		return FALSE;
 	}
 
+	if(request->body.length) {
+		/* inline grammar */
+		mrcp_engine_grammar_t *grammar = mrcp_engine_grammar_request_acquire(recog_channel->demo_engine->grammars,request);
+		if(!grammar) {
+			apt_log(RECOG_LOG_MARK,APT_PRIO_WARNING,"Failed to Load Inline Grammar " APT_SIDRES_FMT, MRCP_MESSAGE_SIDRES(request));
+			response->start_line.status_code = MRCP_STATUS_CODE_METHOD_FAILED;
+			return FALSE;
+		}
+		if(recog_channel->inline_grammar) {
+			mrcp_engine_grammar_release(recog_channel->demo_engine->grammars,recog_channel->inline_grammar);
+		}
+		recog_channel->inline_grammar = grammar;
+	}
+
 	recog_channel->timers_started = TRUE;
 
 	/* get recognizer header */
@@ -340,6 +412,7 @@ static apt_bool_t demo_recog_channel_request_dispatch(mrcp_engine_channel_t *cha
 		case RECOGNIZER_GET_PARAMS:
 			break;
 		case RECOGNIZER_DEFINE_GRAMMAR:
+			processed = demo_recog_channel_grammar_define(channel,request,response);
 			break;
 		case RECOGNIZER_RECOGNIZE:
 			processed = demo_recog_channel_recognize(channel,request,response);
@@ -521,51 +594,15 @@ static apt_bool_t demo_recog_stream_write(mpf_audio_stream_t *stream, const mpf_
 	return TRUE;
 }
 
-static apt_bool_t demo_recog_msg_signal(demo_recog_msg_type_e type, mrcp_engine_channel_t *channel, mrcp_message_t *request)
+/** Close channel, make sure there is no activity and send asynch response */
+static apt_bool_t demo_recog_channel_close_process(mrcp_engine_channel_t *channel)
 {
-	apt_bool_t status = FALSE;
-	demo_recog_channel_t *demo_channel = channel->method_obj;
-	demo_recog_engine_t *demo_engine = demo_channel->demo_engine;
-	apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-	apt_task_msg_t *msg = apt_task_msg_get(task);
-	if(msg) {
-		demo_recog_msg_t *demo_msg;
-		msg->type = TASK_MSG_USER;
-		demo_msg = (demo_recog_msg_t*) msg->data;
-
-		demo_msg->type = type;
-		demo_msg->channel = channel;
-		demo_msg->request = request;
-		status = apt_task_msg_signal(task,msg);
+	demo_recog_channel_t *recog_channel = channel->method_obj;
+	if(recog_channel->audio_out) {
+		fclose(recog_channel->audio_out);
+		recog_channel->audio_out = NULL;
 	}
-	return status;
-}
-
-static apt_bool_t demo_recog_msg_process(apt_task_t *task, apt_task_msg_t *msg)
-{
-	demo_recog_msg_t *demo_msg = (demo_recog_msg_t*)msg->data;
-	switch(demo_msg->type) {
-		case DEMO_RECOG_MSG_OPEN_CHANNEL:
-			/* open channel and send asynch response */
-			mrcp_engine_channel_open_respond(demo_msg->channel,TRUE);
-			break;
-		case DEMO_RECOG_MSG_CLOSE_CHANNEL:
-		{
-			/* close channel, make sure there is no activity and send asynch response */
-			demo_recog_channel_t *recog_channel = demo_msg->channel->method_obj;
-			if(recog_channel->audio_out) {
-				fclose(recog_channel->audio_out);
-				recog_channel->audio_out = NULL;
-			}
+	demo_recog_channel_grammars_release(recog_channel);
 
-			mrcp_engine_channel_close_respond(demo_msg->channel);
-			break;
-		}
-		case DEMO_RECOG_MSG_REQUEST_PROCESS:
-			demo_recog_channel_request_dispatch(demo_msg->channel,demo_msg->request);
-			break;
-		default:
-			break;
-	}
-	return TRUE;
+	return mrcp_engine_channel_close_respond(channel);
 }
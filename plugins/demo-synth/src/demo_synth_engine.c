@@ -28,14 +28,13 @@
  */
 
 #include "mrcp_synth_engine.h"
-#include "apt_consumer_task.h"
+#include "mrcp_engine_worker.h"
 #include "apt_log.h"
 
 #define SYNTH_ENGINE_TASK_NAME "Demo Synth Engine"
 
 typedef struct demo_synth_engine_t demo_synth_engine_t;
 typedef struct demo_synth_channel_t demo_synth_channel_t;
-typedef struct demo_synth_msg_t demo_synth_msg_t;
 
 /** Declaration of synthesizer engine methods */
 static apt_bool_t demo_synth_engine_destroy(mrcp_engine_t *engine);
@@ -83,7 +82,7 @@ static const mpf_audio_stream_vtable_t audio_stream_vtable = {
 
 /** Declaration of demo synthesizer engine */
 struct demo_synth_engine_t {
-	apt_consumer_task_t    *task;
+	mrcp_engine_worker_pool_t *workers;
 };
 
 /** Declaration of demo synthesizer channel */
@@ -105,22 +104,14 @@ struct demo_synth_channel_t {
 	FILE                  *audio_file;
 };
 
-typedef enum {
-	DEMO_SYNTH_MSG_OPEN_CHANNEL,
-	DEMO_SYNTH_MSG_CLOSE_CHANNEL,
-	DEMO_SYNTH_MSG_REQUEST_PROCESS
-} demo_synth_msg_type_e;
-
-/** Declaration of demo synthesizer task message */
-struct demo_synth_msg_t {
-	demo_synth_msg_type_e  type;
-	mrcp_engine_channel_t *channel; 
-	mrcp_message_t        *request;
-};
-
+static apt_bool_t demo_synth_channel_request_dispatch(mrcp_engine_channel_t *channel, mrcp_message_t *request);
 
-static apt_bool_t demo_synth_msg_signal(demo_synth_msg_type_e type, mrcp_engine_channel_t *channel, mrcp_message_t *request);
-static apt_bool_t demo_synth_msg_process(apt_task_t *task, apt_task_msg_t *msg);
+/** Declaration of synthesizer worker handlers (invoked in the context of engine workers) */
+static const mrcp_engine_worker_vtable_t worker_vtable = {
+	NULL,
+	NULL,
+	demo_synth_channel_request_dispatch
+};
 
 /** Declare this macro to set plugin version */
 MRCP_PLUGIN_VERSION_DECLARE
@@ -138,41 +129,31 @@ MRCP_PLUGIN_LOG_SOURCE_IMPLEMENT(SYNTH_PLUGIN,"SYNTH-PLUGIN")
 /** Create demo synthesizer engine */
 MRCP_PLUGIN_DECLARE(mrcp_engine_t*) mrcp_plugin_create(apr_pool_t *pool)
 {
+	mrcp_engine_t *engine;
 	/* create demo engine */
 	demo_synth_engine_t *demo_engine = apr_palloc(pool,sizeof(demo_synth_engine_t));
-	apt_task_t *task;
-	apt_task_vtable_t *vtable;
-	apt_task_msg_pool_t *msg_pool;
-
-	/* create task/thread to run demo engine in the context of this task */
-	msg_pool = apt_task_msg_pool_create_dynamic(sizeof(demo_synth_msg_t),pool);
-	demo_engine->task = apt_consumer_task_create(demo_engine,msg_pool,pool);
-	if(!demo_engine->task) {
-		return NULL;
-	}
-	task = apt_consumer_task_base_get(demo_engine->task);
-	apt_task_name_set(task,SYNTH_ENGINE_TASK_NAME);
-	vtable = apt_task_vtable_get(task);
-	if(vtable) {
-		vtable->process_msg = demo_synth_msg_process;
-	}
+	demo_engine->workers = NULL;
 
 	/* create engine base */
-	return mrcp_engine_create(
+	engine = mrcp_engine_create(
 				MRCP_SYNTHESIZER_RESOURCE, /* MRCP resource identifier */
 				demo_engine,               /* object to associate */
 				&engine_vtable,            /* virtual methods table of engine */
 				pool);                     /* pool to allocate memory from */
+	if(engine) {
+		/* channels share nothing but the workers, the server may process sessions by multiple tasks */
+		mrcp_engine_concurrency_enable(engine);
+	}
+	return engine;
 }
 
 /** Destroy synthesizer engine */
 static apt_bool_t demo_synth_engine_destroy(mrcp_engine_t *engine)
 {
 	demo_synth_engine_t *demo_engine = engine->obj;
-	if(demo_engine->task) {
-		apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-		apt_task_destroy(task);
-		demo_engine->task = NULL;
+	if(demo_engine->workers) {
+		mrcp_engine_worker_pool_destroy(demo_engine->workers);
+		demo_engine->workers = NULL;
 	}
 	return TRUE;
 }
@@ -181,20 +162,21 @@ static apt_bool_t demo_synth_engine_destroy(mrcp_engine_t *engine)
 static apt_bool_t demo_synth_engine_open(mrcp_engine_t *engine)
 {
 	demo_synth_engine_t *demo_engine = engine->obj;
-	if(demo_engine->task) {
-		apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-		apt_task_start(task);
+	/* create workers to process channel requests (the number of workers
+	   is set by the optional "worker-count" param of the engine) */
+	demo_engine->workers = mrcp_engine_worker_pool_create(engine,SYNTH_ENGINE_TASK_NAME,&worker_vtable,engine->pool);
+	if(!demo_engine->workers) {
+		return mrcp_engine_open_respond(engine,FALSE);
 	}
-	return mrcp_engine_open_respond(engine,TRUE);
+	return mrcp_engine_open_respond(engine,mrcp_engine_worker_pool_start(demo_engine->workers));
 }
 
 /** Close synthesizer engine */
 static apt_bool_t demo_synth_engine_close(mrcp_engine_t *engine)
 {
 	demo_synth_engine_t *demo_engine = engine->obj;
-	if(demo_engine->task) {
-		apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-		apt_task_terminate(task,TRUE);
+	if(demo_engine->workers) {
+		mrcp_engine_worker_pool_terminate(demo_engine->workers);
 	}
 	return mrcp_engine_close_respond(engine);
 }
@@ -248,19 +230,22 @@ static apt_bool_t demo_synth_channel_destroy(mrcp_engine_channel_t *channel)
 /** Open engine channel (asynchronous response MUST be sent)*/
 static apt_bool_t demo_synth_channel_open(mrcp_engine_channel_t *channel)
 {
-	return demo_synth_msg_signal(DEMO_SYNTH_MSG_OPEN_CHANNEL,channel,NULL);
+	demo_synth_channel_t *demo_channel = channel->method_obj;
+	return mrcp_engine_worker_channel_open(demo_channel->demo_engine->workers,channel);
 }
 
 /** Close engine channel (asynchronous response MUST be sent)*/
 static apt_bool_t demo_synth_channel_close(mrcp_engine_channel_t *channel)
 {
-	return demo_synth_msg_signal(DEMO_SYNTH_MSG_CLOSE_CHANNEL,channel,NULL);
+	demo_synth_channel_t *demo_channel = channel->method_obj;
+	return mrcp_engine_worker_channel_close(demo_channel->demo_engine->workers,channel);
 }
 
 /** Process MRCP channel request (asynchronous response MUST be sent)*/
 static apt_bool_t demo_synth_channel_request_process(mrcp_engine_channel_t *channel, mrcp_message_t *request)
 {
-	return demo_synth_msg_signal(DEMO_SYNTH_MSG_REQUEST_PROCESS,channel,request);
+	demo_synth_channel_t *demo_channel = channel->method_obj;
+	return mrcp_engine_worker_request_process(demo_channel->demo_engine->workers,channel,request);
 }
 
 /** Process SPEAK request */
@@ -519,44 +504,3 @@ static apt_bool_t demo_synth_stream_read(mpf_audio_stream_t *stream, mpf_frame_t
 	}
 	return TRUE;
 }
-
-static apt_bool_t demo_synth_msg_signal(demo_synth_msg_type_e type, mrcp_engine_channel_t *channel, mrcp_message_t *request)
-{
-	apt_bool_t status = FALSE;
-	demo_synth_channel_t *demo_channel = channel->method_obj;
-	demo_synth_engine_t *demo_engine = demo_channel->demo_engine;
-	apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-	apt_task_msg_t *msg = apt_task_msg_get(task);
-	if(msg) {
-		demo_synth_msg_t *demo_msg;
-		msg->type = TASK_MSG_USER;
-		demo_msg = (demo_synth_msg_t*) msg->data;
-
-		demo_msg->type = type;
-		demo_msg->channel = channel;
-		demo_msg->request = request;
-		status = apt_task_msg_signal(task,msg);
-	}
-	return status;
-}
-
-static apt_bool_t demo_synth_msg_process(apt_task_t *task, apt_task_msg_t *msg)
-{
-	demo_synth_msg_t *demo_msg = (demo_synth_msg_t*)msg->data;
-	switch(demo_msg->type) {
-		case DEMO_SYNTH_MSG_OPEN_CHANNEL:
-			/* open channel and send asynch response */
-			mrcp_engine_channel_open_respond(demo_msg->channel,TRUE);
-			break;
-		case DEMO_SYNTH_MSG_CLOSE_CHANNEL:
-			/* close channel, make sure there is no activity and send asynch response */
-			mrcp_engine_channel_close_respond(demo_msg->channel);
-			break;
-		case DEMO_SYNTH_MSG_REQUEST_PROCESS:
-			demo_synth_channel_request_dispatch(demo_msg->channel,demo_msg->request);
-			break;
-		default:
-			break;
-	}
-	return TRUE;
-}
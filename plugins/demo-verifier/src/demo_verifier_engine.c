@@ -29,14 +29,13 @@
 
 #include "mrcp_verifier_engine.h"
 #include "mpf_activity_detector.h"
-#include "apt_consumer_task.h"
+#include "mrcp_engine_worker.h"
 #include "apt_log.h"
 
 #define VERIFIER_ENGINE_TASK_NAME "Demo Verifier Engine"
 
 typedef struct demo_verifier_engine_t demo_verifier_engine_t;
 typedef struct demo_verifier_channel_t demo_verifier_channel_t;
-typedef struct demo_verifier_msg_t demo_verifier_msg_t;
 
 /** Declaration of verification engine methods */
 static apt_bool_t demo_verifier_engine_destroy(mrcp_engine_t *engine);
@@ -84,7 +83,7 @@ static const mpf_audio_stream_vtable_t audio_stream_vtable = {
 
 /** Declaration of demo verification engine */
 struct demo_verifier_engine_t {
-	apt_consumer_task_t    *task;
+	mrcp_engine_worker_pool_t *workers;
 };
 
 /** Declaration of demo verification channel */
@@ -106,21 +105,15 @@ struct demo_verifier_channel_t {
 	FILE                    *audio_out;
 };
 
-typedef enum {
-	DEMO_VERIF_MSG_OPEN_CHANNEL,
-	DEMO_VERIF_MSG_CLOSE_CHANNEL,
-	DEMO_VERIF_MSG_REQUEST_PROCESS
-} demo_verifier_msg_type_e;
-
-/** Declaration of demo verification task message */
-struct demo_verifier_msg_t {
-	demo_verifier_msg_type_e  type;
-	mrcp_engine_channel_t *channel; 
-	mrcp_message_t        *request;
-};
+static apt_bool_t demo_verifier_channel_request_dispatch(mrcp_engine_channel_t *channel, mrcp_message_t *request);
+static apt_bool_t demo_verifier_channel_close_process(mrcp_engine_channel_t *channel);
 
-static apt_bool_t demo_verifier_msg_signal(demo_verifier_msg_type_e type, mrcp_engine_channel_t *channel, mrcp_message_t *request);
-static apt_bool_t demo_verifier_msg_process(apt_task_t *task, apt_task_msg_t *msg);
+/** Declaration of verifier worker handlers (invoked in the context of engine workers) */
+static const mrcp_engine_worker_vtable_t worker_vtable = {
+	NULL,
+	demo_verifier_channel_close_process,
+	demo_verifier_channel_request_dispatch
+};
 
 static apt_bool_t demo_verifier_result_load(demo_verifier_channel_t *verifier_channel, mrcp_message_t *message);
 
@@ -140,39 +133,30 @@ MRCP_PLUGIN_LOG_SOURCE_IMPLEMENT(VERIF_PLUGIN,"VERIF-PLUGIN")
 /** Create demo verification engine */
 MRCP_PLUGIN_DECLARE(mrcp_engine_t*) mrcp_plugin_create(apr_pool_t *pool)
 {
+	mrcp_engine_t *engine;
 	demo_verifier_engine_t *demo_engine = apr_palloc(pool,sizeof(demo_verifier_engine_t));
-	apt_task_t *task;
-	apt_task_vtable_t *vtable;
-	apt_task_msg_pool_t *msg_pool;
-
-	msg_pool = apt_task_msg_pool_create_dynamic(sizeof(demo_verifier_msg_t),pool);
-	demo_engine->task = apt_consumer_task_create(demo_engine,msg_pool,pool);
-	if(!demo_engine->task) {
-		return NULL;
-	}
-	task = apt_consumer_task_base_get(demo_engine->task);
-	apt_task_name_set(task,VERIFIER_ENGINE_TASK_NAME);
-	vtable = apt_task_vtable_get(task);
-	if(vtable) {
-		vtable->process_msg = demo_verifier_msg_process;
-	}
+	demo_engine->workers = NULL;
 
 	/* create engine base */
-	return mrcp_engine_create(
+	engine = mrcp_engine_create(
 				MRCP_VERIFIER_RESOURCE,    /* MRCP resource identifier */
 				demo_engine,               /* object to associate */
 				&engine_vtable,            /* virtual methods table of engine */
 				pool);                     /* pool to allocate memory from */
+	if(engine) {
+		/* channels share nothing but the workers, the server may process sessions by multiple tasks */
+		mrcp_engine_concurrency_enable(engine);
+	}
+	return engine;
 }
 
 /** Destroy verification engine */
 static apt_bool_t demo_verifier_engine_destroy(mrcp_engine_t *engine)
 {
 	demo_verifier_engine_t *demo_engine = engine->obj;
-	if(demo_engine->task) {
-		apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-		apt_task_destroy(task);
-		demo_engine->task = NULL;
+	if(demo_engine->workers) {
+		mrcp_engine_worker_pool_destroy(demo_engine->workers);
+		demo_engine->workers = NULL;
 	}
 	return TRUE;
 }
@@ -181,20 +165,21 @@ static apt_bool_t demo_verifier_engine_destroy(mrcp_engine_t *engine)
 static apt_bool_t demo_verifier_engine_open(mrcp_engine_t *engine)
 {
 	demo_verifier_engine_t *demo_engine = engine->obj;
-	if(demo_engine->task) {
-		apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-		apt_task_start(task);
+	/* create workers to process channel requests (the number of workers
+	   is set by the optional "worker-count" param of the engine) */
+	demo_engine->workers = mrcp_engine_worker_pool_create(engine,VERIFIER_ENGINE_TASK_NAME,&worker_vtable,engine->pool);
+	if(!demo_engine->workers) {
+		return mrcp_engine_open_respond(engine,FALSE);
 	}
-	return mrcp_engine_open_respond(engine,TRUE);
+	return mrcp_engine_open_respond(engine,mrcp_engine_worker_pool_start(demo_engine->workers));
 }
 
 /** Close verification engine */
 static apt_bool_t demo_verifier_engine_close(mrcp_engine_t *engine)
 {
 	demo_verifier_engine_t *demo_engine = engine->obj;
-	if(demo_engine->task) {
-		apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-		apt_task_terminate(task,TRUE);
+	if(demo_engine->workers) {
+		mrcp_engine_worker_pool_terminate(demo_engine->workers);
 	}
 	return mrcp_engine_close_respond(engine);
 }
@@ -246,19 +231,22 @@ static apt_bool_t demo_verifier_channel_destroy(mrcp_engine_channel_t *channel)
 /** Open engine channel (asynchronous response MUST be sent)*/
 static apt_bool_t demo_verifier_channel_open(mrcp_engine_channel_t *channel)
 {
-	return demo_verifier_msg_signal(DEMO_VERIF_MSG_OPEN_CHANNEL,channel,NULL);
+	demo_verifier_channel_t *demo_channel = channel->method_obj;
+	return mrcp_engine_worker_channel_open(demo_channel->demo_engine->workers,channel);
 }
 
 /** Close engine channel (asynchronous response MUST be sent)*/
 static apt_bool_t demo_verifier_channel_close(mrcp_engine_channel_t *channel)
 {
-	return demo_verifier_msg_signal(DEMO_VERIF_MSG_CLOSE_CHANNEL,channel,NULL);
+	demo_verifier_channel_t *demo_channel = channel->method_obj;
+	return mrcp_engine_worker_channel_close(demo_channel->demo_engine->workers,channel);
 }
 
 /** Process MRCP channel request (asynchronous response MUST be sent)*/
 static apt_bool_t demo_verifier_channel_request_process(mrcp_engine_channel_t *channel, mrcp_message_t *request)
 {
-	return demo_verifier_msg_signal(DEMO_VERIF_MSG_REQUEST_PROCESS,channel,request);
+	demo_verifier_channel_t *demo_channel = channel->method_obj;
+	return mrcp_engine_worker_request_process(demo_channel->demo_engine->workers,channel,request);
 }
 
 /** Process VERIFY request */
@@ -546,51 +534,14 @@ static apt_bool_t demo_verifier_stream_write(mpf_audio_stream_t *stream, const m
 	return TRUE;
 }
 
-static apt_bool_t demo_verifier_msg_signal(demo_verifier_msg_type_e type, mrcp_engine_channel_t *channel, mrcp_message_t *request)
+/** Close channel, make sure there is no activity and send asynch response */
+static apt_bool_t demo_verifier_channel_close_process(mrcp_engine_channel_t *channel)
 {
-	apt_bool_t status = FALSE;
-	demo_verifier_channel_t *demo_channel = channel->method_obj;
-	demo_verifier_engine_t *demo_engine = demo_channel->demo_engine;
-	apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
-	apt_task_msg_t *msg = apt_task_msg_get(task);
-	if(msg) {
-		demo_verifier_msg_t *demo_msg;
-		msg->type = TASK_MSG_USER;
-		demo_msg = (demo_verifier_msg_t*) msg->data;
-
-		demo_msg->type = type;
-		demo_msg->channel = channel;
-		demo_msg->request = request;
-		status = apt_task_msg_signal(task,msg);
+	demo_verifier_channel_t *verifier_channel = channel->method_obj;
+	if(verifier_channel->audio_out) {
+		fclose(verifier_channel->audio_out);
+		verifier_channel->audio_out = NULL;
 	}
-	return status;
-}
 
-static apt_bool_t demo_verifier_msg_process(apt_task_t *task, apt_task_msg_t *msg)
-{
-	demo_verifier_msg_t *demo_msg = (demo_verifier_msg_t*)msg->data;
-	switch(demo_msg->type) {
-		case DEMO_VERIF_MSG_OPEN_CHANNEL:
-			/* open channel and send asynch response */
-			mrcp_engine_channel_open_respond(demo_msg->channel,TRUE);
-			break;
-		case DEMO_VERIF_MSG_CLOSE_CHANNEL:
-		{
-			/* close channel, make sure there is no activity and send asynch response */
-			demo_verifier_channel_t *verifier_channel = demo_msg->channel->method_obj;
-			if(verifier_channel->audio_out) {
-				fclose(verifier_channel->audio_out);
-				verifier_channel->audio_out = NULL;
-			}
-
-			mrcp_engine_channel_close_respond(demo_msg->channel);
-			break;
-		}
-		case DEMO_VERIF_MSG_REQUEST_PROCESS:
-			demo_verifier_channel_request_dispatch(demo_msg->channel,demo_msg->request);
-			break;
-		default:
-			break;
-	}
-	return TRUE;
+	return mrcp_engine_channel_close_respond(channel);
 }
@@ -20,6 +20,12 @@
 apt_test_suite_t* task_test_suite_create(apr_pool_t *pool);
 apt_test_suite_t* consumer_task_test_suite_create(apr_pool_t *pool);
 apt_test_suite_t* multipart_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* pollset_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* timer_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* pool_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* nlsml_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* text_template_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* text_message_test_suite_create(apr_pool_t *pool);
 
 int main(int argc, const char * const *argv)
 {
@@ -46,6 +52,24 @@ int main(int argc, const char * const *argv)
 	test_suite = multipart_test_suite_create(pool);
 	apt_test_framework_suite_add(test_framework,test_suite);
 
+	test_suite = pollset_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = timer_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = pool_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = nlsml_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = text_template_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = text_message_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
 	/* run tests */
 	apt_test_framework_run(test_framework,argc,argv);
 
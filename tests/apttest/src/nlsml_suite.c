@@ -0,0 +1,320 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include "apt_test_suite.h"
+#include "apt_nlsml_doc.h"
+#include "apt_pool.h"
+#include "apt_log.h"
+
+/** Default number of parsing iterations */
+#define NLSML_TEST_COUNT 10000
+
+/** Sample NLSML results */
+static const char *nlsml_test_samples[] = {
+	"<?xml version=\"1.0\"?>\r\n"
+	"<result>\r\n"
+	"  <interpretation grammar=\"session:request1@form-level.store\" confidence=\"0.97\">\r\n"
+	"    <instance>one</instance>\r\n"
+	"    <input mode=\"speech\">one</input>\r\n"
+	"  </interpretation>\r\n"
+	"</result>\r\n",
+
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r\n"
+	"<result xmlns=\"urn:ietf:params:xml:ns:mrcpv2\" grammar=\"session:request1@form-level.store\">\r\n"
+	"  <!-- n-best list -->\r\n"
+	"  <interpretation confidence=\"85\">\r\n"
+	"    <instance>call &lt;Anna&gt; &amp; Bob</instance>\r\n"
+	"    <input mode=\"speech\" confidence=\"0.85\" timestamp-start=\"2015-03-10T10:01:01.250\" timestamp-end=\"2015-03-10T10:01:02.750\">call anna and bob</input>\r\n"
+	"  </interpretation>\r\n"
+	"  <interpretation confidence=\"40\">\r\n"
+	"    <instance><![CDATA[call <Hannah>]]></instance>\r\n"
+	"    <instance>call Ann</instance>\r\n"
+	"    <input mode=\"speech\" confidence=\"0.40\">call hannah</input>\r\n"
+	"  </interpretation>\r\n"
+	"</result>\r\n",
+
+	"<?xml version=\"1.0\"?>\r\n"
+	"<result grammar=\"builtin:dtmf/digits\">\r\n"
+	"  <interpretation>\r\n"
+	"    <instance>1234</instance>\r\n"
+	"    <input mode=\"dtmf\">1 2 3 4</input>\r\n"
+	"  </interpretation>\r\n"
+	"</result>\r\n"
+};
+
+#define NLSML_TEST_SAMPLE_COUNT (sizeof(nlsml_test_samples) / sizeof(nlsml_test_samples[0]))
+
+/** Sample NLSML result with a structured instance */
+typedef struct nlsml_structured_sample_t nlsml_structured_sample_t;
+struct nlsml_structured_sample_t {
+	/** NLSML result holding a single instance */
+	const char *data;
+	/** Content of the instance generated from the XML tree */
+	const char *tree_instance;
+	/** Content of the instance kept by the single-pass parser */
+	const char *fast_instance;
+};
+
+/** Sample NLSML results with SISR instances */
+static const nlsml_structured_sample_t nlsml_structured_samples[] = {
+	{
+		"<?xml version=\"1.0\"?>\r\n"
+		"<result>\r\n"
+		"  <interpretation grammar=\"session:request1@form-level.store\" confidence=\"0.90\">\r\n"
+		"    <instance><city>Boston</city></instance>\r\n"
+		"    <input mode=\"speech\">boston</input>\r\n"
+		"  </interpretation>\r\n"
+		"</result>\r\n",
+		"<city>Boston</city>",
+		"<city>Boston</city>"
+	},
+	{
+		"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r\n"
+		"<result xmlns=\"urn:ietf:params:xml:ns:mrcpv2\" grammar=\"session:request1@form-level.store\">\r\n"
+		"  <interpretation confidence=\"0.80\">\r\n"
+		"    <instance><city>Boston</city><state>MA</state></instance>\r\n"
+		"    <input mode=\"speech\">boston massachusetts</input>\r\n"
+		"  </interpretation>\r\n"
+		"</result>\r\n",
+		"<ns0:city>Boston</ns0:city><ns0:state>MA</ns0:state>",
+		"<city>Boston</city><state>MA</state>"
+	},
+	{
+		"<?xml version=\"1.0\"?>\r\n"
+		"<result>\r\n"
+		"  <interpretation confidence=\"0.70\">\r\n"
+		"    <instance><company type=\"telecom\">AT&amp;T</company></instance>\r\n"
+		"    <input mode=\"speech\">a t and t</input>\r\n"
+		"  </interpretation>\r\n"
+		"</result>\r\n",
+		"<company type=\"telecom\">AT&T</company>",
+		"<company type=\"telecom\">AT&amp;T</company>"
+	}
+};
+
+#define NLSML_STRUCTURED_SAMPLE_COUNT (sizeof(nlsml_structured_samples) / sizeof(nlsml_structured_samples[0]))
+
+static apt_bool_t nlsml_test_str_compare(const char *name, const char *tree_value, const char *fast_value)
+{
+	if(tree_value == fast_value)
+		return TRUE;
+	if(tree_value && fast_value && strcmp(tree_value,fast_value) == 0)
+		return TRUE;
+
+	apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"NLSML Mismatch %s [%s] [%s]",
+		name,
+		tree_value ? tree_value : "null",
+		fast_value ? fast_value : "null");
+	return FALSE;
+}
+
+/** Compare the results of the tree-based and single-pass parsers, the structured sample is NULL for plain instances */
+static apt_bool_t nlsml_test_compare(const nlsml_result_t *tree, const nlsml_result_t *fast, const nlsml_structured_sample_t *structured, apr_pool_t *pool)
+{
+	nlsml_interpretation_t *tree_interpretation;
+	nlsml_interpretation_t *fast_interpretation;
+	nlsml_instance_t *tree_instance;
+	nlsml_instance_t *fast_instance;
+	nlsml_input_t *tree_input;
+	nlsml_input_t *fast_input;
+
+	if(nlsml_test_str_compare("result grammar",nlsml_result_grammar_get(tree),nlsml_result_grammar_get(fast)) == FALSE)
+		return FALSE;
+
+	tree_interpretation = nlsml_first_interpretation_get(tree);
+	fast_interpretation = nlsml_first_interpretation_get(fast);
+	while(tree_interpretation && fast_interpretation) {
+		if(nlsml_test_str_compare("interpretation grammar",
+				nlsml_interpretation_grammar_get(tree_interpretation),
+				nlsml_interpretation_grammar_get(fast_interpretation)) == FALSE)
+			return FALSE;
+		if(nlsml_interpretation_confidence_get(tree_interpretation) != nlsml_interpretation_confidence_get(fast_interpretation)) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"NLSML Mismatch interpretation confidence");
+			return FALSE;
+		}
+
+		tree_instance = nlsml_interpretation_first_instance_get(tree_interpretation);
+		fast_instance = nlsml_interpretation_first_instance_get(fast_interpretation);
+		while(tree_instance && fast_instance) {
+			if(structured) {
+				/* structured content differs by design, check either one against the expected content */
+				if(nlsml_test_str_compare("tree instance",
+						structured->tree_instance,
+						nlsml_instance_content_generate(tree_instance,pool)) == FALSE ||
+					nlsml_test_str_compare("fast instance",
+						structured->fast_instance,
+						nlsml_instance_content_generate(fast_instance,pool)) == FALSE)
+					return FALSE;
+			}
+			else if(nlsml_test_str_compare("instance",
+					nlsml_instance_content_generate(tree_instance,pool),
+					nlsml_instance_content_generate(fast_instance,pool)) == FALSE)
+				return FALSE;
+			tree_instance = nlsml_interpretation_next_instance_get(tree_interpretation,tree_instance);
+			fast_instance = nlsml_interpretation_next_instance_get(fast_interpretation,fast_instance);
+		}
+		if(tree_instance || fast_instance) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"NLSML Mismatch number of instances");
+			return FALSE;
+		}
+
+		tree_input = nlsml_interpretation_input_get(tree_interpretation);
+		fast_input = nlsml_interpretation_input_get(fast_interpretation);
+		if(tree_input && fast_input) {
+			if(nlsml_test_str_compare("input",
+					nlsml_input_content_generate(tree_input,pool),
+					nlsml_input_content_generate(fast_input,pool)) == FALSE ||
+				nlsml_test_str_compare("input mode",
+					nlsml_input_mode_get(tree_input),
+					nlsml_input_mode_get(fast_input)) == FALSE ||
+				nlsml_test_str_compare("input timestamp-start",
+					nlsml_input_timestamp_start_get(tree_input),
+					nlsml_input_timestamp_start_get(fast_input)) == FALSE ||
+				nlsml_test_str_compare("input timestamp-end",
+					nlsml_input_timestamp_end_get(tree_input),
+					nlsml_input_timestamp_end_get(fast_input)) == FALSE)
+				return FALSE;
+			if(nlsml_input_confidence_get(tree_input) != nlsml_input_confidence_get(fast_input)) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"NLSML Mismatch input confidence");
+				return FALSE;
+			}
+		}
+		else if(tree_input || fast_input) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"NLSML Mismatch input");
+			return FALSE;
+		}
+
+		tree_interpretation = nlsml_next_interpretation_get(tree,tree_interpretation);
+		fast_interpretation = nlsml_next_interpretation_get(fast,fast_interpretation);
+	}
+	if(tree_interpretation || fast_interpretation) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"NLSML Mismatch number of interpretations");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+typedef nlsml_result_t* (*nlsml_parse_f)(const char *data, apr_size_t length, apr_pool_t *pool);
+
+/** Parse the sample reading the content of the instances */
+static void nlsml_test_sample_read(nlsml_parse_f parse, const char *data, apr_pool_t *pool)
+{
+	nlsml_interpretation_t *interpretation;
+	nlsml_instance_t *instance;
+	nlsml_result_t *result = parse(data,strlen(data),pool);
+	if(result) {
+		for(interpretation = nlsml_first_interpretation_get(result);
+			interpretation;
+			interpretation = nlsml_next_interpretation_get(result,interpretation)) {
+			instance = nlsml_interpretation_first_instance_get(interpretation);
+			if(instance) {
+				nlsml_instance_content_generate(instance,pool);
+			}
+		}
+	}
+	apr_pool_clear(pool);
+}
+
+/** Parse the samples the specified number of times reading the content of the instances */
+static apr_interval_time_t nlsml_test_time(nlsml_parse_f parse, apr_size_t count, apr_pool_t *pool)
+{
+	apr_size_t i;
+	apr_size_t j;
+	apr_time_t start = apr_time_now();
+	for(i = 0; i < count; i++) {
+		for(j = 0; j < NLSML_TEST_SAMPLE_COUNT; j++) {
+			nlsml_test_sample_read(parse,nlsml_test_samples[j],pool);
+		}
+		for(j = 0; j < NLSML_STRUCTURED_SAMPLE_COUNT; j++) {
+			nlsml_test_sample_read(parse,nlsml_structured_samples[j].data,pool);
+		}
+	}
+	return apr_time_now() - start;
+}
+
+static apt_bool_t nlsml_suite_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apr_size_t i;
+	apr_pool_t *pool;
+	apr_pool_t *subpool;
+	nlsml_result_t *tree;
+	nlsml_result_t *fast;
+	apr_interval_time_t tree_elapsed;
+	apr_interval_time_t fast_elapsed;
+	apr_size_t count = NLSML_TEST_COUNT;
+	if(argc > 0) {
+		count = atol(argv[0]);
+		if(!count) {
+			count = NLSML_TEST_COUNT;
+		}
+	}
+
+	pool = apt_pool_create();
+	if(!pool)
+		return FALSE;
+	/* the root pool is not to be cleared, clear a subpool of it instead */
+	subpool = apt_subpool_create(pool);
+	if(!subpool) {
+		apr_pool_destroy(pool);
+		return FALSE;
+	}
+
+	for(i = 0; i < NLSML_TEST_SAMPLE_COUNT; i++) {
+		tree = nlsml_result_parse(nlsml_test_samples[i],strlen(nlsml_test_samples[i]),subpool);
+		fast = nlsml_result_fast_parse(nlsml_test_samples[i],strlen(nlsml_test_samples[i]),subpool);
+		if(!tree || !fast || nlsml_test_compare(tree,fast,NULL,subpool) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Match NLSML Sample [%"APR_SIZE_T_FMT"]",i);
+			apr_pool_destroy(pool);
+			return FALSE;
+		}
+		apr_pool_clear(subpool);
+	}
+
+	for(i = 0; i < NLSML_STRUCTURED_SAMPLE_COUNT; i++) {
+		const nlsml_structured_sample_t *sample = &nlsml_structured_samples[i];
+		tree = nlsml_result_parse(sample->data,strlen(sample->data),subpool);
+		fast = nlsml_result_fast_parse(sample->data,strlen(sample->data),subpool);
+		if(!tree || !fast || nlsml_test_compare(tree,fast,sample,subpool) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Match Structured NLSML Sample [%"APR_SIZE_T_FMT"]",i);
+			apr_pool_destroy(pool);
+			return FALSE;
+		}
+		apr_pool_clear(subpool);
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Run NLSML Parser Test [%"APR_SIZE_T_FMT" x %d documents]",
+		count,
+		(int)(NLSML_TEST_SAMPLE_COUNT + NLSML_STRUCTURED_SAMPLE_COUNT));
+	tree_elapsed = nlsml_test_time(nlsml_result_parse,count,subpool);
+	fast_elapsed = nlsml_test_time(nlsml_result_fast_parse,count,subpool);
+	count *= NLSML_TEST_SAMPLE_COUNT + NLSML_STRUCTURED_SAMPLE_COUNT;
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"NLSML Tree Parser: elapsed [%"APR_TIME_T_FMT" usec] avg [%"APR_TIME_T_FMT" nsec]",
+		tree_elapsed,
+		tree_elapsed * 1000 / (apr_interval_time_t)count);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"NLSML Single-pass Parser: elapsed [%"APR_TIME_T_FMT" usec] avg [%"APR_TIME_T_FMT" nsec]",
+		fast_elapsed,
+		fast_elapsed * 1000 / (apr_interval_time_t)count);
+
+	apr_pool_destroy(pool);
+	return TRUE;
+}
+
+apt_test_suite_t* nlsml_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"nlsml",NULL,nlsml_suite_run);
+	return suite;
+}
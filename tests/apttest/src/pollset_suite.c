@@ -0,0 +1,331 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include "apt_test_suite.h"
+#include "apt_pollset.h"
+#include "apt_log.h"
+
+/** Default number of iterations */
+#define POLLSET_TEST_ITERATIONS 1000
+
+/** Timeouts (usec) to check the poll call against, including ones not multiple of a millisecond */
+static const apr_interval_time_t pollset_test_timeouts[] = {500, 1500, 10000};
+
+typedef struct pollset_wakeup_test_t pollset_wakeup_test_t;
+struct pollset_wakeup_test_t {
+	apt_pollset_t      *pollset;
+	apr_thread_mutex_t *mutex;
+	apr_time_t          signal_time;
+	apr_size_t          iterations;
+};
+
+static void* APR_THREAD_FUNC pollset_wakeup_thread_proc(apr_thread_t *thread, void *data)
+{
+	pollset_wakeup_test_t *test = data;
+	apr_size_t i;
+	for(i = 0; i < test->iterations; i++) {
+		/* let the poller block first */
+		apr_sleep(1000);
+
+		apr_thread_mutex_lock(test->mutex);
+		test->signal_time = apr_time_now();
+		apr_thread_mutex_unlock(test->mutex);
+		apt_pollset_wakeup(test->pollset);
+	}
+	apr_thread_exit(thread,APR_SUCCESS);
+	return NULL;
+}
+
+/** Measure the time elapsed from the wakeup of the pollset till the return of the blocked poll call */
+static apt_bool_t pollset_wakeup_test_run(apt_pollset_t *pollset, apr_size_t iterations, apr_pool_t *pool)
+{
+	pollset_wakeup_test_t test;
+	apr_thread_t *thread;
+	apr_status_t rv;
+	apr_int32_t num;
+	apr_int32_t i;
+	const apr_pollfd_t *descriptors;
+	apr_size_t count = 0;
+	apr_interval_time_t latency;
+	apr_interval_time_t total = 0;
+	apr_interval_time_t max = 0;
+
+	test.pollset = pollset;
+	test.signal_time = 0;
+	test.iterations = iterations;
+	if(apr_thread_mutex_create(&test.mutex,APR_THREAD_MUTEX_DEFAULT,pool) != APR_SUCCESS) {
+		return FALSE;
+	}
+	if(apr_thread_create(&thread,NULL,pollset_wakeup_thread_proc,&test,pool) != APR_SUCCESS) {
+		apr_thread_mutex_destroy(test.mutex);
+		return FALSE;
+	}
+
+	while(count < iterations) {
+		rv = apt_pollset_poll(pollset,-1,&num,&descriptors);
+		if(rv != APR_SUCCESS) {
+			continue;
+		}
+		for(i = 0; i < num; i++) {
+			if(apt_pollset_is_wakeup(pollset,&descriptors[i]) == TRUE) {
+				apr_thread_mutex_lock(test.mutex);
+				latency = apr_time_now() - test.signal_time;
+				apr_thread_mutex_unlock(test.mutex);
+
+				total += latency;
+				if(latency > max) {
+					max = latency;
+				}
+				count++;
+			}
+		}
+	}
+
+	apr_thread_join(&rv,thread);
+	apr_thread_mutex_destroy(test.mutex);
+	if(!count) {
+		return FALSE;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Wakeup Latency [%s]: avg [%"APR_TIME_T_FMT" usec] max [%"APR_TIME_T_FMT" usec] wakeups [%"APR_SIZE_T_FMT"]",
+		apt_pollset_method_name_get(pollset),
+		total / count,
+		max,
+		count);
+	return TRUE;
+}
+
+/** Check the poll call returns neither before the timeout elapses nor with any descriptor signalled */
+static apt_bool_t pollset_timeout_test_run(apt_pollset_t *pollset)
+{
+	apr_status_t rv;
+	apr_int32_t num;
+	const apr_pollfd_t *descriptors;
+	apr_time_t start;
+	apr_interval_time_t elapsed;
+	apr_size_t i;
+
+	for(i = 0; i < sizeof(pollset_test_timeouts) / sizeof(pollset_test_timeouts[0]); i++) {
+		start = apr_time_now();
+		rv = apt_pollset_poll(pollset,pollset_test_timeouts[i],&num,&descriptors);
+		elapsed = apr_time_now() - start;
+		if(!APR_STATUS_IS_TIMEUP(rv) || num != 0) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Poll Result [%s]: status [%d] descriptors [%d]",
+				apt_pollset_method_name_get(pollset),rv,num);
+			return FALSE;
+		}
+		if(elapsed < pollset_test_timeouts[i]) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Poll Returned Early [%s]: timeout [%"APR_TIME_T_FMT" usec] elapsed [%"APR_TIME_T_FMT" usec]",
+				apt_pollset_method_name_get(pollset),pollset_test_timeouts[i],elapsed);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+#ifndef WIN32
+/** Check the same descriptor cannot be added twice */
+static apt_bool_t pollset_duplicate_test_run(apr_uint32_t flags, apr_pool_t *pool)
+{
+	apt_bool_t status = TRUE;
+	apt_pollset_t *pollset;
+	apr_pollfd_t pfd;
+	apr_file_t *pipe_out;
+
+	pollset = apt_pollset_create_ex(2,flags,pool);
+	if(!pollset) {
+		return FALSE;
+	}
+	if(strncmp(apt_pollset_method_name_get(pollset),"epoll",5) != 0) {
+		/* generic pollsets may not detect duplicates */
+		apt_pollset_destroy(pollset);
+		return TRUE;
+	}
+
+	memset(&pfd,0,sizeof(pfd));
+	if(apr_file_pipe_create(&pfd.desc.f,&pipe_out,pool) != APR_SUCCESS) {
+		apt_pollset_destroy(pollset);
+		return FALSE;
+	}
+	pfd.desc_type = APR_POLL_FILE;
+	pfd.reqevents = APR_POLLIN;
+	if(apt_pollset_add(pollset,&pfd) != TRUE) {
+		status = FALSE;
+	}
+	else {
+		if(apt_pollset_add(pollset,&pfd) == TRUE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Duplicate Descriptor Added [%s]",apt_pollset_method_name_get(pollset));
+			status = FALSE;
+		}
+		/* the duplicate must not affect the registered descriptor */
+		if(apt_pollset_remove(pollset,&pfd) != TRUE || apt_pollset_remove(pollset,&pfd) == TRUE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Removal Result [%s]",apt_pollset_method_name_get(pollset));
+			status = FALSE;
+		}
+	}
+
+	apr_file_close(pipe_out);
+	apr_file_close(pfd.desc.f);
+	apt_pollset_destroy(pollset);
+	return status;
+}
+
+/** Measure the cost of the poll call depending on the number of registered descriptors */
+static apt_bool_t pollset_scalability_test_run(apr_uint32_t flags, apr_size_t desc_count, apr_size_t iterations, apr_pool_t *pool)
+{
+	apr_pool_t *subpool;
+	apt_pollset_t *pollset;
+	apr_pollfd_t *pfds;
+	apr_file_t **pipes_out;
+	apr_int32_t num;
+	const apr_pollfd_t *descriptors;
+	apr_time_t start;
+	apr_interval_time_t add_time;
+	apr_interval_time_t poll_time;
+	apr_size_t i;
+	apr_size_t signalled = 0;
+	apr_size_t missed = 0;
+	char c = 0;
+	apr_size_t len;
+
+	if(apr_pool_create(&subpool,pool) != APR_SUCCESS) {
+		return FALSE;
+	}
+
+	pollset = apt_pollset_create_ex((apr_uint32_t)desc_count,flags,subpool);
+	if(!pollset) {
+		apr_pool_destroy(subpool);
+		return FALSE;
+	}
+
+	pfds = apr_pcalloc(subpool,sizeof(apr_pollfd_t) * desc_count);
+	pipes_out = apr_pcalloc(subpool,sizeof(apr_file_t*) * desc_count);
+	for(i = 0; i < desc_count; i++) {
+		if(apr_file_pipe_create(&pfds[i].desc.f,&pipes_out[i],subpool) != APR_SUCCESS) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Pipe [%"APR_SIZE_T_FMT"]",i);
+			desc_count = i;
+			break;
+		}
+		apr_file_pipe_timeout_set(pfds[i].desc.f,0);
+		pfds[i].desc_type = APR_POLL_FILE;
+		pfds[i].reqevents = APR_POLLIN;
+		pfds[i].client_data = pipes_out[i];
+	}
+
+	start = apr_time_now();
+	for(i = 0; i < desc_count; i++) {
+		apt_pollset_add(pollset,&pfds[i]);
+	}
+	add_time = apr_time_now() - start;
+
+	/* signal one random descriptor per iteration */
+	start = apr_time_now();
+	for(i = 0; desc_count && i < iterations; i++) {
+		apr_size_t index = rand() % desc_count;
+		len = sizeof(c);
+		apr_file_write(pipes_out[index],&c,&len);
+		if(apt_pollset_poll(pollset,-1,&num,&descriptors) == APR_SUCCESS && num > 0) {
+			signalled += num;
+			len = sizeof(c);
+			apr_file_read(pfds[index].desc.f,&c,&len);
+		}
+		/* exactly the signalled descriptor is expected to be reported */
+		if(num != 1 || descriptors[0].client_data != pipes_out[index]) {
+			missed++;
+		}
+	}
+	poll_time = apr_time_now() - start;
+
+	for(i = 0; i < desc_count; i++) {
+		apt_pollset_remove(pollset,&pfds[i]);
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Scalability [%s] descriptors [%"APR_SIZE_T_FMT"]: add [%"APR_TIME_T_FMT" usec] poll avg [%"APR_TIME_T_FMT" nsec] signalled [%"APR_SIZE_T_FMT"]",
+		apt_pollset_method_name_get(pollset),
+		desc_count,
+		add_time,
+		iterations ? poll_time * 1000 / (apr_interval_time_t)iterations : 0,
+		signalled);
+
+	apt_pollset_destroy(pollset);
+	apr_pool_destroy(subpool);
+	if(missed) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Events Not Delivered [%"APR_SIZE_T_FMT"]",missed);
+		return FALSE;
+	}
+	return TRUE;
+}
+#endif
+
+static apt_bool_t pollset_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apt_bool_t status = TRUE;
+	apt_pollset_t *pollset;
+	apr_size_t iterations = POLLSET_TEST_ITERATIONS;
+#ifndef WIN32
+	apr_size_t desc_count;
+#endif
+
+	if(argc > 0) {
+		iterations = atol(argv[0]);
+		if(!iterations) {
+			iterations = POLLSET_TEST_ITERATIONS;
+		}
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Run Wakeup Latency Test [%"APR_SIZE_T_FMT" iterations]",iterations);
+	pollset = apt_pollset_create(1,suite->pool);
+	if(!pollset) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Pollset");
+		return FALSE;
+	}
+	if(pollset_wakeup_test_run(pollset,iterations,suite->pool) != TRUE) {
+		status = FALSE;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Run Timeout Test");
+	if(pollset_timeout_test_run(pollset) != TRUE) {
+		status = FALSE;
+	}
+	apt_pollset_destroy(pollset);
+
+#ifndef WIN32
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Run Duplicate Descriptor Test");
+	if(pollset_duplicate_test_run(0,suite->pool) != TRUE ||
+		pollset_duplicate_test_run(APT_POLLSET_FLAG_EDGE_TRIGGERED,suite->pool) != TRUE) {
+		status = FALSE;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Run Descriptor Scalability Test [%"APR_SIZE_T_FMT" iterations]",iterations);
+	for(desc_count = 16; desc_count <= 1024; desc_count *= 4) {
+		if(pollset_scalability_test_run(0,desc_count,iterations,suite->pool) != TRUE ||
+			pollset_scalability_test_run(APT_POLLSET_FLAG_EDGE_TRIGGERED,desc_count,iterations,suite->pool) != TRUE) {
+			status = FALSE;
+		}
+	}
+#endif
+	return status;
+}
+
+apt_test_suite_t* pollset_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"pollset",NULL,pollset_test_run);
+	return suite;
+}
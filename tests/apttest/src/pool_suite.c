@@ -0,0 +1,260 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <apr_thread_proc.h>
+#include "apt_test_suite.h"
+#include "apt_pool.h"
+#include "apt_log.h"
+
+/** Default number of pools */
+#define POOL_TEST_COUNT       10000
+/** Number of allocations per pool */
+#define POOL_TEST_ALLOC_COUNT 64
+/** Max size of an allocation */
+#define POOL_TEST_ALLOC_SIZE  256
+/** Number of threads sharing the pools */
+#define POOL_TEST_THREAD_COUNT 4
+
+typedef struct pool_thread_test_t pool_thread_test_t;
+struct pool_thread_test_t {
+	/** Root pool the threads create subpools of */
+	apr_pool_t          *root;
+	/** Recycler the threads acquire pools from */
+	apt_pool_recycler_t *recycler;
+	/** Allocator type of the pools created by the threads */
+	apt_pool_allocator_e type;
+	/** Number of iterations per thread */
+	apr_size_t           count;
+	/** Pools created by the threads and destroyed by the main thread */
+	apr_pool_t         **handed_pools;
+	/** Number of failures */
+	apr_size_t           failures[POOL_TEST_THREAD_COUNT];
+};
+
+typedef struct pool_thread_arg_t pool_thread_arg_t;
+struct pool_thread_arg_t {
+	pool_thread_test_t *test;
+	apr_size_t          index;
+};
+
+/** Allocate memory from the pool and check it's not overwritten by anybody else */
+static apt_bool_t pool_test_alloc(apr_pool_t *pool, apr_size_t index)
+{
+	apr_size_t j;
+	apr_size_t size;
+	unsigned char *buf[POOL_TEST_ALLOC_COUNT];
+	apr_size_t sizes[POOL_TEST_ALLOC_COUNT];
+	for(j = 0; j < POOL_TEST_ALLOC_COUNT; j++) {
+		/* rand() is not used, since it's not reentrant */
+		size = 1 + (index * 31 + j * 17) % POOL_TEST_ALLOC_SIZE;
+		buf[j] = apr_palloc(pool,size);
+		if(!buf[j]) {
+			return FALSE;
+		}
+		memset(buf[j],(int)(index + j) & 0xFF,size);
+		sizes[j] = size;
+	}
+	for(j = 0; j < POOL_TEST_ALLOC_COUNT; j++) {
+		for(size = 0; size < sizes[j]; size++) {
+			if(buf[j][size] != ((index + j) & 0xFF)) {
+				return FALSE;
+			}
+		}
+	}
+	return TRUE;
+}
+
+static void* APR_THREAD_FUNC pool_thread_proc(apr_thread_t *thread, void *data)
+{
+	pool_thread_arg_t *arg = data;
+	pool_thread_test_t *test = arg->test;
+	apr_pool_t *pool;
+	apr_size_t i;
+	for(i = 0; i < test->count; i++) {
+		/* subpool of the pool shared across the threads */
+		pool = apt_subpool_create(test->root);
+		if(!pool || pool_test_alloc(pool,arg->index) == FALSE) {
+			test->failures[arg->index]++;
+		}
+		if(pool) {
+			apr_pool_destroy(pool);
+		}
+
+		/* pool acquired from and released to the recycler shared across the threads */
+		pool = apt_pool_recycler_acquire(test->recycler);
+		if(!pool || pool_test_alloc(pool,arg->index) == FALSE) {
+			test->failures[arg->index]++;
+		}
+		apt_pool_recycler_release(test->recycler,pool);
+	}
+
+	/* pool created by this thread, destroyed by the main thread */
+	pool = apt_pool_create_ex(test->type,0);
+	if(!pool || pool_test_alloc(pool,arg->index) == FALSE) {
+		test->failures[arg->index]++;
+	}
+	test->handed_pools[arg->index] = pool;
+
+	apr_thread_exit(thread,APR_SUCCESS);
+	return NULL;
+}
+
+/** Create and destroy pools of the specified type from multiple threads at once */
+static apt_bool_t pool_thread_test_run(apt_pool_allocator_e type, apr_size_t count)
+{
+	pool_thread_test_t test;
+	pool_thread_arg_t args[POOL_TEST_THREAD_COUNT];
+	apr_thread_t *threads[POOL_TEST_THREAD_COUNT];
+	apr_pool_t *pool;
+	apr_status_t rv;
+	apr_size_t i;
+	apr_size_t failures = 0;
+	apr_size_t active_before = 0;
+	apr_size_t active = 0;
+
+	apt_pool_stats_get(type,NULL,&active_before);
+	pool = apt_pool_create();
+	test.root = apt_pool_create_ex(type,0);
+	if(!pool || !test.root) {
+		return FALSE;
+	}
+	test.recycler = apt_pool_recycler_create_ex(POOL_TEST_THREAD_COUNT / 2,type == APT_POOL_ALLOCATOR_OWN ? TRUE : FALSE,pool);
+	test.type = type;
+	test.count = count / POOL_TEST_THREAD_COUNT;
+	test.handed_pools = apr_pcalloc(pool,sizeof(apr_pool_t*) * POOL_TEST_THREAD_COUNT);
+	for(i = 0; i < POOL_TEST_THREAD_COUNT; i++) {
+		test.failures[i] = 0;
+		args[i].test = &test;
+		args[i].index = i;
+		if(apr_thread_create(&threads[i],NULL,pool_thread_proc,&args[i],pool) != APR_SUCCESS) {
+			threads[i] = NULL;
+			failures++;
+		}
+	}
+	for(i = 0; i < POOL_TEST_THREAD_COUNT; i++) {
+		if(threads[i]) {
+			apr_thread_join(&rv,threads[i]);
+		}
+		if(test.handed_pools[i]) {
+			apr_pool_destroy(test.handed_pools[i]);
+		}
+		failures += test.failures[i];
+	}
+	apr_pool_destroy(test.root);
+	apr_pool_destroy(pool);
+
+	apt_pool_stats_get(type,NULL,&active);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Pool Allocator [%s] Shared by [%d] Threads: failures [%"APR_SIZE_T_FMT"]",
+		apt_pool_allocator_type_name_get(type),
+		POOL_TEST_THREAD_COUNT,
+		failures);
+	if(failures || active != active_before) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Pool Thread Test Failed [%s]: active [%"APR_SIZE_T_FMT"] expected [%"APR_SIZE_T_FMT"]",
+			apt_pool_allocator_type_name_get(type),
+			active,
+			active_before);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Create pools of the specified type, allocate memory from them and destroy them */
+static apt_bool_t pool_test_run(apt_pool_allocator_e type, apr_size_t count)
+{
+	apr_size_t i;
+	apr_size_t j;
+	apr_pool_t *pool;
+	apr_size_t created_before = 0;
+	apr_size_t active_before = 0;
+	apr_size_t created = 0;
+	apr_size_t active = 0;
+	apr_time_t start;
+	apr_interval_time_t elapsed;
+
+	apt_pool_stats_get(type,&created_before,&active_before);
+
+	start = apr_time_now();
+	for(i = 0; i < count; i++) {
+		pool = apt_pool_create_ex(type,0);
+		if(!pool) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Pool [%s]",apt_pool_allocator_type_name_get(type));
+			return FALSE;
+		}
+		for(j = 0; j < POOL_TEST_ALLOC_COUNT; j++) {
+			apr_palloc(pool,1 + rand() % POOL_TEST_ALLOC_SIZE);
+		}
+		apr_pool_destroy(pool);
+	}
+	elapsed = apr_time_now() - start;
+
+	apt_pool_stats_get(type,&created,&active);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Pool Allocator [%s]: pools [%"APR_SIZE_T_FMT"] elapsed [%"APR_TIME_T_FMT" usec] avg [%"APR_TIME_T_FMT" nsec]",
+		apt_pool_allocator_type_name_get(type),
+		count,
+		elapsed,
+		count ? elapsed * 1000 / (apr_interval_time_t)count : 0);
+
+	if(created - created_before != count || active != active_before) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Pool Counter Mismatch [%s]: created [%"APR_SIZE_T_FMT"] active [%"APR_SIZE_T_FMT"] expected [%"APR_SIZE_T_FMT"] [%"APR_SIZE_T_FMT"]",
+			apt_pool_allocator_type_name_get(type),
+			created - created_before,
+			active,
+			count,
+			active_before);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static apt_bool_t pool_suite_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	int i;
+	apt_bool_t status = TRUE;
+	apr_size_t count = POOL_TEST_COUNT;
+	if(argc > 0) {
+		count = atol(argv[0]);
+		if(!count) {
+			count = POOL_TEST_COUNT;
+		}
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Run Pool Allocator Test [%"APR_SIZE_T_FMT" pools]",count);
+	for(i = 0; i < APT_POOL_ALLOCATOR_COUNT; i++) {
+		if(pool_test_run(i,count) == FALSE) {
+			status = FALSE;
+		}
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Run Pool Thread Test [%d threads]",POOL_TEST_THREAD_COUNT);
+	for(i = 0; i < APT_POOL_ALLOCATOR_COUNT; i++) {
+		if(i == APT_POOL_ALLOCATOR_UNLOCKED) {
+			/* pools with unlocked allocator must not be shared across threads */
+			continue;
+		}
+		if(pool_thread_test_run(i,count) == FALSE) {
+			status = FALSE;
+		}
+	}
+	return status;
+}
+
+apt_test_suite_t* pool_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"pool",NULL,pool_suite_run);
+	return suite;
+}
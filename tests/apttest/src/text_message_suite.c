@@ -0,0 +1,245 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "apt_test_suite.h"
+#include "apt_text_message.h"
+#include "apt_log.h"
+
+/** Size of the receive buffer */
+#define TEXT_MESSAGE_BUFFER_SIZE 1024
+
+/** Compare float values */
+#define TEXT_MESSAGE_FLOAT_EQUAL(a,b) ((a) - (b) < 0.0001 && (b) - (a) < 0.0001)
+
+typedef struct text_message_t text_message_t;
+
+/** Message of the test, consisting of header section and body only */
+struct text_message_t {
+	/** Header section */
+	apt_header_section_t header;
+	/** Body */
+	apt_str_t            body;
+};
+
+/** Expected header field */
+typedef struct {
+	const char *name;
+	const char *value;
+} text_message_field_t;
+
+/* header fields with folded values, a field missing the colon and empty values */
+static const char text_message_sample[] =
+	"Content-Type: text/plain\r\n"
+	"Folded: first\r\n"
+	" second\r\n"
+	"\t  third\r\n"
+	"Missing-Colon\r\n"
+	"Empty:\r\n"
+	"Spaces:   \r\n"
+	"Trailing-Spaces:value  \r\n"
+	"Content-Length: 5\r\n"
+	"\r\n"
+	"hello";
+
+static const text_message_field_t text_message_sample_fields[] = {
+	{"Content-Type",    "text/plain"},
+	{"Folded",          "firstsecondthird"},
+	{"Empty",           ""},
+	{"Spaces",          ""},
+	{"Trailing-Spaces", "value  "},
+	{"Content-Length",  "5"}
+};
+
+static apt_bool_t text_message_on_start(apt_message_parser_t *parser, apt_message_context_t *context, apt_text_stream_t *stream, apr_pool_t *pool)
+{
+	text_message_t *message = apr_palloc(pool,sizeof(text_message_t));
+	apt_header_section_init(&message->header);
+	apt_string_reset(&message->body);
+	context->message = message;
+	context->header = &message->header;
+	context->body = &message->body;
+	return TRUE;
+}
+
+static apt_bool_t text_message_on_header_complete(apt_message_parser_t *parser, apt_message_context_t *context)
+{
+	text_message_t *message = context->message;
+	apt_header_field_t *header_field;
+	for(header_field = APR_RING_FIRST(&message->header.ring);
+			header_field != APR_RING_SENTINEL(&message->header.ring, apt_header_field_t, link);
+				header_field = APR_RING_NEXT(header_field, link)) {
+		if(strcasecmp(header_field->name.buf,"Content-Length") == 0) {
+			message->body.length = apt_size_value_parse(&header_field->value);
+		}
+	}
+	return TRUE;
+}
+
+static const apt_message_parser_vtable_t text_message_parser_vtable = {
+	text_message_on_start,
+	text_message_on_header_complete,
+	NULL
+};
+
+/** Check the header fields and the body of parsed message */
+static apt_bool_t text_message_verify(const text_message_t *message, const text_message_field_t *fields, apr_size_t field_count, const char *body)
+{
+	const apt_header_field_t *header_field;
+	apr_size_t i = 0;
+	for(header_field = APR_RING_FIRST(&message->header.ring);
+			header_field != APR_RING_SENTINEL(&message->header.ring, apt_header_field_t, link);
+				header_field = APR_RING_NEXT(header_field, link), i++) {
+		if(i >= field_count) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Header Field [%s]",header_field->name.buf);
+			return FALSE;
+		}
+		/* the names and the values are terminated either way they are parsed */
+		if(header_field->name.length != strlen(fields[i].name) || strcmp(header_field->name.buf,fields[i].name) != 0 ||
+			header_field->value.length != strlen(fields[i].value) || strcmp(header_field->value.buf,fields[i].value) != 0) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Header Field [%.*s: %.*s] expected [%s: %s]",
+				header_field->name.length,header_field->name.buf,
+				header_field->value.length,header_field->value.buf,
+				fields[i].name,fields[i].value);
+			return FALSE;
+		}
+	}
+	if(i != field_count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Missing Header Fields [%"APR_SIZE_T_FMT"] expected [%"APR_SIZE_T_FMT"]",i,field_count);
+		return FALSE;
+	}
+	if(message->body.length != strlen(body) || memcmp(message->body.buf,body,message->body.length) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Body [%.*s] expected [%s]",
+			message->body.length,message->body.buf,body);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Parse the sample received by two reads split at the specified offset (at once if 0) */
+static apt_bool_t text_message_split_parse(apt_test_suite_t *suite, apr_size_t split)
+{
+	char buffer[TEXT_MESSAGE_BUFFER_SIZE + 1];
+	apt_message_parser_t *parser = apt_message_parser_create(NULL,&text_message_parser_vtable,suite->pool);
+	apt_text_stream_t stream;
+	apt_message_status_e status = APT_MESSAGE_STATUS_INCOMPLETE;
+	void *message = NULL;
+	apr_size_t size = sizeof(text_message_sample) - 1;
+	apr_size_t segments[2];
+	apr_size_t pos = 0;
+	apr_size_t offset;
+	int i;
+
+	segments[0] = split ? split : size;
+	segments[1] = size - segments[0];
+	apt_text_stream_init(&stream,buffer,TEXT_MESSAGE_BUFFER_SIZE);
+	for(i = 0; i < 2 && segments[i]; i++) {
+		offset = stream.pos - stream.text.buf;
+		memcpy(stream.pos,text_message_sample + pos,segments[i]);
+		pos += segments[i];
+
+		stream.text.length = offset + segments[i];
+		stream.pos[segments[i]] = '\0';
+		apt_text_stream_reset(&stream);
+
+		status = apt_message_parser_run(parser,&stream,&message);
+		if(i == 0 && segments[1] && status != APT_MESSAGE_STATUS_INCOMPLETE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Status [%d] of the first read [%"APR_SIZE_T_FMT" bytes]",status,split);
+			return FALSE;
+		}
+		apt_text_stream_scroll(&stream);
+	}
+
+	if(status != APT_MESSAGE_STATUS_COMPLETE || !message) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Parse Message split at [%"APR_SIZE_T_FMT"]",split);
+		return FALSE;
+	}
+	if(text_message_verify(message,text_message_sample_fields,
+			sizeof(text_message_sample_fields) / sizeof(text_message_sample_fields[0]),"hello") == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Message split at [%"APR_SIZE_T_FMT"]",split);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Parse values which are not terminated right after their length */
+static apt_bool_t text_message_value_parse_test(void)
+{
+	/* the values are at the end of the buffers, without terminator */
+	const char size_buf[] = {' ','4','2','7'};
+	const char float_buf[] = {'0','.','7','5'};
+	apt_str_t str;
+
+	str.buf = (char*)size_buf;
+	str.length = sizeof(size_buf);
+	if(apt_size_value_parse(&str) != 427) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Size Value [%"APR_SIZE_T_FMT"]",apt_size_value_parse(&str));
+		return FALSE;
+	}
+	/* the digits following the length are not taken */
+	str.length = sizeof(size_buf) - 1;
+	if(apt_size_value_parse(&str) != 42) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Size Value [%"APR_SIZE_T_FMT"]",apt_size_value_parse(&str));
+		return FALSE;
+	}
+
+	str.buf = (char*)float_buf;
+	str.length = sizeof(float_buf);
+	if(!TEXT_MESSAGE_FLOAT_EQUAL(apt_float_value_parse(&str),0.75)) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Float Value [%f]",apt_float_value_parse(&str));
+		return FALSE;
+	}
+	str.length = sizeof(float_buf) - 1;
+	if(!TEXT_MESSAGE_FLOAT_EQUAL(apt_float_value_parse(&str),0.7)) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Float Value [%f]",apt_float_value_parse(&str));
+		return FALSE;
+	}
+
+	str.length = 0;
+	if(apt_size_value_parse(&str) != 0 || apt_float_value_parse(&str) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Empty Value");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static apt_bool_t text_message_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apr_size_t split;
+	if(text_message_value_parse_test() == FALSE) {
+		return FALSE;
+	}
+
+	/* the complete header section is parsed in place */
+	if(text_message_split_parse(suite,0) == FALSE) {
+		return FALSE;
+	}
+
+	/* the header section split across two reads is parsed field by field */
+	for(split = 1; split < sizeof(text_message_sample) - 1; split++) {
+		if(text_message_split_parse(suite,split) == FALSE) {
+			return FALSE;
+		}
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Text Message Test Passed: splits [%"APR_SIZE_T_FMT"]",split);
+	return TRUE;
+}
+
+apt_test_suite_t* text_message_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"text-message",NULL,text_message_test_run);
+	return suite;
+}
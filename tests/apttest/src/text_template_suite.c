@@ -0,0 +1,119 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "apt_test_suite.h"
+#include "apt_text_template.h"
+#include "apt_log.h"
+
+/** Slots of the test template */
+static const char *text_template_slot_names[] = {"ip", "port"};
+
+/** Render the template and compare the result against the expected text */
+static apt_bool_t text_template_render_check(const apt_text_template_t *tmpl, const char *ip, const char *port, const char *expected)
+{
+	char buffer[256];
+	apt_text_stream_t stream;
+	apt_str_t values[2];
+	apr_size_t length;
+
+	apt_string_set(&values[0],ip);
+	apt_string_set(&values[1],port);
+	apt_text_stream_init(&stream,buffer,sizeof(buffer));
+	if(apt_text_template_render(tmpl,values,&stream) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Render Template");
+		return FALSE;
+	}
+
+	length = stream.pos - buffer;
+	if(length != strlen(expected) || strncmp(buffer,expected,length) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Template Output [%.*s] expected [%s]",(int)length,buffer,expected);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static apt_bool_t text_template_suite_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apt_text_template_t *tmpl;
+	char buffer[16];
+	char number[8];
+	char *pos;
+	apt_text_stream_t stream;
+	apt_str_t values[2];
+
+	tmpl = apt_text_template_compile("c=IN IP4 ${ip}\r\nm=audio ${port} RTP/AVP 0\r\no=- ${ip}",
+		text_template_slot_names,2,suite->pool);
+	if(!tmpl) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Compile Template");
+		return FALSE;
+	}
+	if(text_template_render_check(tmpl,"10.0.0.1","5000",
+		"c=IN IP4 10.0.0.1\r\nm=audio 5000 RTP/AVP 0\r\no=- 10.0.0.1") == FALSE) {
+		return FALSE;
+	}
+	if(text_template_render_check(tmpl,"192.168.100.200","65000",
+		"c=IN IP4 192.168.100.200\r\nm=audio 65000 RTP/AVP 0\r\no=- 192.168.100.200") == FALSE) {
+		return FALSE;
+	}
+
+	/* the stream must not overflow */
+	apt_string_set(&values[0],"192.168.100.200");
+	apt_string_set(&values[1],"65000");
+	apt_text_stream_init(&stream,buffer,sizeof(buffer));
+	if(apt_text_template_render(tmpl,values,&stream) == TRUE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Template Rendered beyond Buffer Size");
+		return FALSE;
+	}
+
+	/* a sequence of insertions marks the stream as full and stops at the first one which doesn't fit */
+	apt_text_stream_init(&stream,buffer,sizeof(buffer));
+	apt_text_template_number_set(&values[1],number,sizeof(number),5004);
+	apt_text_template_stream_render(tmpl,values,&stream);
+	pos = stream.pos;
+	APT_TEXT_TEMPLATE_LITERAL_INSERT(&stream,"a=");
+	apt_text_template_number_insert(&stream,8);
+	if(stream.is_eos == FALSE || stream.pos != pos) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Stream Not Marked as Full");
+		return FALSE;
+	}
+	apt_text_stream_init(&stream,buffer,sizeof(buffer));
+	APT_TEXT_TEMPLATE_LITERAL_INSERT(&stream,"m=audio ");
+	apt_text_template_number_insert(&stream,values[1].length);
+	apt_text_template_text_insert(&stream,values[1].buf,values[1].length);
+	if(stream.is_eos == TRUE || stream.pos - buffer != 13 || strncmp(buffer,"m=audio 45004",13) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Stream Output [%.*s]",(int)(stream.pos - buffer),buffer);
+		return FALSE;
+	}
+	APT_TEXT_TEMPLATE_LITERAL_INSERT(&stream," RTP/AVP");
+	if(stream.is_eos == FALSE || stream.pos - buffer != 13) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Stream Not Marked as Full");
+		return FALSE;
+	}
+
+	/* unknown slots are rejected at compile time */
+	if(apt_text_template_compile("o=${user}",text_template_slot_names,2,suite->pool) != NULL) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Template with Unknown Slot Compiled");
+		return FALSE;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Text Template Test Passed");
+	return TRUE;
+}
+
+apt_test_suite_t* text_template_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"text-template",NULL,text_template_suite_run);
+	return suite;
+}
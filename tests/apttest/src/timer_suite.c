@@ -0,0 +1,218 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include "apt_test_suite.h"
+#include "apt_timer_queue.h"
+#include "apt_log.h"
+
+/** Default number of timers */
+#define TIMER_TEST_COUNT      10000
+/** Max timeout of a timer in msec */
+#define TIMER_TEST_MAX_TIMEOUT 60000
+/** Time the queue is advanced by per step in msec (same as MPF_TIMER_RESOLUTION) */
+#define TIMER_TEST_STEP       10
+/** Number of times a timer is re-armed from inside its own callback */
+#define TIMER_TEST_REARM_COUNT 300
+
+typedef struct timer_test_t timer_test_t;
+typedef struct timer_test_item_t timer_test_item_t;
+
+struct timer_test_item_t {
+	timer_test_t *test;
+	apt_timer_t  *timer;
+	apr_uint32_t  scheduled_time;
+};
+
+struct timer_test_t {
+	apt_timer_queue_t *timer_queue;
+	timer_test_item_t *items;
+	apr_size_t         count;
+	apr_uint32_t       time;
+	apr_size_t         fired;
+	apr_size_t         misfired;
+};
+
+static void timer_test_proc(apt_timer_t *timer, void *obj)
+{
+	timer_test_item_t *item = obj;
+	timer_test_t *test = item->test;
+	/* the queue is being advanced from test->time to test->time + TIMER_TEST_STEP */
+	if(item->scheduled_time <= test->time || item->scheduled_time > test->time + TIMER_TEST_STEP) {
+		test->misfired++;
+	}
+	test->fired++;
+}
+
+static apr_interval_time_t timer_test_set(timer_test_t *test)
+{
+	apr_size_t i;
+	apr_uint32_t timeout;
+	apr_time_t start = apr_time_now();
+	for(i = 0; i < test->count; i++) {
+		timeout = 1 + rand() % TIMER_TEST_MAX_TIMEOUT;
+		test->items[i].scheduled_time = test->time + timeout;
+		apt_timer_set(test->items[i].timer,timeout);
+	}
+	return apr_time_now() - start;
+}
+
+static apr_interval_time_t timer_test_kill(timer_test_t *test)
+{
+	apr_size_t i;
+	apr_time_t start = apr_time_now();
+	for(i = 0; i < test->count; i++) {
+		apt_timer_kill(test->items[i].timer);
+	}
+	return apr_time_now() - start;
+}
+
+static apr_interval_time_t timer_test_advance(timer_test_t *test)
+{
+	apr_uint32_t timeout;
+	apr_time_t start = apr_time_now();
+	while(apt_timer_queue_is_empty(test->timer_queue) == FALSE) {
+		apt_timer_queue_timeout_get(test->timer_queue,&timeout);
+		apt_timer_queue_advance(test->timer_queue,TIMER_TEST_STEP);
+		test->time += TIMER_TEST_STEP;
+	}
+	return apr_time_now() - start;
+}
+
+typedef struct timer_rearm_test_t timer_rearm_test_t;
+struct timer_rearm_test_t {
+	apt_timer_t *timer;
+	apt_timer_t *other;
+	apr_size_t   fired;
+};
+
+static void timer_rearm_test_proc(apt_timer_t *timer, void *obj)
+{
+	timer_rearm_test_t *test = obj;
+	test->fired++;
+	if(test->other) {
+		/* kill the last timer but this one, which resets the elapsed time of the queue */
+		apt_timer_kill(test->other);
+		test->other = NULL;
+	}
+	if(test->fired < TIMER_TEST_REARM_COUNT) {
+		apt_timer_set(timer,TIMER_TEST_STEP);
+	}
+}
+
+/** Re-arm a timer from inside its own callback, it must fire once per advance of the queue by its timeout */
+static apt_bool_t timer_rearm_test_run(apt_bool_t kill_other, apr_pool_t *pool)
+{
+	timer_rearm_test_t test;
+	apt_timer_queue_t *timer_queue = apt_timer_queue_create(pool);
+	apr_uint32_t timeout;
+	apr_size_t steps = 0;
+
+	test.fired = 0;
+	test.timer = apt_timer_create(timer_queue,timer_rearm_test_proc,&test,pool);
+	test.other = NULL;
+	if(kill_other == TRUE) {
+		test.other = apt_timer_create(timer_queue,timer_rearm_test_proc,&test,pool);
+		apt_timer_set(test.other,TIMER_TEST_STEP * 10);
+	}
+	apt_timer_set(test.timer,TIMER_TEST_STEP);
+
+	while(apt_timer_queue_is_empty(timer_queue) == FALSE) {
+		if(apt_timer_queue_timeout_get(timer_queue,&timeout) == FALSE || timeout != TIMER_TEST_STEP) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Timeout of Re-armed Timer [%u]",timeout);
+			return FALSE;
+		}
+		apt_timer_queue_advance(timer_queue,timeout);
+		steps++;
+		if(test.fired != steps) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Re-armed Timer Misfired: fired [%"APR_SIZE_T_FMT"] expected [%"APR_SIZE_T_FMT"]",
+				test.fired,
+				steps);
+			return FALSE;
+		}
+	}
+
+	apt_timer_queue_destroy(timer_queue);
+	return test.fired == TIMER_TEST_REARM_COUNT ? TRUE : FALSE;
+}
+
+static apt_bool_t timer_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	timer_test_t test;
+	apr_size_t i;
+	apr_interval_time_t set_time;
+	apr_interval_time_t reset_time;
+	apr_interval_time_t kill_time;
+	apr_interval_time_t advance_time;
+
+	test.count = TIMER_TEST_COUNT;
+	if(argc > 0) {
+		test.count = atol(argv[0]);
+		if(!test.count) {
+			test.count = TIMER_TEST_COUNT;
+		}
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Run Timer Queue Test [%"APR_SIZE_T_FMT" timers]",test.count);
+	test.timer_queue = apt_timer_queue_create(suite->pool);
+	test.items = apr_palloc(suite->pool,sizeof(timer_test_item_t) * test.count);
+	test.time = 0;
+	test.fired = 0;
+	test.misfired = 0;
+	for(i = 0; i < test.count; i++) {
+		test.items[i].test = &test;
+		test.items[i].scheduled_time = 0;
+		test.items[i].timer = apt_timer_create(test.timer_queue,timer_test_proc,&test.items[i],suite->pool);
+	}
+
+	/* set all the timers, then kill them */
+	set_time = timer_test_set(&test);
+	kill_time = timer_test_kill(&test);
+
+	/* set all the timers twice, then advance the queue till all of them are elapsed */
+	timer_test_set(&test);
+	reset_time = timer_test_set(&test);
+	advance_time = timer_test_advance(&test);
+
+	apt_timer_queue_destroy(test.timer_queue);
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Timer Queue: set [%"APR_TIME_T_FMT" usec] reset [%"APR_TIME_T_FMT" usec] kill [%"APR_TIME_T_FMT" usec] advance [%"APR_TIME_T_FMT" usec] elapsed [%u msec]",
+		set_time,
+		reset_time,
+		kill_time,
+		advance_time,
+		test.time);
+
+	if(test.fired != test.count || test.misfired) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Timer Queue Mismatch: fired [%"APR_SIZE_T_FMT"] misfired [%"APR_SIZE_T_FMT"] expected [%"APR_SIZE_T_FMT"]",
+			test.fired,
+			test.misfired,
+			test.count);
+		return FALSE;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Run Timer Re-arm Test [%d times]",TIMER_TEST_REARM_COUNT);
+	if(timer_rearm_test_run(FALSE,suite->pool) != TRUE || timer_rearm_test_run(TRUE,suite->pool) != TRUE) {
+		return FALSE;
+	}
+	return TRUE;
+}
+
+apt_test_suite_t* timer_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"timer",NULL,timer_test_run);
+	return suite;
+}
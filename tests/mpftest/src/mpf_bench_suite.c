@@ -0,0 +1,614 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Microbenchmarks of the media processing primitives. Each case processes
+ * a number of 10 msec frames of 8 kHz audio in a single thread and reports
+ * the time spent per frame, the frames processed per second and the number
+ * of real-time channels a core could sustain.
+ *
+ * Usage: mpftest bench [frame count] [case name]
+ */
+
+#include <stdlib.h>
+#include "apt_test_suite.h"
+#include "apt_pool.h"
+#include "apt_log.h"
+#include "mpf_engine.h"
+#include "mpf_codec_manager.h"
+#include "mpf_jitter_buffer.h"
+#include "mpf_activity_detector.h"
+#include "mpf_dtmf_detector.h"
+#include "mpf_dtmf_generator.h"
+#include "mpf_bridge.h"
+#include "mpf_multiplier.h"
+#include "mpf_mixer.h"
+#include "mpf_rtp_stream.h"
+#include "mpf_rtp_descriptor.h"
+
+/** Default number of frames processed per case */
+#define MPF_BENCH_FRAME_COUNT    100000
+/** Number of frames processed before the measurement starts */
+#define MPF_BENCH_WARMUP_COUNT   1000
+/** Sampling rate of the audio processed */
+#define MPF_BENCH_SAMPLING_RATE  8000
+/** Number of sinks of the multiplier and sources of the mixer */
+#define MPF_BENCH_LEG_COUNT      4
+/** Number of frames of the DTMF sequence fed to the detector */
+#define MPF_BENCH_TONE_COUNT     200
+/** Size of RTP header without CSRC and extension */
+#define MPF_BENCH_RTP_HEADER_SIZE 12
+
+typedef struct mpf_bench_t mpf_bench_t;
+typedef struct mpf_bench_case_t mpf_bench_case_t;
+typedef struct mpf_bench_stream_t mpf_bench_stream_t;
+
+/** Benchmark state shared by the cases */
+struct mpf_bench_t {
+	/** Pool of the running case */
+	apr_pool_t             *pool;
+	/** Codec manager */
+	mpf_codec_manager_t    *codec_manager;
+	/** Frame of linear audio */
+	mpf_codec_frame_t       linear_frame;
+	/** Frame of encoded audio */
+	mpf_codec_frame_t       encoded_frame;
+	/** Frame to read into */
+	mpf_frame_t             frame;
+
+	/** Codec under test */
+	mpf_codec_t            *codec;
+	/** Jitter buffer under test */
+	mpf_jitter_buffer_t    *jb;
+	/** Activity detector under test */
+	mpf_activity_detector_t*activity_detector;
+	/** DTMF detector under test */
+	mpf_dtmf_detector_t    *dtmf_detector;
+	/** Frames of DTMF sequence */
+	mpf_frame_t            *tones;
+	/** Bridge, multiplier or mixer under test */
+	mpf_object_t           *object;
+	/** RTP stream under test */
+	mpf_audio_stream_t     *rtp_stream;
+	/** Socket to send RTP packets from */
+	apr_socket_t           *socket;
+	/** Address of RTP stream */
+	apr_sockaddr_t         *sockaddr;
+	/** RTP packet to send */
+	apr_byte_t              packet[MPF_BENCH_RTP_HEADER_SIZE + 160];
+
+	/** Sequence number of the frame processed */
+	apr_uint32_t            seq;
+};
+
+/** Benchmark case */
+struct mpf_bench_case_t {
+	/** Name of the case */
+	const char *name;
+	/** Create objects under test */
+	apt_bool_t (*create)(mpf_bench_t *bench);
+	/** Process one frame */
+	apt_bool_t (*process)(mpf_bench_t *bench);
+	/** Destroy objects under test */
+	void (*destroy)(mpf_bench_t *bench);
+};
+
+/** In-memory audio stream */
+struct mpf_bench_stream_t {
+	/** Frame returned by every read */
+	const mpf_codec_frame_t *frame;
+	/** Number of frames written */
+	apr_size_t               written;
+};
+
+static apt_bool_t mpf_bench_stream_read(mpf_audio_stream_t *stream, mpf_frame_t *frame)
+{
+	mpf_bench_stream_t *bench_stream = stream->obj;
+	frame->type |= MEDIA_FRAME_TYPE_AUDIO;
+	frame->codec_frame.size = bench_stream->frame->size;
+	memcpy(frame->codec_frame.buffer,bench_stream->frame->buffer,bench_stream->frame->size);
+	return TRUE;
+}
+
+static apt_bool_t mpf_bench_stream_write(mpf_audio_stream_t *stream, const mpf_frame_t *frame)
+{
+	mpf_bench_stream_t *bench_stream = stream->obj;
+	bench_stream->written++;
+	return TRUE;
+}
+
+static const mpf_audio_stream_vtable_t mpf_bench_stream_vtable = {
+	NULL,
+	NULL,
+	NULL,
+	mpf_bench_stream_read,
+	NULL,
+	NULL,
+	mpf_bench_stream_write,
+	NULL
+};
+
+/** Create in-memory audio stream of the specified direction and codec */
+static mpf_audio_stream_t* mpf_bench_stream_create(mpf_bench_t *bench, mpf_stream_direction_e direction, mpf_codec_descriptor_t *descriptor, const mpf_codec_frame_t *frame)
+{
+	mpf_stream_capabilities_t *capabilities;
+	mpf_audio_stream_t *stream;
+	mpf_bench_stream_t *bench_stream = apr_palloc(bench->pool,sizeof(mpf_bench_stream_t));
+	bench_stream->frame = frame;
+	bench_stream->written = 0;
+
+	capabilities = mpf_stream_capabilities_create(direction,bench->pool);
+	stream = mpf_audio_stream_create(bench_stream,&mpf_bench_stream_vtable,capabilities,bench->pool);
+	if(!stream) {
+		return NULL;
+	}
+	if(direction & STREAM_DIRECTION_RECEIVE) {
+		stream->rx_descriptor = descriptor;
+	}
+	if(direction & STREAM_DIRECTION_SEND) {
+		stream->tx_descriptor = descriptor;
+	}
+	return stream;
+}
+
+static mpf_codec_descriptor_t* mpf_bench_descriptor_create(const char *name, apr_byte_t payload_type, apr_pool_t *pool)
+{
+	mpf_codec_descriptor_t *descriptor = mpf_codec_descriptor_create(pool);
+	descriptor->payload_type = payload_type;
+	apt_string_set(&descriptor->name,name);
+	descriptor->sampling_rate = MPF_BENCH_SAMPLING_RATE;
+	descriptor->channel_count = 1;
+	return descriptor;
+}
+
+static apt_bool_t mpf_bench_codec_create(mpf_bench_t *bench, const char *name, apr_byte_t payload_type)
+{
+	mpf_codec_descriptor_t *descriptor = mpf_bench_descriptor_create(name,payload_type,bench->pool);
+	bench->codec = mpf_codec_manager_codec_get(bench->codec_manager,descriptor,bench->pool);
+	if(!bench->codec || mpf_codec_open(bench->codec) == FALSE) {
+		return FALSE;
+	}
+	/* have the encoded frame ready for the decoder */
+	return mpf_codec_encode(bench->codec,&bench->linear_frame,&bench->encoded_frame);
+}
+
+static void mpf_bench_codec_destroy(mpf_bench_t *bench)
+{
+	mpf_codec_close(bench->codec);
+}
+
+
+/* G.711 encoder and decoder */
+static apt_bool_t mpf_bench_pcmu_create(mpf_bench_t *bench)
+{
+	return mpf_bench_codec_create(bench,"PCMU",0);
+}
+
+static apt_bool_t mpf_bench_pcma_create(mpf_bench_t *bench)
+{
+	return mpf_bench_codec_create(bench,"PCMA",8);
+}
+
+static apt_bool_t mpf_bench_encode_process(mpf_bench_t *bench)
+{
+	return mpf_codec_encode(bench->codec,&bench->linear_frame,&bench->encoded_frame);
+}
+
+static apt_bool_t mpf_bench_decode_process(mpf_bench_t *bench)
+{
+	return mpf_codec_decode(bench->codec,&bench->encoded_frame,&bench->frame.codec_frame);
+}
+
+
+/* Jitter buffer write and read */
+static apt_bool_t mpf_bench_jb_create(mpf_bench_t *bench)
+{
+	mpf_codec_descriptor_t *descriptor;
+	mpf_jb_config_t *jb_config = apr_palloc(bench->pool,sizeof(mpf_jb_config_t));
+	mpf_jb_config_init(jb_config);
+	jb_config->adaptive = 1;
+	jb_config->min_playout_delay = 0;
+	jb_config->initial_playout_delay = 50;
+	jb_config->max_playout_delay = 200;
+
+	if(mpf_bench_codec_create(bench,"PCMU",0) == FALSE) {
+		return FALSE;
+	}
+	descriptor = mpf_bench_descriptor_create("PCMU",0,bench->pool);
+	bench->jb = mpf_jitter_buffer_create(jb_config,descriptor,bench->codec,bench->pool);
+	return bench->jb ? TRUE : FALSE;
+}
+
+static apt_bool_t mpf_bench_jb_process(mpf_bench_t *bench)
+{
+	apr_uint32_t ts = bench->seq * (apr_uint32_t)(bench->linear_frame.size / sizeof(apr_int16_t));
+	mpf_jitter_buffer_write(
+		bench->jb,
+		bench->encoded_frame.buffer,
+		bench->encoded_frame.size,
+		ts,
+		bench->seq == 0 ? 1 : 0);
+	bench->seq++;
+
+	bench->frame.type = MEDIA_FRAME_TYPE_NONE;
+	return mpf_jitter_buffer_read(bench->jb,&bench->frame);
+}
+
+static void mpf_bench_jb_destroy(mpf_bench_t *bench)
+{
+	mpf_jitter_buffer_destroy(bench->jb);
+	mpf_bench_codec_destroy(bench);
+}
+
+
+/* Activity detector */
+static apt_bool_t mpf_bench_activity_create(mpf_bench_t *bench)
+{
+	bench->activity_detector = mpf_activity_detector_create(bench->pool);
+	bench->frame.type = MEDIA_FRAME_TYPE_AUDIO;
+	bench->frame.codec_frame = bench->linear_frame;
+	return bench->activity_detector ? TRUE : FALSE;
+}
+
+static apt_bool_t mpf_bench_activity_process(mpf_bench_t *bench)
+{
+	mpf_activity_detector_process(bench->activity_detector,&bench->frame);
+	return TRUE;
+}
+
+
+/* DTMF detector fed by in-band tones */
+static apt_bool_t mpf_bench_dtmf_create(mpf_bench_t *bench)
+{
+	apr_size_t i;
+	mpf_frame_t *frame;
+	mpf_dtmf_generator_t *generator;
+	mpf_codec_descriptor_t *descriptor = mpf_codec_lpcm_descriptor_create(MPF_BENCH_SAMPLING_RATE,1,bench->pool);
+	mpf_audio_stream_t *stream = mpf_bench_stream_create(bench,STREAM_DIRECTION_DUPLEX,descriptor,&bench->linear_frame);
+	if(!stream) {
+		return FALSE;
+	}
+
+	generator = mpf_dtmf_generator_create_ex(stream,MPF_DTMF_GENERATOR_INBAND,70,50,bench->pool);
+	bench->dtmf_detector = mpf_dtmf_detector_create_ex(stream,MPF_DTMF_DETECTOR_INBAND,bench->pool);
+	if(!generator || !bench->dtmf_detector) {
+		return FALSE;
+	}
+
+	/* generate all the digits once, then feed the same sequence repeatedly */
+	mpf_dtmf_generator_enqueue(generator,"0123456789*#ABCD");
+	bench->tones = apr_palloc(bench->pool,sizeof(mpf_frame_t) * MPF_BENCH_TONE_COUNT);
+	for(i=0; i<MPF_BENCH_TONE_COUNT; i++) {
+		frame = &bench->tones[i];
+		frame->type = MEDIA_FRAME_TYPE_NONE;
+		frame->marker = MPF_MARKER_NONE;
+		frame->codec_frame.size = bench->linear_frame.size;
+		frame->codec_frame.buffer = apr_pcalloc(bench->pool,frame->codec_frame.size);
+		mpf_dtmf_generator_put_frame(generator,frame);
+		frame->type |= MEDIA_FRAME_TYPE_AUDIO;
+	}
+	mpf_dtmf_generator_destroy(generator);
+	return TRUE;
+}
+
+static apt_bool_t mpf_bench_dtmf_process(mpf_bench_t *bench)
+{
+	mpf_dtmf_detector_get_frame(bench->dtmf_detector,&bench->tones[bench->seq++ % MPF_BENCH_TONE_COUNT]);
+	mpf_dtmf_detector_digit_get(bench->dtmf_detector);
+	return TRUE;
+}
+
+static void mpf_bench_dtmf_destroy(mpf_bench_t *bench)
+{
+	mpf_dtmf_detector_destroy(bench->dtmf_detector);
+}
+
+
+/* Media processing objects */
+static apt_bool_t mpf_bench_bridge_create(mpf_bench_t *bench)
+{
+	mpf_audio_stream_t *source;
+	mpf_audio_stream_t *sink;
+	if(mpf_bench_codec_create(bench,"PCMU",0) == FALSE) {
+		return FALSE;
+	}
+
+	/* RTP -> engine path: decoder followed by linear bridge */
+	source = mpf_bench_stream_create(bench,STREAM_DIRECTION_RECEIVE,
+				mpf_bench_descriptor_create("PCMU",0,bench->pool),
+				&bench->encoded_frame);
+	sink = mpf_bench_stream_create(bench,STREAM_DIRECTION_SEND,
+				mpf_codec_lpcm_descriptor_create(MPF_BENCH_SAMPLING_RATE,1,bench->pool),
+				NULL);
+	if(!source || !sink) {
+		return FALSE;
+	}
+	bench->object = mpf_bridge_create(source,sink,bench->codec_manager,"bench",bench->pool);
+	return bench->object ? TRUE : FALSE;
+}
+
+static apt_bool_t mpf_bench_multiplier_create(mpf_bench_t *bench)
+{
+	apr_size_t i;
+	mpf_audio_stream_t *source;
+	mpf_audio_stream_t **sinks;
+	mpf_codec_descriptor_t *descriptor = mpf_codec_lpcm_descriptor_create(MPF_BENCH_SAMPLING_RATE,1,bench->pool);
+
+	source = mpf_bench_stream_create(bench,STREAM_DIRECTION_RECEIVE,descriptor,&bench->linear_frame);
+	sinks = apr_palloc(bench->pool,sizeof(mpf_audio_stream_t*) * MPF_BENCH_LEG_COUNT);
+	for(i=0; i<MPF_BENCH_LEG_COUNT; i++) {
+		sinks[i] = mpf_bench_stream_create(bench,STREAM_DIRECTION_SEND,descriptor,NULL);
+	}
+	bench->object = mpf_multiplier_create(source,sinks,MPF_BENCH_LEG_COUNT,bench->codec_manager,"bench",bench->pool);
+	return bench->object ? TRUE : FALSE;
+}
+
+static apt_bool_t mpf_bench_mixer_create(mpf_bench_t *bench)
+{
+	apr_size_t i;
+	mpf_audio_stream_t **sources;
+	mpf_audio_stream_t *sink;
+	mpf_codec_descriptor_t *descriptor = mpf_codec_lpcm_descriptor_create(MPF_BENCH_SAMPLING_RATE,1,bench->pool);
+
+	sources = apr_palloc(bench->pool,sizeof(mpf_audio_stream_t*) * MPF_BENCH_LEG_COUNT);
+	for(i=0; i<MPF_BENCH_LEG_COUNT; i++) {
+		sources[i] = mpf_bench_stream_create(bench,STREAM_DIRECTION_RECEIVE,descriptor,&bench->linear_frame);
+	}
+	sink = mpf_bench_stream_create(bench,STREAM_DIRECTION_SEND,descriptor,NULL);
+	bench->object = mpf_mixer_create(sources,MPF_BENCH_LEG_COUNT,sink,bench->codec_manager,"bench",bench->pool);
+	return bench->object ? TRUE : FALSE;
+}
+
+static apt_bool_t mpf_bench_object_process(mpf_bench_t *bench)
+{
+	mpf_object_process(bench->object);
+	return TRUE;
+}
+
+static void mpf_bench_object_destroy(mpf_bench_t *bench)
+{
+	mpf_object_destroy(bench->object);
+}
+
+
+/* RTP receiver: packets are sent over loopback and read through the stream */
+static apt_bool_t mpf_bench_rtp_create(mpf_bench_t *bench)
+{
+	mpf_rtp_config_t *rtp_config;
+	mpf_rtp_settings_t *rtp_settings;
+	mpf_rtp_stream_descriptor_t descriptor;
+	mpf_rtp_media_descriptor_t *local_media;
+	mpf_rtp_media_descriptor_t *remote_media;
+	mpf_codec_t *codec;
+
+	rtp_config = mpf_rtp_config_alloc(bench->pool);
+	apt_string_set(&rtp_config->ip,"127.0.0.1");
+	rtp_config->rtp_port_min = 7000;
+	rtp_config->rtp_port_max = 8000;
+	rtp_config->rtp_port_cur = rtp_config->rtp_port_min;
+
+	rtp_settings = mpf_rtp_settings_alloc(bench->pool);
+	rtp_settings->jb_config.adaptive = 1;
+	rtp_settings->jb_config.min_playout_delay = 0;
+	rtp_settings->jb_config.initial_playout_delay = 50;
+	rtp_settings->jb_config.max_playout_delay = 200;
+	mpf_codec_manager_codec_list_load(bench->codec_manager,&rtp_settings->codec_list,"PCMU",bench->pool);
+
+	bench->rtp_stream = mpf_rtp_stream_create(NULL,rtp_config,rtp_settings,bench->pool);
+	if(!bench->rtp_stream) {
+		return FALSE;
+	}
+
+	local_media = mpf_rtp_media_descriptor_alloc(bench->pool);
+	local_media->state = MPF_MEDIA_ENABLED;
+	local_media->direction = STREAM_DIRECTION_RECEIVE;
+
+	/* the remote address is required to open the receiver, nothing is sent to it */
+	remote_media = mpf_rtp_media_descriptor_alloc(bench->pool);
+	remote_media->state = MPF_MEDIA_ENABLED;
+	remote_media->direction = STREAM_DIRECTION_SEND;
+	apt_string_set(&remote_media->ip,"127.0.0.1");
+	remote_media->port = rtp_config->rtp_port_max;
+	mpf_codec_manager_codec_list_load(bench->codec_manager,&remote_media->codec_list,"PCMU",bench->pool);
+
+	mpf_rtp_stream_descriptor_init(&descriptor);
+	descriptor.local = local_media;
+	descriptor.remote = remote_media;
+	if(mpf_rtp_stream_modify(bench->rtp_stream,&descriptor) == FALSE || !bench->rtp_stream->rx_descriptor) {
+		mpf_rtp_stream_remove(bench->rtp_stream);
+		return FALSE;
+	}
+
+	codec = mpf_codec_manager_codec_get(bench->codec_manager,bench->rtp_stream->rx_descriptor,bench->pool);
+	if(!codec || mpf_audio_stream_rx_open(bench->rtp_stream,codec) == FALSE) {
+		mpf_rtp_stream_remove(bench->rtp_stream);
+		return FALSE;
+	}
+	if(mpf_codec_encode(codec,&bench->linear_frame,&bench->encoded_frame) == FALSE ||
+		apr_sockaddr_info_get(&bench->sockaddr,local_media->ip.buf,APR_INET,local_media->port,0,bench->pool) != APR_SUCCESS ||
+		apr_socket_create(&bench->socket,APR_INET,SOCK_DGRAM,0,bench->pool) != APR_SUCCESS) {
+		mpf_audio_stream_rx_close(bench->rtp_stream);
+		mpf_rtp_stream_remove(bench->rtp_stream);
+		return FALSE;
+	}
+
+	/* V=2, no padding, extension or CSRC; SSRC is fixed */
+	memset(bench->packet,0,MPF_BENCH_RTP_HEADER_SIZE);
+	bench->packet[0] = 0x80;
+	bench->packet[1] = bench->rtp_stream->rx_descriptor->payload_type;
+	bench->packet[8] = 0x12;
+	bench->packet[9] = 0x34;
+	bench->packet[10] = 0x56;
+	bench->packet[11] = 0x78;
+	memcpy(bench->packet + MPF_BENCH_RTP_HEADER_SIZE,bench->encoded_frame.buffer,bench->encoded_frame.size);
+	return TRUE;
+}
+
+static apt_bool_t mpf_bench_rtp_process(mpf_bench_t *bench)
+{
+	apr_size_t size = MPF_BENCH_RTP_HEADER_SIZE + bench->encoded_frame.size;
+	apr_uint32_t ts = bench->seq * (apr_uint32_t)(bench->linear_frame.size / sizeof(apr_int16_t));
+	apr_byte_t *packet = bench->packet;
+
+	packet[1] = (packet[1] & 0x7F) | (bench->seq == 0 ? 0x80 : 0);
+	packet[2] = (apr_byte_t)(bench->seq >> 8);
+	packet[3] = (apr_byte_t)bench->seq;
+	packet[4] = (apr_byte_t)(ts >> 24);
+	packet[5] = (apr_byte_t)(ts >> 16);
+	packet[6] = (apr_byte_t)(ts >> 8);
+	packet[7] = (apr_byte_t)ts;
+	bench->seq++;
+	if(apr_socket_sendto(bench->socket,bench->sockaddr,0,(const char*)packet,&size) != APR_SUCCESS) {
+		return FALSE;
+	}
+
+	bench->frame.type = MEDIA_FRAME_TYPE_NONE;
+	return mpf_audio_stream_frame_read(bench->rtp_stream,&bench->frame);
+}
+
+static void mpf_bench_rtp_destroy(mpf_bench_t *bench)
+{
+	apr_socket_close(bench->socket);
+	mpf_audio_stream_rx_close(bench->rtp_stream);
+	mpf_rtp_stream_remove(bench->rtp_stream);
+}
+
+
+static const mpf_bench_case_t mpf_bench_cases[] = {
+	{"pcmu-encode", mpf_bench_pcmu_create,       mpf_bench_encode_process,   mpf_bench_codec_destroy},
+	{"pcmu-decode", mpf_bench_pcmu_create,       mpf_bench_decode_process,   mpf_bench_codec_destroy},
+	{"pcma-encode", mpf_bench_pcma_create,       mpf_bench_encode_process,   mpf_bench_codec_destroy},
+	{"pcma-decode", mpf_bench_pcma_create,       mpf_bench_decode_process,   mpf_bench_codec_destroy},
+	{"jb",          mpf_bench_jb_create,         mpf_bench_jb_process,       mpf_bench_jb_destroy},
+	{"activity",    mpf_bench_activity_create,   mpf_bench_activity_process, NULL},
+	{"dtmf",        mpf_bench_dtmf_create,       mpf_bench_dtmf_process,     mpf_bench_dtmf_destroy},
+	{"bridge",      mpf_bench_bridge_create,     mpf_bench_object_process,   mpf_bench_object_destroy},
+	{"multiplier",  mpf_bench_multiplier_create, mpf_bench_object_process,   mpf_bench_object_destroy},
+	{"mixer",       mpf_bench_mixer_create,      mpf_bench_object_process,   mpf_bench_object_destroy},
+	{"rtp-rx",      mpf_bench_rtp_create,        mpf_bench_rtp_process,      mpf_bench_rtp_destroy}
+};
+
+#define MPF_BENCH_CASE_COUNT (sizeof(mpf_bench_cases) / sizeof(mpf_bench_cases[0]))
+
+static apt_bool_t mpf_bench_case_run(mpf_bench_t *bench, const mpf_bench_case_t *bench_case, apr_size_t count)
+{
+	apr_size_t i;
+	apr_time_t start;
+	apr_interval_time_t elapsed;
+	double ns_per_frame;
+	apt_bool_t status = TRUE;
+
+	bench->pool = apt_pool_create();
+	bench->seq = 0;
+	bench->frame.type = MEDIA_FRAME_TYPE_NONE;
+	bench->frame.marker = MPF_MARKER_NONE;
+	bench->frame.codec_frame.size = bench->linear_frame.size;
+	bench->frame.codec_frame.buffer = apr_palloc(bench->pool,bench->linear_frame.size);
+	if(bench_case->create(bench) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Benchmark [%s]",bench_case->name);
+		apr_pool_destroy(bench->pool);
+		return FALSE;
+	}
+
+	for(i=0; i<MPF_BENCH_WARMUP_COUNT && status == TRUE; i++) {
+		status = bench_case->process(bench);
+	}
+
+	start = apr_time_now();
+	for(i=0; i<count && status == TRUE; i++) {
+		status = bench_case->process(bench);
+	}
+	elapsed = apr_time_now() - start;
+
+	if(bench_case->destroy) {
+		bench_case->destroy(bench);
+	}
+	apr_pool_destroy(bench->pool);
+
+	if(status == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Process Frame [%s]",bench_case->name);
+		return FALSE;
+	}
+
+	if(elapsed <= 0) {
+		elapsed = 1;
+	}
+	ns_per_frame = (double)elapsed * 1000 / count;
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"%-12s frames [%"APR_SIZE_T_FMT"] ns/frame [%.1f] frames/sec [%.0f] channels/core [%.0f]",
+		bench_case->name,
+		count,
+		ns_per_frame,
+		1000000000.0 / ns_per_frame,
+		1000000000.0 / ns_per_frame * CODEC_FRAME_TIME_BASE / 1000);
+	return TRUE;
+}
+
+/** Run MPF benchmark suite */
+static apt_bool_t mpf_bench_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	mpf_bench_t bench;
+	apr_size_t i;
+	apr_size_t count = MPF_BENCH_FRAME_COUNT;
+	const char *name = NULL;
+	apr_int16_t *samples;
+	apr_uint32_t seed = 1;
+	apt_bool_t status = TRUE;
+
+	if(argc > 0) {
+		count = atol(argv[0]);
+		if(!count) {
+			count = MPF_BENCH_FRAME_COUNT;
+		}
+	}
+	if(argc > 1) {
+		name = argv[1];
+	}
+
+	bench.codec_manager = mpf_engine_codec_manager_create(suite->pool);
+	if(!bench.codec_manager) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Codec Manager");
+		return FALSE;
+	}
+
+	/* 10 msec of noise-like audio of moderate level */
+	bench.linear_frame.size = mpf_codec_linear_frame_size_calculate(MPF_BENCH_SAMPLING_RATE,1);
+	bench.linear_frame.buffer = apr_palloc(suite->pool,bench.linear_frame.size);
+	samples = bench.linear_frame.buffer;
+	for(i=0; i<bench.linear_frame.size / sizeof(apr_int16_t); i++) {
+		seed = seed * 1103515245 + 12345;
+		samples[i] = (apr_int16_t)((seed >> 16) % 8000) - 4000;
+	}
+	bench.encoded_frame.size = bench.linear_frame.size;
+	bench.encoded_frame.buffer = apr_palloc(suite->pool,bench.encoded_frame.size);
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Run MPF Benchmarks [%"APR_SIZE_T_FMT" frames of %d msec]",count,CODEC_FRAME_TIME_BASE);
+	for(i=0; i<MPF_BENCH_CASE_COUNT; i++) {
+		if(name && strcasecmp(name,mpf_bench_cases[i].name) != 0) {
+			continue;
+		}
+		if(mpf_bench_case_run(&bench,&mpf_bench_cases[i],count) == FALSE) {
+			status = FALSE;
+		}
+	}
+	return status;
+}
+
+/** Create MPF benchmark suite */
+apt_test_suite_t* mpf_bench_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"bench",NULL,mpf_bench_run);
+	return suite;
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * Test of the admission control of the MRCP server. The rate of media processing
+ * overruns is calculated over the time elapsed since the previous sample, so that
+ * a backlog accumulated during a quiet period doesn't reject the first offer, and
+ * each admission control threshold rejects sessions once it is reached.
+ */
+
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "mrcp_server.h"
+
+/** Check the rate of overruns calculated for the specified count and elapsed time */
+static apt_bool_t admission_overrun_rate_check(apr_size_t count, apr_interval_time_t elapsed, apr_size_t expected)
+{
+	apr_size_t rate = mrcp_server_overrun_rate_calculate(count,elapsed);
+	if(rate != expected) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Overrun Rate [%"APR_SIZE_T_FMT"] count [%"APR_SIZE_T_FMT"] elapsed [%"APR_TIME_T_FMT" usec] expected [%"APR_SIZE_T_FMT"]",
+			rate,count,elapsed,expected);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Test the rate of overruns */
+static apt_bool_t admission_overrun_rate_test()
+{
+	/* overruns within a second */
+	if(admission_overrun_rate_check(100,apr_time_from_sec(1),100) == FALSE) {
+		return FALSE;
+	}
+	/* overruns within half a second, sampled as soon as possible */
+	if(admission_overrun_rate_check(50,apr_time_from_msec(500),100) == FALSE) {
+		return FALSE;
+	}
+	/* backlog of overruns accumulated since the load was sampled five minutes ago */
+	if(admission_overrun_rate_check(600,apr_time_from_sec(300),2) == FALSE) {
+		return FALSE;
+	}
+	if(admission_overrun_rate_check(0,apr_time_from_sec(10),0) == FALSE) {
+		return FALSE;
+	}
+	/* no time elapsed */
+	if(admission_overrun_rate_check(7,0,7) == FALSE) {
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Check the admission decision for the specified load */
+static apt_bool_t admission_decision_check(const char *name, const mrcp_server_admission_settings_t *settings, const mrcp_server_load_t *load, apt_bool_t expected)
+{
+	if(mrcp_server_load_exceeded(settings,load) != expected) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Admission Decision [%s] expected [%s]",
+			name,expected == TRUE ? "reject" : "admit");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Test the admission decision */
+static apt_bool_t admission_decision_test(apr_pool_t *pool)
+{
+	mrcp_server_admission_settings_t *settings = mrcp_server_admission_settings_alloc(pool);
+	mrcp_server_load_t load;
+	apt_bool_t status = TRUE;
+
+	load.session_count = 1000;
+	load.queue_depth = 1000;
+	load.overrun_count = 1000;
+	load.overrun_total = 1000;
+	load.channel_usage = 100;
+	load.rejected_count = 0;
+	load.overloaded = FALSE;
+
+	/* no settings or no thresholds set, all the sessions are admitted */
+	status &= admission_decision_check("no settings",NULL,&load,FALSE);
+	status &= admission_decision_check("no thresholds",settings,&load,FALSE);
+
+	load.session_count = 9;
+	load.queue_depth = 4;
+	load.overrun_count = 49;
+	load.channel_usage = 79;
+	settings->max_session_count = 10;
+	settings->max_queue_depth = 5;
+	settings->max_overrun_count = 50;
+	settings->max_channel_usage = 80;
+	status &= admission_decision_check("below thresholds",settings,&load,FALSE);
+
+	/* each threshold rejects sessions once it is reached */
+	load.session_count = 10;
+	status &= admission_decision_check("sessions",settings,&load,TRUE);
+	load.session_count = 9;
+	load.queue_depth = 5;
+	status &= admission_decision_check("queue",settings,&load,TRUE);
+	load.queue_depth = 4;
+	load.overrun_count = 50;
+	status &= admission_decision_check("overruns",settings,&load,TRUE);
+	load.overrun_count = 49;
+	load.channel_usage = 80;
+	status &= admission_decision_check("channel usage",settings,&load,TRUE);
+	load.channel_usage = 79;
+
+	/* a backlog of 600 overruns accumulated over five quiet minutes is 2 per second, the offer is admitted */
+	load.overrun_total = 600;
+	load.overrun_count = mrcp_server_overrun_rate_calculate(load.overrun_total,apr_time_from_sec(300));
+	status &= admission_decision_check("overrun backlog",settings,&load,FALSE);
+	/* while 60 overruns within the last second are not */
+	load.overrun_count = mrcp_server_overrun_rate_calculate(60,apr_time_from_sec(1));
+	status &= admission_decision_check("overrun burst",settings,&load,TRUE);
+	return status;
+}
+
+/** Test the load of a server, which has no sessions */
+static apt_bool_t admission_server_load_test(apr_pool_t *pool)
+{
+	mrcp_server_admission_settings_t *settings = mrcp_server_admission_settings_alloc(pool);
+	mrcp_server_load_t load;
+	apt_bool_t status = TRUE;
+	mrcp_server_t *server = mrcp_server_create(NULL);
+	if(!server) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Server");
+		return FALSE;
+	}
+
+	settings->max_session_count = 1;
+	settings->max_overrun_count = 1;
+	mrcp_server_admission_settings_set(server,settings);
+	if(mrcp_server_load_get(server,&load) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Get Server Load");
+		status = FALSE;
+	}
+	else if(load.overloaded == TRUE || load.session_count || load.overrun_count || load.rejected_count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Load: sessions [%"APR_SIZE_T_FMT"] overruns [%"APR_SIZE_T_FMT"] rejected [%"APR_SIZE_T_FMT"]",
+			load.session_count,load.overrun_count,load.rejected_count);
+		status = FALSE;
+	}
+
+	mrcp_server_destroy(server);
+	return status;
+}
+
+static apt_bool_t admission_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	if(admission_overrun_rate_test() == FALSE) {
+		return FALSE;
+	}
+	if(admission_decision_test(suite->pool) == FALSE) {
+		return FALSE;
+	}
+	if(admission_server_load_test(suite->pool) == FALSE) {
+		return FALSE;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Admission Test Passed");
+	return TRUE;
+}
+
+apt_test_suite_t* admission_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"admission",NULL,admission_test_run);
+	return suite;
+}
@@ -0,0 +1,239 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * Test of audio batching by engine workers. A media thread writes frames of
+ * increasing samples to the batcher of a channel, while the channel is closed
+ * by mrcp_engine_worker_channel_close_ex(). The batches must be delivered in
+ * order and none of them must be delivered after the channel is closed.
+ */
+
+#include <apr_thread_proc.h>
+#include <apr_atomic.h>
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "mrcp_engine_audio_batch.h"
+
+/** Number of channels opened and closed in turn */
+#define AUDIO_BATCH_TEST_CHANNEL_COUNT  20
+/** Duration of a batch (msec) */
+#define AUDIO_BATCH_TEST_BATCH_DURATION 20
+/** Sampling rate */
+#define AUDIO_BATCH_TEST_SAMPLING_RATE  8000
+/** Number of samples in a frame (10 msec) */
+#define AUDIO_BATCH_TEST_FRAME_SAMPLES  80
+/** Max time to wait for the close to be processed (usec) */
+#define AUDIO_BATCH_TEST_CLOSE_TIMEOUT  (5 * APR_USEC_PER_SEC)
+
+typedef struct audio_batch_test_t audio_batch_test_t;
+
+/** Audio batch test channel */
+struct audio_batch_test_t {
+	/** Engine channel */
+	mrcp_engine_channel_t       *channel;
+	/** Audio batcher */
+	mrcp_engine_audio_batcher_t *batcher;
+
+	/** Next sample to expect (accessed by the worker only) */
+	apr_uint16_t                 next_sample;
+	/** Number of bytes dropped so far (accessed by the worker only) */
+	apr_size_t                   dropped;
+	/** Number of batches delivered */
+	volatile apr_uint32_t        batch_count;
+	/** Number of batches delivered out of order */
+	volatile apr_uint32_t        disorder_count;
+	/** Number of batches delivered after close */
+	volatile apr_uint32_t        late_count;
+	/** Whether the close is processed */
+	volatile apr_uint32_t        closed;
+	/** Whether the media thread must stop */
+	volatile apr_uint32_t        stop;
+};
+
+static apt_bool_t audio_batch_test_request_process(mrcp_engine_channel_t *channel, mrcp_message_t *request)
+{
+	return TRUE;
+}
+
+static apt_bool_t audio_batch_test_channel_close(mrcp_engine_channel_t *channel)
+{
+	audio_batch_test_t *test = channel->method_obj;
+	apr_atomic_set32(&test->closed,TRUE);
+	return TRUE;
+}
+
+static apt_bool_t audio_batch_test_batch_process(mrcp_engine_channel_t *channel, const mrcp_engine_audio_batch_t *batch)
+{
+	audio_batch_test_t *test = channel->method_obj;
+	const apr_uint16_t *samples = (const apr_uint16_t*)batch->data;
+	apr_size_t count = batch->size / sizeof(apr_uint16_t);
+	apr_size_t i;
+
+	if(apr_atomic_read32(&test->closed) == TRUE) {
+		apr_atomic_inc32(&test->late_count);
+	}
+	apr_atomic_inc32(&test->batch_count);
+	test->dropped += batch->dropped;
+
+	/* samples are consecutive, unless frames are dropped on ring overflow, but never go back */
+	for(i = 0; i < count; i++) {
+		apr_uint16_t distance = (apr_uint16_t)(samples[i] - test->next_sample);
+		if(distance >= 0x8000 || (distance && !test->dropped)) {
+			apr_atomic_inc32(&test->disorder_count);
+			break;
+		}
+		test->next_sample = samples[i] + 1;
+	}
+	return TRUE;
+}
+
+static const mrcp_engine_worker_vtable_t audio_batch_test_vtable = {
+	NULL,
+	audio_batch_test_channel_close,
+	audio_batch_test_request_process,
+	audio_batch_test_batch_process
+};
+
+/** Media thread */
+static void* APR_THREAD_FUNC audio_batch_test_media_proc(apr_thread_t *thread, void *data)
+{
+	audio_batch_test_t *test = data;
+	apr_uint16_t samples[AUDIO_BATCH_TEST_FRAME_SAMPLES];
+	apr_uint16_t sample = 0;
+	mpf_frame_t frame;
+	apr_size_t i;
+
+	frame.type = MEDIA_FRAME_TYPE_AUDIO;
+	frame.marker = MPF_MARKER_NONE;
+	frame.codec_frame.buffer = samples;
+	frame.codec_frame.size = sizeof(samples);
+	while(apr_atomic_read32(&test->stop) == FALSE) {
+		for(i = 0; i < AUDIO_BATCH_TEST_FRAME_SAMPLES; i++) {
+			samples[i] = sample++;
+		}
+		mrcp_engine_audio_batcher_write(test->batcher,&frame);
+		/* faster than real time, but let the worker keep up */
+		apr_sleep(200);
+	}
+	return NULL;
+}
+
+/** Write audio to a channel and close it meanwhile */
+static apt_bool_t audio_batch_test_channel_run(mrcp_engine_worker_pool_t *worker_pool, apr_size_t index, apr_pool_t *pool)
+{
+	audio_batch_test_t test;
+	mpf_codec_descriptor_t descriptor;
+	apr_thread_t *thread;
+	apr_status_t rv;
+	apr_time_t start;
+	apt_bool_t status = TRUE;
+
+	test.channel = apr_pcalloc(pool,sizeof(mrcp_engine_channel_t));
+	test.channel->method_obj = &test;
+	test.channel->pool = pool;
+	test.batcher = mrcp_engine_audio_batcher_create(worker_pool,test.channel,
+						AUDIO_BATCH_TEST_BATCH_DURATION,AUDIO_BATCH_TEST_SAMPLING_RATE,pool);
+	test.next_sample = 0;
+	test.dropped = 0;
+	test.batch_count = 0;
+	test.disorder_count = 0;
+	test.late_count = 0;
+	test.closed = FALSE;
+	test.stop = FALSE;
+
+	mpf_codec_descriptor_init(&descriptor);
+	descriptor.sampling_rate = AUDIO_BATCH_TEST_SAMPLING_RATE;
+	descriptor.channel_count = 1;
+	if(!test.batcher || mrcp_engine_audio_batcher_open(test.batcher,&descriptor) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Open Audio Batcher");
+		return FALSE;
+	}
+
+	if(apr_thread_create(&thread,NULL,audio_batch_test_media_proc,&test,pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Media Thread");
+		return FALSE;
+	}
+
+	/* vary the moment of close, so that it races with the signals of the media thread */
+	apr_sleep((10 + index % 7) * 1000);
+	mrcp_engine_worker_channel_close_ex(worker_pool,test.channel,test.batcher);
+
+	start = apr_time_now();
+	while(apr_atomic_read32(&test.closed) == FALSE) {
+		if(apr_time_now() - start > AUDIO_BATCH_TEST_CLOSE_TIMEOUT) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Audio Batch Test: close is not processed [%"APR_SIZE_T_FMT"]",index);
+			status = FALSE;
+			break;
+		}
+		apr_sleep(1000);
+	}
+
+	/* keep writing after close, nothing must be delivered */
+	apr_sleep(20000);
+	apr_atomic_set32(&test.stop,TRUE);
+	apr_thread_join(&rv,thread);
+
+	if(!test.batch_count || test.disorder_count || test.late_count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Audio Batch Test Failed [%"APR_SIZE_T_FMT"]: batches [%u] out of order [%u] after close [%u]",
+			index,
+			test.batch_count,
+			test.disorder_count,
+			test.late_count);
+		status = FALSE;
+	}
+	return status;
+}
+
+static apt_bool_t audio_batch_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	mrcp_engine_worker_pool_t *worker_pool;
+	apr_pool_t *pool;
+	apr_size_t i;
+	apt_bool_t status = TRUE;
+
+	worker_pool = mrcp_engine_worker_pool_create(NULL,"Audio Batch Test",&audio_batch_test_vtable,suite->pool);
+	if(!worker_pool) {
+		return FALSE;
+	}
+	if(mrcp_engine_worker_pool_start(worker_pool) == FALSE) {
+		mrcp_engine_worker_pool_destroy(worker_pool);
+		return FALSE;
+	}
+
+	for(i = 0; i < AUDIO_BATCH_TEST_CHANNEL_COUNT && status == TRUE; i++) {
+		/* the channel is destroyed right after the close is processed, as the server does */
+		if(apr_pool_create(&pool,suite->pool) != APR_SUCCESS) {
+			status = FALSE;
+			break;
+		}
+		status = audio_batch_test_channel_run(worker_pool,i,pool);
+		apr_pool_destroy(pool);
+	}
+
+	mrcp_engine_worker_pool_terminate(worker_pool);
+	mrcp_engine_worker_pool_destroy(worker_pool);
+	if(status == TRUE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Audio Batch Test Passed: channels [%d]",AUDIO_BATCH_TEST_CHANNEL_COUNT);
+	}
+	return status;
+}
+
+apt_test_suite_t* audio_batch_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"audio-batch",NULL,audio_batch_test_run);
+	return suite;
+}
@@ -0,0 +1,249 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * Test of the audio producer. Streams of consecutive samples are written in
+ * chunks of odd size and read back frame by frame, while the positions wrap
+ * around the ring, and streams are written back to back before the completion
+ * of the previous ones is read.
+ */
+
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "mrcp_engine_audio_producer.h"
+
+/** Sampling rate */
+#define AUDIO_PRODUCER_TEST_SAMPLING_RATE 8000
+/** Prefetch duration (msec) */
+#define AUDIO_PRODUCER_TEST_PREFETCH      20
+/** Capacity duration (msec) */
+#define AUDIO_PRODUCER_TEST_CAPACITY      60
+/** Number of samples in a frame (10 msec) */
+#define AUDIO_PRODUCER_TEST_FRAME_SAMPLES 80
+/** Number of samples in a chunk written at once */
+#define AUDIO_PRODUCER_TEST_CHUNK_SAMPLES 37
+
+/** Write samples starting from the specified one, return the number of samples written */
+static apr_size_t audio_producer_test_write(mrcp_engine_audio_producer_t *producer, apr_uint16_t first, apr_size_t count)
+{
+	apr_uint16_t samples[AUDIO_PRODUCER_TEST_CHUNK_SAMPLES];
+	apr_size_t space = mrcp_engine_audio_producer_space_get(producer) / sizeof(apr_uint16_t);
+	apr_size_t i;
+	if(count > AUDIO_PRODUCER_TEST_CHUNK_SAMPLES) {
+		count = AUDIO_PRODUCER_TEST_CHUNK_SAMPLES;
+	}
+	if(count > space) {
+		count = space;
+	}
+	for(i = 0; i < count; i++) {
+		samples[i] = (apr_uint16_t)(first + i);
+	}
+	return mrcp_engine_audio_producer_write(producer,(const char*)samples,count * sizeof(apr_uint16_t)) / sizeof(apr_uint16_t);
+}
+
+/** Read frame and check the samples expected to follow, the rest of the frame must be silence */
+static mrcp_audio_producer_status_e audio_producer_test_read(mrcp_engine_audio_producer_t *producer, apr_uint16_t *next, apr_size_t *remaining, apt_bool_t *valid)
+{
+	apr_uint16_t samples[AUDIO_PRODUCER_TEST_FRAME_SAMPLES];
+	mpf_frame_t frame;
+	mrcp_audio_producer_status_e status;
+	apr_size_t i;
+
+	frame.type = MEDIA_FRAME_TYPE_NONE;
+	frame.marker = MPF_MARKER_NONE;
+	frame.codec_frame.buffer = samples;
+	frame.codec_frame.size = sizeof(samples);
+	status = mrcp_engine_audio_producer_read(producer,&frame);
+	if(status != MRCP_AUDIO_PRODUCER_AUDIO) {
+		return status;
+	}
+
+	for(i = 0; i < AUDIO_PRODUCER_TEST_FRAME_SAMPLES; i++) {
+		if(*remaining) {
+			if(samples[i] != *next) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Sample [%d] expected [%d]",samples[i],*next);
+				*valid = FALSE;
+				break;
+			}
+			(*next)++;
+			(*remaining)--;
+		}
+		else if(samples[i] != 0) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Sample [%d] expected silence",samples[i]);
+			*valid = FALSE;
+			break;
+		}
+	}
+	return status;
+}
+
+/** Read complete stream, which is entirely written beforehand */
+static apt_bool_t audio_producer_test_stream_read(mrcp_engine_audio_producer_t *producer, apr_uint16_t first, apr_size_t count)
+{
+	mrcp_audio_producer_status_e status;
+	apt_bool_t valid = TRUE;
+	do {
+		status = audio_producer_test_read(producer,&first,&count,&valid);
+	}
+	while(status == MRCP_AUDIO_PRODUCER_AUDIO && valid == TRUE);
+
+	if(status != MRCP_AUDIO_PRODUCER_COMPLETE || count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Status [%d] samples left [%"APR_SIZE_T_FMT"]",status,count);
+		return FALSE;
+	}
+	return valid;
+}
+
+/** Stream audio through the ring, which wraps around a number of times */
+static apt_bool_t audio_producer_wraparound_test(mrcp_engine_audio_producer_t *producer)
+{
+	apr_size_t stream_samples = AUDIO_PRODUCER_TEST_SAMPLING_RATE;
+	apr_size_t written = 0;
+	apr_uint16_t next = 0;
+	apr_size_t remaining = stream_samples;
+	mrcp_audio_producer_status_e status = MRCP_AUDIO_PRODUCER_IDLE;
+	apt_bool_t valid = TRUE;
+	apt_bool_t complete = FALSE;
+
+	if(audio_producer_test_read(producer,&next,&remaining,&valid) != MRCP_AUDIO_PRODUCER_IDLE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Audio Producer Is Not Idle");
+		return FALSE;
+	}
+
+	while(valid == TRUE) {
+		/* fill the ring up, then take a frame off */
+		while(written < stream_samples) {
+			apr_size_t count = audio_producer_test_write(producer,(apr_uint16_t)written,stream_samples - written);
+			if(!count) {
+				break;
+			}
+			written += count;
+		}
+		if(written == stream_samples && complete == FALSE) {
+			complete = mrcp_engine_audio_producer_complete(producer);
+		}
+
+		status = audio_producer_test_read(producer,&next,&remaining,&valid);
+		if(status != MRCP_AUDIO_PRODUCER_AUDIO) {
+			break;
+		}
+	}
+
+	if(valid == FALSE || status != MRCP_AUDIO_PRODUCER_COMPLETE || remaining) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Wraparound Test Failed: status [%d] samples left [%"APR_SIZE_T_FMT"]",status,remaining);
+		return FALSE;
+	}
+	if(mrcp_engine_audio_producer_underrun_count_get(producer)) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Wraparound Test Failed: unexpected underrun");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Write streams back to back, then read them */
+static apt_bool_t audio_producer_back_to_back_test(mrcp_engine_audio_producer_t *producer)
+{
+	/* a stream shorter than the prefetch depth and a stream ending in the middle of a frame */
+	const apr_size_t counts[] = {50, 130, 0};
+	const apr_uint16_t firsts[] = {1000, 2000, 3000};
+	apr_size_t i;
+	apr_size_t written;
+
+	for(i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+		for(written = 0; written < counts[i]; ) {
+			written += audio_producer_test_write(producer,(apr_uint16_t)(firsts[i] + written),counts[i] - written);
+		}
+		if(mrcp_engine_audio_producer_complete(producer) == FALSE) {
+			return FALSE;
+		}
+	}
+
+	for(i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+		if(audio_producer_test_stream_read(producer,firsts[i],counts[i]) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Back to Back Test Failed: stream [%"APR_SIZE_T_FMT"]",i);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/** Complete more streams than can be pending, then flush them */
+static apt_bool_t audio_producer_flush_test(mrcp_engine_audio_producer_t *producer)
+{
+	apr_uint16_t next = 0;
+	apr_size_t remaining = 0;
+	apt_bool_t valid = TRUE;
+	apr_size_t i;
+
+	for(i = 0; mrcp_engine_audio_producer_complete(producer) == TRUE; i++) {
+		audio_producer_test_write(producer,0,AUDIO_PRODUCER_TEST_CHUNK_SAMPLES);
+		if(i > 16) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Flush Test Failed: pending streams are not limited");
+			return FALSE;
+		}
+	}
+	audio_producer_test_write(producer,0,AUDIO_PRODUCER_TEST_CHUNK_SAMPLES);
+
+	mrcp_engine_audio_producer_flush(producer);
+	if(audio_producer_test_read(producer,&next,&remaining,&valid) != MRCP_AUDIO_PRODUCER_IDLE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Flush Test Failed: audio producer is not idle");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static apt_bool_t audio_producer_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	mrcp_engine_audio_producer_t *producer;
+	mpf_codec_descriptor_t descriptor;
+
+	producer = mrcp_engine_audio_producer_create(
+					AUDIO_PRODUCER_TEST_PREFETCH,
+					AUDIO_PRODUCER_TEST_CAPACITY,
+					AUDIO_PRODUCER_TEST_SAMPLING_RATE,
+					suite->pool);
+	mpf_codec_descriptor_init(&descriptor);
+	descriptor.sampling_rate = AUDIO_PRODUCER_TEST_SAMPLING_RATE;
+	descriptor.channel_count = 1;
+	if(!producer || mrcp_engine_audio_producer_open(producer,&descriptor) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Open Audio Producer");
+		return FALSE;
+	}
+
+	if(audio_producer_wraparound_test(producer) == FALSE) {
+		return FALSE;
+	}
+	/* the positions are not reset between streams */
+	if(audio_producer_back_to_back_test(producer) == FALSE) {
+		return FALSE;
+	}
+	if(audio_producer_flush_test(producer) == FALSE) {
+		return FALSE;
+	}
+	/* the producer is still usable after flush */
+	if(audio_producer_back_to_back_test(producer) == FALSE) {
+		return FALSE;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Audio Producer Test Passed");
+	return TRUE;
+}
+
+apt_test_suite_t* audio_producer_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"audio-producer",NULL,audio_producer_test_run);
+	return suite;
+}
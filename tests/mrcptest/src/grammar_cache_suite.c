@@ -0,0 +1,426 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * Test of the grammar cache shared by engine channels. Grammars are looked up by
+ * Content-Id, Content-Type and content, grammars with the same hash are chained,
+ * grammars which are referenced survive eviction, the others are evicted in LRU
+ * order once the memory budget is exceeded, and a grammar compiled concurrently
+ * by two channels is cached only once.
+ */
+
+#include <apr_tables.h>
+#include <string.h>
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "mrcp_engine_grammar_cache.h"
+
+/** Memory budget of the cache (KB) */
+#define GRAMMAR_CACHE_TEST_BUDGET        "1"
+/** Size of a compiled artifact reported to the cache (two grammars fit in the budget, three don't) */
+#define GRAMMAR_CACHE_TEST_ARTIFACT_SIZE 300
+
+/** Grammar cache test */
+typedef struct grammar_cache_test_t grammar_cache_test_t;
+struct grammar_cache_test_t {
+	/** Cache under test */
+	mrcp_engine_grammar_cache_t *cache;
+	/** Number of artifacts compiled */
+	apr_size_t                   compile_count;
+	/** Number of artifacts destroyed */
+	apr_size_t                   destroy_count;
+	/** Acquire the same grammar from within the compile hook once (as another channel would do) */
+	apt_bool_t                   nested_acquire;
+	/** Grammar acquired from within the compile hook */
+	mrcp_engine_grammar_t       *nested_grammar;
+};
+
+static apt_bool_t grammar_cache_test_compile(void *obj, const mrcp_engine_grammar_t *grammar, apr_pool_t *pool, void **artifact, apr_size_t *size)
+{
+	grammar_cache_test_t *test = obj;
+	const apt_str_t *content = mrcp_engine_grammar_content_get(grammar);
+	apt_str_t invalid;
+	apt_string_set(&invalid,"invalid");
+	if(apt_string_compare(content,&invalid) == TRUE) {
+		return FALSE;
+	}
+
+	if(test->nested_acquire == TRUE) {
+		/* the lock of the cache is not held while compiling, the same grammar is compiled meanwhile */
+		test->nested_acquire = FALSE;
+		test->nested_grammar = mrcp_engine_grammar_acquire(
+									test->cache,
+									mrcp_engine_grammar_content_id_get(grammar),
+									mrcp_engine_grammar_content_type_get(grammar),
+									content);
+	}
+
+	*artifact = apr_pstrmemdup(pool,content->buf,content->length);
+	*size = GRAMMAR_CACHE_TEST_ARTIFACT_SIZE;
+	test->compile_count++;
+	return TRUE;
+}
+
+static void grammar_cache_test_destroy(void *obj, const mrcp_engine_grammar_t *grammar, void *artifact)
+{
+	grammar_cache_test_t *test = obj;
+	test->destroy_count++;
+}
+
+static const mrcp_engine_grammar_compiler_t grammar_cache_test_compiler = {
+	grammar_cache_test_compile,
+	grammar_cache_test_destroy
+};
+
+/** Create cache with the budget set by the engine param, or with the default budget */
+static apt_bool_t grammar_cache_test_create(grammar_cache_test_t *test, apt_bool_t budget, apr_pool_t *pool)
+{
+	mrcp_engine_t *engine = NULL;
+	if(budget == TRUE) {
+		engine = apr_pcalloc(pool,sizeof(mrcp_engine_t));
+		engine->config = apr_pcalloc(pool,sizeof(mrcp_engine_config_t));
+		engine->config->params = apr_table_make(pool,1);
+		apr_table_set(engine->config->params,MRCP_ENGINE_GRAMMAR_CACHE_SIZE_PARAM,GRAMMAR_CACHE_TEST_BUDGET);
+	}
+	test->compile_count = 0;
+	test->destroy_count = 0;
+	test->nested_acquire = FALSE;
+	test->nested_grammar = NULL;
+	test->cache = mrcp_engine_grammar_cache_create(engine,&grammar_cache_test_compiler,test,pool);
+	if(!test->cache) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Grammar Cache");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Acquire grammar by Content-Id, Content-Type and content */
+static mrcp_engine_grammar_t* grammar_cache_test_acquire(grammar_cache_test_t *test, const char *content_id, const char *content_type, const char *content)
+{
+	apt_str_t id;
+	apt_str_t type;
+	apt_str_t str;
+	apt_string_set(&id,content_id);
+	apt_string_set(&type,content_type);
+	apt_string_set(&str,content);
+	return mrcp_engine_grammar_acquire(test->cache,&id,&type,&str);
+}
+
+/** Check the grammar is found (or compiled) and has the expected content */
+static apt_bool_t grammar_cache_test_grammar_check(const mrcp_engine_grammar_t *grammar, const char *content)
+{
+	apt_str_t str;
+	const char *artifact;
+	if(!grammar) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No Grammar <%s>",content);
+		return FALSE;
+	}
+	apt_string_set(&str,content);
+	artifact = mrcp_engine_grammar_artifact_get(grammar);
+	if(apt_string_compare(mrcp_engine_grammar_content_get(grammar),&str) == FALSE ||
+		!artifact || strcmp(artifact,content) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Grammar <%s>",content);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Check the statistics of the cache */
+static apt_bool_t grammar_cache_test_stats_check(grammar_cache_test_t *test, const char *step,
+		apr_size_t hit_count, apr_size_t miss_count, apr_size_t failure_count, apr_size_t eviction_count, apr_size_t grammar_count)
+{
+	mrcp_engine_grammar_cache_stats_t stats;
+	mrcp_engine_grammar_cache_stats_get(test->cache,&stats);
+	if(stats.hit_count != hit_count || stats.miss_count != miss_count || stats.failure_count != failure_count ||
+		stats.eviction_count != eviction_count || stats.grammar_count != grammar_count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Grammar Cache Stats [%s]: hits [%"APR_SIZE_T_FMT"] misses [%"APR_SIZE_T_FMT"] failures [%"APR_SIZE_T_FMT"] evictions [%"APR_SIZE_T_FMT"] grammars [%"APR_SIZE_T_FMT"]",
+			step,
+			stats.hit_count,
+			stats.miss_count,
+			stats.failure_count,
+			stats.eviction_count,
+			stats.grammar_count);
+		return FALSE;
+	}
+	if(!stats.grammar_count && stats.size) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Grammar Cache Size [%s]: [%"APR_SIZE_T_FMT" bytes]",step,stats.size);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Test hits and misses, the same content with a different Content-Id, and compilation failures */
+static apt_bool_t grammar_cache_lookup_test(apr_pool_t *pool)
+{
+	grammar_cache_test_t test;
+	mrcp_engine_grammar_t *grammar1;
+	mrcp_engine_grammar_t *grammar2;
+	mrcp_engine_grammar_t *grammar3;
+	apt_bool_t status = FALSE;
+	if(grammar_cache_test_create(&test,FALSE,pool) == FALSE) {
+		return FALSE;
+	}
+
+	do {
+		grammar1 = grammar_cache_test_acquire(&test,"request1@form-level","application/srgs+xml","<grammar>yes</grammar>");
+		if(grammar_cache_test_grammar_check(grammar1,"<grammar>yes</grammar>") == FALSE) break;
+		if(grammar_cache_test_stats_check(&test,"miss",0,1,0,0,1) == FALSE) break;
+
+		grammar2 = grammar_cache_test_acquire(&test,"request1@form-level","application/srgs+xml","<grammar>yes</grammar>");
+		if(grammar2 != grammar1) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Grammar Not Found in Cache");
+			break;
+		}
+		if(grammar_cache_test_stats_check(&test,"hit",1,1,0,0,1) == FALSE) break;
+
+		/* the same content with a different Content-Id is a different grammar */
+		grammar3 = grammar_cache_test_acquire(&test,"request2@form-level","application/srgs+xml","<grammar>yes</grammar>");
+		if(grammar_cache_test_grammar_check(grammar3,"<grammar>yes</grammar>") == FALSE) break;
+		if(grammar3 == grammar1) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Grammar with Different Content-Id Found in Cache");
+			break;
+		}
+		if(grammar_cache_test_stats_check(&test,"content-id",1,2,0,0,2) == FALSE) break;
+
+		/* the same content with a different Content-Type is a different grammar as well */
+		grammar2 = grammar_cache_test_acquire(&test,"request1@form-level","application/xml","<grammar>yes</grammar>");
+		if(!grammar2 || grammar2 == grammar1) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Grammar with Different Content-Type Found in Cache");
+			break;
+		}
+		mrcp_engine_grammar_release(test.cache,grammar2);
+		if(grammar_cache_test_stats_check(&test,"content-type",1,3,0,0,3) == FALSE) break;
+
+		/* failures are counted and not cached */
+		if(grammar_cache_test_acquire(&test,"request3@form-level","application/srgs+xml","invalid") != NULL) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Grammar Compiled");
+			break;
+		}
+		if(grammar_cache_test_stats_check(&test,"failure",1,4,1,0,3) == FALSE) break;
+
+		mrcp_engine_grammar_release(test.cache,grammar1);
+		mrcp_engine_grammar_release(test.cache,grammar1);
+		mrcp_engine_grammar_release(test.cache,grammar3);
+		/* unreferenced grammars are kept within the budget */
+		if(grammar_cache_test_stats_check(&test,"release",1,4,1,0,3) == FALSE) break;
+		status = TRUE;
+	}
+	while(0);
+
+	mrcp_engine_grammar_cache_destroy(test.cache);
+	if(status == TRUE && test.destroy_count != test.compile_count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Artifacts Not Destroyed: compiled [%"APR_SIZE_T_FMT"] destroyed [%"APR_SIZE_T_FMT"]",
+			test.compile_count,test.destroy_count);
+		status = FALSE;
+	}
+	return status;
+}
+
+/** Test grammars with the same hash and different content */
+static apt_bool_t grammar_cache_collision_test(apr_pool_t *pool)
+{
+	grammar_cache_test_t test;
+	mrcp_engine_grammar_t *grammar1;
+	mrcp_engine_grammar_t *grammar2;
+	mrcp_engine_grammar_t *grammar;
+	apt_bool_t status = FALSE;
+	if(grammar_cache_test_create(&test,TRUE,pool) == FALSE) {
+		return FALSE;
+	}
+
+	do {
+		/* the fields are separated by hashing 0xFF, so moving the text between the fields around
+		   the byte 0xFF keeps the hash, while the Content-Type and content differ */
+		grammar1 = grammar_cache_test_acquire(&test,"","text/plain","yes\xFFno");
+		grammar2 = grammar_cache_test_acquire(&test,"","text/plain\xFFyes","no");
+		if(grammar_cache_test_grammar_check(grammar1,"yes\xFFno") == FALSE ||
+			grammar_cache_test_grammar_check(grammar2,"no") == FALSE) break;
+		if(grammar1 == grammar2) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Grammars with Same Hash Not Distinguished");
+			break;
+		}
+		if(grammar_cache_test_stats_check(&test,"same hash",0,2,0,0,2) == FALSE) break;
+
+		/* both are found in the chain, the second one is its head */
+		if(grammar_cache_test_acquire(&test,"","text/plain","yes\xFFno") != grammar1 ||
+			grammar_cache_test_acquire(&test,"","text/plain\xFFyes","no") != grammar2) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Grammars with Same Hash Not Found in Cache");
+			break;
+		}
+		if(grammar_cache_test_stats_check(&test,"same hash hit",2,2,0,0,2) == FALSE) break;
+
+		/* evict the head of the chain, the rest of the chain must still be found */
+		mrcp_engine_grammar_release(test.cache,grammar2);
+		mrcp_engine_grammar_release(test.cache,grammar2);
+		grammar = grammar_cache_test_acquire(&test,"","text/plain","maybe");
+		if(grammar_cache_test_grammar_check(grammar,"maybe") == FALSE) break;
+		if(grammar_cache_test_stats_check(&test,"chain head evicted",2,3,0,1,2) == FALSE) break;
+		if(grammar_cache_test_acquire(&test,"","text/plain","yes\xFFno") != grammar1) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Grammar Not Found after Head of Chain Evicted");
+			break;
+		}
+		if(grammar_cache_test_stats_check(&test,"chain rest hit",3,3,0,1,2) == FALSE) break;
+
+		mrcp_engine_grammar_release(test.cache,grammar1);
+		mrcp_engine_grammar_release(test.cache,grammar1);
+		mrcp_engine_grammar_release(test.cache,grammar1);
+		mrcp_engine_grammar_release(test.cache,grammar);
+		status = TRUE;
+	}
+	while(0);
+
+	mrcp_engine_grammar_cache_destroy(test.cache);
+	return status;
+}
+
+/** Test pinned grammars surviving eviction and LRU order of eviction */
+static apt_bool_t grammar_cache_eviction_test(apr_pool_t *pool)
+{
+	grammar_cache_test_t test;
+	mrcp_engine_grammar_t *grammar_a;
+	mrcp_engine_grammar_t *grammar_b;
+	mrcp_engine_grammar_t *grammar_c;
+	mrcp_engine_grammar_cache_stats_t stats;
+	apt_bool_t status = FALSE;
+	if(grammar_cache_test_create(&test,TRUE,pool) == FALSE) {
+		return FALSE;
+	}
+
+	do {
+		grammar_a = grammar_cache_test_acquire(&test,"a","text/plain","alpha");
+		grammar_b = grammar_cache_test_acquire(&test,"b","text/plain","bravo");
+		if(!grammar_a || !grammar_b) break;
+		/* both fit in the budget and are kept unreferenced, B is used more recently */
+		mrcp_engine_grammar_release(test.cache,grammar_a);
+		mrcp_engine_grammar_release(test.cache,grammar_b);
+		if(grammar_cache_test_stats_check(&test,"within budget",0,2,0,0,2) == FALSE) break;
+
+		/* the budget is exceeded, the least recently used A is evicted */
+		grammar_c = grammar_cache_test_acquire(&test,"c","text/plain","charlie");
+		if(grammar_cache_test_grammar_check(grammar_c,"charlie") == FALSE) break;
+		if(grammar_cache_test_stats_check(&test,"lru evicted",0,3,0,1,2) == FALSE) break;
+		if(test.destroy_count != 1) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Evicted Artifact Not Destroyed");
+			break;
+		}
+		grammar_b = grammar_cache_test_acquire(&test,"b","text/plain","bravo");
+		if(grammar_cache_test_grammar_check(grammar_b,"bravo") == FALSE) break;
+		if(grammar_cache_test_stats_check(&test,"lru kept",1,3,0,1,2) == FALSE) break;
+
+		/* all the grammars are referenced (pinned), none is evicted though the budget is exceeded */
+		grammar_a = grammar_cache_test_acquire(&test,"a","text/plain","alpha");
+		if(grammar_cache_test_grammar_check(grammar_a,"alpha") == FALSE) break;
+		if(grammar_cache_test_stats_check(&test,"pinned",1,4,0,1,3) == FALSE) break;
+		mrcp_engine_grammar_cache_stats_get(test.cache,&stats);
+		if(stats.size <= stats.max_size) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Budget Not Exceeded [%"APR_SIZE_T_FMT" bytes]",stats.size);
+			break;
+		}
+
+		/* C is the least recently used, once released it is evicted */
+		mrcp_engine_grammar_release(test.cache,grammar_c);
+		if(grammar_cache_test_stats_check(&test,"released evicted",1,4,0,2,2) == FALSE) break;
+		mrcp_engine_grammar_cache_stats_get(test.cache,&stats);
+		if(stats.size > stats.max_size) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Budget Exceeded [%"APR_SIZE_T_FMT" bytes]",stats.size);
+			break;
+		}
+		if(grammar_cache_test_acquire(&test,"a","text/plain","alpha") != grammar_a ||
+			grammar_cache_test_acquire(&test,"b","text/plain","bravo") != grammar_b) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Pinned Grammars Not Found in Cache");
+			break;
+		}
+		if(grammar_cache_test_stats_check(&test,"pinned hit",3,4,0,2,2) == FALSE) break;
+
+		mrcp_engine_grammar_release(test.cache,grammar_a);
+		mrcp_engine_grammar_release(test.cache,grammar_a);
+		mrcp_engine_grammar_release(test.cache,grammar_b);
+		mrcp_engine_grammar_release(test.cache,grammar_b);
+		status = TRUE;
+	}
+	while(0);
+
+	mrcp_engine_grammar_cache_destroy(test.cache);
+	return status;
+}
+
+/** Test the same grammar compiled concurrently */
+static apt_bool_t grammar_cache_duplicate_test(apr_pool_t *pool)
+{
+	grammar_cache_test_t test;
+	mrcp_engine_grammar_t *grammar;
+	apt_bool_t status = FALSE;
+	if(grammar_cache_test_create(&test,FALSE,pool) == FALSE) {
+		return FALSE;
+	}
+
+	do {
+		test.nested_acquire = TRUE;
+		grammar = grammar_cache_test_acquire(&test,"request1@form-level","application/srgs+xml","<grammar>yes</grammar>");
+		if(grammar_cache_test_grammar_check(grammar,"<grammar>yes</grammar>") == FALSE) break;
+		/* the grammar compiled first is cached, the duplicate is destroyed */
+		if(grammar != test.nested_grammar) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Duplicate Grammar Returned");
+			break;
+		}
+		if(test.compile_count != 2 || test.destroy_count != 1) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Artifacts: compiled [%"APR_SIZE_T_FMT"] destroyed [%"APR_SIZE_T_FMT"]",
+				test.compile_count,test.destroy_count);
+			break;
+		}
+		if(grammar_cache_test_stats_check(&test,"duplicate",0,2,0,0,1) == FALSE) break;
+
+		/* the grammar is referenced by both */
+		mrcp_engine_grammar_release(test.cache,grammar);
+		if(grammar_cache_test_acquire(&test,"request1@form-level","application/srgs+xml","<grammar>yes</grammar>") != grammar) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Grammar Not Found in Cache");
+			break;
+		}
+		if(grammar_cache_test_stats_check(&test,"duplicate hit",1,2,0,0,1) == FALSE) break;
+		mrcp_engine_grammar_release(test.cache,grammar);
+		mrcp_engine_grammar_release(test.cache,grammar);
+		status = TRUE;
+	}
+	while(0);
+
+	mrcp_engine_grammar_cache_destroy(test.cache);
+	return status;
+}
+
+static apt_bool_t grammar_cache_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	if(grammar_cache_lookup_test(suite->pool) == FALSE) {
+		return FALSE;
+	}
+	if(grammar_cache_collision_test(suite->pool) == FALSE) {
+		return FALSE;
+	}
+	if(grammar_cache_eviction_test(suite->pool) == FALSE) {
+		return FALSE;
+	}
+	if(grammar_cache_duplicate_test(suite->pool) == FALSE) {
+		return FALSE;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Grammar Cache Test Passed");
+	return TRUE;
+}
+
+apt_test_suite_t* grammar_cache_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"grammar-cache",NULL,grammar_cache_test_run);
+	return suite;
+}
@@ -18,8 +18,14 @@
 #include "apt_log.h"
 
 apt_test_suite_t* parse_gen_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* parse_gen_bench_suite_create(apr_pool_t *pool);
 apt_test_suite_t* set_get_test_suite_create(apr_pool_t *pool);
 apt_test_suite_t* transparent_set_get_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* audio_batch_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* audio_producer_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* admission_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* grammar_cache_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* sharding_test_suite_create(apr_pool_t *pool);
 
 int main(int argc, const char * const *argv)
 {
@@ -43,6 +49,18 @@ int main(int argc, const char * const *argv)
 	apt_test_framework_suite_add(test_framework,test_suite);
 	test_suite = parse_gen_test_suite_create(pool);
 	apt_test_framework_suite_add(test_framework,test_suite);
+	test_suite = parse_gen_bench_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+	test_suite = audio_batch_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+	test_suite = audio_producer_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+	test_suite = admission_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+	test_suite = grammar_cache_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+	test_suite = sharding_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
 
 	/* run tests */
 	apt_test_framework_run(test_framework,argc,argv);
@@ -0,0 +1,350 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Throughput benchmark of MRCPv2 parser and generator. The messages of the
+ * corpus directory are concatenated into a single stream, which is fed to
+ * the parser in segments of random size as if received by TCP reads, and
+ * every parsed message is generated back. The corpus is kept in the form
+ * the generator produces, so the generated stream must match the input byte
+ * for byte.
+ *
+ * Usage: mrcptest parse-gen-bench [passes] [max segment size] [corpus dir]
+ */
+
+#include <stdlib.h>
+#include <apr_file_info.h>
+#include <apr_file_io.h>
+#include <apr_tables.h>
+#include "apt_test_suite.h"
+#include "apt_pool.h"
+#include "apt_log.h"
+#include "mrcp_resource_loader.h"
+#include "mrcp_resource_factory.h"
+#include "mrcp_message.h"
+#include "mrcp_stream.h"
+
+/** Default number of passes over the corpus */
+#define PARSE_GEN_BENCH_PASS_COUNT   1000
+/** Default max size of a segment (TCP read) */
+#define PARSE_GEN_BENCH_SEGMENT_SIZE 1460
+/** Default corpus directory */
+#define PARSE_GEN_BENCH_CORPUS_DIR   "corpus"
+/** Size of receive and send buffers (same as MRCP_STREAM_BUFFER_SIZE of connections) */
+#define PARSE_GEN_BENCH_BUFFER_SIZE  1024
+
+typedef struct parse_gen_bench_t parse_gen_bench_t;
+
+/** Parse/generate benchmark */
+struct parse_gen_bench_t {
+	/** Parser, messages are allocated from recycled arenas */
+	mrcp_parser_t    *parser;
+	/** Generator */
+	mrcp_generator_t *generator;
+	/** Concatenated messages of the corpus */
+	char             *data;
+	/** Size of the data */
+	apr_size_t        size;
+	/** Number of messages in the data */
+	apr_size_t        message_count;
+	/** Max size of a segment */
+	apr_size_t        segment_size;
+
+	/** Number of messages parsed */
+	apr_size_t        parsed_count;
+	/** Number of invalid messages */
+	apr_size_t        invalid_count;
+	/** Number of bytes generated */
+	apr_size_t        generated_size;
+	/** Offset in the data the generated output is compared at */
+	apr_size_t        compare_pos;
+	/** Number of messages generated differently from the data */
+	apr_size_t        mismatch_count;
+	/** Pool memory consumed by parsed messages (available with pool debugging only) */
+	apr_size_t        pool_size;
+};
+
+/** Load messages of the corpus directory */
+static apt_bool_t parse_gen_bench_corpus_load(parse_gen_bench_t *bench, const char *dir_name, apr_pool_t *pool)
+{
+	apr_status_t rv;
+	apr_dir_t *dir;
+	apr_finfo_t finfo;
+	apr_file_t *file;
+	char *file_path;
+	apr_size_t length;
+	apr_array_header_t *files;
+	int i;
+
+	if(apr_dir_open(&dir,dir_name,pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Cannot Open Directory [%s]",dir_name);
+		return FALSE;
+	}
+
+	files = apr_array_make(pool,16,sizeof(apr_finfo_t));
+	bench->size = 0;
+	do {
+		rv = apr_dir_read(&finfo,APR_FINFO_DIRENT | APR_FINFO_SIZE,dir);
+		if(rv == APR_SUCCESS && finfo.filetype == APR_REG && finfo.name && finfo.size > 0) {
+			finfo.name = apr_pstrdup(pool,finfo.name);
+			APR_ARRAY_PUSH(files,apr_finfo_t) = finfo;
+			bench->size += (apr_size_t)finfo.size;
+		}
+	}
+	while(rv == APR_SUCCESS);
+	apr_dir_close(dir);
+
+	bench->data = apr_palloc(pool,bench->size + 1);
+	bench->size = 0;
+	for(i=0; i<files->nelts; i++) {
+		finfo = APR_ARRAY_IDX(files,i,apr_finfo_t);
+		apr_filepath_merge(&file_path,dir_name,finfo.name,APR_FILEPATH_NATIVE,pool);
+		if(apr_file_open(&file,file_path,APR_FOPEN_READ | APR_FOPEN_BINARY,APR_OS_DEFAULT,pool) != APR_SUCCESS) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Open File [%s]",file_path);
+			return FALSE;
+		}
+		length = (apr_size_t)finfo.size;
+		apr_file_read_full(file,bench->data + bench->size,length,&length);
+		apr_file_close(file);
+		bench->size += length;
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Load File [%s] [%"APR_SIZE_T_FMT" bytes]",file_path,length);
+	}
+	bench->data[bench->size] = '\0';
+	return bench->size ? TRUE : FALSE;
+}
+
+/** Generate message in chunks of the send buffer size */
+static apt_bool_t parse_gen_bench_generate(parse_gen_bench_t *bench, mrcp_message_t *message)
+{
+	char buffer[PARSE_GEN_BENCH_BUFFER_SIZE];
+	apt_text_stream_t stream;
+	apt_message_status_e status;
+	apr_size_t length;
+	apt_bool_t match = TRUE;
+
+	do {
+		apt_text_stream_init(&stream,buffer,sizeof(buffer));
+		status = mrcp_generator_run(bench->generator,message,&stream);
+		length = stream.pos - stream.text.buf;
+		bench->generated_size += length;
+
+		/* the generated chunk must match the input it is parsed from */
+		if(match == TRUE) {
+			if(length > bench->size - bench->compare_pos ||
+				memcmp(stream.text.buf,bench->data + bench->compare_pos,length) != 0) {
+				match = FALSE;
+			}
+		}
+		bench->compare_pos += length;
+	}
+	while(status == APT_MESSAGE_STATUS_INCOMPLETE);
+
+	if(match == FALSE) {
+		bench->mismatch_count++;
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Generated Message Differs from Input [%"MRCP_REQUEST_ID_FMT"]",message->start_line.request_id);
+	}
+	return status == APT_MESSAGE_STATUS_COMPLETE ? TRUE : FALSE;
+}
+
+/** Feed the corpus to the parser once */
+static apt_bool_t parse_gen_bench_pass(parse_gen_bench_t *bench)
+{
+	char buffer[PARSE_GEN_BENCH_BUFFER_SIZE + 1];
+	apt_text_stream_t stream;
+	apt_message_status_e status;
+	mrcp_message_t *message;
+	apr_size_t pos = 0;
+	apr_size_t offset;
+	apr_size_t length;
+
+	bench->compare_pos = 0;
+	apt_text_stream_init(&stream,buffer,PARSE_GEN_BENCH_BUFFER_SIZE);
+	while(pos < bench->size) {
+		/* calculate offset remaining from the previous receive / if any */
+		offset = stream.pos - stream.text.buf;
+		/* calculate length of the next segment */
+		length = 1 + rand() % bench->segment_size;
+		if(length > PARSE_GEN_BENCH_BUFFER_SIZE - offset) {
+			length = PARSE_GEN_BENCH_BUFFER_SIZE - offset;
+			if(!length) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Receive Buffer Overflow");
+				return FALSE;
+			}
+		}
+		if(length > bench->size - pos) {
+			length = bench->size - pos;
+		}
+		memcpy(stream.pos,bench->data + pos,length);
+		pos += length;
+
+		/* calculate actual length of the stream */
+		stream.text.length = offset + length;
+		stream.pos[length] = '\0';
+		apt_text_stream_reset(&stream);
+
+		do {
+			message = NULL;
+			status = mrcp_parser_run(bench->parser,&stream,&message);
+			if(status == APT_MESSAGE_STATUS_COMPLETE) {
+				bench->parsed_count++;
+				if(parse_gen_bench_generate(bench,message) == FALSE) {
+					bench->invalid_count++;
+				}
+#if APR_POOL_DEBUG
+				bench->pool_size += apr_pool_num_bytes(message->pool,1);
+#endif
+				mrcp_message_destroy(message);
+			}
+			else if(status == APT_MESSAGE_STATUS_INVALID) {
+				bench->invalid_count++;
+			}
+		}
+		while(apt_text_is_eos(&stream) == FALSE);
+
+		/* scroll remaining stream */
+		apt_text_stream_scroll(&stream);
+	}
+
+	if(bench->compare_pos != bench->size) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Generated Size [%"APR_SIZE_T_FMT"] Differs from Input [%"APR_SIZE_T_FMT"]",
+			bench->compare_pos,
+			bench->size);
+		bench->mismatch_count++;
+	}
+	return TRUE;
+}
+
+static apt_bool_t parse_gen_bench_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	parse_gen_bench_t bench;
+	mrcp_resource_factory_t *factory;
+	mrcp_resource_loader_t *resource_loader;
+	apr_size_t pass_count = PARSE_GEN_BENCH_PASS_COUNT;
+	const char *dir_name = PARSE_GEN_BENCH_CORPUS_DIR;
+	apr_size_t i;
+	apr_size_t message_count;
+	apr_time_t start;
+	apr_interval_time_t elapsed;
+	double seconds;
+	apt_bool_t status = TRUE;
+
+	bench.segment_size = PARSE_GEN_BENCH_SEGMENT_SIZE;
+	if(argc > 0) {
+		pass_count = atol(argv[0]);
+		if(!pass_count) {
+			pass_count = PARSE_GEN_BENCH_PASS_COUNT;
+		}
+	}
+	if(argc > 1) {
+		bench.segment_size = atol(argv[1]);
+		if(!bench.segment_size) {
+			bench.segment_size = PARSE_GEN_BENCH_SEGMENT_SIZE;
+		}
+	}
+	if(argc > 2) {
+		dir_name = argv[2];
+	}
+
+	resource_loader = mrcp_resource_loader_create(TRUE,suite->pool);
+	if(!resource_loader) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Resource Loader");
+		return FALSE;
+	}
+	factory = mrcp_resource_factory_get(resource_loader);
+	if(!factory) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Resource Factory");
+		return FALSE;
+	}
+
+	if(parse_gen_bench_corpus_load(&bench,dir_name,suite->pool) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Load Corpus [%s]",dir_name);
+		mrcp_resource_factory_destroy(factory);
+		return FALSE;
+	}
+
+	bench.parser = mrcp_parser_create(factory,suite->pool);
+	mrcp_parser_recycler_set(bench.parser,apt_pool_recycler_create(4,suite->pool));
+	bench.generator = mrcp_generator_create(factory,suite->pool);
+
+	/* the first pass validates the corpus and counts the messages */
+	srand(1);
+	bench.parsed_count = 0;
+	bench.invalid_count = 0;
+	bench.generated_size = 0;
+	bench.mismatch_count = 0;
+	bench.pool_size = 0;
+	if(parse_gen_bench_pass(&bench) == FALSE || bench.invalid_count || bench.mismatch_count || !bench.parsed_count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Corpus [%s] messages [%"APR_SIZE_T_FMT"] invalid [%"APR_SIZE_T_FMT"] mismatched [%"APR_SIZE_T_FMT"]",
+			dir_name,
+			bench.parsed_count,
+			bench.invalid_count,
+			bench.mismatch_count);
+		mrcp_resource_factory_destroy(factory);
+		return FALSE;
+	}
+	bench.message_count = bench.parsed_count;
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Run Parse/Generate Benchmark [%"APR_SIZE_T_FMT" passes of %"APR_SIZE_T_FMT" messages, %"APR_SIZE_T_FMT" bytes] max segment [%"APR_SIZE_T_FMT" bytes]",
+		pass_count,
+		bench.message_count,
+		bench.size,
+		bench.segment_size);
+
+	bench.parsed_count = 0;
+	bench.generated_size = 0;
+	bench.pool_size = 0;
+	start = apr_time_now();
+	for(i=0; i<pass_count && status == TRUE; i++) {
+		status = parse_gen_bench_pass(&bench);
+	}
+	elapsed = apr_time_now() - start;
+	if(elapsed <= 0) {
+		elapsed = 1;
+	}
+
+	message_count = bench.parsed_count;
+	seconds = (double)elapsed / APR_USEC_PER_SEC;
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Parse/Generate: messages [%"APR_SIZE_T_FMT"] elapsed [%"APR_TIME_T_FMT" usec] messages/sec [%.0f] MB/sec [%.1f] usec/message [%.2f]",
+		message_count,
+		elapsed,
+		message_count / seconds,
+		(double)bench.size * pass_count / seconds / (1024 * 1024),
+		message_count ? (double)elapsed / message_count : 0.0);
+#if APR_POOL_DEBUG
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Parse/Generate: pool bytes/message [%.0f]",
+		message_count ? (double)bench.pool_size / message_count : 0.0);
+#else
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Pool usage per message is reported by builds with APR pool debugging only");
+#endif
+
+	if(message_count != bench.message_count * pass_count || bench.invalid_count || bench.mismatch_count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Parse/Generate Mismatch: messages [%"APR_SIZE_T_FMT"] invalid [%"APR_SIZE_T_FMT"] mismatched [%"APR_SIZE_T_FMT"] expected [%"APR_SIZE_T_FMT"]",
+			message_count,
+			bench.invalid_count,
+			bench.mismatch_count,
+			bench.message_count * pass_count);
+		status = FALSE;
+	}
+
+	mrcp_resource_factory_destroy(factory);
+	return status;
+}
+
+apt_test_suite_t* parse_gen_bench_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"parse-gen-bench",NULL,parse_gen_bench_run);
+	return suite;
+}
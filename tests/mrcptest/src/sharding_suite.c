@@ -0,0 +1,317 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * Test of the distribution of sessions across the shards of the MRCP server.
+ * Sessions are distributed only if more than one shard is configured and all
+ * the loaded engines are concurrent. The id of a distributed session is then
+ * generated on the first request already, and the requests of different
+ * sessions are processed by different tasks. Otherwise, all the sessions are
+ * processed by the main task.
+ */
+
+#include <apr_atomic.h>
+#include <apr_portable.h>
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "mrcp_server.h"
+#include "mrcp_engine_impl.h"
+#include "mrcp_resource_loader.h"
+#include "mrcp_sig_agent.h"
+#include "mrcp_session.h"
+#include "mpf_engine.h"
+#include "mpf_rtp_termination_factory.h"
+
+/** Number of sessions to distribute */
+#define SHARDING_TEST_SESSION_COUNT  16
+/** Number of shards to distribute sessions across */
+#define SHARDING_TEST_SHARD_COUNT    4
+/** Max time to wait for the sessions to be terminated (msec) */
+#define SHARDING_TEST_TIMEOUT        5000
+
+typedef struct sharding_test_t sharding_test_t;
+typedef struct sharding_test_slot_t sharding_test_slot_t;
+
+/** Session slot */
+struct sharding_test_slot_t {
+	/** Test the slot belongs to */
+	sharding_test_t *test;
+	/** Server session */
+	mrcp_session_t  *session;
+	/** Thread the termination of the session is responded from */
+	apr_os_thread_t  thread;
+};
+
+/** Sharding test */
+struct sharding_test_t {
+	/** Server under test */
+	mrcp_server_t         *server;
+	/** Signaling agent sessions are created by */
+	mrcp_sig_agent_t      *agent;
+	/** Session slots */
+	sharding_test_slot_t   slots[SHARDING_TEST_SESSION_COUNT];
+	/** Number of terminated sessions */
+	volatile apr_uint32_t  terminated_count;
+};
+
+static apt_bool_t sharding_test_engine_destroy(mrcp_engine_t *engine)
+{
+	return TRUE;
+}
+
+static apt_bool_t sharding_test_engine_open(mrcp_engine_t *engine)
+{
+	return mrcp_engine_open_respond(engine,TRUE);
+}
+
+static apt_bool_t sharding_test_engine_close(mrcp_engine_t *engine)
+{
+	return mrcp_engine_close_respond(engine);
+}
+
+static mrcp_engine_channel_t* sharding_test_engine_channel_create(mrcp_engine_t *engine, apr_pool_t *pool)
+{
+	return NULL;
+}
+
+static const struct mrcp_engine_method_vtable_t sharding_test_engine_vtable = {
+	sharding_test_engine_destroy,
+	sharding_test_engine_open,
+	sharding_test_engine_close,
+	sharding_test_engine_channel_create
+};
+
+static apt_bool_t sharding_test_on_terminate(mrcp_session_t *session)
+{
+	sharding_test_slot_t *slot = session->obj;
+	slot->thread = apr_os_thread_current();
+	apr_atomic_inc32(&slot->test->terminated_count);
+	return TRUE;
+}
+
+static const mrcp_session_response_vtable_t sharding_test_response_vtable = {
+	NULL,
+	sharding_test_on_terminate,
+	NULL,
+	NULL
+};
+
+static const mrcp_session_event_vtable_t sharding_test_event_vtable = {
+	NULL
+};
+
+/** Create and register engine */
+static apt_bool_t sharding_test_engine_register(mrcp_server_t *server, const char *id, mrcp_resource_id resource_id, apt_bool_t concurrent, apr_pool_t *pool)
+{
+	mrcp_engine_t *engine = mrcp_engine_create(resource_id,NULL,&sharding_test_engine_vtable,pool);
+	if(!engine) {
+		return FALSE;
+	}
+	engine->id = id;
+	engine->config = mrcp_engine_config_alloc(pool);
+	if(concurrent == TRUE) {
+		mrcp_engine_concurrency_enable(engine);
+	}
+	return mrcp_server_engine_register(server,engine);
+}
+
+/** Create server with the specified number of shards, one engine of which may be not concurrent */
+static apt_bool_t sharding_test_server_create(sharding_test_t *test, apr_size_t shard_count, apt_bool_t concurrent)
+{
+	apr_pool_t *pool;
+	mrcp_resource_loader_t *resource_loader;
+	mpf_engine_t *media_engine;
+	mpf_rtp_config_t *rtp_config;
+	mpf_rtp_settings_t *rtp_settings;
+	mpf_termination_factory_t *rtp_factory;
+	mrcp_server_profile_t *profile;
+
+	test->server = mrcp_server_create(NULL);
+	if(!test->server) {
+		return FALSE;
+	}
+	pool = mrcp_server_memory_pool_get(test->server);
+	if(mrcp_server_shard_count_set(test->server,shard_count) == FALSE) {
+		return FALSE;
+	}
+
+	resource_loader = mrcp_resource_loader_create(TRUE,pool);
+	if(!resource_loader) {
+		return FALSE;
+	}
+	mrcp_server_resource_factory_register(test->server,mrcp_resource_factory_get(resource_loader));
+	mrcp_server_codec_manager_register(test->server,mpf_engine_codec_manager_create(pool));
+
+	if(sharding_test_engine_register(test->server,"Sharding-Recog",MRCP_RECOGNIZER_RESOURCE,TRUE,pool) == FALSE ||
+		sharding_test_engine_register(test->server,"Sharding-Synth",MRCP_SYNTHESIZER_RESOURCE,concurrent,pool) == FALSE) {
+		return FALSE;
+	}
+
+	media_engine = mpf_engine_create("Sharding-Media",pool);
+	if(!media_engine) {
+		return FALSE;
+	}
+	mrcp_server_media_engine_register(test->server,media_engine);
+
+	rtp_config = mpf_rtp_config_alloc(pool);
+	apt_string_set(&rtp_config->ip,"127.0.0.1");
+	rtp_config->rtp_port_min = 5000;
+	rtp_config->rtp_port_max = 5100;
+	rtp_factory = mpf_rtp_termination_factory_create(rtp_config,pool);
+	rtp_settings = mpf_rtp_settings_alloc(pool);
+	mrcp_server_rtp_factory_register(test->server,rtp_factory,"Sharding-RTP");
+	mrcp_server_rtp_settings_register(test->server,rtp_settings,"Sharding-RTP-Settings");
+
+	test->agent = mrcp_signaling_agent_create("Sharding-Agent",test,pool);
+	mrcp_server_signaling_agent_register(test->server,test->agent);
+
+	/* MRCPv1 profile, which requires no connection agent */
+	profile = mrcp_server_profile_create(
+				"Sharding-Profile",
+				MRCP_VERSION_1,
+				NULL,
+				test->agent,
+				NULL,
+				media_engine,
+				rtp_factory,
+				rtp_settings,
+				pool);
+	return mrcp_server_profile_register(test->server,profile,NULL);
+}
+
+/** Check how the terminated sessions have been processed */
+static apt_bool_t sharding_test_sessions_check(sharding_test_t *test, apt_bool_t sharding)
+{
+	apr_size_t i;
+	apr_size_t j;
+	apr_size_t thread_count = 0;
+	for(i = 0; i < SHARDING_TEST_SESSION_COUNT; i++) {
+		sharding_test_slot_t *slot = &test->slots[i];
+		/* the id of a distributed session is generated to select the shard by */
+		if((slot->session->id.length != 0) != (sharding == TRUE)) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Session Id [%"APR_SIZE_T_FMT"] [%s]",
+				i,
+				slot->session->id.buf ? slot->session->id.buf : "none");
+			return FALSE;
+		}
+
+		for(j = 0; j < i; j++) {
+			if(apr_os_thread_equal(test->slots[j].thread,slot->thread)) {
+				break;
+			}
+		}
+		if(j == i) {
+			thread_count++;
+		}
+	}
+
+	if(sharding == TRUE ? thread_count <= 1 || thread_count > SHARDING_TEST_SHARD_COUNT : thread_count != 1) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Number of Tasks Sessions Are Processed by [%"APR_SIZE_T_FMT"]",
+			thread_count);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Create sessions, terminate them and check how they have been processed */
+static apt_bool_t sharding_test_run(const char *name, apr_size_t shard_count, apt_bool_t concurrent, apt_bool_t sharding)
+{
+	apr_size_t i;
+	apr_size_t created = 0;
+	apr_size_t waited = 0;
+	apt_bool_t status = FALSE;
+	sharding_test_t test;
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Run Sharding Test [%s]",name);
+	test.server = NULL;
+	test.agent = NULL;
+	apr_atomic_set32(&test.terminated_count,0);
+
+	do {
+		if(sharding_test_server_create(&test,shard_count,concurrent) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Server [%s]",name);
+			break;
+		}
+		if(mrcp_server_start(test.server) == FALSE) {
+			break;
+		}
+
+		for(created = 0; created < SHARDING_TEST_SESSION_COUNT; created++) {
+			sharding_test_slot_t *slot = &test.slots[created];
+			slot->test = &test;
+			slot->session = test.agent->create_server_session(test.agent);
+			if(!slot->session) {
+				break;
+			}
+			slot->session->obj = slot;
+			slot->session->response_vtable = &sharding_test_response_vtable;
+			slot->session->event_vtable = &sharding_test_event_vtable;
+		}
+		if(created < SHARDING_TEST_SESSION_COUNT) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Session [%s]",name);
+			break;
+		}
+
+		for(i = 0; i < SHARDING_TEST_SESSION_COUNT; i++) {
+			mrcp_session_terminate_request(test.slots[i].session);
+		}
+		while(apr_atomic_read32(&test.terminated_count) < SHARDING_TEST_SESSION_COUNT && waited < SHARDING_TEST_TIMEOUT) {
+			apr_sleep(apr_time_from_msec(10));
+			waited += 10;
+		}
+		if(apr_atomic_read32(&test.terminated_count) < SHARDING_TEST_SESSION_COUNT) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Sessions Not Terminated [%s] [%u/%d]",
+				name,
+				apr_atomic_read32(&test.terminated_count),
+				SHARDING_TEST_SESSION_COUNT);
+			break;
+		}
+
+		status = sharding_test_sessions_check(&test,sharding);
+	}
+	while(0);
+
+	if(test.server) {
+		mrcp_server_shutdown(test.server);
+		/* sessions are destroyed by the signaling agent, once the server is done with them */
+		for(i = 0; i < created; i++) {
+			mrcp_session_destroy(test.slots[i].session);
+		}
+		mrcp_server_destroy(test.server);
+	}
+	return status;
+}
+
+static apt_bool_t sharding_test_suite_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	if(sharding_test_run("single shard",1,TRUE,FALSE) == FALSE) {
+		return FALSE;
+	}
+	if(sharding_test_run("concurrent engines",SHARDING_TEST_SHARD_COUNT,TRUE,TRUE) == FALSE) {
+		return FALSE;
+	}
+	if(sharding_test_run("engine not concurrent",SHARDING_TEST_SHARD_COUNT,FALSE,FALSE) == FALSE) {
+		return FALSE;
+	}
+	return TRUE;
+}
+
+apt_test_suite_t* sharding_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"sharding",NULL,sharding_test_suite_run);
+	return suite;
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SERVER_BENCH_H
+#define SERVER_BENCH_H
+
+/**
+ * @file serverbench.h
+ * @brief End-to-end Benchmark of UniMRCP Server
+ *
+ * The server is started with the plugins of the configuration in use
+ * (the demo ones by default) together with an in-process client connected
+ * over loopback. A number of virtual users keep running synthesizer and/or
+ * recognizer sessions one after another, while the latencies of messages,
+ * the CPU time and memory of the process and the media processing overruns
+ * of the server are collected and reported in JSON.
+ */
+
+#include <stdio.h>
+#include "mrcp_client.h"
+#include "mrcp_server.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Latencies measured */
+typedef enum {
+	BENCH_METRIC_SESSION_SETUP,        /**< session create -> channel added */
+	BENCH_METRIC_RESPONSE,             /**< SPEAK/RECOGNIZE -> IN-PROGRESS */
+	BENCH_METRIC_SPEAK_COMPLETE,       /**< SPEAK -> SPEAK-COMPLETE */
+	BENCH_METRIC_RECOGNITION_COMPLETE, /**< RECOGNIZE -> RECOGNITION-COMPLETE */
+
+	BENCH_METRIC_COUNT
+} bench_metric_e;
+
+/** Scenario of sessions */
+typedef enum {
+	BENCH_MODE_SYNTH, /**< synthesizer sessions only */
+	BENCH_MODE_RECOG, /**< recognizer sessions only */
+	BENCH_MODE_MIXED  /**< every other virtual user runs recognizer sessions */
+} bench_mode_e;
+
+/** Opaque latency histogram declaration */
+typedef struct bench_histogram_t bench_histogram_t;
+/** Opaque benchmark application declaration */
+typedef struct bench_app_t bench_app_t;
+
+/** Benchmark parameters */
+typedef struct bench_params_t bench_params_t;
+struct bench_params_t {
+	/** Scenario of sessions */
+	bench_mode_e  mode;
+	/** Client profile to use */
+	const char   *profile;
+	/** Number of virtual users (concurrent sessions) */
+	apr_size_t    concurrency;
+	/** Time to launch new sessions for (sec) */
+	apr_size_t    duration;
+};
+
+/** Benchmark results */
+typedef struct bench_results_t bench_results_t;
+struct bench_results_t {
+	/** Elapsed wall clock time (usec) */
+	apr_interval_time_t elapsed_time;
+	/** Consumed user and system CPU time of the process (usec) */
+	apr_interval_time_t user_time;
+	apr_interval_time_t system_time;
+	/** Sum of the durations of sessions (usec) */
+	apr_interval_time_t channel_time;
+
+	/** Resident set size of the process at the end and at the peak (KB) */
+	apr_size_t          rss;
+	apr_size_t          peak_rss;
+
+	/** Total number of media processing overruns and the max per second */
+	apr_size_t          overrun_total;
+	apr_size_t          overrun_peak;
+	/** Max number of messages pending in the queue of a server task */
+	apr_size_t          queue_depth_peak;
+	/** Number of sessions rejected by admission control of the server */
+	apr_size_t          rejected_count;
+
+	/** Number of sessions launched, completed and failed */
+	apr_size_t          launched_count;
+	apr_size_t          completed_count;
+	apr_size_t          failed_count;
+	/** Max number of concurrent sessions */
+	apr_size_t          active_peak;
+};
+
+
+/** Create latency histogram */
+bench_histogram_t* bench_histogram_create(apr_pool_t *pool);
+
+/** Add latency sample (usec) */
+void bench_histogram_add(bench_histogram_t *histogram, apr_interval_time_t latency);
+
+/** Write latency histogram as JSON object */
+void bench_histogram_write(bench_histogram_t *histogram, FILE *file);
+
+
+/** Create benchmark application and register it in the client */
+bench_app_t* bench_app_create(mrcp_client_t *client, const bench_params_t *params, apr_pool_t *pool);
+
+/** Destroy benchmark application */
+void bench_app_destroy(bench_app_t *app);
+
+/** Start launching new sessions */
+void bench_app_start(bench_app_t *app);
+
+/** Launch sessions for the virtual users ready (from the main thread) */
+apr_size_t bench_app_tick(bench_app_t *app);
+
+/** Stop launching new sessions */
+void bench_app_stop(bench_app_t *app);
+
+/** Wait for the sessions in progress to complete */
+apt_bool_t bench_app_wait(bench_app_t *app, apr_interval_time_t timeout);
+
+/** Get session related results */
+void bench_app_results_get(bench_app_t *app, bench_results_t *results);
+
+/** Get latency histogram of the metric */
+bench_histogram_t* bench_app_histogram_get(bench_app_t *app, bench_metric_e metric);
+
+APT_END_EXTERN_C
+
+#endif /* SERVER_BENCH_H */
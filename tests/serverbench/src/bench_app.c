@@ -0,0 +1,602 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Benchmark scenario (run by each virtual user over and over).
+ * C -> S: SIP INVITE                 (add synthesizer or recognizer channel)
+ * S -> C: SIP OK
+ * C -> S: MRCP SPEAK or RECOGNIZE    (inline SSML or SRGS from the data dir)
+ * S -> C: MRCP IN-PROGRESS
+ * C -> S: RTP (one-8kHz.pcm or one-16kHz.pcm followed by silence, recognizer only)
+ * S -> C: MRCP SPEAK-COMPLETE or RECOGNITION-COMPLETE
+ * C -> S: SIP BYE
+ * S -> C: SIP OK
+ */
+
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#include "serverbench.h"
+#include "mrcp_application.h"
+#include "mrcp_message.h"
+#include "mrcp_generic_header.h"
+#include "mrcp_synth_header.h"
+#include "mrcp_synth_resource.h"
+#include "mrcp_recog_header.h"
+#include "mrcp_recog_resource.h"
+#include "apt_log.h"
+
+/** Name of the application registered in the client */
+#define BENCH_APP_NAME          "serverbench"
+/** Time a virtual user waits for after a session failed to be launched (usec) */
+#define BENCH_APP_RETRY_TIME    apr_time_from_sec(1)
+
+typedef struct bench_session_t bench_session_t;
+
+/** Benchmark application */
+struct bench_app_t {
+	/** MRCP application */
+	mrcp_application_t  *application;
+	/** Benchmark parameters */
+	bench_params_t       params;
+
+	/** Guard of the state below, shared by the main and the client threads */
+	apr_thread_mutex_t  *guard;
+	/** Condition signaled when no session is left in progress */
+	apr_thread_cond_t   *idle_cond;
+	/** Whether new sessions are launched */
+	apt_bool_t           admitting;
+	/** Times the virtual users are ready to launch the next session at (0 if busy) */
+	apr_time_t          *ready_times;
+
+	apr_size_t           active_count;
+	apr_size_t           active_peak;
+	apr_size_t           launched_count;
+	apr_size_t           completed_count;
+	apr_size_t           failed_count;
+	apr_interval_time_t  channel_time;
+
+	/** Latency histograms */
+	bench_histogram_t   *histograms[BENCH_METRIC_COUNT];
+
+	/** Bodies of SPEAK and RECOGNIZE requests */
+	apt_str_t            speak_body;
+	apt_str_t            grammar_body;
+	/** Audio to stream to recognizer (8 and 16 kHz) */
+	apt_str_t            audio_8k;
+	apt_str_t            audio_16k;
+};
+
+/** Session of a virtual user */
+struct bench_session_t {
+	bench_app_t         *app;
+	/** Index of the virtual user running the session */
+	apr_size_t           user;
+	/** Whether recognizer or synthesizer session */
+	apt_bool_t           recog;
+	/** Whether the session failed */
+	apt_bool_t           failed;
+
+	apr_time_t           start_time;
+	apr_time_t           request_time;
+
+	/** Audio to stream and the current position */
+	const apt_str_t     *audio;
+	apr_size_t           audio_pos;
+	/** Streaming is in-progress (set by the client thread, read by the media thread) */
+	volatile apt_bool_t  streaming;
+};
+
+static apt_bool_t bench_app_message_handler(const mrcp_app_message_t *app_message);
+
+static apt_bool_t bench_app_on_session_terminate(mrcp_application_t *application, mrcp_session_t *session, mrcp_sig_status_code_e status);
+static apt_bool_t bench_app_on_channel_add(mrcp_application_t *application, mrcp_session_t *session, mrcp_channel_t *channel, mrcp_sig_status_code_e status);
+static apt_bool_t bench_app_on_message_receive(mrcp_application_t *application, mrcp_session_t *session, mrcp_channel_t *channel, mrcp_message_t *message);
+static apt_bool_t bench_app_on_terminate_event(mrcp_application_t *application, mrcp_session_t *session, mrcp_channel_t *channel);
+
+static const mrcp_app_message_dispatcher_t bench_app_dispatcher = {
+	NULL /* on_session_update */,
+	bench_app_on_session_terminate,
+	bench_app_on_channel_add,
+	NULL /* on_channel_remove */,
+	bench_app_on_message_receive,
+	bench_app_on_terminate_event,
+	NULL /* on_resource_discover */
+};
+
+static apt_bool_t bench_stream_read(mpf_audio_stream_t *stream, mpf_frame_t *frame);
+static apt_bool_t bench_stream_write(mpf_audio_stream_t *stream, const mpf_frame_t *frame);
+
+static const mpf_audio_stream_vtable_t bench_stream_vtable = {
+	NULL,
+	NULL,
+	NULL,
+	bench_stream_read,
+	NULL,
+	NULL,
+	bench_stream_write,
+	NULL
+};
+
+
+/** Load the entire content of a file from the data dir */
+static apt_bool_t bench_data_load(apt_str_t *data, const apt_dir_layout_t *dir_layout, const char *file_name, apr_pool_t *pool)
+{
+	FILE *file;
+	long size;
+	char *file_path = apt_datadir_filepath_get(dir_layout,file_name,pool);
+	apt_string_reset(data);
+	if(!file_path) {
+		return FALSE;
+	}
+
+	file = fopen(file_path,"rb");
+	if(!file) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Open [%s]",file_path);
+		return FALSE;
+	}
+
+	fseek(file,0,SEEK_END);
+	size = ftell(file);
+	fseek(file,0,SEEK_SET);
+	if(size > 0) {
+		data->buf = apr_palloc(pool,size + 1);
+		data->length = fread(data->buf,1,size,file);
+		data->buf[data->length] = '\0';
+	}
+	fclose(file);
+	return data->length ? TRUE : FALSE;
+}
+
+/** Create benchmark application and register it in the client */
+bench_app_t* bench_app_create(mrcp_client_t *client, const bench_params_t *params, apr_pool_t *pool)
+{
+	int i;
+	const apt_dir_layout_t *dir_layout = mrcp_client_dir_layout_get(client);
+	bench_app_t *app = apr_palloc(pool,sizeof(bench_app_t));
+	app->params = *params;
+	if(!app->params.concurrency) {
+		app->params.concurrency = 1;
+	}
+	app->guard = NULL;
+	app->idle_cond = NULL;
+	app->admitting = FALSE;
+	app->ready_times = apr_pcalloc(pool,sizeof(apr_time_t) * app->params.concurrency);
+	app->active_count = 0;
+	app->active_peak = 0;
+	app->launched_count = 0;
+	app->completed_count = 0;
+	app->failed_count = 0;
+	app->channel_time = 0;
+	for(i=0; i<BENCH_METRIC_COUNT; i++) {
+		app->histograms[i] = bench_histogram_create(pool);
+	}
+
+	if(app->params.mode != BENCH_MODE_RECOG) {
+		if(bench_data_load(&app->speak_body,dir_layout,"speak.xml",pool) == FALSE) {
+			return NULL;
+		}
+	}
+	if(app->params.mode != BENCH_MODE_SYNTH) {
+		if(bench_data_load(&app->grammar_body,dir_layout,"grammar.xml",pool) == FALSE ||
+			bench_data_load(&app->audio_8k,dir_layout,"one-8kHz.pcm",pool) == FALSE) {
+			return NULL;
+		}
+		bench_data_load(&app->audio_16k,dir_layout,"one-16kHz.pcm",pool);
+	}
+
+	if(apr_thread_mutex_create(&app->guard,APR_THREAD_MUTEX_DEFAULT,pool) != APR_SUCCESS) {
+		return NULL;
+	}
+	if(apr_thread_cond_create(&app->idle_cond,pool) != APR_SUCCESS) {
+		apr_thread_mutex_destroy(app->guard);
+		return NULL;
+	}
+
+	app->application = mrcp_application_create(bench_app_message_handler,app,pool);
+	if(!app->application) {
+		bench_app_destroy(app);
+		return NULL;
+	}
+	mrcp_client_application_register(client,app->application,BENCH_APP_NAME);
+	return app;
+}
+
+/** Destroy benchmark application */
+void bench_app_destroy(bench_app_t *app)
+{
+	if(app->idle_cond) {
+		apr_thread_cond_destroy(app->idle_cond);
+		app->idle_cond = NULL;
+	}
+	if(app->guard) {
+		apr_thread_mutex_destroy(app->guard);
+		app->guard = NULL;
+	}
+}
+
+/** Create channel of the session */
+static mrcp_channel_t* bench_channel_create(mrcp_session_t *session, bench_session_t *bench_session)
+{
+	mpf_termination_t *termination;
+	mpf_stream_capabilities_t *capabilities;
+	apr_pool_t *pool = mrcp_application_session_pool_get(session);
+
+	if(bench_session->recog == TRUE) {
+		capabilities = mpf_source_stream_capabilities_create(pool);
+	}
+	else {
+		capabilities = mpf_sink_stream_capabilities_create(pool);
+	}
+	mpf_codec_capabilities_add(
+			&capabilities->codecs,
+			MPF_SAMPLE_RATE_8000 | MPF_SAMPLE_RATE_16000,
+			"LPCM");
+
+	termination = mrcp_application_audio_termination_create(
+			session,
+			&bench_stream_vtable,
+			capabilities,
+			bench_session);
+
+	return mrcp_application_channel_create(
+			session,
+			bench_session->recog == TRUE ? MRCP_RECOGNIZER_RESOURCE : MRCP_SYNTHESIZER_RESOURCE,
+			termination,
+			NULL,
+			bench_session);
+}
+
+/** Launch a session of the virtual user */
+static apt_bool_t bench_session_launch(bench_app_t *app, apr_size_t user)
+{
+	mrcp_channel_t *channel;
+	bench_session_t *bench_session;
+	mrcp_session_t *session = mrcp_application_session_create(app->application,app->params.profile,NULL);
+	if(!session) {
+		return FALSE;
+	}
+
+	bench_session = apr_palloc(mrcp_application_session_pool_get(session),sizeof(bench_session_t));
+	bench_session->app = app;
+	bench_session->user = user;
+	bench_session->recog = (app->params.mode == BENCH_MODE_RECOG ||
+		(app->params.mode == BENCH_MODE_MIXED && user % 2)) ? TRUE : FALSE;
+	bench_session->failed = FALSE;
+	bench_session->start_time = apr_time_now();
+	bench_session->request_time = 0;
+	bench_session->audio = NULL;
+	bench_session->audio_pos = 0;
+	bench_session->streaming = FALSE;
+	mrcp_application_session_object_set(session,bench_session);
+
+	channel = bench_channel_create(session,bench_session);
+	if(!channel || mrcp_application_channel_add(session,channel) != TRUE) {
+		mrcp_application_session_destroy(session);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Launch sessions for the virtual users ready (from the main thread) */
+apr_size_t bench_app_tick(bench_app_t *app)
+{
+	apr_size_t i;
+	apr_size_t count = 0;
+	apr_time_t now = apr_time_now();
+
+	for(i=0; i<app->params.concurrency; i++) {
+		apr_thread_mutex_lock(app->guard);
+		if(app->admitting == FALSE || !app->ready_times[i] || app->ready_times[i] > now) {
+			apr_thread_mutex_unlock(app->guard);
+			continue;
+		}
+		app->ready_times[i] = 0;
+		app->launched_count++;
+		app->active_count++;
+		if(app->active_count > app->active_peak) {
+			app->active_peak = app->active_count;
+		}
+		apr_thread_mutex_unlock(app->guard);
+
+		/* the client API is not called under the guard, since the handler takes it */
+		if(bench_session_launch(app,i) == TRUE) {
+			count++;
+			continue;
+		}
+
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Launch Session [%"APR_SIZE_T_FMT"]",i);
+		apr_thread_mutex_lock(app->guard);
+		app->failed_count++;
+		app->active_count--;
+		app->ready_times[i] = now + BENCH_APP_RETRY_TIME;
+		if(!app->active_count) {
+			apr_thread_cond_signal(app->idle_cond);
+		}
+		apr_thread_mutex_unlock(app->guard);
+	}
+	return count;
+}
+
+/** Start launching new sessions */
+void bench_app_start(bench_app_t *app)
+{
+	apr_size_t i;
+	apr_time_t now = apr_time_now();
+	apr_thread_mutex_lock(app->guard);
+	app->admitting = TRUE;
+	/* all the virtual users are ready right away */
+	for(i=0; i<app->params.concurrency; i++) {
+		app->ready_times[i] = now;
+	}
+	apr_thread_mutex_unlock(app->guard);
+}
+
+/** Stop launching new sessions */
+void bench_app_stop(bench_app_t *app)
+{
+	apr_thread_mutex_lock(app->guard);
+	app->admitting = FALSE;
+	apr_thread_mutex_unlock(app->guard);
+}
+
+/** Wait for the sessions in progress to complete */
+apt_bool_t bench_app_wait(bench_app_t *app, apr_interval_time_t timeout)
+{
+	apt_bool_t status = TRUE;
+	apr_time_t deadline = apr_time_now() + timeout;
+	apr_thread_mutex_lock(app->guard);
+	while(app->active_count) {
+		apr_time_t now = apr_time_now();
+		if(now >= deadline) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Timed out Waiting for [%"APR_SIZE_T_FMT"] Sessions",
+				app->active_count);
+			status = FALSE;
+			break;
+		}
+		apr_thread_cond_timedwait(app->idle_cond,app->guard,deadline - now);
+	}
+	apr_thread_mutex_unlock(app->guard);
+	return status;
+}
+
+/** Get session related results */
+void bench_app_results_get(bench_app_t *app, bench_results_t *results)
+{
+	apr_thread_mutex_lock(app->guard);
+	results->launched_count = app->launched_count;
+	results->completed_count = app->completed_count;
+	results->failed_count = app->failed_count;
+	results->active_peak = app->active_peak;
+	results->channel_time = app->channel_time;
+	apr_thread_mutex_unlock(app->guard);
+}
+
+/** Get latency histogram of the metric */
+bench_histogram_t* bench_app_histogram_get(bench_app_t *app, bench_metric_e metric)
+{
+	if(metric >= BENCH_METRIC_COUNT) {
+		return NULL;
+	}
+	return app->histograms[metric];
+}
+
+/** Add latency sample of the metric (from the client thread) */
+static void bench_app_metric_add(bench_app_t *app, bench_metric_e metric, apr_time_t start_time)
+{
+	apr_interval_time_t latency = apr_time_now() - start_time;
+	apr_thread_mutex_lock(app->guard);
+	bench_histogram_add(app->histograms[metric],latency);
+	apr_thread_mutex_unlock(app->guard);
+}
+
+/** Mark the session failed and terminate it */
+static apt_bool_t bench_session_fail(bench_session_t *bench_session, mrcp_session_t *session)
+{
+	bench_session->failed = TRUE;
+	bench_session->streaming = FALSE;
+	return mrcp_application_session_terminate(session);
+}
+
+/** Create SPEAK or RECOGNIZE request */
+static mrcp_message_t* bench_request_create(bench_session_t *bench_session, mrcp_session_t *session, mrcp_channel_t *channel)
+{
+	bench_app_t *app = bench_session->app;
+	mrcp_generic_header_t *generic_header;
+	mrcp_message_t *message;
+
+	if(bench_session->recog == FALSE) {
+		message = mrcp_application_message_create(session,channel,SYNTHESIZER_SPEAK);
+		if(!message) {
+			return NULL;
+		}
+		generic_header = mrcp_generic_header_prepare(message);
+		if(generic_header) {
+			apt_string_assign(&generic_header->content_type,"application/synthesis+ssml",message->pool);
+			mrcp_generic_header_property_add(message,GENERIC_HEADER_CONTENT_TYPE);
+		}
+		message->body = app->speak_body;
+	}
+	else {
+		mrcp_recog_header_t *recog_header;
+		message = mrcp_application_message_create(session,channel,RECOGNIZER_RECOGNIZE);
+		if(!message) {
+			return NULL;
+		}
+		generic_header = mrcp_generic_header_prepare(message);
+		if(generic_header) {
+			if(message->start_line.version == MRCP_VERSION_2) {
+				apt_string_assign(&generic_header->content_type,"application/srgs+xml",message->pool);
+			}
+			else {
+				apt_string_assign(&generic_header->content_type,"application/grammar+xml",message->pool);
+			}
+			mrcp_generic_header_property_add(message,GENERIC_HEADER_CONTENT_TYPE);
+		}
+		recog_header = mrcp_resource_header_prepare(message);
+		if(recog_header) {
+			recog_header->no_input_timeout = 5000;
+			mrcp_resource_header_property_add(message,RECOGNIZER_HEADER_NO_INPUT_TIMEOUT);
+			recog_header->recognition_timeout = 10000;
+			mrcp_resource_header_property_add(message,RECOGNIZER_HEADER_RECOGNITION_TIMEOUT);
+			recog_header->start_input_timers = TRUE;
+			mrcp_resource_header_property_add(message,RECOGNIZER_HEADER_START_INPUT_TIMERS);
+		}
+		message->body = app->grammar_body;
+	}
+	return message;
+}
+
+/** Handle the messages sent from the MRCP client stack (from the client thread) */
+static apt_bool_t bench_app_message_handler(const mrcp_app_message_t *app_message)
+{
+	return mrcp_application_message_dispatch(&bench_app_dispatcher,app_message);
+}
+
+static apt_bool_t bench_app_on_session_terminate(mrcp_application_t *application, mrcp_session_t *session, mrcp_sig_status_code_e status)
+{
+	bench_session_t *bench_session = mrcp_application_session_object_get(session);
+	if(bench_session) {
+		bench_app_t *app = bench_session->app;
+		apr_time_t now = apr_time_now();
+		apr_thread_mutex_lock(app->guard);
+		app->channel_time += now - bench_session->start_time;
+		if(bench_session->failed == TRUE || status != MRCP_SIG_STATUS_CODE_SUCCESS) {
+			app->failed_count++;
+		}
+		else {
+			app->completed_count++;
+		}
+		if(app->active_count) {
+			app->active_count--;
+		}
+		if(app->admitting == TRUE) {
+			/* the virtual user is ready to launch the next session */
+			app->ready_times[bench_session->user] = now;
+		}
+		if(!app->active_count) {
+			apr_thread_cond_signal(app->idle_cond);
+		}
+		apr_thread_mutex_unlock(app->guard);
+	}
+
+	mrcp_application_session_destroy(session);
+	return TRUE;
+}
+
+static apt_bool_t bench_app_on_channel_add(mrcp_application_t *application, mrcp_session_t *session, mrcp_channel_t *channel, mrcp_sig_status_code_e status)
+{
+	mrcp_message_t *message;
+	bench_session_t *bench_session = mrcp_application_session_object_get(session);
+	if(status != MRCP_SIG_STATUS_CODE_SUCCESS) {
+		return bench_session_fail(bench_session,session);
+	}
+
+	bench_app_metric_add(bench_session->app,BENCH_METRIC_SESSION_SETUP,bench_session->start_time);
+
+	if(bench_session->recog == TRUE) {
+		const mpf_codec_descriptor_t *descriptor = mrcp_application_source_descriptor_get(channel);
+		bench_session->audio = &bench_session->app->audio_8k;
+		if(descriptor && descriptor->sampling_rate == 16000 && bench_session->app->audio_16k.length) {
+			bench_session->audio = &bench_session->app->audio_16k;
+		}
+	}
+
+	message = bench_request_create(bench_session,session,channel);
+	if(!message) {
+		return bench_session_fail(bench_session,session);
+	}
+	bench_session->request_time = apr_time_now();
+	if(mrcp_application_message_send(session,channel,message) != TRUE) {
+		return bench_session_fail(bench_session,session);
+	}
+	return TRUE;
+}
+
+static apt_bool_t bench_app_on_message_receive(mrcp_application_t *application, mrcp_session_t *session, mrcp_channel_t *channel, mrcp_message_t *message)
+{
+	bench_session_t *bench_session = mrcp_application_session_object_get(session);
+	if(message->start_line.message_type == MRCP_MESSAGE_TYPE_RESPONSE) {
+		if(message->start_line.request_state != MRCP_REQUEST_STATE_INPROGRESS) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Response [%d] " APT_SID_FMT,
+				message->start_line.status_code,
+				MRCP_MESSAGE_SIDRES(message));
+			return bench_session_fail(bench_session,session);
+		}
+		bench_app_metric_add(bench_session->app,BENCH_METRIC_RESPONSE,bench_session->request_time);
+		if(bench_session->recog == TRUE) {
+			/* start to stream the speech to recognize */
+			bench_session->audio_pos = 0;
+			bench_session->streaming = TRUE;
+		}
+	}
+	else if(message->start_line.message_type == MRCP_MESSAGE_TYPE_EVENT) {
+		if(message->start_line.method_id == SYNTHESIZER_SPEAK_COMPLETE && bench_session->recog == FALSE) {
+			mrcp_synth_header_t *synth_header = mrcp_resource_header_get(message);
+			bench_app_metric_add(bench_session->app,BENCH_METRIC_SPEAK_COMPLETE,bench_session->request_time);
+			if(!synth_header || synth_header->completion_cause != SYNTHESIZER_COMPLETION_CAUSE_NORMAL) {
+				bench_session->failed = TRUE;
+			}
+			return mrcp_application_session_terminate(session);
+		}
+		if(message->start_line.method_id == RECOGNIZER_RECOGNITION_COMPLETE && bench_session->recog == TRUE) {
+			mrcp_recog_header_t *recog_header = mrcp_resource_header_get(message);
+			bench_session->streaming = FALSE;
+			bench_app_metric_add(bench_session->app,BENCH_METRIC_RECOGNITION_COMPLETE,bench_session->request_time);
+			if(!recog_header || recog_header->completion_cause != RECOGNIZER_COMPLETION_CAUSE_SUCCESS) {
+				bench_session->failed = TRUE;
+			}
+			return mrcp_application_session_terminate(session);
+		}
+	}
+	return TRUE;
+}
+
+static apt_bool_t bench_app_on_terminate_event(mrcp_application_t *application, mrcp_session_t *session, mrcp_channel_t *channel)
+{
+	bench_session_t *bench_session = mrcp_application_session_object_get(session);
+	return bench_session_fail(bench_session,session);
+}
+
+/** Callback is called from MPF engine context to read new frame (recognizer) */
+static apt_bool_t bench_stream_read(mpf_audio_stream_t *stream, mpf_frame_t *frame)
+{
+	bench_session_t *bench_session = stream->obj;
+	const apt_str_t *audio;
+	apr_size_t size;
+	if(!bench_session || bench_session->streaming == FALSE || !bench_session->audio) {
+		return TRUE;
+	}
+
+	audio = bench_session->audio;
+	size = frame->codec_frame.size;
+	if(bench_session->audio_pos + size <= audio->length) {
+		memcpy(frame->codec_frame.buffer,audio->buf + bench_session->audio_pos,size);
+		bench_session->audio_pos += size;
+	}
+	else {
+		/* keep streaming silence after the speech until the recognition completes */
+		memset(frame->codec_frame.buffer,0,size);
+	}
+	frame->type |= MEDIA_FRAME_TYPE_AUDIO;
+	return TRUE;
+}
+
+/** Callback is called from MPF engine context to write new frame (synthesizer) */
+static apt_bool_t bench_stream_write(mpf_audio_stream_t *stream, const mpf_frame_t *frame)
+{
+	/* synthesized audio is just discarded */
+	return TRUE;
+}
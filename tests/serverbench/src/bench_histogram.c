@@ -0,0 +1,112 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <apr_tables.h>
+#include "serverbench.h"
+
+/** Upper bounds of the histogram buckets (msec), the last bucket is unbounded */
+static const apr_uint32_t bench_histogram_bounds[] = {
+	1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000
+};
+
+#define BENCH_HISTOGRAM_BOUND_COUNT (sizeof(bench_histogram_bounds) / sizeof(bench_histogram_bounds[0]))
+
+/** Latency histogram */
+struct bench_histogram_t {
+	/** Samples (apr_uint32_t usec) kept for the percentiles */
+	apr_array_header_t *samples;
+	/** Sum of the samples (usec) */
+	apr_uint64_t        sum;
+	/** Number of samples per bucket */
+	apr_size_t          buckets[BENCH_HISTOGRAM_BOUND_COUNT + 1];
+};
+
+/** Create latency histogram */
+bench_histogram_t* bench_histogram_create(apr_pool_t *pool)
+{
+	bench_histogram_t *histogram = apr_pcalloc(pool,sizeof(bench_histogram_t));
+	histogram->samples = apr_array_make(pool,1024,sizeof(apr_uint32_t));
+	return histogram;
+}
+
+/** Add latency sample (usec) */
+void bench_histogram_add(bench_histogram_t *histogram, apr_interval_time_t latency)
+{
+	apr_size_t i;
+	if(latency < 0) {
+		latency = 0;
+	}
+	APR_ARRAY_PUSH(histogram->samples,apr_uint32_t) = (apr_uint32_t)latency;
+	histogram->sum += latency;
+
+	for(i=0; i<BENCH_HISTOGRAM_BOUND_COUNT; i++) {
+		if(latency <= (apr_interval_time_t)bench_histogram_bounds[i] * 1000) {
+			break;
+		}
+	}
+	histogram->buckets[i]++;
+}
+
+static int bench_sample_compare(const void *left, const void *right)
+{
+	apr_uint32_t l = *(const apr_uint32_t*)left;
+	apr_uint32_t r = *(const apr_uint32_t*)right;
+	if(l < r) {
+		return -1;
+	}
+	return l > r ? 1 : 0;
+}
+
+/** Write latency histogram as JSON object */
+void bench_histogram_write(bench_histogram_t *histogram, FILE *file)
+{
+	apr_size_t i;
+	apr_uint32_t *samples = (apr_uint32_t*)histogram->samples->elts;
+	int count = histogram->samples->nelts;
+
+	fprintf(file,"{\"count\": %d",count);
+	if(count) {
+		qsort(samples,count,sizeof(apr_uint32_t),bench_sample_compare);
+#define BENCH_PERCENTILE(p) (samples[((count - 1) * (p)) / 100] / 1000.0)
+		fprintf(file,
+			", \"min\": %.3f, \"avg\": %.3f, \"p50\": %.3f, \"p90\": %.3f"
+			", \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f",
+			samples[0] / 1000.0,
+			(double)histogram->sum / count / 1000.0,
+			BENCH_PERCENTILE(50),
+			BENCH_PERCENTILE(90),
+			BENCH_PERCENTILE(95),
+			BENCH_PERCENTILE(99),
+			samples[count - 1] / 1000.0);
+#undef BENCH_PERCENTILE
+	}
+
+	fprintf(file,", \"buckets\": [");
+	for(i=0; i<=BENCH_HISTOGRAM_BOUND_COUNT; i++) {
+		if(i < BENCH_HISTOGRAM_BOUND_COUNT) {
+			fprintf(file,"%s{\"le\": %u, \"count\": %"APR_SIZE_T_FMT"}",
+				i ? ", " : "",
+				bench_histogram_bounds[i],
+				histogram->buckets[i]);
+		}
+		else {
+			fprintf(file,", {\"le\": null, \"count\": %"APR_SIZE_T_FMT"}",
+				histogram->buckets[i]);
+		}
+	}
+	fprintf(file,"]}");
+}
@@ -0,0 +1,411 @@
+/*
+ * Copyright 2008-2015 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <apr_getopt.h>
+#ifdef WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
+#include "serverbench.h"
+#include "unimrcp_server.h"
+#include "unimrcp_client.h"
+#include "uni_version.h"
+#include "apt_pool.h"
+#include "apt_log.h"
+
+/** Interval sessions are launched and the load of the server is sampled at (usec) */
+#define BENCH_TICK_INTERVAL     apr_time_from_msec(10)
+/** Max time to wait for the sessions in progress after the benchmark is over (usec) */
+#define BENCH_COMPLETE_TIMEOUT  apr_time_from_sec(30)
+
+typedef struct {
+	const char     *root_dir_path;
+	const char     *log_priority;
+	const char     *output_path;
+	bench_params_t  params;
+} bench_options_t;
+
+static const char *bench_mode_names[] = {"synth", "recog", "mixed"};
+
+static const char *bench_metric_names[BENCH_METRIC_COUNT] = {
+	"session_setup",
+	"response",
+	"speak_complete",
+	"recognition_complete"
+};
+
+static void usage(void)
+{
+	printf(
+		"\n"
+		"Usage:\n"
+		"\n"
+		"  serverbench [options]\n"
+		"\n"
+		"  Available options:\n"
+		"\n"
+		"   -r [--root-dir] path     : Set the path to the project root directory.\n"
+		"\n"
+		"   -m [--mode] mode         : Set the scenario of sessions.\n"
+		"                              (synth, recog or mixed, the default is mixed)\n"
+		"\n"
+		"   -p [--profile] name      : Set the client profile to use (the default is uni2).\n"
+		"\n"
+		"   -n [--concurrency] count : Set the number of concurrent sessions (the default is 10).\n"
+		"\n"
+		"   -d [--duration] sec      : Set the time to launch new sessions for (the default is 30).\n"
+		"\n"
+		"   -o [--output] path       : Write the results to the file instead of stdout.\n"
+		"\n"
+		"   -l [--log-prio] priority : Set the log priority (the default is 3-error).\n"
+		"                              (0-emergency, ..., 7-debug)\n"
+		"\n"
+		"   -h [--help]              : Show the help.\n"
+		"\n");
+}
+
+static apt_bool_t bench_options_load(bench_options_t *options, int argc, const char * const *argv, apr_pool_t *pool)
+{
+	apr_status_t rv;
+	apr_getopt_t *opt = NULL;
+	int optch;
+	const char *optarg;
+
+	const apr_getopt_option_t opt_option[] = {
+		/* long-option, short-option, has-arg flag, description */
+		{ "root-dir",    'r', TRUE,  "path to root dir" },         /* -r arg or --root-dir arg */
+		{ "mode",        'm', TRUE,  "scenario of sessions" },     /* -m arg or --mode arg */
+		{ "profile",     'p', TRUE,  "client profile" },           /* -p arg or --profile arg */
+		{ "concurrency", 'n', TRUE,  "concurrent sessions" },      /* -n arg or --concurrency arg */
+		{ "duration",    'd', TRUE,  "duration" },                 /* -d arg or --duration arg */
+		{ "output",      'o', TRUE,  "path to output file" },      /* -o arg or --output arg */
+		{ "log-prio",    'l', TRUE,  "log priority" },             /* -l arg or --log-prio arg */
+		{ "help",        'h', FALSE, "show help" },                /* -h or --help */
+		{ NULL, 0, 0, NULL },                                      /* end */
+	};
+
+	rv = apr_getopt_init(&opt, pool , argc, argv);
+	if(rv != APR_SUCCESS) {
+		return FALSE;
+	}
+
+	/* reset the options */
+	options->root_dir_path = NULL;
+	options->log_priority = NULL;
+	options->output_path = NULL;
+	options->params.mode = BENCH_MODE_MIXED;
+	options->params.profile = "uni2";
+	options->params.concurrency = 10;
+	options->params.duration = 30;
+
+	while((rv = apr_getopt_long(opt, opt_option, &optch, &optarg)) == APR_SUCCESS) {
+		switch(optch) {
+			case 'r':
+				options->root_dir_path = optarg;
+				break;
+			case 'm':
+				if(strcasecmp(optarg,"synth") == 0)
+					options->params.mode = BENCH_MODE_SYNTH;
+				else if(strcasecmp(optarg,"recog") == 0)
+					options->params.mode = BENCH_MODE_RECOG;
+				else if(strcasecmp(optarg,"mixed") == 0)
+					options->params.mode = BENCH_MODE_MIXED;
+				else {
+					usage();
+					return FALSE;
+				}
+				break;
+			case 'p':
+				options->params.profile = optarg;
+				break;
+			case 'n':
+				options->params.concurrency = atol(optarg);
+				break;
+			case 'd':
+				options->params.duration = atol(optarg);
+				break;
+			case 'o':
+				options->output_path = optarg;
+				break;
+			case 'l':
+				options->log_priority = optarg;
+				break;
+			case 'h':
+				usage();
+				return FALSE;
+		}
+	}
+
+	if(rv != APR_EOF || !options->params.concurrency) {
+		usage();
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/** Get CPU time consumed by the process (usec) */
+static void bench_cpu_time_get(apr_interval_time_t *user_time, apr_interval_time_t *system_time)
+{
+#ifdef WIN32
+	FILETIME creation_time, exit_time, kernel_time, user_ft;
+	*user_time = *system_time = 0;
+	if(GetProcessTimes(GetCurrentProcess(),&creation_time,&exit_time,&kernel_time,&user_ft)) {
+		/* FILETIME is in 100-nanosecond units */
+		*user_time = (((apr_interval_time_t)user_ft.dwHighDateTime << 32) | user_ft.dwLowDateTime) / 10;
+		*system_time = (((apr_interval_time_t)kernel_time.dwHighDateTime << 32) | kernel_time.dwLowDateTime) / 10;
+	}
+#else
+	struct rusage usage;
+	*user_time = *system_time = 0;
+	if(getrusage(RUSAGE_SELF,&usage) == 0) {
+		*user_time = (apr_interval_time_t)usage.ru_utime.tv_sec * APR_USEC_PER_SEC + usage.ru_utime.tv_usec;
+		*system_time = (apr_interval_time_t)usage.ru_stime.tv_sec * APR_USEC_PER_SEC + usage.ru_stime.tv_usec;
+	}
+#endif
+}
+
+/** Get current and peak resident set size of the process (KB) */
+static void bench_rss_get(apr_size_t *rss, apr_size_t *peak_rss)
+{
+#ifdef WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	*rss = *peak_rss = 0;
+	if(GetProcessMemoryInfo(GetCurrentProcess(),&counters,sizeof(counters))) {
+		*rss = counters.WorkingSetSize / 1024;
+		*peak_rss = counters.PeakWorkingSetSize / 1024;
+	}
+#else
+	struct rusage usage;
+	FILE *file;
+	*rss = *peak_rss = 0;
+	if(getrusage(RUSAGE_SELF,&usage) == 0) {
+#ifdef __APPLE__
+		*peak_rss = usage.ru_maxrss / 1024;
+#else
+		*peak_rss = usage.ru_maxrss;
+#endif
+	}
+	/* the current size is only available on systems providing procfs */
+	file = fopen("/proc/self/statm","r");
+	if(file) {
+		unsigned long size, resident;
+		if(fscanf(file,"%lu %lu",&size,&resident) == 2) {
+			*rss = resident * (sysconf(_SC_PAGESIZE) / 1024);
+		}
+		fclose(file);
+	}
+#endif
+}
+
+/** Run the benchmark */
+static apt_bool_t bench_run(mrcp_server_t *server, bench_app_t *app, const bench_params_t *params, bench_results_t *results)
+{
+	mrcp_server_load_t load;
+	apr_size_t overrun_base = 0;
+	apr_interval_time_t user_time, system_time;
+	apr_time_t start_time, stop_time, now;
+	apt_bool_t status;
+
+	memset(results,0,sizeof(bench_results_t));
+	if(mrcp_server_load_get(server,&load) == TRUE) {
+		overrun_base = load.overrun_total;
+	}
+	bench_cpu_time_get(&user_time,&system_time);
+
+	start_time = now = apr_time_now();
+	stop_time = start_time + apr_time_from_sec(params->duration);
+	bench_app_start(app);
+	while(now < stop_time) {
+		bench_app_tick(app);
+		if(mrcp_server_load_get(server,&load) == TRUE) {
+			if(load.overrun_count > results->overrun_peak)
+				results->overrun_peak = load.overrun_count;
+			if(load.queue_depth > results->queue_depth_peak)
+				results->queue_depth_peak = load.queue_depth;
+		}
+		apr_sleep(BENCH_TICK_INTERVAL);
+		now = apr_time_now();
+	}
+	bench_app_stop(app);
+	status = bench_app_wait(app,BENCH_COMPLETE_TIMEOUT);
+
+	results->elapsed_time = apr_time_now() - start_time;
+	bench_cpu_time_get(&results->user_time,&results->system_time);
+	results->user_time -= user_time;
+	results->system_time -= system_time;
+	bench_rss_get(&results->rss,&results->peak_rss);
+	if(mrcp_server_load_get(server,&load) == TRUE) {
+		results->overrun_total = load.overrun_total - overrun_base;
+		results->rejected_count = load.rejected_count;
+	}
+	bench_app_results_get(app,results);
+	return status;
+}
+
+/** Write the results as JSON */
+static void bench_results_write(bench_app_t *app, const bench_params_t *params, const bench_results_t *results, FILE *file)
+{
+	int i;
+	double elapsed = (double)results->elapsed_time / APR_USEC_PER_SEC;
+	double cpu_time = (double)(results->user_time + results->system_time) / 1000;
+	double channel_time = (double)results->channel_time / APR_USEC_PER_SEC;
+
+	fprintf(file,"{\n");
+	fprintf(file,"  \"version\": \"%s\",\n",UNI_VERSION_STRING);
+	fprintf(file,"  \"params\": {\"mode\": \"%s\", \"profile\": \"%s\", \"concurrency\": %"APR_SIZE_T_FMT", \"duration\": %"APR_SIZE_T_FMT"},\n",
+		bench_mode_names[params->mode],
+		params->profile,
+		params->concurrency,
+		params->duration);
+	fprintf(file,"  \"elapsed_sec\": %.3f,\n",elapsed);
+	fprintf(file,"  \"sessions\": {\"launched\": %"APR_SIZE_T_FMT", \"completed\": %"APR_SIZE_T_FMT", \"failed\": %"APR_SIZE_T_FMT", \"rejected\": %"APR_SIZE_T_FMT", \"peak_concurrency\": %"APR_SIZE_T_FMT", \"per_sec\": %.3f},\n",
+		results->launched_count,
+		results->completed_count,
+		results->failed_count,
+		results->rejected_count,
+		results->active_peak,
+		elapsed > 0 ? results->completed_count / elapsed : 0.0);
+	/* the CPU time of the in-process client is accounted too */
+	fprintf(file,"  \"cpu\": {\"user_msec\": %.1f, \"system_msec\": %.1f, \"percent\": %.2f, \"channel_sec\": %.1f, \"msec_per_channel_sec\": %.3f},\n",
+		(double)results->user_time / 1000,
+		(double)results->system_time / 1000,
+		elapsed > 0 ? cpu_time / 10 / elapsed : 0.0,
+		channel_time,
+		channel_time > 0 ? cpu_time / channel_time : 0.0);
+	fprintf(file,"  \"memory\": {\"rss_kb\": %"APR_SIZE_T_FMT", \"peak_rss_kb\": %"APR_SIZE_T_FMT"},\n",
+		results->rss,
+		results->peak_rss);
+	fprintf(file,"  \"media\": {\"overruns\": %"APR_SIZE_T_FMT", \"peak_overruns_per_sec\": %"APR_SIZE_T_FMT"},\n",
+		results->overrun_total,
+		results->overrun_peak);
+	fprintf(file,"  \"server\": {\"peak_queue_depth\": %"APR_SIZE_T_FMT"},\n",
+		results->queue_depth_peak);
+	fprintf(file,"  \"latency_msec\": {\n");
+	for(i=0; i<BENCH_METRIC_COUNT; i++) {
+		fprintf(file,"    \"%s\": ",bench_metric_names[i]);
+		bench_histogram_write(bench_app_histogram_get(app,i),file);
+		fprintf(file,"%s\n",i + 1 < BENCH_METRIC_COUNT ? "," : "");
+	}
+	fprintf(file,"  }\n");
+	fprintf(file,"}\n");
+}
+
+int main(int argc, const char * const *argv)
+{
+	apr_pool_t *pool;
+	bench_options_t options;
+	bench_results_t results;
+	apt_dir_layout_t *dir_layout;
+	mrcp_server_t *server;
+	mrcp_client_t *client;
+	bench_app_t *app;
+	int exit_code = 1;
+
+	/* APR global initialization */
+	if(apr_initialize() != APR_SUCCESS) {
+		apr_terminate();
+		return 1;
+	}
+
+	/* create APR pool */
+	pool = apt_pool_create();
+	if(!pool) {
+		apr_terminate();
+		return 1;
+	}
+
+	/* load options */
+	if(bench_options_load(&options,argc,argv,pool) != TRUE) {
+		apr_pool_destroy(pool);
+		apr_terminate();
+		return 1;
+	}
+
+	/* only errors are logged by default not to skew the results */
+	apt_log_instance_create(APT_LOG_OUTPUT_CONSOLE,APT_PRIO_ERROR,pool);
+	if(options.log_priority) {
+		apt_log_priority_set(atoi(options.log_priority));
+	}
+
+	dir_layout = apt_default_dir_layout_create(options.root_dir_path,pool);
+	if(!dir_layout) {
+		printf("Failed to Create Directories Layout\n");
+		apt_log_instance_destroy();
+		apr_pool_destroy(pool);
+		apr_terminate();
+		return 1;
+	}
+
+	/* start the server with the plugins of its configuration */
+	server = unimrcp_server_start(dir_layout);
+	if(server) {
+		/* create the client connecting to the server over loopback */
+		client = unimrcp_client_create(dir_layout);
+		if(client) {
+			app = bench_app_create(client,&options.params,pool);
+			if(app && mrcp_client_start(client) == TRUE) {
+				FILE *file = stdout;
+				if(options.output_path) {
+					file = fopen(options.output_path,"w");
+				}
+
+				if(bench_run(server,app,&options.params,&results) == TRUE && results.completed_count) {
+					exit_code = 0;
+				}
+
+				if(file) {
+					bench_results_write(app,&options.params,&results,file);
+					if(file != stdout) {
+						fclose(file);
+					}
+				}
+				else {
+					printf("Failed to Open [%s]\n",options.output_path);
+					exit_code = 1;
+				}
+				mrcp_client_shutdown(client);
+			}
+			else {
+				printf("Failed to Start Client\n");
+			}
+			mrcp_client_destroy(client);
+			if(app) {
+				bench_app_destroy(app);
+			}
+		}
+		else {
+			printf("Failed to Create Client\n");
+		}
+		unimrcp_server_shutdown(server);
+	}
+	else {
+		printf("Failed to Start Server\n");
+	}
+
+	/* destroy singleton logger */
+	apt_log_instance_destroy();
+	/* destroy APR pool */
+	apr_pool_destroy(pool);
+	/* APR global termination */
+	apr_terminate();
+	return exit_code;
+}